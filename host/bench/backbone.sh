@@ -0,0 +1,49 @@
+#!/bin/sh
+#
+# Backbone stand-in for the host build: a veth pair between the border
+# router's network namespace (otbr-br, where the Wi-Fi STA would be) and
+# a "home LAN" namespace (otbr-lan, where Home Assistant would be).
+#
+#   sudo bench/backbone.sh up [delay]    e.g. "up 3ms" adds Wi-Fi-like latency
+#   sudo bench/backbone.sh down
+#
+
+set -e
+
+BR_NS=otbr-br
+LAN_NS=otbr-lan
+BR_IF=bb0
+LAN_IF=lan0
+
+case "$1" in
+up)
+    ip netns add "$BR_NS"
+    ip netns add "$LAN_NS"
+    ip link add "$BR_IF" netns "$BR_NS" type veth peer name "$LAN_IF" netns "$LAN_NS"
+
+    ip -n "$BR_NS" link set lo up
+    ip -n "$LAN_NS" link set lo up
+    ip -n "$BR_NS" link set "$BR_IF" up
+    ip -n "$LAN_NS" link set "$LAN_IF" up
+
+    # The border router forwards between wpan0 and the backbone; the LAN
+    # host learns the route to the Thread OMR prefix from its RAs (RIO).
+    ip netns exec "$BR_NS" sysctl -qw net.ipv6.conf.all.forwarding=1
+    ip netns exec "$BR_NS" sysctl -qw "net.ipv6.conf.$BR_IF.accept_ra=2"
+    ip netns exec "$LAN_NS" sysctl -qw "net.ipv6.conf.$LAN_IF.accept_ra=2"
+    ip netns exec "$LAN_NS" sysctl -qw "net.ipv6.conf.$LAN_IF.accept_ra_rt_info_max_plen=64"
+
+    if [ -n "$2" ]; then
+        ip netns exec "$BR_NS" tc qdisc add dev "$BR_IF" root netem delay "$2"
+    fi
+    echo "Backbone up: $BR_NS/$BR_IF <-> $LAN_NS/$LAN_IF"
+    ;;
+down)
+    ip netns del "$BR_NS" 2>/dev/null || true
+    ip netns del "$LAN_NS" 2>/dev/null || true
+    ;;
+*)
+    echo "usage: $0 up [delay] | down" >&2
+    exit 1
+    ;;
+esac
@@ -0,0 +1,462 @@
+#!/usr/bin/env python3
+"""Border-router benchmarks on the Linux host build.
+
+Drives otbr-host (the firmware's startup/border-router logic on the
+OpenThread POSIX platform) and simulated ot-cli-ftd nodes over their
+CLIs, with the veth backbone from backbone.sh:
+
+  attach    time to leader after a cold boot (energy scan + new network)
+            and after a warm restart (saved dataset, fast reattach), and
+            time for N nodes to attach
+  forward   LAN <-> Thread round-trip latency and flood throughput
+            through the border router.  On the host the veth backbone
+            and the Thread TUN are both Linux interfaces, so this is the
+            kernel's IPv6 forwarding, not the firmware's lwIP path and
+            netif hooks; results are named forward_kernel_*
+  srp       SRP registration rate with N nodes registering at once
+  commission
+            joins per minute with N simulated joiners started at once
+            against the stock OpenThread commissioner (wildcard PSKd);
+            otbr-host has no "otbr commission", so this is a baseline
+            for the join pipeline, not a measurement of bulk mode
+
+Needs root (network namespaces, TUN).  Typical use:
+
+  sudo bench/backbone.sh up
+  sudo bench/otbr_bench.py --build build-host all --json result.json
+  sudo bench/otbr_bench.py --build build-host all --baseline result.json
+
+With --baseline, exits non-zero if any result regressed by more than
+--tolerance against the stored run.
+"""
+
+import argparse
+import json
+import os
+import queue
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+BR_NS = "otbr-br"
+LAN_NS = "otbr-lan"
+BR_IF = "bb0"
+LAN_IF = "lan0"
+
+BR_NODE_ID = 1
+
+# Result name -> True when higher is better
+HIGHER_IS_BETTER = {
+    "forward_kernel_lan_to_thread_kbps": True,
+    "srp_registrations_per_s": True,
+    "commission_joins_per_min": True,
+}
+
+JOINER_PSKD = "J01NME"
+
+
+class CliError(Exception):
+    pass
+
+
+class Process:
+    """A process with an OpenThread CLI on stdin/stdout."""
+
+    def __init__(self, name, argv, cwd):
+        self.name = name
+        self.lines = queue.Queue()
+        self.log = []
+        self.log_cond = threading.Condition()
+        self.proc = subprocess.Popen(
+            ["ip", "netns", "exec", BR_NS] + argv, cwd=cwd, text=True, bufsize=1,
+            stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        threading.Thread(target=self._read_stdout, daemon=True).start()
+        threading.Thread(target=self._read_stderr, daemon=True).start()
+
+    def _read_stdout(self):
+        for line in self.proc.stdout:
+            line = line.strip()
+            while line.startswith(">"):
+                line = line[1:].strip()
+            if line:
+                self.lines.put(line)
+
+    def _read_stderr(self):
+        for line in self.proc.stderr:
+            with self.log_cond:
+                self.log.append(line.rstrip())
+                self.log_cond.notify_all()
+
+    def cli(self, command, timeout=10.0):
+        """Run a CLI command and return its output lines (without Done)."""
+        while not self.lines.empty():
+            self.lines.get_nowait()
+        self.proc.stdin.write(command + "\n")
+        self.proc.stdin.flush()
+
+        out = []
+        deadline = time.monotonic() + timeout
+        while True:
+            try:
+                line = self.lines.get(timeout=max(0.0, deadline - time.monotonic()))
+            except queue.Empty:
+                raise CliError(f"{self.name}: '{command}' timed out") from None
+            if line == command:
+                continue  # echo from the simulated UART
+            if line == "Done":
+                return out
+            if line.startswith("Error"):
+                raise CliError(f"{self.name}: '{command}': {line}")
+            out.append(line)
+
+    def wait_log(self, pattern, timeout):
+        """Wait for a stderr line matching pattern; return the match."""
+        regex = re.compile(pattern)
+        deadline = time.monotonic() + timeout
+        seen = 0
+        with self.log_cond:
+            while True:
+                for line in self.log[seen:]:
+                    m = regex.search(line)
+                    if m:
+                        return m
+                seen = len(self.log)
+                remaining = deadline - time.monotonic()
+                if remaining <= 0 or self.proc.poll() is not None:
+                    raise CliError(f"{self.name}: no log line matching '{pattern}'")
+                self.log_cond.wait(remaining)
+
+    def wait_output(self, pattern, timeout):
+        """Wait for an asynchronous CLI output line matching pattern."""
+        regex = re.compile(pattern)
+        deadline = time.monotonic() + timeout
+        while True:
+            try:
+                line = self.lines.get(timeout=max(0.0, deadline - time.monotonic()))
+            except queue.Empty:
+                raise CliError(f"{self.name}: no output matching '{pattern}'") from None
+            m = regex.search(line)
+            if m:
+                return m
+
+    def wait_state(self, states, timeout):
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            if self.cli("state")[0] in states:
+                return
+            time.sleep(0.1)
+        raise CliError(f"{self.name}: not {'/'.join(states)} after {timeout:.0f} s")
+
+    def stop(self):
+        if self.proc.poll() is None:
+            self.proc.stdin.close()  # otbr-host exits when stdin closes
+            try:
+                self.proc.wait(timeout=5)
+            except subprocess.TimeoutExpired:
+                self.proc.kill()
+                self.proc.wait()
+
+
+class Bench:
+    def __init__(self, args):
+        self.args = args
+        self.build = os.path.abspath(args.build)
+        self.workdir = tempfile.mkdtemp(prefix="otbr-bench-")
+        self.br = None
+        self.nodes = []
+        self.results = {}
+
+    # ---- process management ----
+
+    def start_br(self, reset):
+        rcp = os.path.join(self.build, "simulation/examples/apps/ncp/ot-rcp")
+        argv = [os.path.join(self.build, "otbr-host"),
+                "-B", BR_IF, "-a", "-c", str(self.args.ap_channel),
+                "-s", os.path.join(self.workdir, "state"),
+                f"spinel+hdlc+forkpty://{rcp}?forkpty-arg={BR_NODE_ID}"]
+        if reset:
+            argv.insert(1, "-r")
+        self.br = Process("otbr", argv, self.workdir)
+
+    def start_nodes(self, count=None, first_id=BR_NODE_ID + 1):
+        ftd = os.path.join(self.build, "simulation/examples/apps/cli/ot-cli-ftd")
+        started = []
+        for i in range(self.args.nodes if count is None else count):
+            node_id = first_id + i
+            started.append(Process(f"node{node_id}", [ftd, str(node_id)], self.workdir))
+        self.nodes += started
+        return started
+
+    def stop_all(self):
+        for p in self.nodes + [self.br]:
+            if p is not None:
+                p.stop()
+        self.nodes = []
+        self.br = None
+
+    def ensure_network(self):
+        if self.br is None:
+            self.start_br(reset=True)
+            self.br.wait_log(r"br_ready reached", 30)
+            self.br.wait_state(("leader",), 60)
+        if not self.nodes:
+            self.attach_nodes()
+
+    def attach_nodes(self):
+        nodes = self.start_nodes()
+        dataset = self.br.cli("dataset active -x")[0]
+        started = {}
+        for node in nodes:
+            node.cli(f"dataset set active {dataset}")
+            node.cli("ifconfig up")
+            started[node.name] = time.monotonic()
+            node.cli("thread start")
+
+        attach_ms = []
+        for node in nodes:
+            node.wait_state(("child", "router"), 60)
+            attach_ms.append((time.monotonic() - started[node.name]) * 1000)
+        return attach_ms
+
+    def result(self, name, value):
+        self.results[name] = round(value, 1)
+        print(f"  {name:40s} {value:10.1f}")
+
+    # ---- benchmarks ----
+
+    def bench_attach(self):
+        print("attach:")
+        self.stop_all()
+
+        self.start_br(reset=True)
+        leader = self.br.wait_log(r"thread_router reached at (\d+) ms", 90)
+        self.result("attach_cold_leader_ms", int(leader.group(1)))
+        self.br.wait_log(r"br_ready reached", 10)
+
+        # Warm restart: saved dataset and router state from the cold run
+        self.br.stop()
+        self.start_br(reset=False)
+        leader = self.br.wait_log(r"thread_router reached at (\d+) ms", 90)
+        self.result("attach_warm_leader_ms", int(leader.group(1)))
+        self.br.wait_log(r"br_ready reached", 10)
+
+        attach_ms = self.attach_nodes()
+        self.result("attach_node_median_ms", statistics.median(attach_ms))
+        self.result("attach_node_max_ms", max(attach_ms))
+
+    def omr_address(self, node, timeout=60):
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            for line in node.cli("ipaddr -v"):
+                if "origin:slaac" in line:
+                    return line.split()[0]
+            time.sleep(0.5)
+        raise CliError(f"{node.name}: no OMR address")
+
+    def lan_address(self, timeout=30):
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            out = subprocess.run(["ip", "-n", LAN_NS, "-6", "-o", "addr", "show", "dev", LAN_IF,
+                                  "scope", "global"], capture_output=True, text=True).stdout
+            m = re.search(r"inet6 ([0-9a-f:]+)/", out)
+            if m:
+                return m.group(1)
+            time.sleep(0.5)
+        raise CliError(f"{LAN_IF}: no global address (no RA from the border router?)")
+
+    @staticmethod
+    def lan_ping(addr, extra):
+        out = subprocess.run(["ip", "netns", "exec", LAN_NS, "ping", "-6", "-q"] + extra + [addr],
+                             capture_output=True, text=True).stdout
+        rtt = re.search(r"= [\d.]+/([\d.]+)/([\d.]+)", out)
+        sent = re.search(r"(\d+) packets transmitted, (\d+) received.*time (\d+)ms", out)
+        if not rtt or not sent:
+            raise CliError(f"ping {addr}: {out.strip() or 'no output'}")
+        return (float(rtt.group(1)), float(rtt.group(2)),
+                int(sent.group(1)), int(sent.group(2)), int(sent.group(3)))
+
+    def bench_forward(self):
+        # LAN <-> Thread forwarding is the Linux kernel's here, not lwIP
+        print("forward (Linux kernel path, not the firmware's lwIP forwarding):")
+        self.ensure_network()
+        node = self.nodes[0]
+        omr = self.omr_address(node)
+
+        count = self.args.pings
+        avg, mx, sent, recv, _ = self.lan_ping(omr, ["-c", str(count), "-i", "0.05", "-s", "64"])
+        self.result("forward_kernel_lan_to_thread_rtt_avg_ms", avg)
+        self.result("forward_kernel_lan_to_thread_rtt_max_ms", mx)
+        self.result("forward_kernel_lan_to_thread_loss_pct", 100.0 * (sent - recv) / sent)
+
+        size = 1000  # fragmented on the Thread side, as OTA/bulk traffic is
+        _, _, sent, recv, elapsed_ms = self.lan_ping(omr, ["-f", "-c", str(count), "-s", str(size)])
+        self.result("forward_kernel_lan_to_thread_kbps", recv * size * 8 / max(elapsed_ms, 1))
+
+        lan = self.lan_address()
+        out = node.cli(f"ping {lan} 64 {count} 0.05", timeout=count * 0.05 + 15)
+        rtt = next((re.search(r"= [\d.]+/([\d.]+)/([\d.]+) ms", l) for l in out
+                    if "Round-trip" in l), None)
+        if rtt:
+            self.result("forward_kernel_thread_to_lan_rtt_avg_ms", float(rtt.group(1)))
+            self.result("forward_kernel_thread_to_lan_rtt_max_ms", float(rtt.group(2)))
+
+    def registered_hosts(self):
+        hosts = 0
+        for line in self.br.cli("srp server host"):
+            if line.startswith("bench-"):
+                hosts += 1
+            elif line.startswith("deleted: true"):
+                hosts -= 1
+        return hosts
+
+    def bench_srp(self):
+        print("srp:")
+        self.ensure_network()
+        for i, node in enumerate(self.nodes):
+            node.cli(f"srp client host name bench-{i}")
+            node.cli("srp client host address auto")
+            node.cli(f"srp client service add ins-{i} _bench._udp 5683")
+
+        start = time.monotonic()
+        for node in self.nodes:
+            node.cli("srp client autostart enable")
+
+        deadline = start + 120
+        while self.registered_hosts() < len(self.nodes):
+            if time.monotonic() > deadline:
+                raise CliError("SRP registrations did not complete in 120 s")
+            time.sleep(0.1)
+        elapsed = time.monotonic() - start
+        self.result("srp_all_registered_ms", elapsed * 1000)
+        self.result("srp_registrations_per_s", len(self.nodes) / elapsed)
+
+    def bench_commission(self):
+        # Stock "commissioner start" / "joiner add *": the host build does
+        # not include commission.c, so this is the OpenThread baseline.
+        print("commission (stock OpenThread commissioner, baseline):")
+        self.ensure_network()  # the attached nodes serve as joiner routers
+
+        self.br.cli("commissioner start")
+        deadline = time.monotonic() + 30
+        while self.br.cli("commissioner state")[0] != "active":
+            if time.monotonic() > deadline:
+                raise CliError("commissioner not active after 30 s")
+            time.sleep(0.2)
+        self.br.cli(f"commissioner joiner add * {JOINER_PSKD} 900")
+
+        count = self.args.joiners
+        joiners = self.start_nodes(count, BR_NODE_ID + 1 + len(self.nodes))
+        for joiner in joiners:
+            joiner.cli("ifconfig up")
+
+        # One thread per joiner, so each join is timed when it happens
+        join_ms = {}
+        done = []
+        failed = []
+        timeout = 60 + 30 * count
+
+        def wait_join(joiner, start):
+            try:
+                m = joiner.wait_output(r"Join (success|failed.*)", timeout)
+                if m.group(1) == "success":
+                    done.append(time.monotonic())
+                    join_ms[joiner.name] = (done[-1] - start) * 1000
+                else:
+                    failed.append(f"{joiner.name}: {m.group(0)}")
+            except CliError as e:
+                failed.append(str(e))
+
+        start = time.monotonic()
+        waiters = []
+        for joiner in joiners:
+            joiner.cli(f"joiner start {JOINER_PSKD}")
+            waiters.append(threading.Thread(target=wait_join, args=(joiner, time.monotonic())))
+            waiters[-1].start()
+        for w in waiters:
+            w.join()
+        self.br.cli("commissioner stop")
+        for joiner in joiners:
+            joiner.stop()
+            self.nodes.remove(joiner)
+
+        for f in failed:
+            print(f"  {f}")
+        if not join_ms:
+            raise CliError("no joiner joined")
+        elapsed_ms = (max(done) - start) * 1000
+        self.result("commission_joined", len(join_ms))
+        self.result("commission_join_median_ms", statistics.median(join_ms.values()))
+        self.result("commission_all_joined_ms", elapsed_ms)
+        self.result("commission_joins_per_min", len(join_ms) * 60000 / elapsed_ms)
+
+    def run(self, which):
+        try:
+            for name in which:
+                getattr(self, f"bench_{name}")()
+        finally:
+            self.stop_all()
+            shutil.rmtree(self.workdir, ignore_errors=True)
+
+
+def compare(results, baseline, tolerance):
+    regressions = []
+    for name, old in baseline.items():
+        new = results.get(name)
+        if new is None or old == 0:
+            continue
+        change = (new - old) / abs(old)
+        if not HIGHER_IS_BETTER.get(name, False):
+            change = -change
+        if change < -tolerance:
+            regressions.append(f"{name}: {old} -> {new} ({change * 100:+.0f} %)")
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("benchmarks", nargs="*", default=["all"],
+                        choices=["all", "attach", "forward", "srp", "commission"])
+    parser.add_argument("--build", default="build-host", help="host build directory")
+    parser.add_argument("--nodes", type=int, default=8, help="simulated Thread nodes")
+    parser.add_argument("--joiners", type=int, default=8,
+                        help="simulated joiners for the commission (baseline) benchmark")
+    parser.add_argument("--pings", type=int, default=100, help="pings per latency run")
+    parser.add_argument("--ap-channel", type=int, default=6,
+                        help="emulated backbone AP channel (steers channel planning)")
+    parser.add_argument("--json", help="write results to this file")
+    parser.add_argument("--baseline", help="compare against results from --json")
+    parser.add_argument("--tolerance", type=float, default=0.2,
+                        help="allowed regression against the baseline (fraction)")
+    args = parser.parse_args()
+
+    if os.geteuid() != 0:
+        sys.exit("needs root: network namespaces and the TUN interface")
+
+    which = ["attach", "forward", "srp", "commission"] if "all" in args.benchmarks else args.benchmarks
+    bench = Bench(args)
+    try:
+        bench.run(which)
+    except CliError as e:
+        sys.exit(f"benchmark failed: {e}")
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(bench.results, f, indent=2, sort_keys=True)
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            regressions = compare(bench.results, json.load(f), args.tolerance)
+        for r in regressions:
+            print(f"REGRESSION {r}")
+        if regressions:
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,301 @@
+/*
+ * OpenThread Border Router — Linux host build
+ *
+ * Runs the firmware's Thread startup, dataset and channel-planning
+ * logic (main/ot_startup.c and friends) on the OpenThread POSIX
+ * platform, so boot and forwarding behaviour can be measured without
+ * hardware:
+ *
+ *   802.15.4 radio   simulated RCP (ot-rcp from the simulation platform),
+ *                    talking to simulated ot-cli-ftd nodes
+ *   Wi-Fi backbone   a veth/TAP interface given with -B
+ *   Thread netif     a TUN interface (-I), routed by the Linux kernel
+ *
+ * The OpenThread CLI is on stdin/stdout, logs go to stderr in the
+ * ESP-IDF format.  See host/bench/ for the benchmark suite.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+
+#include "openthread-system.h"
+#include "openthread/border_routing.h"
+#include "openthread/cli.h"
+#include "openthread/instance.h"
+#include "openthread/srp_server.h"
+#include "openthread/tasklet.h"
+
+#include "config.h"
+#include "boot_time.h"
+#include "channel_plan.h"
+#include "host_port.h"
+#include "ot_startup.h"
+
+static const char *TAG = "otbr_host";
+
+#define CLI_LINE_MAX            640
+
+static volatile sig_atomic_t s_terminate = 0;
+
+static char s_cli_line[CLI_LINE_MAX];
+static size_t s_cli_len = 0;
+
+/* ------------------------------------------------------------------ */
+/*  Command line                                                       */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    const char *thread_if;
+    const char *backbone_if;
+    const char *radio_url;
+    const char *state_dir;
+    uint8_t ap_channel;
+    bool auto_create;
+    bool reset;
+} host_options_t;
+
+static void usage(const char *prog, FILE *out)
+{
+    fprintf(out,
+            "Usage: %s [options] -B <backbone-if> <radio-url>\n"
+            "\n"
+            "  -I, --interface-name NAME      Thread network interface (default wpan0)\n"
+            "  -B, --backbone-interface NAME  Backbone interface standing in for Wi-Fi\n"
+            "  -s, --state-dir DIR            Firmware NVS state (default otbr-host-state)\n"
+            "  -c, --ap-channel N             Wi-Fi channel of the emulated AP (1-14)\n"
+            "  -a, --auto-create              Create a network if none is saved\n"
+            "                                 (THREAD_AUTO_START, default %d)\n"
+            "  -r, --reset                    Erase OpenThread settings and NVS state\n"
+            "  -v, --verbose                  Also print debug logs\n"
+            "  -h, --help                     Show this help\n"
+            "\n"
+            "Example:\n"
+            "  %s -B bb0 -a 'spinel+hdlc+forkpty://ot-rcp?forkpty-arg=1'\n",
+            prog, THREAD_AUTO_START, prog);
+}
+
+static void parse_args(int argc, char *argv[], host_options_t *opts)
+{
+    static const struct option long_options[] = {
+        { "interface-name",     required_argument, NULL, 'I' },
+        { "backbone-interface", required_argument, NULL, 'B' },
+        { "state-dir",          required_argument, NULL, 's' },
+        { "ap-channel",         required_argument, NULL, 'c' },
+        { "auto-create",        no_argument,       NULL, 'a' },
+        { "reset",              no_argument,       NULL, 'r' },
+        { "verbose",            no_argument,       NULL, 'v' },
+        { "help",               no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+
+    *opts = (host_options_t) {
+        .thread_if = "wpan0",
+        .state_dir = "otbr-host-state",
+        .auto_create = THREAD_AUTO_START,
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "I:B:s:c:arvh", long_options, NULL)) != -1) {
+        switch (c) {
+        case 'I': opts->thread_if = optarg;                   break;
+        case 'B': opts->backbone_if = optarg;                 break;
+        case 's': opts->state_dir = optarg;                   break;
+        case 'c': opts->ap_channel = (uint8_t)atoi(optarg);   break;
+        case 'a': opts->auto_create = true;                   break;
+        case 'r': opts->reset = true;                         break;
+        case 'v': host_log_debug = 1;                         break;
+        case 'h': usage(argv[0], stdout);                     exit(EXIT_SUCCESS);
+        default:  usage(argv[0], stderr);                     exit(EXIT_FAILURE);
+        }
+    }
+
+    if (optind + 1 != argc || opts->backbone_if == NULL) {
+        usage(argv[0], stderr);
+        exit(EXIT_FAILURE);
+    }
+    opts->radio_url = argv[optind];
+}
+
+/* ------------------------------------------------------------------ */
+/*  CLI on stdin / stdout                                              */
+/* ------------------------------------------------------------------ */
+
+static int cli_output(void *context, const char *format, va_list args)
+{
+    int n = vfprintf(stdout, format, args);
+    fflush(stdout);
+    return n;
+}
+
+static otError cmd_metrics(void *context, uint8_t argc, char *argv[])
+{
+    host_metrics_write(stdout);
+    return OT_ERROR_NONE;
+}
+
+static const otCliCommand s_host_commands[] = {
+    { "metrics", cmd_metrics },
+};
+
+static void cli_process(void)
+{
+    char buf[256];
+    ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+
+    if (n == 0) {
+        /* stdin closed: the benchmark driver went away */
+        s_terminate = 1;
+        return;
+    }
+
+    for (ssize_t i = 0; i < n; i++) {
+        if (buf[i] == '\r' || buf[i] == '\n') {
+            if (s_cli_len == 0) continue;
+            s_cli_line[s_cli_len] = '\0';
+            otCliInputLine(s_cli_line);
+            s_cli_len = 0;
+        } else if (s_cli_len < sizeof(s_cli_line) - 1) {
+            s_cli_line[s_cli_len++] = buf[i];
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Border routing                                                     */
+/* ------------------------------------------------------------------ */
+
+/*
+ * A copy, not shared code: stage 2 of ot_br_init_task() in main/main.c,
+ * without the wait for Wi-Fi (the backbone stand-in is up before we
+ * start).  The firmware enables border routing and the SRP server
+ * through ESP-IDF's esp_openthread_border_router_init(); here
+ * otSysInit() has already bound border routing to the -B interface, so
+ * the OpenThread calls are made directly.
+ * Everything else main.c starts at that point (SRP -> mDNS, DNS proxy,
+ * NAT64, route health, multicast policy, commissioning, metrics) is
+ * device-only.  Nothing keeps the two in step: when main.c's stage 2
+ * changes, update this too.
+ */
+static void border_router_up(otInstance *instance)
+{
+    boot_time_mark(BOOT_PHASE_WIFI_CONNECTED);
+    boot_time_mark(BOOT_PHASE_WIFI_IPV6);
+
+    otError error = otBorderRoutingSetEnabled(instance, true);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to enable border routing: %d", error);
+        return;
+    }
+    otSrpServerSetAutoEnableMode(instance, true);
+
+    boot_time_mark(BOOT_PHASE_BR_READY);
+    ESP_LOGI(TAG, "OpenThread Border Router initialized");
+}
+
+/* ------------------------------------------------------------------ */
+/*  Mainloop                                                           */
+/* ------------------------------------------------------------------ */
+
+static void on_signal(int signo)
+{
+    s_terminate = 1;
+}
+
+static void mainloop(otInstance *instance)
+{
+    int wake_fd = host_port_wake_fd();
+
+    while (!s_terminate) {
+        otSysMainloopContext ctx;
+
+        memset(&ctx, 0, sizeof(ctx));
+        FD_ZERO(&ctx.mReadFdSet);
+        FD_ZERO(&ctx.mWriteFdSet);
+        FD_ZERO(&ctx.mErrorFdSet);
+        ctx.mMaxFd = -1;
+        ctx.mTimeout.tv_sec = 10;
+        ctx.mTimeout.tv_usec = 0;
+
+        otTaskletsProcess(instance);
+
+        FD_SET(STDIN_FILENO, &ctx.mReadFdSet);
+        FD_SET(wake_fd, &ctx.mReadFdSet);
+        ctx.mMaxFd = wake_fd > STDIN_FILENO ? wake_fd : STDIN_FILENO;
+        otSysMainloopUpdate(instance, &ctx);
+
+        /* Background tasks (channel planning) get the lock while we sleep */
+        esp_openthread_lock_release();
+        int rval = otSysMainloopPoll(&ctx);
+        esp_openthread_lock_acquire(portMAX_DELAY);
+
+        if (rval < 0) {
+            if (errno == EINTR) continue;
+            ESP_LOGE(TAG, "select: %s", strerror(errno));
+            break;
+        }
+
+        otSysMainloopProcess(instance, &ctx);
+        if (FD_ISSET(wake_fd, &ctx.mReadFdSet)) host_port_drain_wake();
+        if (FD_ISSET(STDIN_FILENO, &ctx.mReadFdSet)) cli_process();
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Entry point                                                        */
+/* ------------------------------------------------------------------ */
+
+int main(int argc, char *argv[])
+{
+    host_options_t opts;
+    parse_args(argc, argv, &opts);
+
+    ESP_LOGI(TAG, "OpenThread Border Router (host) — %s, backbone %s",
+             DEVICE_NAME, opts.backbone_if);
+
+    ESP_ERROR_CHECK(host_nvs_init(opts.state_dir, opts.reset));
+
+    otPlatformConfig config;
+    memset(&config, 0, sizeof(config));
+    config.mInterfaceName = opts.thread_if;
+    config.mBackboneInterfaceName = opts.backbone_if;
+    config.mCoprocessorUrls.mUrls[0] = opts.radio_url;
+    config.mCoprocessorUrls.mNum = 1;
+    config.mSpeedUpFactor = 1;
+
+    otInstance *instance = otSysInit(&config);
+    host_port_init(instance);
+    boot_time_mark(BOOT_PHASE_OT_INIT);
+
+    if (opts.reset) otInstanceErasePersistentInfo(instance);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    otCliInit(instance, cli_output, NULL);
+    otCliSetUserCommands(s_host_commands, sizeof(s_host_commands) / sizeof(s_host_commands[0]),
+                         NULL);
+    otSetStateChangedCallback(instance, ot_startup_state_changed, instance);
+
+    /* -c stands in for the channel cached from the last association,
+     * and for the association itself: the backbone is already up      */
+    channel_plan_init(opts.ap_channel);
+    if (opts.ap_channel != 0) channel_plan_set_ap_channel(opts.ap_channel);
+    ot_startup_start_thread(instance, opts.auto_create);
+    border_router_up(instance);
+
+    mainloop(instance);
+
+    esp_openthread_lock_release();
+    otSysDeinit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,28 @@
+/*
+ * Host port: ESP_LOGx on stderr, in the ESP-IDF "I (ms) tag: ..." format
+ * so the same log parsing works for the firmware and the host build.
+ */
+
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+uint32_t esp_log_timestamp(void);
+
+/* Set from the command line (-v): also print ESP_LOGD */
+extern int host_log_debug;
+
+#define HOST_LOG(letter, tag, format, ...)                                  \
+    fprintf(stderr, letter " (%lu) %s: " format "\n",                       \
+            (unsigned long)esp_log_timestamp(), tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)                                          \
+    do { if (host_log_debug) HOST_LOG("D", tag, format, ##__VA_ARGS__); } while (0)
+#define ESP_LOGV(tag, format, ...) ESP_LOGD(tag, format, ##__VA_ARGS__)
+
+#endif /* HOST_ESP_LOG_H */
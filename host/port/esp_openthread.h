@@ -0,0 +1,12 @@
+/*
+ * Host port: the OpenThread instance created by otSysInit()
+ */
+
+#ifndef HOST_ESP_OPENTHREAD_H
+#define HOST_ESP_OPENTHREAD_H
+
+#include "openthread/instance.h"
+
+otInstance *esp_openthread_get_instance(void);
+
+#endif /* HOST_ESP_OPENTHREAD_H */
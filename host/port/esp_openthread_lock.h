@@ -0,0 +1,20 @@
+/*
+ * Host port: the OpenThread API lock
+ *
+ * The mainloop holds it except while it sleeps in select(), as the
+ * ESP-IDF mainloop does.  Releasing it from any other thread wakes the
+ * mainloop so tasklets posted meanwhile run without waiting for the
+ * next timer.
+ */
+
+#ifndef HOST_ESP_OPENTHREAD_LOCK_H
+#define HOST_ESP_OPENTHREAD_LOCK_H
+
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+
+bool esp_openthread_lock_acquire(TickType_t block_ticks);
+void esp_openthread_lock_release(void);
+
+#endif /* HOST_ESP_OPENTHREAD_LOCK_H */
@@ -0,0 +1,15 @@
+/*
+ * Host port: run a function on the mainloop (with the OpenThread lock)
+ */
+
+#ifndef HOST_ESP_OPENTHREAD_TASK_QUEUE_H
+#define HOST_ESP_OPENTHREAD_TASK_QUEUE_H
+
+#include "esp_err.h"
+
+typedef void (*esp_openthread_task_t)(void *arg);
+
+/** Queue task(arg) for the mainloop's next wakeup (host_port_drain_wake). */
+esp_err_t esp_openthread_task_queue_post(esp_openthread_task_t task, void *arg);
+
+#endif /* HOST_ESP_OPENTHREAD_TASK_QUEUE_H */
@@ -0,0 +1,38 @@
+/*
+ * Host port: glue between otbr_host.c and the ESP-IDF shims
+ */
+
+#ifndef HOST_PORT_H
+#define HOST_PORT_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "openthread/instance.h"
+
+#include "esp_err.h"
+
+/**
+ * Record the instance returned by otSysInit() and make the calling
+ * thread the mainloop (it starts out holding the OpenThread lock).
+ */
+void host_port_init(otInstance *instance);
+
+/**
+ * Readable end of the mainloop wake pipe: becomes readable when another
+ * thread releases the OpenThread lock or posts to the task queue.
+ * Drain with host_port_drain_wake(), which also runs the queued tasks.
+ */
+int host_port_wake_fd(void);
+void host_port_drain_wake(void);
+
+/**
+ * Point NVS at a state directory (created if missing).  erase removes
+ * every blob in it first, like "idf.py erase-flash" for firmware state.
+ */
+esp_err_t host_nvs_init(const char *dir, bool erase);
+
+/** Write every registered metrics source to out (Prometheus text). */
+void host_metrics_write(FILE *out);
+
+#endif /* HOST_PORT_H */
@@ -0,0 +1,14 @@
+/*
+ * Host port: NVS partitions are subdirectories of the state directory
+ * (see nvs.h)
+ */
+
+#ifndef HOST_NVS_FLASH_H
+#define HOST_NVS_FLASH_H
+
+#include "esp_err.h"
+
+esp_err_t nvs_flash_init_partition(const char *partition_label);
+esp_err_t nvs_flash_erase_partition(const char *part_name);
+
+#endif /* HOST_NVS_FLASH_H */
@@ -0,0 +1,352 @@
+/*
+ * Host port: FreeRTOS tasks and mutexes, esp_timer, logging, the
+ * OpenThread lock and task queue on pthreads — see host_port.h
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_openthread.h"
+#include "esp_openthread_lock.h"
+#include "esp_openthread_task_queue.h"
+#include "esp_timer.h"
+
+#include "host_port.h"
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    char name[16];
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint32_t notify_count;
+};
+
+int host_log_debug = 0;
+
+static struct timespec s_start;
+static __thread struct host_task *s_self;
+
+struct host_semaphore {
+    pthread_mutex_t mutex;
+};
+
+struct host_timer {
+    esp_timer_create_args_t args;
+    uint64_t timeout_us;
+};
+
+struct queued_task {
+    struct queued_task *next;
+    esp_openthread_task_t fn;
+    void *arg;
+};
+
+static otInstance *s_instance;
+static pthread_mutex_t s_ot_lock;
+static pthread_t s_mainloop_thread;
+static int s_wake_pipe[2] = { -1, -1 };
+
+static pthread_mutex_t s_queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct queued_task *s_queue_head;
+static struct queued_task **s_queue_tail = &s_queue_head;
+
+/* ------------------------------------------------------------------ */
+/*  Time                                                               */
+/* ------------------------------------------------------------------ */
+
+__attribute__((constructor)) static void record_start(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &s_start);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - s_start.tv_sec) * 1000000 +
+           (now.tv_nsec - s_start.tv_nsec) / 1000;
+}
+
+/* One thread per start: the few timers here fire once or twice */
+static void *timer_thread(void *arg)
+{
+    struct host_timer *timer = arg;
+    struct timespec ts = {
+        .tv_sec = (time_t)(timer->timeout_us / 1000000),
+        .tv_nsec = (long)(timer->timeout_us % 1000000) * 1000,
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+    timer->args.callback(timer->args.arg);
+    return NULL;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out)
+{
+    struct host_timer *timer = calloc(1, sizeof(*timer));
+    if (timer == NULL) return ESP_ERR_NO_MEM;
+    timer->args = *args;
+    *out = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    pthread_t thread;
+    timer->timeout_us = timeout_us;
+    if (pthread_create(&thread, NULL, timer_thread, timer) != 0) return ESP_ERR_NO_MEM;
+    pthread_detach(thread);
+    return ESP_OK;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+/* Absolute CLOCK_REALTIME deadline ticks from now, for timed waits */
+static struct timespec deadline_after(TickType_t ticks)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ticks / 1000;
+    ts.tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:                     return "ESP_OK";
+    case ESP_FAIL:                   return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:             return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:      return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:       return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:          return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_TIMEOUT:            return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND:      return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_INVALID_HANDLE: return "ESP_ERR_NVS_INVALID_HANDLE";
+    case ESP_ERR_NVS_INVALID_NAME:   return "ESP_ERR_NVS_INVALID_NAME";
+    case ESP_ERR_NVS_INVALID_LENGTH: return "ESP_ERR_NVS_INVALID_LENGTH";
+    case ESP_ERR_NVS_NO_FREE_PAGES:  return "ESP_ERR_NVS_NO_FREE_PAGES";
+    case ESP_ERR_NVS_NEW_VERSION_FOUND: return "ESP_ERR_NVS_NEW_VERSION_FOUND";
+    default:                         return "ESP_ERR_UNKNOWN";
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Tasks                                                              */
+/* ------------------------------------------------------------------ */
+
+static void *task_trampoline(void *arg)
+{
+    s_self = arg;
+    pthread_setname_np(pthread_self(), s_self->name);
+    s_self->fn(s_self->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *created)
+{
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task == NULL) return pdFAIL;
+
+    task->fn = fn;
+    task->arg = arg;
+    strncpy(task->name, name, sizeof(task->name) - 1);
+    pthread_mutex_init(&task->mutex, NULL);
+    pthread_cond_init(&task->cond, NULL);
+
+    if (pthread_create(&task->thread, NULL, task_trampoline, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+
+    if (created != NULL) *created = task;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    /* Only self-deletion is used; the handle stays valid for notifies */
+    if (task == NULL || task == s_self) pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = { .tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->mutex);
+    task->notify_count++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->mutex);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    struct host_task *self = s_self;
+    struct timespec deadline = deadline_after(ticks_to_wait);
+
+    pthread_mutex_lock(&self->mutex);
+    while (self->notify_count == 0 && ticks_to_wait != 0) {
+        int rc = ticks_to_wait == portMAX_DELAY
+                     ? pthread_cond_wait(&self->cond, &self->mutex)
+                     : pthread_cond_timedwait(&self->cond, &self->mutex, &deadline);
+        if (rc == ETIMEDOUT) break;
+    }
+    uint32_t count = self->notify_count;
+    if (count > 0) self->notify_count = clear_on_exit ? 0 : count - 1;
+    pthread_mutex_unlock(&self->mutex);
+
+    return count;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Mutex semaphores                                                   */
+/* ------------------------------------------------------------------ */
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    struct host_semaphore *sem = calloc(1, sizeof(*sem));
+    if (sem != NULL) pthread_mutex_init(&sem->mutex, NULL);
+    return sem;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    pthread_mutex_destroy(&sem->mutex);
+    free(sem);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait)
+{
+    if (ticks_to_wait == portMAX_DELAY) return pthread_mutex_lock(&sem->mutex) == 0;
+
+    struct timespec deadline = deadline_after(ticks_to_wait);
+    return pthread_mutex_timedlock(&sem->mutex, &deadline) == 0;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    return pthread_mutex_unlock(&sem->mutex) == 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  OpenThread instance and lock                                       */
+/* ------------------------------------------------------------------ */
+
+void host_port_init(otInstance *instance)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&s_ot_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    if (pipe2(s_wake_pipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+        ESP_LOGE("port", "pipe2: %s", strerror(errno));
+        abort();
+    }
+
+    s_instance = instance;
+    s_mainloop_thread = pthread_self();
+    pthread_mutex_lock(&s_ot_lock);
+}
+
+otInstance *esp_openthread_get_instance(void)
+{
+    return s_instance;
+}
+
+bool esp_openthread_lock_acquire(TickType_t block_ticks)
+{
+    if (block_ticks == portMAX_DELAY) return pthread_mutex_lock(&s_ot_lock) == 0;
+
+    struct timespec deadline = deadline_after(block_ticks);
+    return pthread_mutex_timedlock(&s_ot_lock, &deadline) == 0;
+}
+
+static void wake_mainloop(void)
+{
+    char c = 0;
+    (void)!write(s_wake_pipe[1], &c, 1);
+}
+
+void esp_openthread_lock_release(void)
+{
+    pthread_mutex_unlock(&s_ot_lock);
+
+    if (!pthread_equal(pthread_self(), s_mainloop_thread)) wake_mainloop();
+}
+
+esp_err_t esp_openthread_task_queue_post(esp_openthread_task_t task, void *arg)
+{
+    struct queued_task *t = malloc(sizeof(*t));
+    if (t == NULL) return ESP_ERR_NO_MEM;
+    t->next = NULL;
+    t->fn = task;
+    t->arg = arg;
+
+    pthread_mutex_lock(&s_queue_lock);
+    *s_queue_tail = t;
+    s_queue_tail = &t->next;
+    pthread_mutex_unlock(&s_queue_lock);
+
+    wake_mainloop();
+    return ESP_OK;
+}
+
+int host_port_wake_fd(void)
+{
+    return s_wake_pipe[0];
+}
+
+void host_port_drain_wake(void)
+{
+    char buf[64];
+    while (read(s_wake_pipe[0], buf, sizeof(buf)) > 0) {
+    }
+
+    pthread_mutex_lock(&s_queue_lock);
+    struct queued_task *t = s_queue_head;
+    s_queue_head = NULL;
+    s_queue_tail = &s_queue_head;
+    pthread_mutex_unlock(&s_queue_lock);
+
+    while (t != NULL) {
+        struct queued_task *next = t->next;
+        t->fn(t->arg);
+        free(t);
+        t = next;
+    }
+}
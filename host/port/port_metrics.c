@@ -0,0 +1,97 @@
+/*
+ * Host port: metrics sources printed to a stdio stream instead of the
+ * HTTP endpoint — see metrics.h
+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "esp_log.h"
+
+#include "host_port.h"
+#include "metrics.h"
+
+static const char *TAG = "metrics";
+
+#define METRICS_MAX_SOURCES     8
+
+struct metrics_writer {
+    FILE *out;
+};
+
+static portMUX_TYPE s_sources_lock = portMUX_INITIALIZER_UNLOCKED;
+static metrics_source_fn s_sources[METRICS_MAX_SOURCES];
+static int s_num_sources;
+
+void metrics_printf(metrics_writer_t *w, const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vfprintf(w->out, fmt, ap);
+    va_end(ap);
+}
+
+void metrics_header(metrics_writer_t *w, const char *name,
+                    const char *type, const char *help)
+{
+    metrics_printf(w, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void metrics_sample(metrics_writer_t *w, const char *name,
+                    const char *labels, uint64_t value)
+{
+    if (labels != NULL) {
+        metrics_printf(w, "%s{%s} %llu\n", name, labels, (unsigned long long)value);
+    } else {
+        metrics_printf(w, "%s %llu\n", name, (unsigned long long)value);
+    }
+}
+
+void metrics_counter(metrics_writer_t *w, const char *name,
+                     const char *help, uint64_t value)
+{
+    metrics_header(w, name, "counter", help);
+    metrics_sample(w, name, NULL, value);
+}
+
+void metrics_gauge(metrics_writer_t *w, const char *name,
+                   const char *help, uint64_t value)
+{
+    metrics_header(w, name, "gauge", help);
+    metrics_sample(w, name, NULL, value);
+}
+
+void metrics_register_source(metrics_source_fn fn)
+{
+    taskENTER_CRITICAL(&s_sources_lock);
+    bool full = s_num_sources >= METRICS_MAX_SOURCES;
+    if (!full) s_sources[s_num_sources++] = fn;
+    taskEXIT_CRITICAL(&s_sources_lock);
+
+    if (full) ESP_LOGW(TAG, "Too many metrics sources");
+}
+
+void metrics_start(void)
+{
+}
+
+uint32_t metrics_task_queue_drops(void)
+{
+    return 0;
+}
+
+void host_metrics_write(FILE *out)
+{
+    metrics_writer_t w = { .out = out };
+
+    taskENTER_CRITICAL(&s_sources_lock);
+    int num_sources = s_num_sources;
+    taskEXIT_CRITICAL(&s_sources_lock);
+    for (int i = 0; i < num_sources; i++) {
+        s_sources[i](&w);
+    }
+    fflush(out);
+}
@@ -0,0 +1,313 @@
+/*
+ * Host port: file-backed NVS blobs — see nvs.h and nvs_flash.h
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#include "host_port.h"
+
+static const char *TAG = "nvs";
+
+/* NVS limits namespace and key names to 15 characters */
+#define NVS_NAME_MAX            15
+#define NVS_MAX_HANDLES         8
+
+typedef struct {
+    char part[NVS_NAME_MAX + 1];
+    char ns[NVS_NAME_MAX + 1];
+    nvs_open_mode_t mode;
+    bool used;
+} handle_t;
+
+struct host_nvs_iterator {
+    DIR *dir;
+    char ns[NVS_NAME_MAX + 1];
+    nvs_entry_info_t info;
+};
+
+static char s_dir[PATH_MAX] = ".";
+static handle_t s_handles[NVS_MAX_HANDLES];
+
+static void part_dir(const char *part, char *path, size_t size)
+{
+    if (strcmp(part, NVS_DEFAULT_PART_NAME) == 0) {
+        snprintf(path, size, "%s", s_dir);
+    } else {
+        snprintf(path, size, "%s/%s", s_dir, part);
+    }
+}
+
+/* Remove the blobs in dir whose names start with prefix ("" for all),
+ * and with subdirs, the partitions below it too.                      */
+static esp_err_t erase_dir(const char *dir, const char *prefix, bool subdirs)
+{
+    DIR *d = opendir(dir);
+    if (d == NULL) return errno == ENOENT ? ESP_OK : ESP_FAIL;
+
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') continue;
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        if (e->d_type == DT_DIR) {
+            if (subdirs) erase_dir(path, "", false);
+        } else if (strncmp(e->d_name, prefix, strlen(prefix)) == 0) {
+            unlink(path);
+        }
+    }
+    closedir(d);
+    return ESP_OK;
+}
+
+esp_err_t host_nvs_init(const char *dir, bool erase)
+{
+    snprintf(s_dir, sizeof(s_dir), "%s", dir);
+    if (mkdir(s_dir, 0755) != 0 && errno != EEXIST) {
+        ESP_LOGE(TAG, "mkdir %s: %s", s_dir, strerror(errno));
+        return ESP_FAIL;
+    }
+    if (!erase) return ESP_OK;
+
+    if (erase_dir(s_dir, "", true) != ESP_OK) return ESP_FAIL;
+    ESP_LOGI(TAG, "Erased state in %s", s_dir);
+    return ESP_OK;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Partitions                                                         */
+/* ------------------------------------------------------------------ */
+
+esp_err_t nvs_flash_init_partition(const char *partition_label)
+{
+    char path[PATH_MAX];
+    part_dir(partition_label, path, sizeof(path));
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+        ESP_LOGE(TAG, "mkdir %s: %s", path, strerror(errno));
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase_partition(const char *part_name)
+{
+    char path[PATH_MAX];
+    part_dir(part_name, path, sizeof(path));
+    return erase_dir(path, "", false);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Handles and blobs                                                  */
+/* ------------------------------------------------------------------ */
+
+static handle_t *lookup(nvs_handle_t handle)
+{
+    if (handle == 0 || handle > NVS_MAX_HANDLES || !s_handles[handle - 1].used) return NULL;
+    return &s_handles[handle - 1];
+}
+
+static esp_err_t blob_path(const handle_t *h, const char *key, char *path, size_t size)
+{
+    if (strlen(key) > NVS_NAME_MAX) return ESP_ERR_NVS_INVALID_NAME;
+
+    char dir[PATH_MAX];
+    part_dir(h->part, dir, sizeof(dir));
+    snprintf(path, size, "%s/%s.%s", dir, h->ns, key);
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    return nvs_open_from_partition(NVS_DEFAULT_PART_NAME, name, open_mode, out_handle);
+}
+
+esp_err_t nvs_open_from_partition(const char *part_name, const char *name,
+                                  nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    if (strlen(part_name) > NVS_NAME_MAX || strlen(name) > NVS_NAME_MAX) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+
+    for (int i = 0; i < NVS_MAX_HANDLES; i++) {
+        if (s_handles[i].used) continue;
+        snprintf(s_handles[i].part, sizeof(s_handles[i].part), "%s", part_name);
+        snprintf(s_handles[i].ns, sizeof(s_handles[i].ns), "%s", name);
+        s_handles[i].mode = open_mode;
+        s_handles[i].used = true;
+        *out_handle = (nvs_handle_t)(i + 1);
+        return ESP_OK;
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    handle_t *h = lookup(handle);
+    if (h != NULL) h->used = false;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    handle_t *h = lookup(handle);
+    if (h == NULL) return ESP_ERR_NVS_INVALID_HANDLE;
+
+    char path[PATH_MAX];
+    esp_err_t err = blob_path(h, key, path, sizeof(path));
+    if (err != ESP_OK) return err;
+
+    struct stat st;
+    if (stat(path, &st) != 0) return ESP_ERR_NVS_NOT_FOUND;
+
+    size_t size = (size_t)st.st_size;
+    if (out_value == NULL) {
+        *length = size;
+        return ESP_OK;
+    }
+    if (*length < size) {
+        *length = size;
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return ESP_ERR_NVS_NOT_FOUND;
+    size_t n = fread(out_value, 1, size, f);
+    fclose(f);
+    if (n != size) return ESP_FAIL;
+
+    *length = size;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    handle_t *h = lookup(handle);
+    if (h == NULL || h->mode != NVS_READWRITE) return ESP_ERR_NVS_INVALID_HANDLE;
+
+    char path[PATH_MAX];
+    char tmp[PATH_MAX + 4];
+    esp_err_t err = blob_path(h, key, path, sizeof(path));
+    if (err != ESP_OK) return err;
+
+    /* Write-then-rename, so a killed process leaves the old blob */
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL) return ESP_FAIL;
+    size_t n = fwrite(value, 1, length, f);
+    if (fclose(f) != 0 || n != length || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    handle_t *h = lookup(handle);
+    if (h == NULL || h->mode != NVS_READWRITE) return ESP_ERR_NVS_INVALID_HANDLE;
+
+    char path[PATH_MAX];
+    esp_err_t err = blob_path(h, key, path, sizeof(path));
+    if (err != ESP_OK) return err;
+
+    return unlink(path) == 0 ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+    handle_t *h = lookup(handle);
+    if (h == NULL || h->mode != NVS_READWRITE) return ESP_ERR_NVS_INVALID_HANDLE;
+
+    char dir[PATH_MAX];
+    char prefix[NVS_NAME_MAX + 2];
+    part_dir(h->part, dir, sizeof(dir));
+    snprintf(prefix, sizeof(prefix), "%s.", h->ns);
+    return erase_dir(dir, prefix, false);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return lookup(handle) != NULL ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Iterators                                                          */
+/* ------------------------------------------------------------------ */
+
+/* Move to the next blob of the iterator's namespace */
+static bool iterator_advance(struct host_nvs_iterator *it)
+{
+    size_t ns_len = strlen(it->ns);
+    struct dirent *e;
+
+    while ((e = readdir(it->dir)) != NULL) {
+        const char *name = e->d_name;
+        size_t len = strlen(name);
+        if (e->d_type == DT_DIR || strncmp(name, it->ns, ns_len) != 0 || name[ns_len] != '.') {
+            continue;
+        }
+        if (len > 4 && strcmp(name + len - 4, ".tmp") == 0) continue;
+        if (len - ns_len - 1 > NVS_NAME_MAX) continue;
+
+        snprintf(it->info.key, sizeof(it->info.key), "%s", name + ns_len + 1);
+        return true;
+    }
+    return false;
+}
+
+esp_err_t nvs_entry_find(const char *part_name, const char *namespace_name, nvs_type_t type,
+                         nvs_iterator_t *output_iterator)
+{
+    *output_iterator = NULL;
+    if (strlen(namespace_name) > NVS_NAME_MAX) return ESP_ERR_NVS_INVALID_NAME;
+
+    char dir[PATH_MAX];
+    part_dir(part_name, dir, sizeof(dir));
+
+    struct host_nvs_iterator *it = calloc(1, sizeof(*it));
+    if (it == NULL) return ESP_ERR_NO_MEM;
+    it->dir = opendir(dir);
+    snprintf(it->ns, sizeof(it->ns), "%s", namespace_name);
+    snprintf(it->info.namespace_name, sizeof(it->info.namespace_name), "%s", namespace_name);
+    it->info.type = NVS_TYPE_BLOB;
+
+    if (it->dir == NULL || !iterator_advance(it)) {
+        nvs_release_iterator(it);
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *output_iterator = it;
+    return ESP_OK;
+}
+
+esp_err_t nvs_entry_next(nvs_iterator_t *iterator)
+{
+    if (*iterator == NULL) return ESP_ERR_INVALID_ARG;
+    if (iterator_advance(*iterator)) return ESP_OK;
+
+    nvs_release_iterator(*iterator);
+    *iterator = NULL;
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_entry_info(const nvs_iterator_t iterator, nvs_entry_info_t *out_info)
+{
+    if (iterator == NULL) return ESP_ERR_INVALID_ARG;
+    *out_info = iterator->info;
+    return ESP_OK;
+}
+
+void nvs_release_iterator(nvs_iterator_t iterator)
+{
+    if (iterator == NULL) return;
+    if (iterator->dir != NULL) closedir(iterator->dir);
+    free(iterator);
+}
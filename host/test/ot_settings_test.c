@@ -0,0 +1,243 @@
+/*
+ * Host test for the ot_settings write coalescing: a settings wipe and a
+ * new write of the same key while the background flusher is writing the
+ * value from before the wipe.  The new value must reach flash.
+ *
+ * The real OpenThread settings backend is replaced by an in-memory one
+ * whose writes can be held, so the test controls when the flusher's
+ * write completes.  Takes about two OT_SETTINGS_COALESCE_MS.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "openthread/error.h"
+#include "openthread/instance.h"
+#include "openthread/platform/settings.h"
+
+#include "config.h"
+#include "host_port.h"
+#include "ot_settings.h"
+
+#define CHECK(cond) do {                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                        \
+        }                                                                   \
+    } while (0)
+
+/* Longest wait for the flusher: one coalescing delay plus slack */
+#define FLUSH_WAIT_MS           (OT_SETTINGS_COALESCE_MS + 2000)
+
+#define FLASH_KEYS              32
+#define FLASH_VALUE_MAX         64
+
+/* ------------------------------------------------------------------ */
+/*  In-memory settings backend (the __real_ side of the wrappers)      */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    bool present;
+    uint16_t len;
+    uint8_t data[FLASH_VALUE_MAX];
+} flash_value_t;
+
+static pthread_mutex_t s_flash_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_flash_cond = PTHREAD_COND_INITIALIZER;
+static flash_value_t s_flash[FLASH_KEYS];
+static bool s_hold_writes;
+static bool s_write_held;           /* a write is waiting in __real_..Set */
+
+otError __real_otPlatSettingsGet(otInstance *aInstance, uint16_t aKey, int aIndex,
+                                 uint8_t *aValue, uint16_t *aValueLength)
+{
+    otError err = OT_ERROR_NOT_FOUND;
+
+    pthread_mutex_lock(&s_flash_lock);
+    if (aKey < FLASH_KEYS && aIndex == 0 && s_flash[aKey].present) {
+        if (aValue && aValueLength) {
+            memcpy(aValue, s_flash[aKey].data,
+                   *aValueLength < s_flash[aKey].len ? *aValueLength : s_flash[aKey].len);
+        }
+        if (aValueLength) *aValueLength = s_flash[aKey].len;
+        err = OT_ERROR_NONE;
+    }
+    pthread_mutex_unlock(&s_flash_lock);
+    return err;
+}
+
+otError __real_otPlatSettingsSet(otInstance *aInstance, uint16_t aKey,
+                                 const uint8_t *aValue, uint16_t aValueLength)
+{
+    if (aKey >= FLASH_KEYS || aValueLength > FLASH_VALUE_MAX) return OT_ERROR_NO_BUFS;
+
+    pthread_mutex_lock(&s_flash_lock);
+    while (s_hold_writes) {
+        s_write_held = true;
+        pthread_cond_broadcast(&s_flash_cond);
+        pthread_cond_wait(&s_flash_cond, &s_flash_lock);
+    }
+    s_write_held = false;
+    s_flash[aKey].present = true;
+    s_flash[aKey].len = aValueLength;
+    memcpy(s_flash[aKey].data, aValue, aValueLength);
+    pthread_cond_broadcast(&s_flash_cond);
+    pthread_mutex_unlock(&s_flash_lock);
+    return OT_ERROR_NONE;
+}
+
+otError __real_otPlatSettingsAdd(otInstance *aInstance, uint16_t aKey,
+                                 const uint8_t *aValue, uint16_t aValueLength)
+{
+    return __real_otPlatSettingsSet(aInstance, aKey, aValue, aValueLength);
+}
+
+otError __real_otPlatSettingsDelete(otInstance *aInstance, uint16_t aKey, int aIndex)
+{
+    otError err = OT_ERROR_NOT_FOUND;
+
+    pthread_mutex_lock(&s_flash_lock);
+    if (aKey < FLASH_KEYS && s_flash[aKey].present) {
+        s_flash[aKey].present = false;
+        err = OT_ERROR_NONE;
+    }
+    pthread_cond_broadcast(&s_flash_cond);
+    pthread_mutex_unlock(&s_flash_lock);
+    return err;
+}
+
+void __real_otPlatSettingsWipe(otInstance *aInstance)
+{
+    pthread_mutex_lock(&s_flash_lock);
+    memset(s_flash, 0, sizeof(s_flash));
+    pthread_cond_broadcast(&s_flash_cond);
+    pthread_mutex_unlock(&s_flash_lock);
+}
+
+/* The wrappers under test, normally reached through --wrap */
+otError __wrap_otPlatSettingsGet(otInstance *aInstance, uint16_t aKey, int aIndex,
+                                 uint8_t *aValue, uint16_t *aValueLength);
+otError __wrap_otPlatSettingsSet(otInstance *aInstance, uint16_t aKey,
+                                 const uint8_t *aValue, uint16_t aValueLength);
+void __wrap_otPlatSettingsWipe(otInstance *aInstance);
+
+/* ot_profiler isn't part of this test */
+void ot_profiler_note_flash(uint32_t us)
+{
+}
+
+/* ------------------------------------------------------------------ */
+/*  Helpers                                                            */
+/* ------------------------------------------------------------------ */
+
+static struct timespec deadline_ms(int ms)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+/* Wait until the flusher is inside a held write */
+static bool wait_write_held(void)
+{
+    struct timespec deadline = deadline_ms(FLUSH_WAIT_MS);
+    bool held;
+
+    pthread_mutex_lock(&s_flash_lock);
+    while (!s_write_held &&
+           pthread_cond_timedwait(&s_flash_cond, &s_flash_lock, &deadline) == 0) {
+    }
+    held = s_write_held;
+    pthread_mutex_unlock(&s_flash_lock);
+    return held;
+}
+
+static void hold_writes(bool hold)
+{
+    pthread_mutex_lock(&s_flash_lock);
+    s_hold_writes = hold;
+    pthread_cond_broadcast(&s_flash_cond);
+    pthread_mutex_unlock(&s_flash_lock);
+}
+
+/* Wait until flash holds value for key */
+static bool wait_flash_value(uint16_t key, const char *value)
+{
+    struct timespec deadline = deadline_ms(2 * FLUSH_WAIT_MS);
+    bool match;
+
+    pthread_mutex_lock(&s_flash_lock);
+    for (;;) {
+        match = s_flash[key].present && s_flash[key].len == strlen(value) &&
+                memcmp(s_flash[key].data, value, s_flash[key].len) == 0;
+        if (match || pthread_cond_timedwait(&s_flash_cond, &s_flash_lock, &deadline) != 0) break;
+    }
+    pthread_mutex_unlock(&s_flash_lock);
+    return match;
+}
+
+static otError set_string(uint16_t key, const char *value)
+{
+    return __wrap_otPlatSettingsSet(NULL, key, (const uint8_t *)value, (uint16_t)strlen(value));
+}
+
+static bool get_matches(uint16_t key, const char *value)
+{
+    uint8_t buf[FLASH_VALUE_MAX];
+    uint16_t len = sizeof(buf);
+
+    return __wrap_otPlatSettingsGet(NULL, key, 0, buf, &len) == OT_ERROR_NONE &&
+           len == strlen(value) && memcmp(buf, value, len) == 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Test                                                               */
+/* ------------------------------------------------------------------ */
+
+int main(void)
+{
+    const uint16_t key = OT_SETTINGS_KEY_PARENT_INFO;   /* deferrable */
+
+    char dir[] = "/tmp/ot_settings_test.XXXXXX";
+    CHECK(mkdtemp(dir) != NULL);
+    CHECK(host_nvs_init(dir, false) == ESP_OK);
+    CHECK(ot_settings_init() == ESP_OK);
+
+    /* Deferred write; the flusher picks it up and is held mid-write */
+    hold_writes(true);
+    CHECK(set_string(key, "before") == OT_ERROR_NONE);
+    CHECK(wait_write_held());
+
+    /* Wipe, then write the key again before that write completes */
+    __wrap_otPlatSettingsWipe(NULL);
+    CHECK(set_string(key, "after") == OT_ERROR_NONE);
+    CHECK(get_matches(key, "after"));
+
+    /* The flusher deletes its stale copy and writes the new value */
+    hold_writes(false);
+    CHECK(wait_flash_value(key, "after"));
+    CHECK(get_matches(key, "after"));
+
+    ot_settings_stats_t stats;
+    ot_settings_get_stats(&stats);
+    CHECK(stats.flushed == 1);
+
+    char part[sizeof(dir) + sizeof(OT_SETTINGS_PARTITION)];
+    snprintf(part, sizeof(part), "%s/%s", dir, OT_SETTINGS_PARTITION);
+    host_nvs_init(dir, true);
+    rmdir(part);
+    rmdir(dir);
+    printf("ot_settings wipe during flush: ok\n");
+    return 0;
+}
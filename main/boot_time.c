@@ -0,0 +1,77 @@
+/*
+ * Boot phase timestamps — see boot_time.h
+ */
+
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "boot_time.h"
+
+static const char *TAG = "boot";
+
+static const char *const s_phase_names[BOOT_PHASE_COUNT] = {
+    [BOOT_PHASE_OT_INIT]         = "ot_init",
+    [BOOT_PHASE_THREAD_START]    = "thread_start",
+    [BOOT_PHASE_THREAD_ATTACHED] = "thread_attached",
+    [BOOT_PHASE_THREAD_ROUTER]   = "thread_router",
+    [BOOT_PHASE_WIFI_CONNECTED]  = "wifi_connected",
+    [BOOT_PHASE_WIFI_IPV6]       = "wifi_ipv6",
+    [BOOT_PHASE_BR_READY]        = "br_ready",
+};
+
+static int64_t s_phase_us[BOOT_PHASE_COUNT] = {
+    [0 ... BOOT_PHASE_COUNT - 1] = -1,
+};
+static bool s_summary_logged = false;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void log_summary(void)
+{
+    ESP_LOGI(TAG, "Boot summary: thread_router=%lld ms, br_ready=%lld ms "
+             "(ot_init=%lld, wifi_connected=%lld, wifi_ipv6=%lld)",
+             (long long)(s_phase_us[BOOT_PHASE_THREAD_ROUTER] / 1000),
+             (long long)(s_phase_us[BOOT_PHASE_BR_READY] / 1000),
+             (long long)(s_phase_us[BOOT_PHASE_OT_INIT] / 1000),
+             (long long)(s_phase_us[BOOT_PHASE_WIFI_CONNECTED] / 1000),
+             (long long)(s_phase_us[BOOT_PHASE_WIFI_IPV6] / 1000));
+}
+
+void boot_time_mark(boot_phase_t phase)
+{
+    if (phase >= BOOT_PHASE_COUNT) return;
+
+    int64_t now = esp_timer_get_time();
+    bool first = false;
+    bool summary = false;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (s_phase_us[phase] < 0) {
+        s_phase_us[phase] = now;
+        first = true;
+        if (!s_summary_logged &&
+            s_phase_us[BOOT_PHASE_THREAD_ROUTER] >= 0 &&
+            s_phase_us[BOOT_PHASE_BR_READY] >= 0) {
+            s_summary_logged = true;
+            summary = true;
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (first) {
+        ESP_LOGI(TAG, "%s reached at %lld ms", s_phase_names[phase], (long long)(now / 1000));
+    }
+    if (summary) {
+        log_summary();
+    }
+}
+
+int64_t boot_time_get_us(boot_phase_t phase)
+{
+    if (phase >= BOOT_PHASE_COUNT) return -1;
+    return s_phase_us[phase];
+}
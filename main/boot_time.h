@@ -0,0 +1,37 @@
+/*
+ * Boot phase timestamps
+ *
+ * Records the first time each startup phase is reached (microseconds
+ * since power-on) and logs it, so time-to-router can be compared
+ * across firmware versions from the serial log alone.
+ */
+
+#ifndef BOOT_TIME_H
+#define BOOT_TIME_H
+
+#include <stdint.h>
+
+typedef enum {
+    BOOT_PHASE_OT_INIT = 0,     /* OpenThread stack + 802.15.4 radio up  */
+    BOOT_PHASE_THREAD_START,    /* Dataset loaded, Thread enabled        */
+    BOOT_PHASE_THREAD_ATTACHED, /* First child/router/leader role        */
+    BOOT_PHASE_THREAD_ROUTER,   /* First router/leader role              */
+    BOOT_PHASE_WIFI_CONNECTED,  /* Backbone associated and has IPv4      */
+    BOOT_PHASE_WIFI_IPV6,       /* Backbone IPv6 link-local ready        */
+    BOOT_PHASE_BR_READY,        /* Border routing attached to backbone   */
+    BOOT_PHASE_COUNT
+} boot_phase_t;
+
+/**
+ * Record that a boot phase was reached.  Only the first call per phase
+ * is kept; later calls are ignored.  Safe to call from any task.
+ */
+void boot_time_mark(boot_phase_t phase);
+
+/**
+ * Timestamp (µs since boot) at which a phase was first reached,
+ * or -1 if it has not been reached yet.
+ */
+int64_t boot_time_get_us(boot_phase_t phase);
+
+#endif /* BOOT_TIME_H */
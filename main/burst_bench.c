@@ -0,0 +1,214 @@
+/*
+ * Forwarding burst benchmark — see burst_bench.h
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/inet.h"
+#include "lwip/sockets.h"
+
+#include "burst_bench.h"
+#include "metrics.h"
+
+static const char *TAG = "burst";
+
+#define BENCH_ECHO_ID       0x07b7
+#define BENCH_DRAIN_MS      2000    /* wait for replies after the last send */
+#define BENCH_RECV_BUF      1500
+
+#define ICMP6_TYPE_ECHO_REQUEST 128
+#define ICMP6_TYPE_ECHO_REPLY   129
+#define IP6_HEADER_LEN          40
+#define IP6_NEXT_HEADER_ICMP6   58
+
+typedef struct __attribute__((packed)) {
+    uint8_t  type;
+    uint8_t  code;
+    uint16_t checksum;      /* filled in by lwIP for raw ICMPv6 sockets */
+    uint16_t id;
+    uint16_t seq;
+} echo_hdr_t;
+
+typedef struct {
+    struct sockaddr_in6 dest;
+    uint32_t count;
+    uint32_t size;
+} bench_args_t;
+
+static volatile bool s_running = false;
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Match pending echo replies to their sequence numbers and record RTTs */
+static void drain_replies(int sock, uint8_t *buf, int64_t *sent_us,
+                          uint32_t *rtt_us, uint32_t count, uint32_t *received, int flags)
+{
+    for (;;) {
+        int len = recvfrom(sock, buf, BENCH_RECV_BUF, flags, NULL, NULL);
+        if (len <= 0) return;
+
+        int64_t now = esp_timer_get_time();
+        int off = 0;
+
+        /* Some lwIP versions hand raw IPv6 sockets the IP header too */
+        if (len >= IP6_HEADER_LEN + (int)sizeof(echo_hdr_t) &&
+            (buf[0] >> 4) == 6 && buf[6] == IP6_NEXT_HEADER_ICMP6) {
+            off = IP6_HEADER_LEN;
+        }
+        if (len - off < (int)sizeof(echo_hdr_t)) continue;
+
+        echo_hdr_t hdr;
+        memcpy(&hdr, buf + off, sizeof(hdr));
+        if (hdr.type != ICMP6_TYPE_ECHO_REPLY || ntohs(hdr.id) != BENCH_ECHO_ID) continue;
+
+        uint16_t seq = ntohs(hdr.seq);
+        if (seq >= count || sent_us[seq] < 0 || rtt_us[seq] != UINT32_MAX) continue;
+
+        rtt_us[seq] = (uint32_t)(now - sent_us[seq]);
+        (*received)++;
+    }
+}
+
+static void burst_bench_task(void *arg)
+{
+    bench_args_t *args = (bench_args_t *)arg;
+    const uint32_t count = args->count;
+    const size_t pkt_len = sizeof(echo_hdr_t) + args->size;
+
+    int64_t  *sent_us = malloc(count * sizeof(*sent_us));
+    uint32_t *rtt_us  = malloc(count * sizeof(*rtt_us));
+    uint8_t  *pkt     = calloc(1, pkt_len);
+    uint8_t  *rx      = malloc(BENCH_RECV_BUF);
+    int sock = -1;
+
+    if (!sent_us || !rtt_us || !pkt || !rx) {
+        ESP_LOGE(TAG, "Out of memory for %lu packets", (unsigned long)count);
+        goto exit;
+    }
+
+    sock = socket(AF_INET6, SOCK_RAW, IPPROTO_ICMPV6);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Failed to open raw ICMPv6 socket: %d", errno);
+        goto exit;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        sent_us[i] = -1;
+        rtt_us[i] = UINT32_MAX;
+    }
+    for (size_t i = sizeof(echo_hdr_t); i < pkt_len; i++) {
+        pkt[i] = (uint8_t)i;
+    }
+
+    uint32_t drops_before = metrics_task_queue_drops();
+    uint32_t send_errors = 0;
+    uint32_t received = 0;
+
+    /* ----- Burst: send back-to-back, picking up early replies ----- */
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < count; i++) {
+        echo_hdr_t hdr = {
+            .type = ICMP6_TYPE_ECHO_REQUEST,
+            .id = htons(BENCH_ECHO_ID),
+            .seq = htons((uint16_t)i),
+        };
+        memcpy(pkt, &hdr, sizeof(hdr));
+
+        sent_us[i] = esp_timer_get_time();
+        if (sendto(sock, pkt, pkt_len, 0, (struct sockaddr *)&args->dest,
+                   sizeof(args->dest)) < 0) {
+            sent_us[i] = -1;
+            send_errors++;
+        }
+        drain_replies(sock, rx, sent_us, rtt_us, count, &received, MSG_DONTWAIT);
+    }
+    int64_t send_us = esp_timer_get_time() - start;
+
+    /* ----- Drain: wait for late replies ----- */
+    struct timeval tv = { .tv_sec = 0, .tv_usec = 100 * 1000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    int64_t deadline = esp_timer_get_time() + BENCH_DRAIN_MS * 1000;
+    while (received + send_errors < count && esp_timer_get_time() < deadline) {
+        drain_replies(sock, rx, sent_us, rtt_us, count, &received, 0);
+    }
+
+    uint32_t queue_drops = metrics_task_queue_drops() - drops_before;
+
+    /* ----- Report ----- */
+    uint32_t lost = count - received;
+    ESP_LOGI(TAG, "Burst of %lu x %u B in %lld ms (%lu pkt/s offered)",
+             (unsigned long)count, (unsigned)args->size, send_us / 1000,
+             send_us > 0 ? (unsigned long)(count * 1000000ULL / send_us) : 0UL);
+    ESP_LOGI(TAG, "  lost %lu/%lu (%lu.%lu %%): send errors %lu, task-queue drops %lu",
+             (unsigned long)lost, (unsigned long)count,
+             (unsigned long)(lost * 100 / count), (unsigned long)(lost * 1000 / count % 10),
+             (unsigned long)send_errors, (unsigned long)queue_drops);
+
+    if (received > 0) {
+        /* Compact the measured RTTs to the front and sort for percentiles */
+        uint32_t n = 0;
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            if (rtt_us[i] == UINT32_MAX) continue;
+            rtt_us[n++] = rtt_us[i];
+            sum += rtt_us[i];
+        }
+        qsort(rtt_us, n, sizeof(rtt_us[0]), cmp_u32);
+        ESP_LOGI(TAG, "  rtt ms: min %lu.%03lu avg %lu.%03lu p50 %lu.%03lu "
+                 "p99 %lu.%03lu max %lu.%03lu",
+                 (unsigned long)(rtt_us[0] / 1000), (unsigned long)(rtt_us[0] % 1000),
+                 (unsigned long)(sum / n / 1000), (unsigned long)(sum / n % 1000),
+                 (unsigned long)(rtt_us[n / 2] / 1000), (unsigned long)(rtt_us[n / 2] % 1000),
+                 (unsigned long)(rtt_us[n * 99 / 100] / 1000),
+                 (unsigned long)(rtt_us[n * 99 / 100] % 1000),
+                 (unsigned long)(rtt_us[n - 1] / 1000), (unsigned long)(rtt_us[n - 1] % 1000));
+    }
+
+exit:
+    if (sock >= 0) close(sock);
+    free(sent_us);
+    free(rtt_us);
+    free(pkt);
+    free(rx);
+    free(args);
+    s_running = false;
+    vTaskDelete(NULL);
+}
+
+esp_err_t burst_bench_start(const char *ipv6_addr, uint32_t count, uint32_t size)
+{
+    if (count == 0 || count > BURST_BENCH_MAX_COUNT || size > BURST_BENCH_MAX_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_running) return ESP_ERR_INVALID_STATE;
+
+    bench_args_t *args = calloc(1, sizeof(*args));
+    if (args == NULL) return ESP_ERR_NO_MEM;
+
+    args->dest.sin6_family = AF_INET6;
+    if (inet_pton(AF_INET6, ipv6_addr, &args->dest.sin6_addr) != 1) {
+        free(args);
+        return ESP_ERR_INVALID_ARG;
+    }
+    args->count = count;
+    args->size = size;
+
+    s_running = true;
+    if (xTaskCreate(burst_bench_task, "burst_bench", 4096, args, 4, NULL) != pdPASS) {
+        s_running = false;
+        free(args);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,30 @@
+/*
+ * Forwarding burst benchmark
+ *
+ * Sends a back-to-back burst of ICMPv6 echo requests from the border
+ * router's lwIP stack to a Thread device, so every packet crosses the
+ * lwIP → OpenThread netif glue queues at once.  Reports loss, per-
+ * packet round-trip latency and task-queue drops seen during the run.
+ * Run it before and after changing OT_NETIF_QUEUE_SIZE/OT_TASK_QUEUE_SIZE.
+ */
+
+#ifndef BURST_BENCH_H
+#define BURST_BENCH_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define BURST_BENCH_DEFAULT_COUNT   100
+#define BURST_BENCH_DEFAULT_SIZE    64
+#define BURST_BENCH_MAX_COUNT       1000
+#define BURST_BENCH_MAX_SIZE        1232    /* IPv6 min MTU - headers */
+
+/**
+ * Start a burst towards an IPv6 address in the background; results are
+ * logged when it finishes.  Returns ESP_ERR_INVALID_STATE if a run is
+ * already in progress and ESP_ERR_INVALID_ARG for bad arguments.
+ */
+esp_err_t burst_bench_start(const char *ipv6_addr, uint32_t count, uint32_t size);
+
+#endif /* BURST_BENCH_H */
@@ -0,0 +1,467 @@
+/*
+ * Thread channel planning — see channel_plan.h
+ */
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "esp_openthread.h"
+#include "esp_openthread_lock.h"
+#include "esp_openthread_task_queue.h"
+#include "openthread/dataset.h"
+#include "openthread/ip6.h"
+#include "openthread/link.h"
+#include "openthread/thread.h"
+
+#include "config.h"
+#include "channel_plan.h"
+#include "metrics.h"
+
+static const char *TAG = "chan_plan";
+
+/* Per-channel dwell of the energy scan (16 channels → ~5 s total)     */
+#define SCAN_DURATION_MS        300
+#define SCAN_CHANNEL_MASK       (((1UL << CHANNEL_PLAN_COUNT) - 1) << CHANNEL_PLAN_FIRST)
+
+/* Retry interval while waiting for Thread to attach before checking */
+#define EVAL_RETRY_MS           10000
+
+/* A scan this recent is reused instead of scanning again             */
+#define RESCAN_MIN_S            60
+
+/* Channels we never heard anything on */
+#define ENERGY_FLOOR_DBM        (-100)
+
+/* Score penalties (dB) for overlapping the backbone AP: inside its
+ * 20 MHz channel, and within the spectral-mask skirt next to it.      */
+#define AP_INBAND_PENALTY_DB    30
+#define AP_SKIRT_PENALTY_DB     10
+
+/* Many regulatory domains cap 802.15.4 channel 26 at reduced power    */
+#define CHANNEL_26_PENALTY_DB   3
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static int8_t s_energy[CHANNEL_PLAN_COUNT];
+static bool s_scanned = false;
+static int64_t s_scan_done_us = 0;
+static uint8_t s_ap_channel = 0;           /* from the current association */
+static uint8_t s_cached_ap_channel = 0;    /* from the last boot, until then */
+static uint8_t s_thread_channel = 0;
+
+static channel_plan_done_fn s_done;
+static void *s_done_context;
+static TaskHandle_t s_eval_task;
+
+/* A first scan waiting for the AP channel (channel_plan_scan_after_ap) */
+static atomic_bool s_deferred;
+static otInstance *s_deferred_instance;
+static channel_plan_done_fn s_deferred_done;
+static void *s_deferred_context;
+static esp_timer_handle_t s_deferred_timer;
+
+/* ------------------------------------------------------------------ */
+/*  Scoring                                                            */
+/* ------------------------------------------------------------------ */
+
+static int wifi_center_mhz(uint8_t channel)
+{
+    return channel == 14 ? 2484 : 2407 + 5 * channel;
+}
+
+static int thread_center_mhz(uint8_t channel)
+{
+    return 2405 + 5 * (channel - CHANNEL_PLAN_FIRST);
+}
+
+static uint8_t ap_channel_locked(void)
+{
+    return s_ap_channel ? s_ap_channel : s_cached_ap_channel;
+}
+
+/* Overlap with the AP.  Call with s_lock held. */
+static int overlap_locked(uint8_t channel)
+{
+    uint8_t ap_channel = ap_channel_locked();
+    if (ap_channel == 0) return 0;
+
+    int offset = abs(thread_center_mhz(channel) - wifi_center_mhz(ap_channel));
+    if (offset <= 10) return AP_INBAND_PENALTY_DB;
+    if (offset <= 20) return AP_SKIRT_PENALTY_DB;
+    return 0;
+}
+
+/* Overlap with the AP and regulatory penalty.  Call with s_lock held. */
+static int penalty_locked(uint8_t channel)
+{
+    int score = overlap_locked(channel);
+    if (channel == 26) score += CHANNEL_26_PENALTY_DB;
+    return score;
+}
+
+/* Lower is better.  Call with s_lock held. */
+static int score_locked(uint8_t channel)
+{
+    int energy = s_scanned ? s_energy[channel - CHANNEL_PLAN_FIRST] : ENERGY_FLOOR_DBM;
+    return energy + penalty_locked(channel);
+}
+
+static uint8_t best_locked(void)
+{
+    uint8_t ap_channel = ap_channel_locked();
+    uint8_t best = CHANNEL_PLAN_FIRST;
+    int best_score = score_locked(best);
+    int best_distance = 0;
+
+    for (uint8_t ch = CHANNEL_PLAN_FIRST; ch <= CHANNEL_PLAN_LAST; ch++) {
+        int score = score_locked(ch);
+        /* On a tie, keep further away from the AP */
+        int distance = ap_channel ? abs(thread_center_mhz(ch) - wifi_center_mhz(ap_channel)) : 0;
+        if (score < best_score || (score == best_score && distance > best_distance)) {
+            best = ch;
+            best_score = score;
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+uint8_t channel_plan_best(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    uint8_t best = best_locked();
+    taskEXIT_CRITICAL(&s_lock);
+    return best;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Energy scan (OpenThread mainloop)                                  */
+/* ------------------------------------------------------------------ */
+
+static void energy_scan_result(otEnergyScanResult *result, void *context)
+{
+    otInstance *instance = (otInstance *)context;
+
+    if (result != NULL) {
+        if (result->mChannel < CHANNEL_PLAN_FIRST || result->mChannel > CHANNEL_PLAN_LAST) return;
+        int8_t rssi = result->mMaxRssi;
+        if (rssi > 0 || rssi < ENERGY_FLOOR_DBM) rssi = ENERGY_FLOOR_DBM;   /* 127 = invalid */
+        taskENTER_CRITICAL(&s_lock);
+        s_energy[result->mChannel - CHANNEL_PLAN_FIRST] = rssi;
+        taskEXIT_CRITICAL(&s_lock);
+        return;
+    }
+
+    /* NULL result: scan complete */
+    taskENTER_CRITICAL(&s_lock);
+    s_scanned = true;
+    s_scan_done_us = esp_timer_get_time();
+    uint8_t best = best_locked();
+    int best_score = score_locked(best);
+    uint8_t ap_channel = ap_channel_locked();
+    taskEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Energy scan done: best Thread channel %u (score %d, AP on Wi-Fi channel %u)",
+             best, best_score, ap_channel);
+
+    channel_plan_done_fn done = s_done;
+    s_done = NULL;
+    if (done) done(instance, best, s_done_context);
+}
+
+otError channel_plan_scan(otInstance *instance, channel_plan_done_fn done, void *context)
+{
+    if (otLinkIsEnergyScanInProgress(instance)) return OT_ERROR_BUSY;
+
+    /* The MAC only accepts scans while the interface is up */
+    if (!otIp6IsEnabled(instance)) {
+        otError error = otIp6SetEnabled(instance, true);
+        if (error != OT_ERROR_NONE) return error;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < CHANNEL_PLAN_COUNT; i++) s_energy[i] = ENERGY_FLOOR_DBM;
+    taskEXIT_CRITICAL(&s_lock);
+
+    s_done = done;
+    s_done_context = context;
+
+    otError error = otLinkEnergyScan(instance, SCAN_CHANNEL_MASK, SCAN_DURATION_MS,
+                                     energy_scan_result, instance);
+    if (error != OT_ERROR_NONE) {
+        s_done = NULL;
+        return error;
+    }
+    ESP_LOGI(TAG, "Energy scan of channels %d-%d started", CHANNEL_PLAN_FIRST, CHANNEL_PLAN_LAST);
+    return OT_ERROR_NONE;
+}
+
+/* Mainloop: the AP channel is known, or we stopped waiting for it */
+static void deferred_scan_tasklet(void *arg)
+{
+    otInstance *instance = s_deferred_instance;
+    otError error = channel_plan_scan(instance, s_deferred_done, s_deferred_context);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGW(TAG, "Energy scan failed (%d), planning from the AP channel only", error);
+        s_deferred_done(instance, channel_plan_best(), s_deferred_context);
+    }
+}
+
+/* Event loop or esp_timer task: whichever comes first starts the scan */
+static void start_deferred_scan(const char *reason)
+{
+    if (!atomic_exchange(&s_deferred, false)) return;
+
+    ESP_LOGI(TAG, "Planning the Thread channel (%s)", reason);
+    if (esp_openthread_task_queue_post(deferred_scan_tasklet, NULL) != ESP_OK) {
+        ESP_LOGE(TAG, "Task queue full, Thread channel not planned");
+    }
+}
+
+static void deferred_timeout(void *arg)
+{
+    start_deferred_scan("no Wi-Fi association yet");
+}
+
+void channel_plan_scan_after_ap(otInstance *instance, channel_plan_done_fn done, void *context)
+{
+    s_deferred_instance = instance;
+    s_deferred_done = done;
+    s_deferred_context = context;
+    atomic_store(&s_deferred, true);
+
+    /* Armed before looking, so an association in between isn't missed */
+    taskENTER_CRITICAL(&s_lock);
+    bool known = s_ap_channel != 0;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (known) {
+        start_deferred_scan("AP channel known");
+        return;
+    }
+    ESP_LOGI(TAG, "Waiting up to %d s for the Wi-Fi AP channel before the energy scan",
+             CHANNEL_AP_WAIT_MS / 1000);
+    esp_timer_start_once(s_deferred_timer, (uint64_t)CHANNEL_AP_WAIT_MS * 1000);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Migration                                                          */
+/* ------------------------------------------------------------------ */
+
+static void migrate_result(otError result, void *context)
+{
+    if (result == OT_ERROR_NONE) {
+        ESP_LOGI(TAG, "Leader accepted the channel migration (applies in %d s)",
+                 CHANNEL_MIGRATE_DELAY_MS / 1000);
+    } else {
+        ESP_LOGW(TAG, "Channel migration rejected: %d", result);
+    }
+}
+
+otError channel_plan_migrate(otInstance *instance, uint8_t channel)
+{
+    if (channel < CHANNEL_PLAN_FIRST || channel > CHANNEL_PLAN_LAST) return OT_ERROR_INVALID_ARGS;
+
+    otOperationalDataset active;
+    otError error = otDatasetGetActive(instance, &active);
+    if (error != OT_ERROR_NONE) return error;
+    if (active.mChannel == channel) return OT_ERROR_ALREADY;
+
+    /* Only the changed fields: the leader merges them into a pending
+     * dataset with a newer active timestamp and the delay timer.      */
+    otOperationalDataset pending;
+    memset(&pending, 0, sizeof(pending));
+
+    pending.mActiveTimestamp = active.mActiveTimestamp;
+    pending.mActiveTimestamp.mSeconds++;
+    pending.mComponents.mIsActiveTimestampPresent = true;
+
+    otOperationalDataset current_pending;
+    pending.mPendingTimestamp.mSeconds = pending.mActiveTimestamp.mSeconds;
+    if (otDatasetGetPending(instance, &current_pending) == OT_ERROR_NONE &&
+        current_pending.mComponents.mIsPendingTimestampPresent &&
+        current_pending.mPendingTimestamp.mSeconds >= pending.mPendingTimestamp.mSeconds) {
+        pending.mPendingTimestamp.mSeconds = current_pending.mPendingTimestamp.mSeconds + 1;
+    }
+    pending.mComponents.mIsPendingTimestampPresent = true;
+
+    pending.mChannel = channel;
+    pending.mComponents.mIsChannelPresent = true;
+    pending.mDelay = CHANNEL_MIGRATE_DELAY_MS;
+    pending.mComponents.mIsDelayPresent = true;
+
+    error = otDatasetSendMgmtPendingSet(instance, &pending, NULL, 0, migrate_result, NULL);
+    if (error == OT_ERROR_NONE) {
+        ESP_LOGI(TAG, "Requested migration from channel %u to %u", active.mChannel, channel);
+    }
+    return error;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Re-evaluation after an AP channel change                           */
+/* ------------------------------------------------------------------ */
+
+/* Compare the current Thread channel with the best one (mainloop) */
+static void check_channel(otInstance *instance)
+{
+    otDeviceRole role = otThreadGetDeviceRole(instance);
+    if (role < OT_DEVICE_ROLE_CHILD) return;
+
+    uint8_t current = otLinkGetChannel(instance);
+
+    /* Our own mesh is on the current channel and shows up in its energy
+     * reading: score it on overlap alone, so a move needs another
+     * channel to be clearly better.                                   */
+    taskENTER_CRITICAL(&s_lock);
+    s_thread_channel = current;
+    uint8_t best = best_locked();
+    int current_score = ENERGY_FLOOR_DBM + penalty_locked(current);
+    int best_score = score_locked(best);
+    uint8_t ap_channel = ap_channel_locked();
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (best == current || current_score - best_score < CHANNEL_MIGRATE_MARGIN_DB) {
+        ESP_LOGI(TAG, "Thread channel %u fits Wi-Fi channel %u", current, ap_channel);
+        return;
+    }
+
+    if (CHANNEL_AUTO_MIGRATE && role == OT_DEVICE_ROLE_LEADER) {
+        channel_plan_migrate(instance, best);
+    } else {
+        ESP_LOGW(TAG, "Thread channel %u overlaps Wi-Fi channel %u; channel %u scores %d dB "
+                 "better — run \"otbr channel migrate %u\" to move the network",
+                 current, ap_channel, best, current_score - best_score, best);
+    }
+}
+
+static void rescan_done(otInstance *instance, uint8_t best, void *context)
+{
+    check_channel(instance);
+}
+
+/* Rescan for the new AP channel, then check.  Returns false if Thread
+ * isn't attached yet (try again later).  The scan takes the radio off
+ * the mesh for ~5 s, so it is skipped while the current channel stays
+ * clear of the AP: nothing else the AP does changes its score.        */
+static bool evaluate(otInstance *instance)
+{
+    if (otThreadGetDeviceRole(instance) < OT_DEVICE_ROLE_CHILD) return false;
+
+    uint8_t current = otLinkGetChannel(instance);
+    taskENTER_CRITICAL(&s_lock);
+    bool clear = overlap_locked(current) == 0;
+    bool fresh = s_scanned && esp_timer_get_time() - s_scan_done_us < RESCAN_MIN_S * 1000000LL;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (clear) {
+        check_channel(instance);
+        return true;
+    }
+
+    otError error = fresh ? OT_ERROR_ALREADY : channel_plan_scan(instance, rescan_done, NULL);
+    if (error != OT_ERROR_NONE) {
+        if (!fresh) ESP_LOGW(TAG, "Energy scan failed (%d), checking the last one", error);
+        check_channel(instance);
+    }
+    return true;
+}
+
+static void eval_task(void *arg)
+{
+    bool waiting = false;
+
+    for (;;) {
+        TickType_t wait = waiting ? pdMS_TO_TICKS(EVAL_RETRY_MS) : portMAX_DELAY;
+        if (ulTaskNotifyTake(pdTRUE, wait) == 0 && !waiting) continue;
+
+        esp_openthread_lock_acquire(portMAX_DELAY);
+        waiting = !evaluate(esp_openthread_get_instance());
+        esp_openthread_lock_release();
+    }
+}
+
+void channel_plan_set_ap_channel(uint8_t wifi_channel)
+{
+    /* Against the channel cached from the last boot until the first
+     * association, so a reboot only re-evaluates if the AP moved.     */
+    taskENTER_CRITICAL(&s_lock);
+    uint8_t previous = ap_channel_locked();
+    s_ap_channel = wifi_channel;
+    taskEXIT_CRITICAL(&s_lock);
+
+    start_deferred_scan("AP channel known");
+
+    if (wifi_channel == previous) return;
+
+    if (s_eval_task == NULL &&
+        xTaskCreate(eval_task, "chan_plan", 3072, NULL, 2, &s_eval_task) != pdPASS) {
+        s_eval_task = NULL;
+        return;
+    }
+    xTaskNotifyGive(s_eval_task);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Report / metrics                                                   */
+/* ------------------------------------------------------------------ */
+
+void channel_plan_get_report(channel_plan_report_t *report)
+{
+    int64_t now = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&s_lock);
+    report->scanned = s_scanned;
+    report->scan_age_s = s_scanned ? (now - s_scan_done_us) / 1000000 : -1;
+    report->ap_channel = ap_channel_locked();
+    report->thread_channel = s_thread_channel;
+    report->best_channel = best_locked();
+    for (int i = 0; i < CHANNEL_PLAN_COUNT; i++) {
+        report->energy_dbm[i] = s_scanned ? s_energy[i] : ENERGY_FLOOR_DBM;
+        report->score[i] = (int16_t)score_locked(CHANNEL_PLAN_FIRST + i);
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static void write_metrics(metrics_writer_t *w)
+{
+    channel_plan_report_t r;
+    channel_plan_get_report(&r);
+
+    metrics_gauge(w, "otbr_wifi_channel", "Backbone AP Wi-Fi channel (0 = unknown)", r.ap_channel);
+    metrics_gauge(w, "otbr_channel_recommended", "Best Thread channel for the current AP channel",
+                  r.best_channel);
+
+    metrics_header(w, "otbr_channel_score", "gauge",
+                   "Thread channel score: energy (dBm) plus Wi-Fi overlap penalty, lower is better");
+    for (int i = 0; i < CHANNEL_PLAN_COUNT; i++) {
+        metrics_printf(w, "otbr_channel_score{channel=\"%d\"} %d\n",
+                       CHANNEL_PLAN_FIRST + i, r.score[i]);
+    }
+    if (r.scanned) {
+        metrics_header(w, "otbr_channel_energy_dbm", "gauge",
+                       "Max RSSI per Thread channel in the last energy scan");
+        for (int i = 0; i < CHANNEL_PLAN_COUNT; i++) {
+            metrics_printf(w, "otbr_channel_energy_dbm{channel=\"%d\"} %d\n",
+                           CHANNEL_PLAN_FIRST + i, r.energy_dbm[i]);
+        }
+    }
+}
+
+void channel_plan_init(uint8_t cached_ap_channel)
+{
+    s_cached_ap_channel = cached_ap_channel;
+
+    const esp_timer_create_args_t args = {
+        .callback = deferred_timeout,
+        .name = "chan_plan",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &s_deferred_timer));
+
+    metrics_register_source(write_metrics);
+}
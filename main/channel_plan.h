@@ -0,0 +1,85 @@
+/*
+ * Thread channel planning
+ *
+ * The C6 time-shares a single 2.4 GHz radio between Wi-Fi and 802.15.4,
+ * so a Thread channel inside the backbone AP's 20 MHz band loses on both
+ * sides.  An 802.15.4 energy scan measures every Thread channel (11-26);
+ * each reading is then penalised by how much the channel overlaps the
+ * AP's Wi-Fi channel — the scan cannot see our own backbone traffic,
+ * since that uses the same radio — and the lowest score wins.
+ *
+ * Used when a new network is created (THREAD_CHANNEL 0), after waiting
+ * up to CHANNEL_AP_WAIT_MS for Wi-Fi to associate so the AP channel is
+ * known, and again when the backbone AP moves onto the current Thread
+ * channel: the channels are rescanned, and if the current Thread
+ * channel then scores CHANNEL_MIGRATE_MARGIN_DB worse than the best one
+ * a migration is suggested in the log ("otbr channel migrate <ch>"), or
+ * started through a pending dataset when CHANNEL_AUTO_MIGRATE is set.
+ */
+
+#ifndef CHANNEL_PLAN_H
+#define CHANNEL_PLAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "openthread/instance.h"
+
+#define CHANNEL_PLAN_FIRST      11
+#define CHANNEL_PLAN_LAST       26
+#define CHANNEL_PLAN_COUNT      (CHANNEL_PLAN_LAST - CHANNEL_PLAN_FIRST + 1)
+
+typedef void (*channel_plan_done_fn)(otInstance *instance, uint8_t channel, void *context);
+
+typedef struct {
+    bool scanned;                           /* energy[] holds a scan     */
+    int64_t scan_age_s;                     /* seconds since that scan   */
+    uint8_t ap_channel;                     /* Wi-Fi channel, 0=unknown  */
+    uint8_t thread_channel;                 /* last seen, 0=unknown      */
+    uint8_t best_channel;
+    int8_t energy_dbm[CHANNEL_PLAN_COUNT];  /* max RSSI per channel      */
+    int16_t score[CHANNEL_PLAN_COUNT];      /* energy + AP overlap       */
+} channel_plan_report_t;
+
+/**
+ * Register the metrics source and seed the AP channel from the last
+ * boot (used until Wi-Fi associates).  Call once at boot.
+ */
+void channel_plan_init(uint8_t cached_ap_channel);
+
+/**
+ * Record the backbone AP's channel (WIFI_EVENT_STA_CONNECTED).  When it
+ * differs from the previous one (after boot, the cached one) and Thread
+ * is attached, the current Thread channel is re-evaluated in the
+ * background, rescanning the channels first if it overlaps the AP.
+ */
+void channel_plan_set_ap_channel(uint8_t wifi_channel);
+
+/**
+ * Energy-scan all Thread channels (bringing the IPv6 interface up if
+ * needed) and call done() on the OpenThread mainloop with the best
+ * channel.  Call with the OpenThread lock held.
+ */
+otError channel_plan_scan(otInstance *instance, channel_plan_done_fn done, void *context);
+
+/**
+ * channel_plan_scan() once the AP channel is known (the next
+ * channel_plan_set_ap_channel()), or after CHANNEL_AP_WAIT_MS without
+ * one; done() also gets the best channel if the scan can't start.
+ * Call on the OpenThread mainloop.
+ */
+void channel_plan_scan_after_ap(otInstance *instance, channel_plan_done_fn done, void *context);
+
+/** Best channel from the last scan and the current AP channel. */
+uint8_t channel_plan_best(void);
+
+/**
+ * Move the network to another channel through a pending dataset
+ * (MGMT_PENDING_SET to the leader, applied after CHANNEL_MIGRATE_DELAY_MS).
+ * Call with the OpenThread lock held.
+ */
+otError channel_plan_migrate(otInstance *instance, uint8_t channel);
+
+void channel_plan_get_report(channel_plan_report_t *report);
+
+#endif /* CHANNEL_PLAN_H */
@@ -0,0 +1,238 @@
+/*
+ * Adaptive Wi-Fi / 802.15.4 coexistence control — see coex_ctrl.h
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_ieee802154.h"
+#include "esp_log.h"
+
+#include "config.h"
+#include "coex_ctrl.h"
+#include "metrics.h"
+#include "netif_hooks.h"
+#include "ot_status.h"
+
+static const char *TAG = "coex";
+
+#define COEX_SAMPLE_MS          2000
+
+/* An interval only counts as evidence with this many MAC attempts    */
+#define MIN_TX_ATTEMPTS         10
+
+/* Step up above the high marks, count towards stepping down below the
+ * low marks (per mille of transmission attempts).                     */
+#define RETRY_HIGH_PM           150
+#define RETRY_LOW_PM            50
+#define CCA_HIGH_PM             50
+#define CCA_LOW_PM              10
+
+/* Raising Thread priority only helps when Wi-Fi is what's in the way */
+#define WIFI_BUSY_KBPS          500
+
+/* Quiet intervals in a row before stepping down one level            */
+#define STEP_DOWN_INTERVALS     15
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static coex_ctrl_stats_t s_stats = { .adaptive = COEX_ADAPTIVE };
+static TaskHandle_t s_task;
+
+/* Sampler's copy of the OpenThread snapshot (too big for its stack)  */
+static ot_status_t s_status;
+
+#if CONFIG_ESP_COEX_SW_COEXIST_ENABLE
+static esp_ieee802154_coex_config_t s_levels[COEX_LEVEL_COUNT];
+#endif
+
+const char *coex_level_name(coex_level_t level)
+{
+    switch (level) {
+    case COEX_LEVEL_BALANCED:   return "balanced";
+    case COEX_LEVEL_THREAD:     return "thread";
+    case COEX_LEVEL_THREAD_MAX: return "thread-max";
+    default:                    return "?";
+    }
+}
+
+/* Called from the sampler and the CLI: the level is checked and
+ * changed in one critical section.                                    */
+static void apply_level(coex_level_t level, const char *reason)
+{
+    taskENTER_CRITICAL(&s_lock);
+    bool changed = level != s_stats.level;
+    if (changed) {
+        s_stats.level = level;
+        s_stats.level_changes++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    if (!changed) return;
+
+#if CONFIG_ESP_COEX_SW_COEXIST_ENABLE
+    esp_ieee802154_coex_config_set(s_levels[level]);
+#endif
+
+    ESP_LOGI(TAG, "802.15.4 coex priority: %s (%s)", coex_level_name(level), reason);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Sampling                                                           */
+/* ------------------------------------------------------------------ */
+
+static void adapt(const coex_ctrl_stats_t *sample, uint32_t *quiet_intervals)
+{
+    bool evidence = sample->tx_attempts >= MIN_TX_ATTEMPTS;
+    bool bad = evidence && sample->wifi_kbps >= WIFI_BUSY_KBPS &&
+               (sample->retry_pm >= RETRY_HIGH_PM || sample->cca_fail_pm >= CCA_HIGH_PM);
+    bool quiet = !evidence ||
+                 (sample->retry_pm <= RETRY_LOW_PM && sample->cca_fail_pm <= CCA_LOW_PM);
+
+    if (bad) {
+        *quiet_intervals = 0;
+        if (sample->level + 1 < COEX_LEVEL_COUNT) {
+            apply_level(sample->level + 1, sample->retry_pm >= RETRY_HIGH_PM ?
+                        "MAC retries high" : "CCA failures high");
+        }
+    } else if (quiet) {
+        if (++*quiet_intervals >= STEP_DOWN_INTERVALS && sample->level > COEX_LEVEL_BALANCED) {
+            *quiet_intervals = 0;
+            apply_level(sample->level - 1, "Thread quiet");
+        }
+    } else {
+        *quiet_intervals = 0;
+    }
+}
+
+static uint32_t per_mille(uint32_t part, uint32_t whole)
+{
+    return whole ? (uint32_t)((uint64_t)part * 1000 / whole) : 0;
+}
+
+static void coex_task(void *arg)
+{
+    otMacCounters prev_mac;
+    netif_hooks_counters_t prev_wifi;
+    bool have_prev = false;
+    uint32_t quiet_intervals = 0;
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(COEX_SAMPLE_MS));
+
+        if (!ot_status_read(&s_status)) continue;
+        otMacCounters mac = s_status.mac;
+
+        netif_hooks_counters_t wifi;
+        netif_hooks_get_backbone(&wifi);
+
+        if (!have_prev) {
+            prev_mac = mac;
+            prev_wifi = wifi;
+            have_prev = true;
+            continue;
+        }
+
+        /* Unsigned deltas survive counter wrap */
+        uint32_t tx_total = mac.mTxTotal - prev_mac.mTxTotal;
+        uint32_t tx_retry = mac.mTxRetry - prev_mac.mTxRetry;
+        uint32_t tx_cca = (mac.mTxErrCca - prev_mac.mTxErrCca) +
+                          (mac.mTxErrBusyChannel - prev_mac.mTxErrBusyChannel);
+        uint32_t rx_total = mac.mRxTotal - prev_mac.mRxTotal;
+        uint32_t rx_errors = (mac.mRxErrFcs - prev_mac.mRxErrFcs) +
+                             (mac.mRxErrNoFrame - prev_mac.mRxErrNoFrame) +
+                             (mac.mRxErrOther - prev_mac.mRxErrOther);
+        uint64_t wifi_bytes = (wifi.rx_bytes - prev_wifi.rx_bytes) +
+                              (wifi.tx_bytes - prev_wifi.tx_bytes);
+        prev_mac = mac;
+        prev_wifi = wifi;
+
+        coex_ctrl_stats_t sample;
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.tx_attempts = tx_total + tx_retry;
+        s_stats.retry_pm = per_mille(tx_retry, tx_total + tx_retry);
+        s_stats.cca_fail_pm = per_mille(tx_cca, tx_total + tx_retry);
+        s_stats.rx_error_pm = per_mille(rx_errors, rx_total);
+        s_stats.wifi_kbps = (uint32_t)(wifi_bytes * 8 / COEX_SAMPLE_MS);
+        s_stats.mac_tx_total = mac.mTxTotal;
+        s_stats.mac_tx_retry = mac.mTxRetry;
+        s_stats.mac_tx_err_cca = mac.mTxErrCca;
+        s_stats.mac_tx_err_busy = mac.mTxErrBusyChannel;
+        s_stats.mac_rx_total = mac.mRxTotal;
+        s_stats.mac_rx_errors = mac.mRxErrFcs + mac.mRxErrNoFrame + mac.mRxErrOther;
+        sample = s_stats;
+        taskEXIT_CRITICAL(&s_lock);
+
+        if (sample.adaptive) adapt(&sample, &quiet_intervals);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Control / metrics                                                  */
+/* ------------------------------------------------------------------ */
+
+static void write_metrics(metrics_writer_t *w)
+{
+    coex_ctrl_stats_t st;
+    coex_ctrl_get_stats(&st);
+
+    metrics_gauge(w, "otbr_coex_level",
+                  "802.15.4 coex priority level (0 balanced, 1 thread, 2 thread-max)", st.level);
+    metrics_gauge(w, "otbr_coex_adaptive", "Coex level chosen by the controller (1) or pinned (0)",
+                  st.adaptive);
+    metrics_counter(w, "otbr_coex_level_changes_total", "Coex priority level changes",
+                    st.level_changes);
+
+    metrics_header(w, "otbr_mac_tx_total", "counter", "802.15.4 MAC transmissions by outcome");
+    metrics_sample(w, "otbr_mac_tx_total", "result=\"frame\"", st.mac_tx_total);
+    metrics_sample(w, "otbr_mac_tx_total", "result=\"retry\"", st.mac_tx_retry);
+    metrics_sample(w, "otbr_mac_tx_total", "result=\"cca_fail\"", st.mac_tx_err_cca);
+    metrics_sample(w, "otbr_mac_tx_total", "result=\"busy_channel\"", st.mac_tx_err_busy);
+    metrics_header(w, "otbr_mac_rx_total", "counter", "802.15.4 MAC receptions by outcome");
+    metrics_sample(w, "otbr_mac_rx_total", "result=\"frame\"", st.mac_rx_total);
+    metrics_sample(w, "otbr_mac_rx_total", "result=\"error\"", st.mac_rx_errors);
+
+    metrics_header(w, "otbr_coex_sample_permille", "gauge",
+                   "Last coex sample interval: rates per mille");
+    metrics_sample(w, "otbr_coex_sample_permille", "rate=\"tx_retry\"", st.retry_pm);
+    metrics_sample(w, "otbr_coex_sample_permille", "rate=\"cca_fail\"", st.cca_fail_pm);
+    metrics_sample(w, "otbr_coex_sample_permille", "rate=\"rx_error\"", st.rx_error_pm);
+    metrics_gauge(w, "otbr_backbone_throughput_kbps",
+                  "Wi-Fi backbone throughput (rx+tx) in the last coex sample", st.wifi_kbps);
+}
+
+void coex_ctrl_set_mode(bool adaptive, coex_level_t level)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.adaptive = adaptive;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (!adaptive && level < COEX_LEVEL_COUNT) apply_level(level, "pinned");
+}
+
+void coex_ctrl_start(void)
+{
+    if (s_task != NULL) return;
+
+#if CONFIG_ESP_COEX_SW_COEXIST_ENABLE
+    esp_ieee802154_coex_config_t base = esp_ieee802154_coex_config_get();
+
+    s_levels[COEX_LEVEL_BALANCED] = base;
+
+    s_levels[COEX_LEVEL_THREAD] = base;
+    s_levels[COEX_LEVEL_THREAD].txrx = IEEE802154_HIGH;
+
+    s_levels[COEX_LEVEL_THREAD_MAX] = s_levels[COEX_LEVEL_THREAD];
+    s_levels[COEX_LEVEL_THREAD_MAX].idle = IEEE802154_MIDDLE;
+#endif
+
+    metrics_register_source(write_metrics);
+    xTaskCreate(coex_task, "coex_ctrl", 3072, NULL, 3, &s_task);
+}
+
+void coex_ctrl_get_stats(coex_ctrl_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
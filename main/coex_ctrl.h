@@ -0,0 +1,67 @@
+/*
+ * Adaptive Wi-Fi / 802.15.4 coexistence control
+ *
+ * Both radios share one RF front end; the coexistence arbiter decides
+ * who gets it by the 802.15.4 request priority for idle listening, for
+ * normal TX/RX and for timed TX/RX (acks, CSL).  ESP-IDF's default
+ * favours Wi-Fi for everything but timed operations, which under heavy
+ * backbone traffic shows up as Thread MAC retries and CCA failures —
+ * i.e. Thread latency.
+ *
+ * Every COEX_SAMPLE_MS the controller samples the OpenThread MAC
+ * counters and backbone throughput.  While Wi-Fi is busy and Thread
+ * retry/CCA-failure rates are high it raises the 802.15.4 priority one
+ * level; once the rates have stayed low for a while it steps back down
+ * so Wi-Fi gets its airtime again.
+ *
+ *   balanced    ESP-IDF default (idle low, tx/rx middle, timed high)
+ *   thread      tx/rx high
+ *   thread-max  tx/rx high and idle listening middle
+ */
+
+#ifndef COEX_CTRL_H
+#define COEX_CTRL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    COEX_LEVEL_BALANCED = 0,
+    COEX_LEVEL_THREAD,
+    COEX_LEVEL_THREAD_MAX,
+    COEX_LEVEL_COUNT,
+} coex_level_t;
+
+typedef struct {
+    coex_level_t level;
+    bool adaptive;              /* false: level pinned from the CLI */
+    uint32_t level_changes;
+    /* Last sample interval, per mille of MAC transmission attempts */
+    uint32_t tx_attempts;
+    uint32_t retry_pm;
+    uint32_t cca_fail_pm;
+    uint32_t rx_error_pm;       /* of received frames */
+    uint32_t wifi_kbps;
+    /* OpenThread MAC counters at the last sample (since boot) */
+    uint32_t mac_tx_total;
+    uint32_t mac_tx_retry;
+    uint32_t mac_tx_err_cca;
+    uint32_t mac_tx_err_busy;
+    uint32_t mac_rx_total;
+    uint32_t mac_rx_errors;
+} coex_ctrl_stats_t;
+
+/**
+ * Start the sampling task.  Call after esp_openthread_init(); the
+ * coexistence arbiter itself is enabled in app_main().
+ */
+void coex_ctrl_start(void);
+
+/** Pin a level (adaptive = false) or hand control back to the sampler. */
+void coex_ctrl_set_mode(bool adaptive, coex_level_t level);
+
+void coex_ctrl_get_stats(coex_ctrl_stats_t *stats);
+
+const char *coex_level_name(coex_level_t level);
+
+#endif /* COEX_CTRL_H */
@@ -0,0 +1,424 @@
+/*
+ * Bulk commissioning — see commission.h
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_openthread_task_queue.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "mbedtls/ecjpake.h"
+
+#include "openthread/commissioner.h"
+#include "openthread/error.h"
+
+#include "commission.h"
+#include "metrics.h"
+
+static const char *TAG = "commission";
+
+#define PSKD_MIN_LEN            6
+#define PSKD_MAX_LEN            32
+#define BENCH_BUF_SIZE          512     /* largest EC-JPAKE round is ~330 B */
+#define BENCH_SECRET            "J01NME"
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static otInstance *s_instance;
+static esp_timer_handle_t s_window_timer;
+
+/* Commissioner state: mainloop only, except st (s_lock) */
+static struct {
+    commission_stats_t st;
+    char pskd[PSKD_MAX_LEN + 1];
+    uint32_t minutes;
+    int64_t session_us;
+    int64_t first_us;
+    int64_t last_end_us;
+    int64_t last_join_us;
+    uint64_t handshake_ms_sum;
+    uint32_t handshakes;
+    uint64_t join_ms_sum;
+    bool finalized;
+} s_batch;
+
+static struct {
+    commission_bench_stats_t st;  /* s_lock */
+    uint32_t count;
+    TaskHandle_t task;
+} s_bench;
+
+/* ------------------------------------------------------------------ */
+/*  Commissioner                                                       */
+/* ------------------------------------------------------------------ */
+
+static uint32_t ms_since(int64_t us)
+{
+    return (uint32_t)((esp_timer_get_time() - us) / 1000);
+}
+
+static void log_batch(void)
+{
+    commission_stats_t st;
+    commission_get_stats(&st);
+    ESP_LOGI(TAG, "batch: %lu joined, %lu failed in %lu s (%lu.%lu joins/min); handshake "
+             "avg %lu ms, max %lu ms; join avg %lu ms; idle between sessions %lu ms",
+             (unsigned long)st.joined, (unsigned long)st.failed, (unsigned long)st.elapsed_s,
+             (unsigned long)(st.joins_per_min_x10 / 10),
+             (unsigned long)(st.joins_per_min_x10 % 10),
+             (unsigned long)st.handshake_ms_avg, (unsigned long)st.handshake_ms_max,
+             (unsigned long)st.join_ms_avg, (unsigned long)st.idle_ms);
+}
+
+static void end_session(void)
+{
+    if (!s_batch.st.in_session) return;
+
+    taskENTER_CRITICAL(&s_lock);
+    s_batch.st.in_session = false;
+    if (!s_batch.finalized) s_batch.st.failed++;
+    taskEXIT_CRITICAL(&s_lock);
+    s_batch.last_end_us = esp_timer_get_time();
+}
+
+static void on_joiner(otCommissionerJoinerEvent event, const otJoinerInfo *info,
+                      const otExtAddress *joiner_id, void *ctx)
+{
+    int64_t now = esp_timer_get_time();
+
+    switch (event) {
+    case OT_COMMISSIONER_JOINER_START:
+        end_session();          /* END is always signalled; just in case */
+        s_batch.session_us = now;
+        s_batch.finalized = false;
+        taskENTER_CRITICAL(&s_lock);
+        if (s_batch.st.sessions++ == 0) {
+            s_batch.first_us = now;
+        } else {
+            s_batch.st.idle_ms += (uint32_t)((now - s_batch.last_end_us) / 1000);
+        }
+        s_batch.st.in_session = true;
+        taskEXIT_CRITICAL(&s_lock);
+        break;
+
+    case OT_COMMISSIONER_JOINER_CONNECTED: {
+        uint32_t ms = ms_since(s_batch.session_us);
+        taskENTER_CRITICAL(&s_lock);
+        s_batch.handshake_ms_sum += ms;
+        s_batch.handshakes++;
+        if (ms > s_batch.st.handshake_ms_max) s_batch.st.handshake_ms_max = ms;
+        taskEXIT_CRITICAL(&s_lock);
+        break;
+    }
+
+    case OT_COMMISSIONER_JOINER_FINALIZE: {
+        uint32_t ms = ms_since(s_batch.session_us);
+        s_batch.finalized = true;
+        s_batch.last_join_us = now;
+        taskENTER_CRITICAL(&s_lock);
+        s_batch.st.joined++;
+        s_batch.join_ms_sum += ms;
+        if (ms > s_batch.st.join_ms_max) s_batch.st.join_ms_max = ms;
+        taskEXIT_CRITICAL(&s_lock);
+        ESP_LOGI(TAG, "joiner %02x%02x%02x%02x%02x%02x%02x%02x joined in %lu ms",
+                 joiner_id->m8[0], joiner_id->m8[1], joiner_id->m8[2], joiner_id->m8[3],
+                 joiner_id->m8[4], joiner_id->m8[5], joiner_id->m8[6], joiner_id->m8[7],
+                 (unsigned long)ms);
+        break;
+    }
+
+    case OT_COMMISSIONER_JOINER_END:
+        end_session();
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void on_state(otCommissionerState state, void *ctx)
+{
+    if (state == OT_COMMISSIONER_STATE_ACTIVE) {
+        if (s_batch.pskd[0] == '\0') {
+            ESP_LOGI(TAG, "Commissioner active; add joiners with \"commissioner joiner add\"");
+            return;
+        }
+        otError err = otCommissionerAddJoiner(s_instance, NULL, s_batch.pskd,
+                                              s_batch.minutes * 60);
+        if (err != OT_ERROR_NONE) {
+            ESP_LOGE(TAG, "Adding the wildcard joiner failed: %s", otThreadErrorToString(err));
+            return;
+        }
+        ESP_LOGI(TAG, "Commissioner active; any joiner with the PSKd for %lu min",
+                 (unsigned long)s_batch.minutes);
+    } else if (state == OT_COMMISSIONER_STATE_DISABLED && s_batch.st.active) {
+        end_session();
+        esp_timer_stop(s_window_timer);
+        taskENTER_CRITICAL(&s_lock);
+        s_batch.st.active = false;
+        taskEXIT_CRITICAL(&s_lock);
+        log_batch();
+    }
+}
+
+static void stop_tasklet(void *ctx)
+{
+    commission_stop();
+}
+
+/* esp_timer task: the commissioner is only touched on the mainloop */
+static void window_timer_cb(void *arg)
+{
+    esp_openthread_task_queue_post(stop_tasklet, NULL);
+}
+
+static bool pskd_valid(const char *pskd)
+{
+    size_t len = strlen(pskd);
+    if (len < PSKD_MIN_LEN || len > PSKD_MAX_LEN) return false;
+    for (const char *c = pskd; *c != '\0'; c++) {
+        /* Uppercase alphanumerics without I, O, Q and Z */
+        bool digit = *c >= '0' && *c <= '9';
+        bool upper = *c >= 'A' && *c <= 'Y' && *c != 'I' && *c != 'O' && *c != 'Q';
+        if (!digit && !upper) return false;
+    }
+    return true;
+}
+
+esp_err_t commission_start(const char *pskd, uint32_t minutes)
+{
+    if (s_instance == NULL || s_batch.st.active) return ESP_ERR_INVALID_STATE;
+    if (pskd != NULL && !pskd_valid(pskd)) return ESP_ERR_INVALID_ARG;
+
+    taskENTER_CRITICAL(&s_lock);
+    memset(&s_batch, 0, sizeof(s_batch));
+    taskEXIT_CRITICAL(&s_lock);
+    if (pskd != NULL) strlcpy(s_batch.pskd, pskd, sizeof(s_batch.pskd));
+    s_batch.minutes = minutes > 0 ? minutes : COMMISSION_WINDOW_MIN;
+
+    otError err = otCommissionerStart(s_instance, on_state, on_joiner, NULL);
+    if (err != OT_ERROR_NONE) {
+        ESP_LOGW(TAG, "Commissioner start failed: %s", otThreadErrorToString(err));
+        return ESP_ERR_INVALID_STATE;
+    }
+    taskENTER_CRITICAL(&s_lock);
+    s_batch.st.active = true;
+    taskEXIT_CRITICAL(&s_lock);
+    esp_timer_start_once(s_window_timer, (uint64_t)s_batch.minutes * 60000000);
+    return ESP_OK;
+}
+
+void commission_stop(void)
+{
+    if (!s_batch.st.active) return;
+    /* DISABLED is signalled from here and ends the batch */
+    otCommissionerStop(s_instance);
+}
+
+void commission_get_stats(commission_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_batch.st;
+    if (s_batch.handshakes > 0) {
+        stats->handshake_ms_avg = (uint32_t)(s_batch.handshake_ms_sum / s_batch.handshakes);
+    }
+    if (s_batch.st.joined > 0) {
+        /* First session's start to the last finalize: every join in full */
+        uint32_t elapsed_ms = (uint32_t)((s_batch.last_join_us - s_batch.first_us) / 1000);
+        stats->join_ms_avg = (uint32_t)(s_batch.join_ms_sum / s_batch.st.joined);
+        stats->elapsed_s = elapsed_ms / 1000;
+        if (elapsed_ms > 0) {
+            stats->joins_per_min_x10 =
+                (uint32_t)((uint64_t)s_batch.st.joined * 600000 / elapsed_ms);
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Handshake benchmark                                                */
+/* ------------------------------------------------------------------ */
+
+static int bench_rng(void *ctx, unsigned char *buf, size_t len)
+{
+    esp_fill_random(buf, len);
+    return 0;
+}
+
+/* One EC-JPAKE exchange as in a Thread join, the PSKd as the secret */
+static bool bench_one(int64_t *commissioner_us)
+{
+    static mbedtls_ecjpake_context joiner, comm;
+    static unsigned char buf[BENCH_BUF_SIZE];
+    unsigned char key_joiner[32], key_comm[32];
+    size_t len, key_len;
+    int64_t t;
+    int ret;
+
+    mbedtls_ecjpake_init(&joiner);
+    mbedtls_ecjpake_init(&comm);
+    ret = mbedtls_ecjpake_setup(&joiner, MBEDTLS_ECJPAKE_CLIENT, MBEDTLS_MD_SHA256,
+                                MBEDTLS_ECP_DP_SECP256R1, (const unsigned char *)BENCH_SECRET,
+                                strlen(BENCH_SECRET));
+    if (ret == 0) {
+        t = esp_timer_get_time();
+        ret = mbedtls_ecjpake_setup(&comm, MBEDTLS_ECJPAKE_SERVER, MBEDTLS_MD_SHA256,
+                                    MBEDTLS_ECP_DP_SECP256R1, (const unsigned char *)BENCH_SECRET,
+                                    strlen(BENCH_SECRET));
+        *commissioner_us += esp_timer_get_time() - t;
+    }
+
+    /* ClientHello / ServerHello: round one both ways */
+    if (ret == 0) ret = mbedtls_ecjpake_write_round_one(&joiner, buf, sizeof(buf), &len,
+                                                        bench_rng, NULL);
+    if (ret == 0) {
+        t = esp_timer_get_time();
+        ret = mbedtls_ecjpake_read_round_one(&comm, buf, len);
+        if (ret == 0) ret = mbedtls_ecjpake_write_round_one(&comm, buf, sizeof(buf), &len,
+                                                            bench_rng, NULL);
+        *commissioner_us += esp_timer_get_time() - t;
+    }
+    if (ret == 0) ret = mbedtls_ecjpake_read_round_one(&joiner, buf, len);
+
+    /* ServerKeyExchange / ClientKeyExchange: round two */
+    if (ret == 0) {
+        t = esp_timer_get_time();
+        ret = mbedtls_ecjpake_write_round_two(&comm, buf, sizeof(buf), &len, bench_rng, NULL);
+        *commissioner_us += esp_timer_get_time() - t;
+    }
+    if (ret == 0) ret = mbedtls_ecjpake_read_round_two(&joiner, buf, len);
+    if (ret == 0) ret = mbedtls_ecjpake_write_round_two(&joiner, buf, sizeof(buf), &len,
+                                                        bench_rng, NULL);
+    if (ret == 0) {
+        t = esp_timer_get_time();
+        ret = mbedtls_ecjpake_read_round_two(&comm, buf, len);
+        if (ret == 0) ret = mbedtls_ecjpake_derive_secret(&comm, key_comm, sizeof(key_comm),
+                                                          &key_len, bench_rng, NULL);
+        *commissioner_us += esp_timer_get_time() - t;
+    }
+    if (ret == 0) ret = mbedtls_ecjpake_derive_secret(&joiner, key_joiner, sizeof(key_joiner),
+                                                      &key_len, bench_rng, NULL);
+
+    mbedtls_ecjpake_free(&joiner);
+    mbedtls_ecjpake_free(&comm);
+    if (ret != 0) ESP_LOGW(TAG, "bench: EC-JPAKE failed: -0x%04x", (unsigned)-ret);
+    return ret == 0 && memcmp(key_joiner, key_comm, key_len) == 0;
+}
+
+static void bench_task(void *arg)
+{
+    uint64_t total_us = 0;
+    int64_t commissioner_us = 0;
+
+    for (uint32_t i = 0; i < s_bench.count; i++) {
+        int64_t start = esp_timer_get_time();
+        bool ok = bench_one(&commissioner_us);
+        int64_t us = esp_timer_get_time() - start;
+        uint32_t ms = (uint32_t)(us / 1000);
+        total_us += us;
+
+        taskENTER_CRITICAL(&s_lock);
+        commission_bench_stats_t *st = &s_bench.st;
+        if (ok) {
+            st->done++;
+        } else {
+            st->failed++;
+        }
+        if (ms > st->max_ms) st->max_ms = ms;
+        st->avg_ms = (uint32_t)(total_us / 1000 / (i + 1));
+        st->commissioner_ms = (uint32_t)(commissioner_us / 1000 / (i + 1));
+        st->per_min = total_us > 0 ? (uint32_t)((uint64_t)(i + 1) * 60000000 / total_us) : 0;
+        taskEXIT_CRITICAL(&s_lock);
+    }
+
+    commission_bench_stats_t st;
+    taskENTER_CRITICAL(&s_lock);
+    s_bench.st.active = false;
+    st = s_bench.st;
+    s_bench.task = NULL;
+    taskEXIT_CRITICAL(&s_lock);
+    ESP_LOGI(TAG, "bench: %lu EC-JPAKE handshakes (%lu failed), avg %lu ms (commissioner "
+             "%lu ms), max %lu ms: %lu per minute",
+             (unsigned long)st.done, (unsigned long)st.failed, (unsigned long)st.avg_ms,
+             (unsigned long)st.commissioner_ms, (unsigned long)st.max_ms,
+             (unsigned long)st.per_min);
+
+    vTaskDelete(NULL);
+}
+
+esp_err_t commission_bench_start(uint32_t count)
+{
+    if (count == 0) return ESP_ERR_INVALID_ARG;
+    if (s_bench.task != NULL) return ESP_ERR_INVALID_STATE;
+
+    taskENTER_CRITICAL(&s_lock);
+    memset(&s_bench.st, 0, sizeof(s_bench.st));
+    s_bench.st.active = true;
+    taskEXIT_CRITICAL(&s_lock);
+    s_bench.count = count;
+
+    /* Below the OpenThread task: the crypto runs in its idle time */
+    if (xTaskCreate(bench_task, "commission_bench", COMMISSION_BENCH_STACK, NULL, 2,
+                    &s_bench.task) != pdPASS) {
+        s_bench.st.active = false;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void commission_bench_get_stats(commission_bench_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_bench.st;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Metrics / init                                                     */
+/* ------------------------------------------------------------------ */
+
+static void write_metrics(metrics_writer_t *w)
+{
+    commission_stats_t st;
+    commission_get_stats(&st);
+
+    metrics_gauge(w, "otbr_commission_active", "Commissioner started by otbr commission",
+                  st.active);
+    metrics_header(w, "otbr_commission_joins_total", "counter", "Joiner sessions by outcome");
+    metrics_sample(w, "otbr_commission_joins_total", "result=\"joined\"", st.joined);
+    metrics_sample(w, "otbr_commission_joins_total", "result=\"failed\"", st.failed);
+    metrics_header(w, "otbr_commission_handshake_ms", "gauge",
+                   "Joiner DTLS handshake time in the current batch");
+    metrics_sample(w, "otbr_commission_handshake_ms", "stat=\"avg\"", st.handshake_ms_avg);
+    metrics_sample(w, "otbr_commission_handshake_ms", "stat=\"max\"", st.handshake_ms_max);
+    metrics_header(w, "otbr_commission_joins_per_minute", "gauge",
+                   "Joins per minute in the current batch");
+    metrics_printf(w, "otbr_commission_joins_per_minute %lu.%lu\n",
+                   (unsigned long)(st.joins_per_min_x10 / 10),
+                   (unsigned long)(st.joins_per_min_x10 % 10));
+    metrics_counter(w, "otbr_commission_idle_ms_total",
+                    "Time between joiner sessions in the current batch", st.idle_ms);
+
+    commission_bench_stats_t bench;
+    commission_bench_get_stats(&bench);
+    if (bench.done > 0) {
+        metrics_gauge(w, "otbr_commission_bench_handshakes_per_minute",
+                      "Simulated EC-JPAKE handshakes per minute", bench.per_min);
+    }
+}
+
+void commission_init(otInstance *instance)
+{
+    if (s_instance != NULL) return;
+
+    const esp_timer_create_args_t args = {
+        .callback = window_timer_cb,
+        .name = "commission",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &s_window_timer));
+    metrics_register_source(write_metrics);
+    s_instance = instance;
+}
@@ -0,0 +1,82 @@
+/*
+ * Bulk commissioning
+ *
+ * "otbr commission start" makes this router the Thread network's
+ * commissioner for a batch of new devices.  With a PSKd, every joiner
+ * that knows it is accepted (a wildcard joiner entry) for the given
+ * minutes; without one, devices are added with the OpenThread CLI's
+ * "commissioner joiner add <eui64> <pskd>" and go through in the same
+ * session.  The commissioner stops when the window ends or on
+ * "otbr commission stop", and the batch is reported in the log.
+ *
+ * Joiners go through one after another: OpenThread's commissioner holds
+ * one DTLS session at a time, and a joiner that arrives meanwhile is
+ * dropped and retries.  Nothing here changes that; the idle time between
+ * sessions is reported to show how much of the batch is spent waiting
+ * for the next joiner to retry.
+ *
+ * "otbr commission bench" measures the crypto alone: EC-JPAKE exchanges
+ * between a simulated joiner and commissioner in memory, on a
+ * low-priority task, as handshakes per minute.  Whole joins against
+ * simulated joiners are measured by host/bench/otbr_bench.py commission.
+ */
+
+#ifndef COMMISSION_H
+#define COMMISSION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "openthread/instance.h"
+
+#define COMMISSION_WINDOW_MIN   15
+#define COMMISSION_BENCH_STACK  8192
+
+typedef struct {
+    bool active;                /* commissioner started from here     */
+    bool in_session;
+    uint32_t sessions;
+    uint32_t joined;
+    uint32_t failed;            /* session ended before finalize      */
+    uint32_t handshake_ms_avg;  /* session start to DTLS connected    */
+    uint32_t handshake_ms_max;
+    uint32_t join_ms_avg;       /* session start to finalize          */
+    uint32_t join_ms_max;
+    uint32_t idle_ms;           /* between sessions, within the batch */
+    uint32_t elapsed_s;         /* first session start to last join   */
+    uint32_t joins_per_min_x10;
+} commission_stats_t;
+
+typedef struct {
+    bool active;
+    uint32_t done;
+    uint32_t failed;
+    uint32_t avg_ms;            /* one exchange, both sides           */
+    uint32_t max_ms;
+    uint32_t commissioner_ms;   /* commissioner's share of avg_ms     */
+    uint32_t per_min;
+} commission_bench_stats_t;
+
+/** Register metrics and the power-management lock; call once at startup. */
+void commission_init(otInstance *instance);
+
+/**
+ * Start the commissioner; with pskd, accept any joiner that has it for
+ * minutes (0: COMMISSION_WINDOW_MIN).  Call on the OpenThread mainloop.
+ * ESP_ERR_INVALID_STATE if a commissioner is already running,
+ * ESP_ERR_INVALID_ARG for a bad PSKd.
+ */
+esp_err_t commission_start(const char *pskd, uint32_t minutes);
+
+/** Stop the commissioner and log the batch.  Call on the mainloop. */
+void commission_stop(void);
+
+void commission_get_stats(commission_stats_t *stats);
+
+/** Run count simulated EC-JPAKE handshakes; results in the log. */
+esp_err_t commission_bench_start(uint32_t count);
+
+void commission_bench_get_stats(commission_bench_stats_t *stats);
+
+#endif /* COMMISSION_H */
@@ -26,6 +26,25 @@
 /* Maximum connection retries before reboot (0 = retry forever)        */
 #define WIFI_MAX_RETRY          0
 
+/* Reconnect backoff after a disconnect: the first retry comes after
+ * about WIFI_RECONNECT_MIN_MS, doubling per failed attempt up to
+ * WIFI_RECONNECT_MAX_MS (each delay is randomised by up to -50 %).   */
+#define WIFI_RECONNECT_MIN_MS   250
+#define WIFI_RECONNECT_MAX_MS   30000
+
+/* Backbone power save.  Modem sleep delays packets from the AP (e.g.
+ * Home Assistant → Thread) by up to a DTIM period; boards on USB power
+ * don't need it.  0 = always off (lowest latency), 1 = adaptive (off
+ * while forwarding, back on after WIFI_POWER_IDLE_MS idle), 2 = ESP-IDF
+ * default modem sleep.  Software coexistence (sdkconfig.defaults)
+ * needs modem sleep, so 0 and 1 only apply in builds without it.      */
+#define WIFI_POWER_POLICY       1
+#define WIFI_POWER_IDLE_MS      3000
+
+/* Gateway ping interval for the backbone RTT statistics ("otbr power",
+ * /metrics).  0 = disabled.                                           */
+#define WIFI_RTT_PROBE_MS       5000
+
 /* ------------------------------------------------------------------ */
 /*  JOIN AN EXISTING THREAD NETWORK                                    */
 /* ------------------------------------------------------------------ */
@@ -52,21 +71,185 @@
  * Usually you want this set to 0 so the device waits for credentials. */
 #define THREAD_AUTO_START       0
 
-/* Default Thread channel (only used when THREAD_AUTO_START == 1)      */
-#define THREAD_CHANNEL          15
+/* Thread channel for a new network (only used when THREAD_AUTO_START
+ * == 1).  0 = pick the least-contended channel from an energy scan,
+ * away from the Wi-Fi AP's channel; 11-26 = use that channel.         */
+#define THREAD_CHANNEL          0
+
+/* A new network's energy scan waits up to this long (ms) for Wi-Fi to
+ * associate, so the AP's channel is part of the plan.                 */
+#define CHANNEL_AP_WAIT_MS      15000
+
+/* When the Wi-Fi AP moves to another channel and the Thread channel
+ * now scores this much worse (dB) than the best one, suggest moving
+ * the network ("otbr channel migrate <ch>").  With CHANNEL_AUTO_MIGRATE
+ * set, the leader starts the move itself via a pending dataset that
+ * takes effect after CHANNEL_MIGRATE_DELAY_MS (ms).                   */
+#define CHANNEL_MIGRATE_MARGIN_DB 10
+#define CHANNEL_AUTO_MIGRATE    0
+#define CHANNEL_MIGRATE_DELAY_MS 300000
 
 /* Default Thread network name (only used when THREAD_AUTO_START == 1) */
 #define THREAD_NETWORK_NAME     "OpenThread-HA"
 
+/* After a reboot, reuse the router ID and role cached from the last
+ * boot to get back to router/leader quickly (1) instead of waiting out
+ * the normal detached → child → router upgrade jitter (0).           */
+#define THREAD_FAST_REATTACH    1
+
 /* ------------------------------------------------------------------ */
 /*  ADVANCED / OPTIONAL                                                */
 /* ------------------------------------------------------------------ */
 
 /* OpenThread CLI over USB serial — set to 1 for serial provisioning.
- * When enabled, a ">" prompt appears on the monitor output.           */
+ * When enabled, a ">" prompt appears on the monitor output, including
+ * the firmware's own diagnostics ("otbr help").                      */
 #define OT_CLI_UART_ENABLE      0
 
 /* mDNS instance name (used for HA discovery, derived from DEVICE_NAME)*/
 #define MDNS_INSTANCE_NAME      DEVICE_NAME
 
+/* Prometheus-style metrics: http://<DEVICE_NAME>.local:<port>/metrics
+ * Forwarding counters, queue drops, SRP/NAT64, heap and stack usage.
+ * Set to 0 to disable the HTTP endpoint.                              */
+#define METRICS_HTTP_PORT       9100
+
+/* Log output is queued as compact binary records (format string +
+ * arguments, one to three 96-byte slots each) in a ring of this many
+ * slots and written out by a low-priority task, so a slow USB console
+ * never blocks Wi-Fi events or the Thread mainloop.  A full ring drops
+ * the newest records and says how many ("otbr log").  Power of two;
+ * 0 = log synchronously.                                              */
+#define LOG_RING_SLOTS          128
+
+/* Also stream log lines over UDP to a collector on the LAN, e.g.
+ * "192.168.1.10" ("nc -klu 5140" there).  "" = console only; can be
+ * changed at run time with "otbr log udp".                            */
+#define LOG_UDP_COLLECTOR       ""
+#define LOG_UDP_PORT            5140
+
+/* Packet capture ("otbr capture"): packets from both interfaces are
+ * queued in a ring of CAPTURE_SLOTS records (power of two) of the first
+ * CAPTURE_SNAPLEN bytes each, allocated on the first capture (about
+ * 10 KB with the defaults), and streamed as pcapng.                   */
+#define CAPTURE_SLOTS           64
+#define CAPTURE_SNAPLEN         128
+
+/* Profile the OpenThread mainloop from boot (iteration, tasklet, timer
+ * and radio latency histograms, CPU share per task) instead of only
+ * after "otbr profile start".  Costs a few timestamps per iteration.  */
+#define OT_PROFILER_AT_BOOT     0
+
+/* Depth of the Wi-Fi/lwIP → OpenThread packet queue (netif) and of
+ * the OpenThread task queue.  Bursts such as an OTA image pushed to a
+ * Thread device overflow shallow queues; watch the dropped counter on
+ * /metrics or run "otbr burst".  0 = size from free heap at boot.     */
+#define OT_NETIF_QUEUE_SIZE     0
+#define OT_TASK_QUEUE_SIZE      0
+
+/* OpenThread settings live in the "ot_storage" partition.  Writes of
+ * low-value, high-churn keys (parent info, SRP state) are held in RAM
+ * this long and flushed by a background task as one write per key;
+ * identical rewrites are dropped.  Each flash write still stalls the
+ * single-core C6, mainloop included; the time is on /metrics.        */
+#define OT_SETTINGS_COALESCE_MS 5000
+
+/* Wi-Fi / Thread share one radio.  1 = raise the 802.15.4 coexistence
+ * priority while Thread MAC retries/CCA failures climb under backbone
+ * load, and drop it again when they settle ("otbr coex").  0 = keep
+ * the ESP-IDF default priorities.                                     */
+#define COEX_ADAPTIVE           1
+
+/* With several border routers on one Thread network: 1 = publish this
+ * router's routes with a higher or lower preference as its health
+ * (backbone RSSI, Thread MAC retries, buffer/queue pressure, free heap)
+ * changes, so traffic flows through the best-connected one
+ * ("otbr route").  A preference is kept at least ROUTE_HEALTH_HOLD_S. */
+#define ROUTE_HEALTH_ADAPT      1
+#define ROUTE_HEALTH_HOLD_S     60
+
+/* Multicast between Thread and the backbone ("otbr mcast"), for groups
+ * wider than realm-local.  0 = forward everything, as lwIP does.
+ * 1 = forward a group only if the other side has a listener: Thread
+ * devices' MLR registrations, backbone hosts' MLD reports.  A host
+ * whose report was missed loses its group until it reports again, so
+ * filtering is opt-in.  2 = also send a group with few backbone
+ * listeners to each as unicast Wi-Fi frames (data rate, no DTIM wait)
+ * when that takes less airtime.                                       */
+#define MCAST_POLICY            0
+
+/* Wi-Fi rates behind the airtime estimates (kbit/s): the AP's lowest
+ * basic rate, which multicast uses, and a typical unicast data rate.  */
+#define MCAST_BASIC_RATE_KBPS   1000
+#define MCAST_UNICAST_RATE_KBPS 24000
+
+/* SRP registrations from Thread devices are re-published on the LAN
+ * via mDNS.  Updates arriving within this window (ms) are merged and
+ * published as one batch — after a restart every device re-registers
+ * at once.  Capacity follows CONFIG_MDNS_MAX_SERVICES ("otbr srp").   */
+#define SRP_MDNS_BATCH_MS       50
+
+/* Discovery proxy: Thread devices' DNS-SD queries for LAN services
+ * (mDNS) and internet names (answered via NAT64) are looked up once
+ * and then served from a cache of at most this many bytes until the
+ * TTL runs out; popular names are refreshed ahead of expiry.  0 =
+ * leave discovery to OpenThread ("otbr dns").                         */
+#define DNS_PROXY_CACHE_BYTES   16384
+
+/* lwIP's resolver doesn't pass record TTLs through; internet names
+ * answered by the discovery proxy are cached this long (s).           */
+#define DNS_PROXY_UPSTREAM_TTL_S 60
+
+/* NAT64 for Thread → IPv4 traffic.  0 = OpenThread's translator and
+ * lwIP NAPT (fixed limits).  1 = this firmware's engine: a hashed
+ * mapping table of NAT64_MAX_MAPPINGS entries on backbone ports
+ * 16384 and up, with per-protocol idle timeouts and occupancy on
+ * /metrics ("otbr nat64").                                            */
+#define NAT64_ENGINE            0
+
+/* Engine mapping table size; 30 bytes per mapping, allocated only
+ * when NAT64_ENGINE is 1 (at most 16384).                             */
+#define NAT64_MAX_MAPPINGS 1024
+
+/* Engine idle timeouts (s).  TCP follows RFC 6146's established
+ * timeout; a TCP mapping that has seen FIN or RST drops to 240 s.     */
+#define NAT64_UDP_TIMEOUT_S 300
+#define NAT64_TCP_TIMEOUT_S 7440
+#define NAT64_ICMP_TIMEOUT_S 60
+
+/* Memory ("otbr mem").  Published SRP hosts and services, queued SRP
+ * updates and small discovery-proxy answers come from fixed pools of
+ * this many blocks, reserved at build time, so months of churn can't
+ * fragment the heap with them.  Both SRP pools are sized for
+ * SRP_HOSTS_EXPECTED devices with one service each: the mDNS responder
+ * holds at most CONFIG_MDNS_MAX_SERVICES (64, the component's limit)
+ * services, a few of them the border router's own, so more hosts could
+ * never be advertised.  Queued updates cover a quarter of the hosts
+ * re-registering within one SRP_MDNS_BATCH_MS window — about 18 KB in
+ * all with the defaults.  A full pool falls back to the heap and counts
+ * it on /metrics.                                                     */
+#define SRP_HOSTS_EXPECTED      60
+#define MEM_POOL_SRP_HOSTS      SRP_HOSTS_EXPECTED
+#define MEM_POOL_SRP_SERVICES   SRP_HOSTS_EXPECTED
+#define MEM_POOL_SRP_UPDATES    (SRP_HOSTS_EXPECTED / 4)
+#define MEM_POOL_DNS_ANSWERS    24
+
+/* A warning is logged once free heap, the largest free block, any
+ * task's untouched stack or free OpenThread message buffers drop below
+ * these — checked every 30 s, well before an allocation fails.        */
+#define MEM_WARN_FREE_BYTES     32768
+#define MEM_WARN_BLOCK_BYTES    8192
+#define MEM_WARN_STACK_BYTES    512
+#define MEM_WARN_OT_BUFFERS     16
+
+/* Stacks of the OpenThread task and the border router init task; the
+ * memory budget logged at startup shows how much of each is used.     */
+#define OT_TASK_STACK           20480
+#define BR_INIT_STACK           6144
+
+/* Thread starts as soon as the radio is up; border routing attaches to
+ * Wi-Fi later.  Once Wi-Fi has an IPv4 lease, wait at most this long
+ * for its IPv6 link-local address before attaching anyway (ms).       */
+#define BACKBONE_IPV6_WAIT_MS   10000
+
 #endif /* CONFIG_H */
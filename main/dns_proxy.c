@@ -0,0 +1,873 @@
+/*
+ * DNS-SD discovery proxy with an answer cache — see dns_proxy.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "lwip/dns.h"
+#include "mdns.h"
+
+#include "openthread/border_router.h"
+#include "openthread/dnssd_server.h"
+#include "openthread/srp_server.h"
+
+#include "config.h"
+#include "dns_proxy.h"
+#include "mem_pool.h"
+#include "metrics.h"
+
+static const char *TAG = "dns_proxy";
+
+/* Few enough that a linear scan (hash compare first) is cheaper than
+ * keeping an index; the byte budget is normally the tighter limit.    */
+#define CACHE_ENTRIES           64
+
+/* Host, upstream and most single-instance answers fit a pool block */
+#define ANSWER_BLOCK            192
+
+#define DNS_NAME_MAX            256     /* full name + NUL */
+#define LABEL_MAX               64
+#define ADDRS_MAX               4
+
+/* Browse answers come from several responders, each after a random
+ * 20-120 ms delay; resolves stop at the first answer.                 */
+#define BROWSE_TIMEOUT_MS       500
+#define RESOLVE_TIMEOUT_MS      2000
+#define BROWSE_MAX_RESULTS      16
+
+#define POLL_MS                 100
+
+/* Refresh-ahead: an entry asked for at least this often since it was
+ * fetched is looked up again once 80 % of its TTL has passed (the
+ * point where mDNS queriers refresh too).                             */
+#define REFRESH_HITS            2
+#define REFRESH_AT_PERCENT      80
+
+#define FNV_INIT                2166136261u
+
+typedef enum {
+    ENTRY_FREE,
+    ENTRY_QUEUED,               /* waiting for the task to start a lookup */
+    ENTRY_RESOLVING,            /* first lookup in flight, no answer yet */
+    ENTRY_VALID,
+} entry_state_t;
+
+typedef enum {
+    KIND_BROWSE,                /* _svc._tcp.<domain>        → PTR      */
+    KIND_INSTANCE,              /* inst._svc._tcp.<domain>   → SRV/TXT  */
+    KIND_HOST,                  /* host.<domain>             → AAAA     */
+    KIND_UPSTREAM,              /* anything else, via lwIP DNS (+NAT64) */
+} entry_kind_t;
+
+typedef struct {
+    entry_kind_t kind;
+    char instance[LABEL_MAX];
+    char service[LABEL_MAX];
+    char proto[LABEL_MAX];
+    char host[LABEL_MAX];
+} query_t;
+
+/* One service instance or host in an answer; strings and TXT data live
+ * in the same allocation, after the record array.                     */
+typedef struct {
+    const char *instance;       /* NULL for host answers */
+    const char *host;
+    const uint8_t *txt;
+    uint16_t txt_len;
+    uint16_t port;
+    uint8_t num_addrs;
+    otIp6Address addrs[ADDRS_MAX];
+    uint32_t ipv4;              /* network order; used via NAT64 when no IPv6 */
+} answer_rec_t;
+
+typedef struct {
+    uint16_t count;
+    answer_rec_t recs[];
+} answer_t;
+
+/* Written by lwIP's DNS callback in the tcpip thread */
+typedef struct {
+    volatile bool done;
+    bool found;
+    ip_addr_t addr;
+    char name[DNS_NAME_MAX];
+} upstream_req_t;
+
+typedef struct {
+    char *name;                 /* as OpenThread asked for it */
+    uint32_t hash;              /* of the lower-cased name */
+    uint8_t state;
+    uint8_t kind;
+    bool subscribed;            /* a DNS-SD query is waiting for this name */
+    bool deliver;               /* answer to hand to OpenThread */
+    bool refreshing;            /* lookup in flight for a VALID entry */
+    bool busy;                  /* task is calling mDNS/lwIP, lock released */
+    uint32_t ttl_s;
+    uint32_t hits;              /* since the answer was fetched */
+    int64_t expires_us;
+    int64_t last_used_us;
+    int64_t started_us;
+    size_t bytes;               /* name + answer */
+    answer_t *answer;
+    mdns_search_once_t *search;
+    upstream_req_t *upstream;
+} entry_t;
+
+MEM_POOL_DEFINE(s_answer_pool, "dns_answer", ANSWER_BLOCK, MEM_POOL_DNS_ANSWERS);
+
+/* Cache (s_cache_lock).  Lock order: OpenThread lock, then this one.
+ * Never held across calls into mDNS or lwIP: the tcpip thread can be
+ * waiting for the OpenThread lock, whose holder may be waiting for this.
+ * An entry marked busy stays put (in_flight) while it is released.    */
+static SemaphoreHandle_t s_cache_lock;
+static entry_t s_entries[CACHE_ENTRIES];
+static size_t s_bytes;
+
+static char s_domain[DNS_NAME_MAX] = "default.service.arpa.";
+static otInstance *s_instance;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static dns_proxy_stats_t s_stats;
+static TaskHandle_t s_task;
+
+static void count_stat(uint32_t *counter)
+{
+    taskENTER_CRITICAL(&s_lock);
+    (*counter)++;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Names                                                              */
+/* ------------------------------------------------------------------ */
+
+static uint32_t name_hash(const char *name)
+{
+    uint32_t hash = FNV_INIT;
+    for (const char *p = name; *p != '\0'; p++) {
+        char c = *p;
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        hash = (hash ^ (uint8_t)c) * 16777619u;
+    }
+    return hash;
+}
+
+/* Copies the first label of *name into out and steps past it */
+static bool next_label(const char **name, char *out, size_t size)
+{
+    const char *dot = strchr(*name, '.');
+    size_t len = dot != NULL ? (size_t)(dot - *name) : strlen(*name);
+
+    if (len == 0 || len >= size) return false;
+    memcpy(out, *name, len);
+    out[len] = '\0';
+    *name += dot != NULL ? len + 1 : len;
+    return true;
+}
+
+static bool is_proto(const char *label)
+{
+    return strcasecmp(label, "_tcp") == 0 || strcasecmp(label, "_udp") == 0;
+}
+
+static bool ends_with(const char *name, const char *suffix)
+{
+    size_t n = strlen(name), s = strlen(suffix);
+    return n >= s && strcasecmp(name + n - s, suffix) == 0;
+}
+
+/* Works out what OpenThread is asking for.  Names under the Thread
+ * domain map onto .local; subtype browses and reverse lookups aren't
+ * proxied.                                                            */
+static bool parse_query(const char *name, query_t *q)
+{
+    size_t len = strlen(name), dlen = strlen(s_domain);
+    char labels[3][LABEL_MAX];
+    int count = 0;
+
+    memset(q, 0, sizeof(*q));
+
+    if (len > dlen && name[len - dlen - 1] == '.' && ends_with(name, s_domain)) {
+        const char *end = name + len - dlen;
+        const char *p = name;
+        while (p < end) {
+            if (count == 3 || !next_label(&p, labels[count], LABEL_MAX)) return false;
+            count++;
+        }
+
+        if (count == 1) {
+            q->kind = KIND_HOST;
+            strcpy(q->host, labels[0]);
+            return true;
+        }
+        if (count == 2 && labels[0][0] == '_' && is_proto(labels[1])) {
+            q->kind = KIND_BROWSE;
+            strcpy(q->service, labels[0]);
+            strcpy(q->proto, labels[1]);
+            return true;
+        }
+        if (count == 3 && labels[1][0] == '_' && is_proto(labels[2])) {
+            q->kind = KIND_INSTANCE;
+            strcpy(q->instance, labels[0]);
+            strcpy(q->service, labels[1]);
+            strcpy(q->proto, labels[2]);
+            return true;
+        }
+        return false;
+    }
+
+    /* Internet host names only: no service labels, no .local/.arpa */
+    if (strchr(name, '_') != NULL || ends_with(name, ".local.") || ends_with(name, ".arpa.")) {
+        return false;
+    }
+    q->kind = KIND_UPSTREAM;
+    return true;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Cache entries (s_cache_lock held)                                  */
+/* ------------------------------------------------------------------ */
+
+static entry_t *find_entry(const char *name, uint32_t hash)
+{
+    for (int i = 0; i < CACHE_ENTRIES; i++) {
+        entry_t *e = &s_entries[i];
+        if (e->state != ENTRY_FREE && e->hash == hash && strcasecmp(e->name, name) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static bool in_flight(const entry_t *e)
+{
+    return e->search != NULL || e->upstream != NULL || e->busy;
+}
+
+static void drop_answer(entry_t *e)
+{
+    size_t name_bytes = strlen(e->name) + 1;
+    s_bytes -= e->bytes - name_bytes;
+    e->bytes = name_bytes;
+    mem_pool_free(&s_answer_pool, e->answer);
+    e->answer = NULL;
+}
+
+static void free_entry(entry_t *e)
+{
+    if (e->search != NULL) mdns_query_async_delete(e->search);
+    free(e->upstream);
+    mem_pool_free(&s_answer_pool, e->answer);
+    free(e->name);
+    s_bytes -= e->bytes;
+    memset(e, 0, sizeof(*e));
+}
+
+/* Least recently used answer that nobody is waiting on */
+static entry_t *lru_victim(const entry_t *keep)
+{
+    entry_t *victim = NULL;
+    for (int i = 0; i < CACHE_ENTRIES; i++) {
+        entry_t *e = &s_entries[i];
+        if (e == keep || e->state != ENTRY_VALID || e->deliver || in_flight(e)) continue;
+        if (victim == NULL || e->last_used_us < victim->last_used_us) victim = e;
+    }
+    return victim;
+}
+
+static void enforce_budget(void)
+{
+    while (s_bytes > DNS_PROXY_CACHE_BYTES) {
+        entry_t *victim = lru_victim(NULL);
+        if (victim == NULL) break;
+        free_entry(victim);
+        count_stat(&s_stats.evicted);
+    }
+}
+
+static entry_t *new_entry(const char *name, uint32_t hash, entry_kind_t kind)
+{
+    entry_t *e = NULL;
+    for (int i = 0; i < CACHE_ENTRIES && e == NULL; i++) {
+        if (s_entries[i].state == ENTRY_FREE) e = &s_entries[i];
+    }
+    if (e == NULL) {
+        e = lru_victim(NULL);
+        if (e == NULL) return NULL;
+        free_entry(e);
+        count_stat(&s_stats.evicted);
+    }
+
+    e->name = strdup(name);
+    if (e->name == NULL) return NULL;
+    e->hash = hash;
+    e->kind = kind;
+    e->bytes = strlen(name) + 1;
+    s_bytes += e->bytes;
+    return e;
+}
+
+/* ------------------------------------------------------------------ */
+/*  DNS-SD server callbacks (OpenThread mainloop)                      */
+/* ------------------------------------------------------------------ */
+
+static void on_subscribe(void *context, const char *name)
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t hash = name_hash(name);
+    query_t q;
+
+    count_stat(&s_stats.queries);
+
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    entry_t *e = find_entry(name, hash);
+
+    if (e != NULL && e->state == ENTRY_VALID && e->expires_us > now) {
+        /* Handed over by the task: answering from inside this callback
+         * would re-enter the DNS-SD server mid-query.                 */
+        e->hits++;
+        e->last_used_us = now;
+        e->subscribed = true;
+        e->deliver = true;
+        count_stat(&s_stats.hits);
+    } else if (e != NULL && (e->state != ENTRY_VALID || e->refreshing || e->busy)) {
+        e->subscribed = true;
+        e->last_used_us = now;
+        count_stat(&s_stats.misses);
+        count_stat(&s_stats.coalesced);
+    } else if (e != NULL) {
+        /* Expired and not worth refreshing: look it up again */
+        drop_answer(e);
+        e->state = ENTRY_QUEUED;
+        e->subscribed = true;
+        e->hits = 0;
+        e->last_used_us = now;
+        count_stat(&s_stats.misses);
+    } else if (parse_query(name, &q)) {
+        e = new_entry(name, hash, q.kind);
+        if (e != NULL) {
+            e->state = ENTRY_QUEUED;
+            e->subscribed = true;
+            e->last_used_us = now;
+        }
+        count_stat(&s_stats.misses);
+    } else {
+        count_stat(&s_stats.unsupported);
+    }
+    xSemaphoreGive(s_cache_lock);
+
+    if (e != NULL) xTaskNotifyGive(s_task);
+}
+
+static void on_unsubscribe(void *context, const char *name)
+{
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    entry_t *e = find_entry(name, name_hash(name));
+    if (e != NULL) e->subscribed = false;
+    xSemaphoreGive(s_cache_lock);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Lookups (proxy task, s_cache_lock held except around mDNS / lwIP)  */
+/* ------------------------------------------------------------------ */
+
+static void on_search_done(mdns_search_once_t *search)
+{
+    xTaskNotifyGive(s_task);
+}
+
+static void on_upstream_found(const char *name, const ip_addr_t *addr, void *arg)
+{
+    upstream_req_t *req = arg;
+    if (addr != NULL) {
+        req->addr = *addr;
+        req->found = true;
+    }
+    req->done = true;
+    xTaskNotifyGive(s_task);
+}
+
+/* Runs in the tcpip thread, where lwIP's resolver lives */
+static esp_err_t upstream_start(void *ctx)
+{
+    upstream_req_t *req = ctx;
+    err_t err = dns_gethostbyname_addrtype(req->name, &req->addr, on_upstream_found, req,
+                                           LWIP_DNS_ADDRTYPE_IPV6_IPV4);
+    if (err == ERR_OK) {
+        req->found = true;      /* in lwIP's own cache */
+        req->done = true;
+    } else if (err != ERR_INPROGRESS) {
+        req->done = true;
+    }
+    return ESP_OK;
+}
+
+static bool start_lookup(entry_t *e, int64_t now)
+{
+    query_t q;
+    mdns_search_once_t *search = NULL;
+    upstream_req_t *upstream = NULL;
+
+    if (!parse_query(e->name, &q)) return false;
+    if (q.kind == KIND_UPSTREAM) {
+        upstream = calloc(1, sizeof(*upstream));
+        if (upstream == NULL) return false;
+        strlcpy(upstream->name, e->name, sizeof(upstream->name));
+        size_t len = strlen(upstream->name);
+        if (upstream->name[len - 1] == '.') upstream->name[len - 1] = '\0';
+    }
+
+    e->busy = true;
+    xSemaphoreGive(s_cache_lock);
+    switch (q.kind) {
+    case KIND_BROWSE:
+        search = mdns_query_async_new(NULL, q.service, q.proto, MDNS_TYPE_PTR,
+                                      BROWSE_TIMEOUT_MS, BROWSE_MAX_RESULTS, on_search_done);
+        break;
+    case KIND_INSTANCE:
+        search = mdns_query_async_new(q.instance, q.service, q.proto, MDNS_TYPE_SRV,
+                                      RESOLVE_TIMEOUT_MS, 1, on_search_done);
+        break;
+    case KIND_HOST:
+        /* A and AAAA: IPv4-only hosts are reachable through NAT64 */
+        search = mdns_query_async_new(q.host, NULL, NULL, MDNS_TYPE_ANY,
+                                      RESOLVE_TIMEOUT_MS, 1, on_search_done);
+        break;
+    case KIND_UPSTREAM:
+        esp_netif_tcpip_exec(upstream_start, upstream);
+        break;
+    }
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    e->busy = false;
+    e->search = search;
+    e->upstream = upstream;
+
+    if (!in_flight(e)) return false;
+    e->started_us = now;
+    count_stat(&s_stats.lookups);
+    return true;
+}
+
+static uint8_t copy_addrs(const mdns_ip_addr_t *a, answer_rec_t *rec)
+{
+    for (; a != NULL && rec->num_addrs < ADDRS_MAX; a = a->next) {
+        if (a->addr.type == ESP_IPADDR_TYPE_V4) {
+            if (rec->ipv4 == 0) rec->ipv4 = a->addr.u_addr.ip4.addr;
+            continue;
+        }
+
+        otIp6Address *addr = &rec->addrs[rec->num_addrs];
+        memcpy(addr->mFields.m32, a->addr.u_addr.ip6.addr, sizeof(addr->mFields.m32));
+        /* Backbone link-local addresses mean nothing inside the mesh */
+        if (addr->mFields.m8[0] == 0xfe && (addr->mFields.m8[1] & 0xc0) == 0x80) continue;
+        rec->num_addrs++;
+    }
+    return rec->num_addrs;
+}
+
+static size_t txt_item_len(const mdns_result_t *r, size_t i)
+{
+    const mdns_txt_item_t *item = &r->txt[i];
+    size_t value_len = r->txt_value_len != NULL ? r->txt_value_len[i]
+                       : item->value != NULL ? strlen(item->value) : 0;
+    size_t len = strlen(item->key) + (item->value != NULL ? 1 + value_len : 0);
+    return len > 255 ? 255 : len;
+}
+
+/* TXT key/value pairs back to DNS wire format */
+static size_t txt_encode(const mdns_result_t *r, uint8_t *out)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < r->txt_count; i++) {
+        size_t len = txt_item_len(r, i);
+        if (out != NULL) {
+            const mdns_txt_item_t *item = &r->txt[i];
+            size_t key_len = strlen(item->key);
+            uint8_t *p = out + total;
+            *p++ = (uint8_t)len;
+            memcpy(p, item->key, key_len < len ? key_len : len);
+            if (item->value != NULL && key_len < len) {
+                p[key_len] = '=';
+                memcpy(p + key_len + 1, item->value, len - key_len - 1);
+            }
+        }
+        total += 1 + len;
+    }
+    return total;
+}
+
+/* Copies mDNS results into one allocation.  Host lookups collapse into
+ * a single record; service results without a host are skipped.        */
+static answer_t *answer_from_mdns(const entry_t *e, const mdns_result_t *results,
+                                  size_t *size, uint32_t *ttl_s)
+{
+    bool host_only = e->kind == KIND_HOST;
+    size_t count = 0, extra = 0;
+    uint32_t ttl = UINT32_MAX;
+
+    for (const mdns_result_t *r = results; r != NULL; r = r->next) {
+        if (!host_only && (r->hostname == NULL || r->instance_name == NULL)) continue;
+        if (!host_only || count == 0) count++;
+        if (!host_only) {
+            extra += strlen(r->instance_name) + 1 + strlen(r->hostname) + 1 + txt_encode(r, NULL);
+        }
+        if (r->ttl < ttl) ttl = r->ttl;
+    }
+    if (count == 0) return NULL;
+
+    *size = sizeof(answer_t) + count * sizeof(answer_rec_t) + extra;
+    answer_t *answer = mem_pool_alloc(&s_answer_pool, *size);
+    if (answer == NULL) return NULL;
+
+    char *heap = (char *)&answer->recs[count];
+    for (const mdns_result_t *r = results; r != NULL; r = r->next) {
+        if (host_only) {
+            copy_addrs(r->addr, &answer->recs[0]);
+            continue;
+        }
+        if (r->hostname == NULL || r->instance_name == NULL) continue;
+
+        answer_rec_t *rec = &answer->recs[answer->count++];
+        rec->instance = strcpy(heap, r->instance_name);
+        heap += strlen(heap) + 1;
+        rec->host = strcpy(heap, r->hostname);
+        heap += strlen(heap) + 1;
+        rec->txt = (uint8_t *)heap;
+        rec->txt_len = (uint16_t)txt_encode(r, (uint8_t *)heap);
+        heap += rec->txt_len;
+        rec->port = r->port;
+        copy_addrs(r->addr, rec);
+    }
+    if (host_only) answer->count = 1;
+
+    if (host_only && answer->recs[0].num_addrs == 0 && answer->recs[0].ipv4 == 0) {
+        mem_pool_free(&s_answer_pool, answer);
+        return NULL;
+    }
+    *ttl_s = ttl;
+    return answer;
+}
+
+static answer_t *answer_from_upstream(const upstream_req_t *req, size_t *size, uint32_t *ttl_s)
+{
+    if (!req->found) return NULL;
+
+    *size = sizeof(answer_t) + sizeof(answer_rec_t);
+    answer_t *answer = mem_pool_alloc(&s_answer_pool, *size);
+    if (answer == NULL) return NULL;
+
+    answer->count = 1;
+    if (IP_IS_V6(&req->addr)) {
+        memcpy(answer->recs[0].addrs[0].mFields.m32, ip_2_ip6(&req->addr)->addr,
+               sizeof(answer->recs[0].addrs[0].mFields.m32));
+        answer->recs[0].num_addrs = 1;
+    } else {
+        answer->recs[0].ipv4 = ip_2_ip4(&req->addr)->addr;
+    }
+
+    /* lwIP's resolver doesn't pass the record TTL through */
+    *ttl_s = DNS_PROXY_UPSTREAM_TTL_S;
+    return answer;
+}
+
+static void finish_lookup(entry_t *e, int64_t now)
+{
+    mdns_result_t *results = NULL;
+    answer_t *answer = NULL;
+    size_t size = 0;
+    uint32_t ttl_s = 0;
+
+    if (e->search != NULL) {
+        mdns_search_once_t *search = e->search;
+        uint8_t num = 0;
+
+        e->busy = true;
+        xSemaphoreGive(s_cache_lock);
+        bool ready = mdns_query_async_get_results(search, 0, &results, &num);
+        if (ready) {
+            mdns_query_async_delete(search);
+            answer = answer_from_mdns(e, results, &size, &ttl_s);
+            mdns_query_results_free(results);
+        }
+        xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+        e->busy = false;
+
+        if (!ready) return;
+        e->search = NULL;
+    } else {
+        if (!e->upstream->done) return;
+        answer = answer_from_upstream(e->upstream, &size, &ttl_s);
+        free(e->upstream);
+        e->upstream = NULL;
+    }
+
+    uint32_t elapsed_ms = (uint32_t)((now - e->started_us) / 1000);
+    bool refresh = e->refreshing;
+    e->refreshing = false;
+
+    if (answer == NULL) {
+        count_stat(&s_stats.failures);
+        /* A failed refresh keeps serving the old answer until it expires */
+        if (!refresh) free_entry(e);
+        return;
+    }
+
+    if (e->answer != NULL) drop_answer(e);
+    e->answer = answer;
+    e->bytes += size;
+    s_bytes += size;
+    e->state = ENTRY_VALID;
+    e->ttl_s = ttl_s;
+    e->hits = 0;
+    e->expires_us = now + (int64_t)ttl_s * 1000000;
+    if (e->subscribed) e->deliver = true;
+
+    if (!refresh) {
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.lookup_ms_sum += elapsed_ms;
+        s_stats.lookup_count++;
+        if (elapsed_ms > s_stats.lookup_max_ms) s_stats.lookup_max_ms = elapsed_ms;
+        taskEXIT_CRITICAL(&s_lock);
+    }
+}
+
+static void age_entry(entry_t *e, int64_t now)
+{
+    int64_t left_us = e->expires_us - now;
+
+    if (left_us <= 0) {
+        free_entry(e);
+        count_stat(&s_stats.expired);
+        return;
+    }
+
+    int64_t refresh_us = (int64_t)e->ttl_s * 1000000 * (100 - REFRESH_AT_PERCENT) / 100;
+    if (e->hits >= REFRESH_HITS && left_us <= refresh_us && start_lookup(e, now)) {
+        e->refreshing = true;
+        count_stat(&s_stats.refreshes);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Answers (proxy task, OpenThread lock + s_cache_lock held)          */
+/* ------------------------------------------------------------------ */
+
+/* DNS64: the favored NAT64 prefix (always /96) + the IPv4 address */
+static bool nat64_synthesize(uint32_t ipv4, otIp6Address *out)
+{
+    otIp6Prefix prefix;
+    otRoutePreference preference;
+
+    if (otBorderRoutingGetFavoredNat64Prefix(s_instance, &prefix, &preference) != OT_ERROR_NONE ||
+        prefix.mLength != 96) {
+        return false;
+    }
+    *out = prefix.mPrefix;
+    out->mFields.m32[3] = ipv4;
+    return true;
+}
+
+static void deliver(entry_t *e, int64_t now)
+{
+    uint32_t ttl_s = (uint32_t)((e->expires_us - now + 999999) / 1000000);
+    char full_name[DNS_NAME_MAX];
+    char host_name[DNS_NAME_MAX];
+
+    for (uint16_t i = 0; i < e->answer->count; i++) {
+        const answer_rec_t *rec = &e->answer->recs[i];
+        const otIp6Address *addrs = rec->addrs;
+        uint8_t num_addrs = rec->num_addrs;
+        otIp6Address synthesized;
+
+        if (num_addrs == 0 && rec->ipv4 != 0 && nat64_synthesize(rec->ipv4, &synthesized)) {
+            addrs = &synthesized;
+            num_addrs = 1;
+        }
+
+        if (e->kind == KIND_HOST || e->kind == KIND_UPSTREAM) {
+            if (num_addrs == 0) continue;
+            otDnssdHostInfo info = {
+                .mAddressNum = num_addrs,
+                .mAddresses = addrs,
+                .mTtl = ttl_s,
+            };
+            otDnssdQueryHandleDiscoveredHost(s_instance, e->name, &info);
+            continue;
+        }
+
+        /* Browse answers name the instance under the service queried;
+         * a resolve was for the instance itself.                      */
+        const char *service_name = e->name;
+        if (e->kind == KIND_BROWSE) {
+            snprintf(full_name, sizeof(full_name), "%s.%s", rec->instance, e->name);
+        } else {
+            strlcpy(full_name, e->name, sizeof(full_name));
+            service_name = strchr(e->name, '.') + 1;
+        }
+        snprintf(host_name, sizeof(host_name), "%s.%s", rec->host, s_domain);
+
+        otDnssdServiceInstanceInfo info = {
+            .mFullName = full_name,
+            .mHostName = host_name,
+            .mAddressNum = num_addrs,
+            .mAddresses = addrs,
+            .mPort = rec->port,
+            .mTxtLength = rec->txt_len,
+            .mTxtData = rec->txt,
+            .mTtl = ttl_s,
+        };
+        otDnssdQueryHandleDiscoveredServiceInstance(s_instance, service_name, &info);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Proxy task                                                         */
+/* ------------------------------------------------------------------ */
+
+static void proxy_task(void *arg)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(POLL_MS));
+        int64_t now = esp_timer_get_time();
+        bool pending = false;
+
+        xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+        for (int i = 0; i < CACHE_ENTRIES; i++) {
+            entry_t *e = &s_entries[i];
+
+            if (e->state == ENTRY_QUEUED) {
+                if (start_lookup(e, now)) {
+                    e->state = ENTRY_RESOLVING;
+                } else {
+                    free_entry(e);
+                    count_stat(&s_stats.failures);
+                }
+            } else if (in_flight(e)) {
+                finish_lookup(e, now);
+            } else if (e->state == ENTRY_VALID && !e->deliver) {
+                age_entry(e, now);
+            }
+            if (e->deliver) pending = true;
+        }
+        xSemaphoreGive(s_cache_lock);
+
+        if (pending) {
+            esp_openthread_lock_acquire(portMAX_DELAY);
+            xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+            for (int i = 0; i < CACHE_ENTRIES; i++) {
+                entry_t *e = &s_entries[i];
+                if (!e->deliver) continue;
+                e->deliver = false;
+                if (e->answer != NULL) deliver(e, now);
+            }
+            xSemaphoreGive(s_cache_lock);
+            esp_openthread_lock_release();
+        }
+
+        xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+        enforce_budget();
+        uint32_t entries = 0;
+        for (int i = 0; i < CACHE_ENTRIES; i++) {
+            if (s_entries[i].state != ENTRY_FREE) entries++;
+        }
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.entries = entries;
+        s_stats.bytes = (uint32_t)s_bytes;
+        taskEXIT_CRITICAL(&s_lock);
+        xSemaphoreGive(s_cache_lock);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Control / metrics                                                  */
+/* ------------------------------------------------------------------ */
+
+static void write_metrics(metrics_writer_t *w)
+{
+    dns_proxy_stats_t st;
+    dns_proxy_get_stats(&st);
+
+    metrics_header(w, "otbr_dns_proxy_queries_total", "counter",
+                   "Discovery proxy queries by cache result");
+    metrics_sample(w, "otbr_dns_proxy_queries_total", "result=\"hit\"", st.hits);
+    metrics_sample(w, "otbr_dns_proxy_queries_total", "result=\"miss\"", st.misses);
+    metrics_sample(w, "otbr_dns_proxy_queries_total", "result=\"unsupported\"", st.unsupported);
+    metrics_counter(w, "otbr_dns_proxy_coalesced_total",
+                    "Misses that joined a lookup already in flight", st.coalesced);
+
+    metrics_header(w, "otbr_dns_proxy_lookups_total", "counter",
+                   "mDNS / DNS lookups sent to the backbone");
+    metrics_sample(w, "otbr_dns_proxy_lookups_total", "reason=\"miss\"",
+                   st.lookups - st.refreshes);
+    metrics_sample(w, "otbr_dns_proxy_lookups_total", "reason=\"refresh\"", st.refreshes);
+    metrics_counter(w, "otbr_dns_proxy_failures_total", "Lookups with no usable answer",
+                    st.failures);
+
+    metrics_header(w, "otbr_dns_proxy_removed_total", "counter", "Cache entries dropped");
+    metrics_sample(w, "otbr_dns_proxy_removed_total", "reason=\"expired\"", st.expired);
+    metrics_sample(w, "otbr_dns_proxy_removed_total", "reason=\"evicted\"", st.evicted);
+    metrics_gauge(w, "otbr_dns_proxy_entries", "Names cached or being looked up", st.entries);
+    metrics_gauge(w, "otbr_dns_proxy_cache_bytes", "Heap held by cached names and answers",
+                  st.bytes);
+    metrics_gauge(w, "otbr_dns_proxy_cache_limit_bytes", "DNS_PROXY_CACHE_BYTES",
+                  DNS_PROXY_CACHE_BYTES);
+
+    metrics_header(w, "otbr_dns_proxy_lookup_ms", "summary", "Cache miss to answer");
+    metrics_sample(w, "otbr_dns_proxy_lookup_ms_sum", NULL, st.lookup_ms_sum);
+    metrics_sample(w, "otbr_dns_proxy_lookup_ms_count", NULL, st.lookup_count);
+    metrics_gauge(w, "otbr_dns_proxy_lookup_max_ms", "Slowest cache miss", st.lookup_max_ms);
+}
+
+void dns_proxy_init(void)
+{
+    if (DNS_PROXY_CACHE_BYTES == 0 || s_task != NULL) return;
+
+    s_cache_lock = xSemaphoreCreateMutex();
+    mem_pool_register(&s_answer_pool);
+    metrics_register_source(write_metrics);
+    xTaskCreate(proxy_task, "dns_proxy", 4096, NULL, 4, &s_task);
+}
+
+void dns_proxy_start(otInstance *instance)
+{
+    if (s_task == NULL) {
+        ESP_LOGI(TAG, "Discovery proxy disabled (DNS_PROXY_CACHE_BYTES 0)");
+        return;
+    }
+
+    s_instance = instance;
+    strlcpy(s_domain, otSrpServerGetDomain(instance), sizeof(s_domain));
+    otDnssdQuerySetCallbacks(instance, on_subscribe, on_unsubscribe, NULL);
+    ESP_LOGI(TAG, "Discovery proxy for %s, cache %d bytes", s_domain, DNS_PROXY_CACHE_BYTES);
+}
+
+void dns_proxy_get_stats(dns_proxy_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void dns_proxy_flush(void)
+{
+    if (s_task == NULL) return;
+
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    for (int i = 0; i < CACHE_ENTRIES; i++) {
+        entry_t *e = &s_entries[i];
+        if (e->state == ENTRY_VALID && !in_flight(e) && !e->deliver) free_entry(e);
+    }
+    xSemaphoreGive(s_cache_lock);
+    xTaskNotifyGive(s_task);
+}
@@ -0,0 +1,61 @@
+/*
+ * DNS-SD discovery proxy with an answer cache
+ *
+ * Thread devices ask the border router's DNS-SD server for services on
+ * the LAN ("_hap._tcp.default.service.arpa.") and for internet names.
+ * Names that the SRP server can't answer are handed to this module,
+ * which looks them up over mDNS or lwIP's resolver and keeps the answer:
+ *   - answers are reused until their TTL runs out, so a sleepy device
+ *     polling the same service doesn't cost a Wi-Fi round-trip each time
+ *   - the cache is capped at DNS_PROXY_CACHE_BYTES (least recently used
+ *     answers go first)
+ *   - entries that are being asked for are looked up again shortly
+ *     before they expire, so popular names never miss
+ *   - identical queries arriving while a lookup is in flight wait for
+ *     that lookup instead of starting their own
+ *
+ * Internet names are answered with their IPv6 address, or with the
+ * NAT64 form of their IPv4 address (DNS64).  Hit rate and memory use
+ * are on /metrics and "otbr dns".
+ */
+
+#ifndef DNS_PROXY_H
+#define DNS_PROXY_H
+
+#include <stdint.h>
+
+#include "openthread/instance.h"
+
+typedef struct {
+    uint32_t queries;           /* names asked for by the DNS-SD server */
+    uint32_t hits;              /* answered from the cache             */
+    uint32_t misses;
+    uint32_t coalesced;         /* misses that joined a lookup in flight */
+    uint32_t lookups;           /* mDNS / DNS lookups started          */
+    uint32_t refreshes;         /* of those, refresh-ahead             */
+    uint32_t failures;          /* lookups that found nothing usable   */
+    uint32_t unsupported;       /* names not proxied (subtypes, reverse) */
+    uint32_t expired;
+    uint32_t evicted;           /* dropped to stay within the budget   */
+    uint32_t entries;
+    uint32_t bytes;             /* names + answers currently cached    */
+    uint64_t lookup_ms_sum;     /* miss → answer, per lookup           */
+    uint32_t lookup_count;
+    uint32_t lookup_max_ms;
+} dns_proxy_stats_t;
+
+/** Create the lookup task and register metrics.  Call after mdns_init(). */
+void dns_proxy_init(void);
+
+/**
+ * Take over the DNS-SD server's discovery queries.  Call with the
+ * OpenThread lock held, after the border router is initialized.
+ */
+void dns_proxy_start(otInstance *instance);
+
+void dns_proxy_get_stats(dns_proxy_stats_t *stats);
+
+/** Drop every cached answer (lookups in flight are kept). */
+void dns_proxy_flush(void);
+
+#endif /* DNS_PROXY_H */
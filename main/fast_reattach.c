@@ -0,0 +1,260 @@
+/*
+ * Fast mesh reattach after reboot — see fast_reattach.h
+ *
+ * How the fast path works:
+ *   - The router ID we held before the reboot is set as the preferred
+ *     router ID, so the leader hands the same ID back and neighbours'
+ *     routing tables stay valid.
+ *   - The router selection jitter (120 s by default) is shortened, and
+ *     as soon as we attach as a child we request a router upgrade
+ *     explicitly instead of waiting for the jitter to expire.
+ *   - Once router/leader is reached the default jitter is restored so
+ *     normal router-upgrade behaviour is unchanged afterwards.
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "nvs.h"
+
+#include "openthread/thread.h"
+#include "openthread/thread_ftd.h"
+
+#include "config.h"
+#include "boot_time.h"
+#include "fast_reattach.h"
+
+static const char *TAG = "reattach";
+
+#define REATTACH_NVS_NAMESPACE  "otbr"
+#define REATTACH_NVS_KEY        "reattach"
+#define REATTACH_CACHE_VERSION  1
+
+/* Router selection jitter used while the fast path is armed (seconds) */
+#define FAST_REATTACH_JITTER_S  1
+
+typedef struct {
+    uint8_t      version;
+    uint8_t      role;              /* otDeviceRole at last save        */
+    uint8_t      router_id;         /* valid when role is router/leader */
+    uint8_t      leader_router_id;
+    uint32_t     partition_id;
+    otExtAddress parent;            /* valid when parent_valid != 0     */
+    uint8_t      parent_valid;
+    uint32_t     fast_router_ms;    /* last time-to-router, fast path   */
+    uint32_t     standard_router_ms;/* last time-to-router, standard    */
+} reattach_cache_t;
+
+static reattach_cache_t s_cache;
+static reattach_cache_t s_saved;        /* what is currently in NVS     */
+static reattach_cache_t s_to_save;      /* handed to the save task      */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;   /* s_to_save */
+static TaskHandle_t s_save_task;
+static bool s_cache_loaded = false;
+static bool s_fast_armed = false;       /* jitter still shortened       */
+static bool s_fast_path = false;        /* this boot used the fast path */
+static bool s_measured = false;
+static uint8_t s_default_jitter;
+
+/* ------------------------------------------------------------------ */
+/*  NVS persistence                                                    */
+/* ------------------------------------------------------------------ */
+
+static bool cache_load(void)
+{
+    nvs_handle_t handle;
+    if (nvs_open(REATTACH_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+
+    size_t len = sizeof(s_cache);
+    esp_err_t err = nvs_get_blob(handle, REATTACH_NVS_KEY, &s_cache, &len);
+    nvs_close(handle);
+
+    if (err != ESP_OK || len != sizeof(s_cache) ||
+        s_cache.version != REATTACH_CACHE_VERSION) {
+        memset(&s_cache, 0, sizeof(s_cache));
+        return false;
+    }
+    s_saved = s_cache;
+    return true;
+}
+
+/* NVS writes stall everything running from flash for milliseconds, so
+ * they are done here rather than on the OpenThread mainloop.          */
+static void save_task(void *arg)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        reattach_cache_t cache;
+        taskENTER_CRITICAL(&s_lock);
+        cache = s_to_save;
+        taskEXIT_CRITICAL(&s_lock);
+        if (memcmp(&cache, &s_saved, sizeof(cache)) == 0) continue;
+
+        nvs_handle_t handle;
+        esp_err_t err = nvs_open(REATTACH_NVS_NAMESPACE, NVS_READWRITE, &handle);
+        if (err == ESP_OK) {
+            err = nvs_set_blob(handle, REATTACH_NVS_KEY, &cache, sizeof(cache));
+            if (err == ESP_OK) err = nvs_commit(handle);
+            nvs_close(handle);
+        }
+
+        if (err == ESP_OK) {
+            s_saved = cache;
+        } else {
+            ESP_LOGW(TAG, "Failed to save router state: %s", esp_err_to_name(err));
+        }
+    }
+}
+
+/* Mainloop: hand the current state to the save task */
+static void cache_save(void)
+{
+    s_cache.version = REATTACH_CACHE_VERSION;
+
+    taskENTER_CRITICAL(&s_lock);
+    s_to_save = s_cache;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (s_save_task == NULL &&
+        xTaskCreate(save_task, "reattach", 3072, NULL, 2, &s_save_task) != pdPASS) {
+        s_save_task = NULL;
+        ESP_LOGW(TAG, "No task to save router state");
+        return;
+    }
+    xTaskNotifyGive(s_save_task);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Boot-time comparison                                               */
+/* ------------------------------------------------------------------ */
+
+static void record_time_to_router(void)
+{
+    int64_t start_us  = boot_time_get_us(BOOT_PHASE_THREAD_START);
+    int64_t router_us = boot_time_get_us(BOOT_PHASE_THREAD_ROUTER);
+    if (s_measured || start_us < 0 || router_us < 0) return;
+    s_measured = true;
+
+    uint32_t ms = (uint32_t)((router_us - start_us) / 1000);
+    uint32_t other_ms;
+
+    if (s_fast_path) {
+        s_cache.fast_router_ms = ms;
+        other_ms = s_cache.standard_router_ms;
+    } else {
+        s_cache.standard_router_ms = ms;
+        other_ms = s_cache.fast_router_ms;
+    }
+
+    if (other_ms != 0) {
+        ESP_LOGI(TAG, "Time to router: %lu ms via %s path (last %s path: %lu ms)",
+                 (unsigned long)ms, s_fast_path ? "fast" : "standard",
+                 s_fast_path ? "standard" : "fast", (unsigned long)other_ms);
+    } else {
+        ESP_LOGI(TAG, "Time to router: %lu ms via %s path (no %s baseline yet)",
+                 (unsigned long)ms, s_fast_path ? "fast" : "standard",
+                 s_fast_path ? "standard" : "fast");
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                         */
+/* ------------------------------------------------------------------ */
+
+void fast_reattach_init(otInstance *instance)
+{
+    s_cache_loaded = cache_load();
+    if (!s_cache_loaded) {
+        ESP_LOGI(TAG, "No cached router state — standard attach");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Cached state: role=%s router_id=%u leader=%u partition=0x%08lx",
+             otThreadDeviceRoleToString((otDeviceRole)s_cache.role),
+             s_cache.router_id, s_cache.leader_router_id,
+             (unsigned long)s_cache.partition_id);
+
+#if THREAD_FAST_REATTACH
+    bool was_router = s_cache.role == OT_DEVICE_ROLE_ROUTER ||
+                      s_cache.role == OT_DEVICE_ROLE_LEADER;
+
+    if (!was_router || s_cache.router_id > OT_MAX_ROUTER_ID ||
+        !otThreadIsRouterEligible(instance)) {
+        return;
+    }
+
+    otError error = otThreadSetPreferredRouterId(instance, s_cache.router_id);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGW(TAG, "Failed to set preferred router ID %u: %d",
+                 s_cache.router_id, error);
+    }
+
+    s_default_jitter = otThreadGetRouterSelectionJitter(instance);
+    otThreadSetRouterSelectionJitter(instance, FAST_REATTACH_JITTER_S);
+    s_fast_armed = true;
+    s_fast_path = true;
+
+    ESP_LOGI(TAG, "Fast reattach armed: preferred router ID %u, jitter %u s",
+             s_cache.router_id, FAST_REATTACH_JITTER_S);
+#else
+    (void)instance;
+#endif
+}
+
+void fast_reattach_handle_state_change(otInstance *instance, otChangedFlags flags)
+{
+    if (!(flags & (OT_CHANGED_THREAD_ROLE | OT_CHANGED_THREAD_PARTITION_ID))) {
+        return;
+    }
+
+    otDeviceRole role = otThreadGetDeviceRole(instance);
+
+    if (role == OT_DEVICE_ROLE_CHILD) {
+        otRouterInfo parent;
+
+        if ((flags & OT_CHANGED_THREAD_ROLE) && s_fast_armed) {
+            otError error = otThreadBecomeRouter(instance);
+            ESP_LOGI(TAG, "Requesting router upgrade: %s",
+                     error == OT_ERROR_NONE ? "sent" : otThreadErrorToString(error));
+        }
+
+        if (otThreadGetParentInfo(instance, &parent) == OT_ERROR_NONE) {
+            if ((flags & OT_CHANGED_THREAD_ROLE) && s_cache_loaded && s_cache.parent_valid) {
+                bool same = memcmp(&parent.mExtAddress, &s_cache.parent,
+                                   sizeof(parent.mExtAddress)) == 0;
+                ESP_LOGI(TAG, "Attached to %s parent (router %u)",
+                         same ? "cached" : "different", parent.mRouterId);
+            }
+            s_cache.parent = parent.mExtAddress;
+            s_cache.parent_valid = 1;
+        }
+
+        /* While the router upgrade is pending, keep the cached router
+         * role so a reboot in this window still takes the fast path. */
+        if (!s_fast_armed) {
+            s_cache.role = (uint8_t)role;
+        }
+    } else if (role == OT_DEVICE_ROLE_ROUTER || role == OT_DEVICE_ROLE_LEADER) {
+        if (s_fast_armed) {
+            otThreadSetRouterSelectionJitter(instance, s_default_jitter);
+            s_fast_armed = false;
+        }
+        record_time_to_router();
+        s_cache.role = (uint8_t)role;
+        s_cache.router_id = (uint8_t)(otThreadGetRloc16(instance) >> 10);
+    } else {
+        /* Detached/disabled are transient on the way up or down — keep
+         * the last attached state so the next boot can use it. */
+        return;
+    }
+
+    s_cache.leader_router_id = otThreadGetLeaderRouterId(instance);
+    s_cache.partition_id = otThreadGetPartitionId(instance);
+    cache_save();
+}
@@ -0,0 +1,31 @@
+/*
+ * Fast mesh reattach after reboot
+ *
+ * Caches the last Thread role, router ID, leader and parent in NVS and
+ * uses them on the next boot to get back to router/leader as quickly
+ * as possible instead of walking detached → child → (jitter) → router.
+ *
+ * Also records time-to-router for the fast and standard paths so the
+ * two can be compared from the boot log.
+ */
+
+#ifndef FAST_REATTACH_H
+#define FAST_REATTACH_H
+
+#include "openthread/instance.h"
+
+/**
+ * Load the cached router state and, when THREAD_FAST_REATTACH is set,
+ * arm the fast path (preferred router ID, short selection jitter).
+ * Call with the OpenThread lock held, before otThreadSetEnabled().
+ */
+void fast_reattach_init(otInstance *instance);
+
+/**
+ * Feed OpenThread state changes (call from the state-change callback,
+ * after boot_time_mark() for the role phases).  The cache is written to
+ * NVS from a background task, not the mainloop.
+ */
+void fast_reattach_handle_state_change(otInstance *instance, otChangedFlags flags);
+
+#endif /* FAST_REATTACH_H */
@@ -0,0 +1,642 @@
+/*
+ * Deferred logging — see log_ring.h
+ */
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_memory_utils.h"
+#include "lwip/inet.h"
+#include "lwip/sockets.h"
+
+#include "config.h"
+#include "log_ring.h"
+#include "metrics.h"
+
+static const char *TAG = "log_ring";
+
+_Static_assert((LOG_RING_SLOTS & (LOG_RING_SLOTS - 1)) == 0,
+               "LOG_RING_SLOTS must be a power of two");
+_Static_assert(LOG_RING_SLOTS == 0 || LOG_RING_SLOTS >= LOG_RING_RECORD_SLOTS,
+               "LOG_RING_SLOTS must hold the longest record");
+_Static_assert(LOG_RING_RECORD_BYTES <= UINT8_MAX, "record length is a uint8_t");
+
+#define WRITER_POLL_MS          10
+#define LOG_LINE_MAX            256
+#define SPEC_MAX                24
+#define UDP_DATAGRAM_MAX        1200
+
+/* Bounded multi-producer queue (Vyukov): a slot's seq is its position
+ * while free and position + 1 once written; the writer hands it back
+ * for the next lap with position + LOG_RING_SLOTS.  A record claims
+ * its slots in one step and publishes its first slot last, so the
+ * writer sees a whole record or none of it.                           */
+typedef struct {
+    atomic_uint seq;
+    const char *fmt;            /* first slot of a record only         */
+    uint8_t len;                /* bytes of arguments in the record    */
+    uint8_t slots;              /* slots the record takes, this one on */
+    uint8_t truncated;
+    uint8_t args[LOG_RING_ARG_BYTES];
+} slot_t;
+
+/* A record put together outside the ring */
+typedef struct {
+    const char *fmt;            /* in flash; NULL: args[] holds the text */
+    uint8_t len;                /* bytes used in args[] */
+    uint8_t truncated;
+    uint8_t args[LOG_RING_RECORD_BYTES];
+} record_t;
+
+typedef enum {
+    ARG_NONE,                   /* "%%" */
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_SIZE,
+    ARG_PTR,
+    ARG_DOUBLE,
+    ARG_STR,                    /* stored as length byte + characters */
+    ARG_BAD,                    /* unsupported: the rest is not formatted */
+} arg_kind_t;
+
+typedef struct {
+    arg_kind_t kind;
+    uint8_t stars;              /* '*' width/precision ints before the value */
+} spec_t;
+
+static slot_t *s_slots;
+static atomic_uint s_head;
+static uint32_t s_tail;                 /* writer task only */
+static vprintf_like_t s_console;
+static TaskHandle_t s_task;
+
+/* Producer counters: any task, no lock */
+static atomic_uint s_queued;
+static atomic_uint s_dropped;
+static atomic_uint s_truncated;
+
+/* Writer statistics and collector (s_lock) */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static log_ring_stats_t s_stats;
+static struct sockaddr_storage s_collector;
+static uint32_t s_collector_gen;
+
+/* ------------------------------------------------------------------ */
+/*  Format strings                                                     */
+/* ------------------------------------------------------------------ */
+
+/* p points at '%'; returns the character after the conversion */
+static const char *parse_spec(const char *p, spec_t *spec)
+{
+    const char *s = p + 1;
+    int longs = 0;
+    bool size = false;
+
+    spec->stars = 0;
+    if (*s == '%') {
+        spec->kind = ARG_NONE;
+        return s + 1;
+    }
+
+    while (*s != '\0' && strchr("-+ #0", *s) != NULL) s++;
+    if (*s == '*') {
+        spec->stars++;
+        s++;
+    }
+    while (isdigit((unsigned char)*s)) s++;
+    if (*s == '.') {
+        s++;
+        if (*s == '*') {
+            spec->stars++;
+            s++;
+        }
+        while (isdigit((unsigned char)*s)) s++;
+    }
+    for (;; s++) {
+        if (*s == 'l') {
+            longs++;
+        } else if (*s == 'j') {
+            longs = 2;
+        } else if (*s == 'z' || *s == 't') {
+            size = true;
+        } else if (*s != 'h') {
+            break;
+        }
+    }
+
+    switch (*s) {
+    case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+        spec->kind = longs >= 2 ? ARG_LLONG : longs == 1 ? ARG_LONG : size ? ARG_SIZE : ARG_INT;
+        break;
+    case 'p':
+        spec->kind = ARG_PTR;
+        break;
+    case 's':
+        spec->kind = ARG_STR;
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        spec->kind = ARG_DOUBLE;
+        break;
+    default:
+        spec->kind = ARG_BAD;
+        return s;
+    }
+    return s + 1;
+}
+
+static size_t value_size(arg_kind_t kind)
+{
+    switch (kind) {
+    case ARG_INT:    return sizeof(int);
+    case ARG_LONG:   return sizeof(long);
+    case ARG_LLONG:  return sizeof(long long);
+    case ARG_SIZE:   return sizeof(size_t);
+    case ARG_PTR:    return sizeof(void *);
+    case ARG_DOUBLE: return sizeof(double);
+    default:         return 0;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Producer: esp_log output function                                  */
+/* ------------------------------------------------------------------ */
+
+static void capture(record_t *rec, const char *fmt, va_list ap)
+{
+    uint8_t *out = rec->args;
+    size_t used = 0;
+
+    rec->truncated = 0;
+    for (const char *p = strchr(fmt, '%'); p != NULL; p = strchr(p, '%')) {
+        spec_t spec;
+        p = parse_spec(p, &spec);
+        if (spec.kind == ARG_BAD) break;
+        if (spec.kind == ARG_NONE) continue;
+
+        size_t need = spec.stars * sizeof(int) + (spec.kind == ARG_STR ? 1 : value_size(spec.kind));
+        if (used + need > sizeof(rec->args)) {
+            rec->truncated = 1;
+            break;
+        }
+        for (uint8_t i = 0; i < spec.stars; i++) {
+            int star = va_arg(ap, int);
+            memcpy(out + used, &star, sizeof(star));
+            used += sizeof(star);
+        }
+
+        union { int i; long l; long long ll; size_t z; void *p; double d; } v;
+        switch (spec.kind) {
+        case ARG_INT:    v.i = va_arg(ap, int); break;
+        case ARG_LONG:   v.l = va_arg(ap, long); break;
+        case ARG_LLONG:  v.ll = va_arg(ap, long long); break;
+        case ARG_SIZE:   v.z = va_arg(ap, size_t); break;
+        case ARG_PTR:    v.p = va_arg(ap, void *); break;
+        case ARG_DOUBLE: v.d = va_arg(ap, double); break;
+        case ARG_STR: {
+            const char *str = va_arg(ap, const char *);
+            if (str == NULL) str = "(null)";
+            size_t room = sizeof(rec->args) - used - 1;
+            size_t len = strnlen(str, room < UINT8_MAX ? room : UINT8_MAX);
+            if (str[len] != '\0') rec->truncated = 1;
+            out[used++] = (uint8_t)len;
+            memcpy(out + used, str, len);
+            used += len;
+            continue;
+        }
+        default:
+            break;
+        }
+        memcpy(out + used, &v, value_size(spec.kind));
+        used += value_size(spec.kind);
+    }
+    rec->len = (uint8_t)used;
+}
+
+static inline slot_t *slot_at(unsigned pos)
+{
+    return &s_slots[pos & (LOG_RING_SLOTS - 1)];
+}
+
+/* Claim count consecutive slots; false when the ring is full.  The
+ * writer frees slots in order, so the last one free means all are.   */
+static bool claim(unsigned count, unsigned *out)
+{
+    unsigned pos = atomic_load_explicit(&s_head, memory_order_relaxed);
+
+    for (;;) {
+        unsigned last = pos + count - 1;
+        int diff = (int)(atomic_load_explicit(&slot_at(pos)->seq, memory_order_acquire) - pos);
+        int last_diff =
+            (int)(atomic_load_explicit(&slot_at(last)->seq, memory_order_acquire) - last);
+
+        if (diff == 0 && last_diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&s_head, &pos, pos + count,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                *out = pos;
+                return true;
+            }
+        } else if (diff < 0 || (diff == 0 && last_diff < 0)) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&s_head, memory_order_relaxed);
+        }
+    }
+}
+
+static int ring_vprintf(const char *fmt, va_list ap)
+{
+    record_t rec;
+
+    if (esp_ptr_in_drom(fmt)) {
+        rec.fmt = fmt;
+        capture(&rec, fmt, ap);
+    } else {
+        /* A format built at run time may be gone by the time the writer
+         * gets to it: format it here, into the record.                */
+        int n = vsnprintf((char *)rec.args, sizeof(rec.args), fmt, ap);
+        rec.fmt = NULL;
+        rec.truncated = n >= (int)sizeof(rec.args);
+        rec.len = n < 0 ? 0 : rec.truncated ? sizeof(rec.args) - 1 : (uint8_t)n;
+    }
+
+    unsigned count = rec.len == 0 ? 1 : (rec.len + LOG_RING_ARG_BYTES - 1) / LOG_RING_ARG_BYTES;
+    unsigned pos;
+    if (!claim(count, &pos)) {
+        atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed);
+        return 0;
+    }
+
+    /* Continuation slots first, then the head slot the writer waits on */
+    for (unsigned i = count; i-- > 0;) {
+        slot_t *slot = slot_at(pos + i);
+        size_t off = i * LOG_RING_ARG_BYTES;
+        size_t len = rec.len > off ? rec.len - off : 0;
+        memcpy(slot->args, rec.args + off, len < LOG_RING_ARG_BYTES ? len : LOG_RING_ARG_BYTES);
+        slot->fmt = rec.fmt;
+        slot->len = rec.len;
+        slot->slots = (uint8_t)(count - i);
+        slot->truncated = rec.truncated;
+        atomic_store_explicit(&slot->seq, pos + i + 1, memory_order_release);
+    }
+    if (rec.truncated) atomic_fetch_add_explicit(&s_truncated, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s_queued, 1, memory_order_relaxed);
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Writer task                                                        */
+/* ------------------------------------------------------------------ */
+
+static void append(char *line, size_t *n, const char *text, size_t len)
+{
+    if (*n + len >= LOG_LINE_MAX) len = LOG_LINE_MAX - 1 - *n;
+    memcpy(line + *n, text, len);
+    *n += len;
+    line[*n] = '\0';
+}
+
+/* Copy the conversion, with any '*' replaced by the recorded value */
+static bool build_spec(char *out, const char *start, const char *end, const int *stars)
+{
+    size_t n = 0;
+    uint8_t star = 0;
+
+    for (const char *s = start; s < end; s++) {
+        if (*s != '*') {
+            if (n + 1 >= SPEC_MAX) return false;
+            out[n++] = *s;
+            continue;
+        }
+        /* A negative precision means none: drop the '.' before it */
+        if (s > start && s[-1] == '.' && stars[star] < 0) {
+            n--;
+            star++;
+            continue;
+        }
+        int w = snprintf(out + n, SPEC_MAX - n, "%d", stars[star++]);
+        if (w < 0 || n + (size_t)w >= SPEC_MAX) return false;
+        n += (size_t)w;
+    }
+    out[n] = '\0';
+    return true;
+}
+
+static size_t format_record(const record_t *rec, char *line)
+{
+    const uint8_t *in = rec->args;
+    const uint8_t *in_end = rec->args + rec->len;
+    bool cut = rec->truncated;
+    const char *p = rec->fmt;
+    size_t n = 0;
+
+    line[0] = '\0';
+    if (p == NULL) {
+        append(line, &n, (const char *)rec->args, rec->len);
+        p = "";
+    }
+    while (*p != '\0') {
+        const char *pct = strchr(p, '%');
+        append(line, &n, p, pct != NULL ? (size_t)(pct - p) : strlen(p));
+        if (pct == NULL) break;
+
+        spec_t spec;
+        const char *end = parse_spec(pct, &spec);
+        if (spec.kind == ARG_NONE) {
+            append(line, &n, "%", 1);
+            p = end;
+            continue;
+        }
+        if (spec.kind == ARG_BAD) {
+            append(line, &n, pct, strlen(pct));
+            break;
+        }
+
+        int stars[2] = { 0, 0 };
+        size_t need = spec.stars * sizeof(int) + (spec.kind == ARG_STR ? 1 : value_size(spec.kind));
+        if (in + need > in_end) {
+            cut = true;
+            break;
+        }
+        for (uint8_t i = 0; i < spec.stars; i++) {
+            memcpy(&stars[i], in, sizeof(int));
+            in += sizeof(int);
+        }
+
+        char fmt[SPEC_MAX];
+        char tmp[LOG_LINE_MAX];
+        if (!build_spec(fmt, pct, end, stars)) {
+            cut = true;
+            break;
+        }
+
+        int w;
+        union { int i; long l; long long ll; size_t z; void *p; double d; } v;
+        if (spec.kind == ARG_STR) {
+            size_t len = *in++;
+            if (in + len > in_end) len = (size_t)(in_end - in);
+            char str[UINT8_MAX + 1];
+            memcpy(str, in, len);
+            str[len] = '\0';
+            in += len;
+            w = snprintf(tmp, sizeof(tmp), fmt, str);
+        } else {
+            memcpy(&v, in, value_size(spec.kind));
+            in += value_size(spec.kind);
+            switch (spec.kind) {
+            case ARG_INT:    w = snprintf(tmp, sizeof(tmp), fmt, v.i); break;
+            case ARG_LONG:   w = snprintf(tmp, sizeof(tmp), fmt, v.l); break;
+            case ARG_LLONG:  w = snprintf(tmp, sizeof(tmp), fmt, v.ll); break;
+            case ARG_SIZE:   w = snprintf(tmp, sizeof(tmp), fmt, v.z); break;
+            case ARG_PTR:    w = snprintf(tmp, sizeof(tmp), fmt, v.p); break;
+            default:         w = snprintf(tmp, sizeof(tmp), fmt, v.d); break;
+            }
+        }
+        if (w > 0) append(line, &n, tmp, strlen(tmp));
+        p = end;
+    }
+
+    if (cut) {
+        /* Keep the line ending (and colour reset) esp_log put last */
+        if (n > 0 && line[n - 1] == '\n') n--;
+        line[n] = '\0';
+        append(line, &n, " ...\n", 5);
+    }
+    return n;
+}
+
+static int console_printf(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    int n = s_console(fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+typedef struct {
+    int sock;
+    int family;
+    uint32_t gen;
+    struct sockaddr_storage dest;
+    size_t len;
+    char buf[UDP_DATAGRAM_MAX];
+} udp_out_t;
+
+static void udp_flush(udp_out_t *u)
+{
+    if (u->len == 0) return;
+
+    socklen_t dest_len = u->family == AF_INET6 ? sizeof(struct sockaddr_in6)
+                                               : sizeof(struct sockaddr_in);
+    bool ok = u->sock >= 0 &&
+              sendto(u->sock, u->buf, u->len, MSG_DONTWAIT, (struct sockaddr *)&u->dest,
+                     dest_len) == (ssize_t)u->len;
+    u->len = 0;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (ok) {
+        s_stats.udp_sent++;
+    } else {
+        s_stats.udp_failed++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/* Pick up a collector change from log_ring_set_collector() */
+static void udp_update(udp_out_t *u)
+{
+    taskENTER_CRITICAL(&s_lock);
+    bool changed = u->gen != s_collector_gen;
+    u->gen = s_collector_gen;
+    u->dest = s_collector;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (!changed) return;
+    u->len = 0;
+    if (u->sock >= 0 && u->family != u->dest.ss_family) {
+        close(u->sock);
+        u->sock = -1;
+    }
+    u->family = u->dest.ss_family;
+    if (u->sock < 0 && u->family != AF_UNSPEC) u->sock = socket(u->family, SOCK_DGRAM, 0);
+}
+
+static void udp_append(udp_out_t *u, const char *line, size_t len)
+{
+    if (u->family == AF_UNSPEC) return;
+    if (u->len + len > sizeof(u->buf)) udp_flush(u);
+    if (len > sizeof(u->buf)) len = sizeof(u->buf);
+    memcpy(u->buf + u->len, line, len);
+    u->len += len;
+}
+
+static void emit(udp_out_t *u, const char *line, size_t len)
+{
+    console_printf("%s", line);
+    udp_append(u, line, len);
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.emitted++;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/* Copy the record starting at s_tail out of the ring and free its slots */
+static void take_record(const slot_t *head, record_t *rec)
+{
+    unsigned count = head->slots;
+
+    rec->fmt = head->fmt;
+    rec->len = head->len;
+    rec->truncated = head->truncated;
+    for (unsigned i = 0; i < count; i++) {
+        slot_t *slot = slot_at(s_tail + i);
+        size_t off = i * LOG_RING_ARG_BYTES;
+        size_t len = rec->len > off ? rec->len - off : 0;
+        memcpy(rec->args + off, slot->args, len < LOG_RING_ARG_BYTES ? len : LOG_RING_ARG_BYTES);
+        atomic_store_explicit(&slot->seq, s_tail + i + LOG_RING_SLOTS, memory_order_release);
+    }
+    s_tail += count;
+}
+
+static void writer_task(void *arg)
+{
+    static udp_out_t udp = { .sock = -1, .family = AF_UNSPEC };
+    static record_t rec;
+    char line[LOG_LINE_MAX];
+    uint32_t reported_drops = 0;
+
+    for (;;) {
+        udp_update(&udp);
+
+        uint32_t used = atomic_load_explicit(&s_head, memory_order_relaxed) - s_tail;
+        taskENTER_CRITICAL(&s_lock);
+        if (used > s_stats.max_used) s_stats.max_used = used;
+        taskEXIT_CRITICAL(&s_lock);
+
+        for (;;) {
+            const slot_t *slot = slot_at(s_tail);
+            if (atomic_load_explicit(&slot->seq, memory_order_acquire) != s_tail + 1) break;
+
+            take_record(slot, &rec);
+            emit(&udp, line, format_record(&rec, line));
+        }
+
+        /* Report drops once there is room again, in the log itself */
+        uint32_t dropped = atomic_load_explicit(&s_dropped, memory_order_relaxed);
+        if (dropped != reported_drops) {
+            int len = snprintf(line, sizeof(line), "W (%lu) %s: %lu log records dropped (ring full)\n",
+                               (unsigned long)esp_log_timestamp(), TAG,
+                               (unsigned long)(dropped - reported_drops));
+            reported_drops = dropped;
+            emit(&udp, line, (size_t)len);
+        }
+
+        udp_flush(&udp);
+        vTaskDelay(pdMS_TO_TICKS(WRITER_POLL_MS));
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Control / metrics                                                  */
+/* ------------------------------------------------------------------ */
+
+static void write_metrics(metrics_writer_t *w)
+{
+    log_ring_stats_t st;
+    log_ring_get_stats(&st);
+
+    metrics_header(w, "otbr_log_records_total", "counter", "Log records by outcome");
+    metrics_sample(w, "otbr_log_records_total", "result=\"queued\"", st.queued);
+    metrics_sample(w, "otbr_log_records_total", "result=\"dropped\"", st.dropped);
+    metrics_sample(w, "otbr_log_records_total", "result=\"truncated\"", st.truncated);
+    metrics_counter(w, "otbr_log_lines_total", "Log lines written by the log task", st.emitted);
+    metrics_gauge(w, "otbr_log_ring_slots", "Log ring size (records)", st.slots);
+    metrics_gauge(w, "otbr_log_ring_max_used", "Most log records waiting at once", st.max_used);
+    metrics_header(w, "otbr_log_udp_datagrams_total", "counter",
+                   "Log datagrams sent to the UDP collector");
+    metrics_sample(w, "otbr_log_udp_datagrams_total", "result=\"sent\"", st.udp_sent);
+    metrics_sample(w, "otbr_log_udp_datagrams_total", "result=\"failed\"", st.udp_failed);
+}
+
+esp_err_t log_ring_set_collector(const char *addr, uint16_t port)
+{
+    struct sockaddr_storage dest = { .ss_family = AF_UNSPEC };
+
+    if (s_slots == NULL) return ESP_ERR_INVALID_STATE;   /* no writer task */
+    if (addr != NULL) {
+        struct sockaddr_in *in = (struct sockaddr_in *)&dest;
+        struct sockaddr_in6 *in6 = (struct sockaddr_in6 *)&dest;
+        if (inet_pton(AF_INET, addr, &in->sin_addr) == 1) {
+            in->sin_family = AF_INET;
+            in->sin_port = htons(port);
+        } else if (inet_pton(AF_INET6, addr, &in6->sin6_addr) == 1) {
+            in6->sin6_family = AF_INET6;
+            in6->sin6_port = htons(port);
+        } else {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (port == 0) return ESP_ERR_INVALID_ARG;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_collector = dest;
+    s_collector_gen++;
+    s_stats.udp_enabled = addr != NULL;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (addr != NULL) {
+        ESP_LOGI(TAG, "Streaming log to %s port %u", addr, port);
+    } else {
+        ESP_LOGI(TAG, "Log streaming off");
+    }
+    return ESP_OK;
+}
+
+void log_ring_init(void)
+{
+    if (LOG_RING_SLOTS == 0 || s_slots != NULL) return;
+
+    s_slots = calloc(LOG_RING_SLOTS, sizeof(*s_slots));
+    if (s_slots == NULL) {
+        ESP_LOGE(TAG, "No memory for %d log records, logging synchronously", LOG_RING_SLOTS);
+        return;
+    }
+    for (unsigned i = 0; i < LOG_RING_SLOTS; i++) {
+        atomic_init(&s_slots[i].seq, i);
+    }
+
+    if (xTaskCreate(writer_task, "log_ring", 4096, NULL, 1, &s_task) != pdPASS) {
+        free(s_slots);
+        s_slots = NULL;
+        return;
+    }
+    s_stats.slots = LOG_RING_SLOTS;
+    s_console = esp_log_set_vprintf(ring_vprintf);
+
+    if (LOG_UDP_COLLECTOR[0] != '\0') log_ring_set_collector(LOG_UDP_COLLECTOR, LOG_UDP_PORT);
+    metrics_register_source(write_metrics);
+    ESP_LOGI(TAG, "Deferred logging: %d slots of %u bytes, up to %d per record",
+             LOG_RING_SLOTS, (unsigned)sizeof(slot_t), LOG_RING_RECORD_SLOTS);
+}
+
+void log_ring_get_stats(log_ring_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+
+    stats->queued = atomic_load_explicit(&s_queued, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&s_dropped, memory_order_relaxed);
+    stats->truncated = atomic_load_explicit(&s_truncated, memory_order_relaxed);
+}
@@ -0,0 +1,64 @@
+/*
+ * Deferred logging
+ *
+ * ESP_LOGx (and OpenThread's log, which goes through esp_log) formats
+ * the message and writes it to the USB-serial-JTAG console in the
+ * calling task: a slow or disconnected console stalls the Wi-Fi event
+ * task or the OpenThread mainloop in the middle of a state change.
+ *
+ * This module takes over esp_log's output function.  The caller only
+ * stores a compact binary record — the format string pointer and the
+ * raw argument values, with %s arguments copied — in a lock-free ring
+ * of LOG_RING_SLOTS fixed-size slots, and returns.  A low-priority task
+ * formats the records and writes them to the console and, when a
+ * collector is set, to UDP.  When the ring is full the newest records
+ * are dropped, counted, and reported in the log once there is room.
+ *
+ * A slot holds LOG_RING_ARG_BYTES of arguments, and a record takes as
+ * many consecutive slots as its arguments need, up to
+ * LOG_RING_RECORD_SLOTS: a one-string OpenThread line of up to 250-odd
+ * characters goes through whole.  Past that, strings are cut short and
+ * the line is marked with "...".  ESP_EARLY_LOGx and ESP_DRAM_LOGx
+ * bypass esp_log's output function and stay synchronous.
+ */
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define LOG_RING_ARG_BYTES      85
+#define LOG_RING_RECORD_SLOTS   3
+#define LOG_RING_RECORD_BYTES   (LOG_RING_ARG_BYTES * LOG_RING_RECORD_SLOTS)
+
+typedef struct {
+    uint32_t slots;
+    uint32_t queued;            /* records accepted                    */
+    uint32_t dropped;           /* ring full                           */
+    uint32_t truncated;         /* arguments did not fit in a record   */
+    uint32_t emitted;           /* lines written to the console        */
+    uint32_t max_used;          /* high-water mark of occupied slots   */
+    uint32_t udp_sent;          /* datagrams sent to the collector     */
+    uint32_t udp_failed;
+    bool udp_enabled;
+} log_ring_stats_t;
+
+/**
+ * Install the ring as esp_log's output and start the writer task.  Call
+ * first thing in app_main(); a no-op with LOG_RING_SLOTS 0.
+ */
+void log_ring_init(void);
+
+/**
+ * Stream log lines to addr (IPv4 or IPv6 literal) port over UDP, or
+ * stop with addr NULL.  ESP_ERR_INVALID_ARG for an unparsable address,
+ * ESP_ERR_INVALID_STATE when logging is synchronous (LOG_RING_SLOTS 0).
+ */
+esp_err_t log_ring_set_collector(const char *addr, uint16_t port);
+
+void log_ring_get_stats(log_ring_stats_t *stats);
+
+#endif /* LOG_RING_H */
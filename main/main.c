@@ -29,9 +29,11 @@
 #include "mdns.h"
 #include "driver/gpio.h"
 #include "driver/uart.h"
+#include "driver/usb_serial_jtag.h"
 
 #include "esp_openthread.h"
 #include "esp_openthread_border_router.h"
+#include "esp_openthread_cli.h"
 #include "esp_openthread_lock.h"
 #include "esp_openthread_netif_glue.h"
 #include "esp_openthread_types.h"
@@ -40,15 +42,32 @@
 
 #include "openthread/border_router.h"
 #include "openthread/cli.h"
-#include "openthread/dataset.h"
-#include "openthread/dataset_ftd.h"
 #include "openthread/instance.h"
 #include "openthread/logging.h"
 #include "openthread/platform/logging.h"
 #include "openthread/tasklet.h"
-#include "openthread/thread.h"
 
 #include "config.h"
+#include "boot_time.h"
+#include "channel_plan.h"
+#include "coex_ctrl.h"
+#include "commission.h"
+#include "dns_proxy.h"
+#include "log_ring.h"
+#include "mcast_fwd.h"
+#include "mem_watch.h"
+#include "metrics.h"
+#include "nat64.h"
+#include "netif_hooks.h"
+#include "ot_profiler.h"
+#include "ot_settings.h"
+#include "ot_startup.h"
+#include "ot_status.h"
+#include "otbr_cli.h"
+#include "route_health.h"
+#include "srp_mdns.h"
+#include "wifi_power.h"
+#include "wifi_reconnect.h"
 
 /* ------------------------------------------------------------------ */
 /*  Constants & tags                                                    */
@@ -74,13 +93,29 @@ static int s_retry_count = 0;
 static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                                int32_t event_id, void *event_data)
 {
+    esp_netif_t *wifi_netif = (esp_netif_t *)arg;
+
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
+        wifi_reconnect_connect_now();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        wifi_event_sta_connected_t *event = (wifi_event_sta_connected_t *)event_data;
+        wifi_reconnect_handle_connected(event);
+        channel_plan_set_ap_channel(event->channel);
+
+        /* Create an IPv6 link-local address on the Wi-Fi interface.
+         * The border router needs this to send Router Solicitations
+         * on the backbone — without it, ND6/RS messages fail. */
+        esp_netif_create_ip6_linklocal(wifi_netif);
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        wifi_reconnect_handle_disconnected((wifi_event_sta_disconnected_t *)event_data);
+        wifi_power_handle_disconnected();
+
+        /* Retry with backoff — the Thread mesh keeps routing meanwhile */
         if (WIFI_MAX_RETRY == 0 || s_retry_count < WIFI_MAX_RETRY) {
-            esp_wifi_connect();
+            uint32_t delay_ms = wifi_reconnect_schedule();
             s_retry_count++;
-            ESP_LOGW(TAG, "Wi-Fi disconnected, retrying... (%d)", s_retry_count);
+            ESP_LOGW(TAG, "Wi-Fi disconnected, retrying in %lu ms... (%d)",
+                     (unsigned long)delay_ms, s_retry_count);
         } else {
             xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
             ESP_LOGE(TAG, "Wi-Fi connection failed after %d retries", s_retry_count);
@@ -89,16 +124,24 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
         ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
         s_retry_count = 0;
+        wifi_reconnect_handle_got_ip();
+        wifi_power_handle_got_ip(&event->ip_info.gw);
+        boot_time_mark(BOOT_PHASE_WIFI_CONNECTED);
         xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_GOT_IP6) {
         ip_event_got_ip6_t *event = (ip_event_got_ip6_t *)event_data;
         ESP_LOGI(TAG, "Got IPv6: " IPV6STR, IPV62STR(event->ip6_info.ip));
+        boot_time_mark(BOOT_PHASE_WIFI_IPV6);
         xEventGroupSetBits(s_wifi_event_group, WIFI_IPV6_BIT);
     }
 }
 
 /* ------------------------------------------------------------------ */
 /*  Wi-Fi initialization (STA mode)                                    */
+/*                                                                     */
+/*  Non-blocking: association completes in the background while the    */
+/*  Thread side boots.  ot_br_init_task() attaches border routing to   */
+/*  the backbone once WIFI_CONNECTED_BIT / WIFI_IPV6_BIT are set.      */
 /* ------------------------------------------------------------------ */
 
 static esp_netif_t *init_wifi(void)
@@ -106,6 +149,7 @@ static esp_netif_t *init_wifi(void)
     s_wifi_event_group = xEventGroupCreate();
 
     esp_netif_t *wifi_netif = esp_netif_create_default_wifi_sta();
+    netif_hooks_set_backbone(wifi_netif);
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -116,11 +160,11 @@ static esp_netif_t *init_wifi(void)
     esp_event_handler_instance_t got_ip6_event;
 
     ESP_ERROR_CHECK(esp_event_handler_instance_register(
-        WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL, &any_wifi_event));
+        WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, wifi_netif, &any_wifi_event));
     ESP_ERROR_CHECK(esp_event_handler_instance_register(
-        IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL, &got_ip_event));
+        IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, wifi_netif, &got_ip_event));
     ESP_ERROR_CHECK(esp_event_handler_instance_register(
-        IP_EVENT, IP_EVENT_GOT_IP6, &wifi_event_handler, NULL, &got_ip6_event));
+        IP_EVENT, IP_EVENT_GOT_IP6, &wifi_event_handler, wifi_netif, &got_ip6_event));
 
     /* Configure Wi-Fi */
     wifi_config_t wifi_config = {
@@ -131,38 +175,24 @@ static esp_netif_t *init_wifi(void)
         },
     };
 
+    /* Credentials come from config.h on every boot, so keep the STA
+     * config in RAM — the reconnect engine rewrites it per attempt
+     * (cached BSSID/channel vs. full scan) and must not wear flash. */
+    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    wifi_reconnect_init(&wifi_config);
+    wifi_power_init();
     ESP_ERROR_CHECK(esp_wifi_start());
 
     ESP_LOGI(TAG, "Connecting to Wi-Fi SSID: %s ...", WIFI_SSID);
 
-    /* Wait for connection */
-    EventBits_t bits = xEventGroupWaitBits(
-        s_wifi_event_group,
-        WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-        pdFALSE, pdFALSE,
-        portMAX_DELAY);
-
-    if (bits & WIFI_CONNECTED_BIT) {
-        ESP_LOGI(TAG, "Wi-Fi connected successfully");
-
-        /* Create an IPv6 link-local address on the Wi-Fi interface.
-         * The border router needs this to send Router Solicitations
-         * on the backbone — without it, ND6/RS messages fail. */
-        ESP_ERROR_CHECK(esp_netif_create_ip6_linklocal(wifi_netif));
-    } else if (bits & WIFI_FAIL_BIT) {
-        ESP_LOGE(TAG, "Wi-Fi connection failed — rebooting in 5 s");
-        vTaskDelay(pdMS_TO_TICKS(5000));
-        esp_restart();
-    }
-
     return wifi_netif;
 }
 
 /* ------------------------------------------------------------------ */
-/*  mDNS setup (hostname only — the OpenThread border agent handles    */
-/*  _meshcop._udp publication with correct dynamic TXT records)        */
+/*  mDNS setup (hostname and SRP advertising — the OpenThread border   */
+/*  agent handles _meshcop._udp with correct dynamic TXT records)      */
 /* ------------------------------------------------------------------ */
 
 static void init_mdns(void)
@@ -171,203 +201,122 @@ static void init_mdns(void)
     ESP_ERROR_CHECK(mdns_hostname_set(DEVICE_NAME));
     ESP_ERROR_CHECK(mdns_instance_name_set(MDNS_INSTANCE_NAME));
     ESP_LOGI(TAG, "mDNS hostname: %s.local", DEVICE_NAME);
+
+    /* Thread devices' SRP registrations are re-published from here, and
+     * their DNS-SD queries for LAN services are answered through it    */
+    srp_mdns_init();
+    dns_proxy_init();
 }
 
 /* ------------------------------------------------------------------ */
-/*  Hex string → byte array helper                                     */
+/*  Thread start + border router init task (runs after mainloop start) */
 /* ------------------------------------------------------------------ */
 
-static int hex_nibble(char c)
-{
-    if (c >= '0' && c <= '9') return c - '0';
-    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
-    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
-    return -1;
-}
-
-static int hex_to_bytes(const char *hex, uint8_t *out, size_t max_len)
+static void ot_br_init_task(void *arg)
 {
-    size_t hex_len = strlen(hex);
-    if (hex_len == 0 || hex_len % 2 != 0) return -1;
+    esp_netif_t *wifi_netif = (esp_netif_t *)arg;
 
-    size_t byte_len = hex_len / 2;
-    if (byte_len > max_len) return -1;
+    /* ----- Stage 1: mesh attach, independent of the backbone ----- */
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    ot_startup_start_thread(esp_openthread_get_instance(), THREAD_AUTO_START);
+    esp_openthread_lock_release();
 
-    for (size_t i = 0; i < byte_len; i++) {
-        int hi = hex_nibble(hex[i * 2]);
-        int lo = hex_nibble(hex[i * 2 + 1]);
-        if (hi < 0 || lo < 0) return -1;
-        out[i] = (uint8_t)((hi << 4) | lo);
-    }
-    return (int)byte_len;
-}
+    /* Radio coexistence follows Thread MAC health from here on */
+    coex_ctrl_start();
 
-/* ------------------------------------------------------------------ */
-/*  OpenThread dataset helpers                                         */
-/* ------------------------------------------------------------------ */
+    /* ----- Stage 2: attach border routing once Wi-Fi is up ----- */
+    EventBits_t bits = xEventGroupWaitBits(
+        s_wifi_event_group,
+        WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
+        pdFALSE, pdFALSE,
+        portMAX_DELAY);
 
-/**
- * Load a Thread active dataset from the hex TLV string in config.h.
- * Returns true if the dataset was successfully applied.
- */
-static bool load_dataset_from_tlvs(otInstance *instance)
-{
-    const char *hex = THREAD_DATASET_TLVS;
-    if (strlen(hex) == 0) return false;
-
-    otOperationalDatasetTlvs tlvs;
-    int len = hex_to_bytes(hex, tlvs.mTlvs, sizeof(tlvs.mTlvs));
-    if (len < 0) {
-        ESP_LOGE(TAG, "THREAD_DATASET_TLVS: invalid hex string");
-        return false;
+    if (bits & WIFI_FAIL_BIT) {
+        ESP_LOGE(TAG, "Wi-Fi connection failed — rebooting in 5 s");
+        vTaskDelay(pdMS_TO_TICKS(5000));
+        esp_restart();
     }
-    tlvs.mLength = (uint8_t)len;
 
-    otError error = otDatasetSetActiveTlvs(instance, &tlvs);
-    if (error != OT_ERROR_NONE) {
-        ESP_LOGE(TAG, "Failed to set active dataset from TLVs: %d", error);
-        return false;
-    }
+    /* Wait for the Wi-Fi interface to have an IPv6 link-local address.
+     * The border router sends Router Solicitations on the backbone and
+     * will fail with "Failed to send ND6 message" if IPv6 isn't ready. */
+    ESP_LOGI(TAG, "Wi-Fi connected, waiting for IPv6 link-local...");
+    xEventGroupWaitBits(s_wifi_event_group, WIFI_IPV6_BIT,
+                        pdFALSE, pdFALSE, pdMS_TO_TICKS(BACKBONE_IPV6_WAIT_MS));
 
-    ESP_LOGI(TAG, "Thread dataset loaded from config (%d bytes)", len);
-    return true;
-}
+    /* host/otbr_host.c border_router_up() mirrors this stage by hand */
+    esp_openthread_lock_acquire(portMAX_DELAY);
 
-#if THREAD_AUTO_START
-/**
- * Create a brand new Thread network (only used when no existing
- * dataset is available and THREAD_AUTO_START == 1).
- */
-static void create_default_dataset(otInstance *instance)
-{
-    otOperationalDataset dataset;
+    esp_openthread_set_backbone_netif(wifi_netif);
+    ESP_ERROR_CHECK(esp_openthread_border_router_init());
+    srp_mdns_start(esp_openthread_get_instance());
+    dns_proxy_start(esp_openthread_get_instance());
+    nat64_start(esp_openthread_get_instance(), wifi_netif);
 
-    ESP_LOGI(TAG, "Creating new Thread network");
+    esp_openthread_lock_release();
 
-    memset(&dataset, 0, sizeof(dataset));
+    /* Route preference follows this router's health from here on */
+    route_health_start(esp_openthread_get_instance());
 
-    otError error = otDatasetCreateNewNetwork(instance, &dataset);
-    if (error != OT_ERROR_NONE) {
-        ESP_LOGE(TAG, "Failed to create new network dataset: %d", error);
-        return;
-    }
+    /* Multicast crosses the border only towards listeners */
+    mcast_fwd_start(esp_openthread_get_instance());
 
-    /* Override channel and network name with our config */
-    dataset.mChannel = THREAD_CHANNEL;
-    dataset.mComponents.mIsChannelPresent = true;
+    /* "otbr commission" can run a commissioner from here on */
+    commission_init(esp_openthread_get_instance());
 
-    size_t name_len = strlen(THREAD_NETWORK_NAME);
-    if (name_len > OT_NETWORK_NAME_MAX_SIZE) {
-        name_len = OT_NETWORK_NAME_MAX_SIZE;
-    }
-    memcpy(dataset.mNetworkName.m8, THREAD_NETWORK_NAME, name_len);
-    dataset.mNetworkName.m8[name_len] = '\0';
-    dataset.mComponents.mIsNetworkNamePresent = true;
-
-    error = otDatasetSetActive(instance, &dataset);
-    if (error != OT_ERROR_NONE) {
-        ESP_LOGE(TAG, "Failed to set active dataset: %d", error);
-    } else {
-        ESP_LOGI(TAG, "New network created: ch=%d, name=%s",
-                 THREAD_CHANNEL, THREAD_NETWORK_NAME);
-    }
-}
-#endif /* THREAD_AUTO_START */
+    boot_time_mark(BOOT_PHASE_BR_READY);
+    ESP_LOGI(TAG, "OpenThread Border Router initialized");
 
-/* ------------------------------------------------------------------ */
-/*  OpenThread state-change callback                                   */
-/* ------------------------------------------------------------------ */
+    /* --- Adaptive backbone power save follows forwarding traffic --- */
+    wifi_power_start_monitor();
 
-static void ot_state_change_callback(otChangedFlags flags, void *context)
-{
-    otInstance *instance = (otInstance *)context;
-
-    if (flags & OT_CHANGED_THREAD_ROLE) {
-        otDeviceRole role = otThreadGetDeviceRole(instance);
-        const char *role_str;
-
-        switch (role) {
-        case OT_DEVICE_ROLE_DISABLED: role_str = "disabled"; break;
-        case OT_DEVICE_ROLE_DETACHED: role_str = "detached"; break;
-        case OT_DEVICE_ROLE_CHILD:    role_str = "child";    break;
-        case OT_DEVICE_ROLE_ROUTER:   role_str = "router";   break;
-        case OT_DEVICE_ROLE_LEADER:   role_str = "leader";   break;
-        default:                      role_str = "unknown";  break;
-        }
+    /* --- Metrics scrape endpoint (served on the backbone) --- */
+    metrics_start();
 
-        ESP_LOGI(TAG, "Thread role changed: %s", role_str);
-    }
+    /* --- Memory budget report, then heap/stack watch --- */
+    mem_watch_start();
 
-    if (flags & OT_CHANGED_THREAD_NETDATA) {
-        ESP_LOGI(TAG, "Thread network data updated");
-    }
+    vTaskDelete(NULL);
 }
 
 /* ------------------------------------------------------------------ */
-/*  Border router init task (runs after mainloop has started)          */
+/*  OpenThread queue sizing                                            */
 /* ------------------------------------------------------------------ */
 
-static void ot_br_init_task(void *arg)
-{
-    esp_netif_t *wifi_netif = (esp_netif_t *)arg;
+/* Auto-sizing: let queued packets use up to this share of free heap,
+ * assuming each one can hold an IPv6 MTU (1280 B) worth of data.     */
+#define OT_QUEUE_AUTO_HEAP_PERCENT  10
+#define OT_QUEUE_AUTO_MIN           10
+#define OT_QUEUE_AUTO_MAX           64
 
-    /* Wait for the Wi-Fi interface to have an IPv6 link-local address.
-     * The border router sends Router Solicitations on the backbone and
-     * will fail with "Failed to send ND6 message" if IPv6 isn't ready. */
-    ESP_LOGI(TAG, "Waiting for IPv6 link-local on Wi-Fi...");
-    xEventGroupWaitBits(s_wifi_event_group, WIFI_IPV6_BIT,
-                        pdFALSE, pdFALSE, pdMS_TO_TICKS(10000));
-
-    esp_openthread_lock_acquire(portMAX_DELAY);
-
-    esp_openthread_set_backbone_netif(wifi_netif);
-    ESP_ERROR_CHECK(esp_openthread_border_router_init());
-
-    ESP_LOGI(TAG, "OpenThread Border Router initialized");
-
-    otInstance *instance = esp_openthread_get_instance();
-
-    /* ----- Load dataset and start Thread ----- */
-    bool dataset_ready = false;
-    otOperationalDataset dataset;
-
-    /* Priority 1: Saved dataset in NVS (from a previous boot or CLI) */
-    if (otDatasetGetActive(instance, &dataset) == OT_ERROR_NONE) {
-        ESP_LOGI(TAG, "Using saved Thread dataset from NVS");
-        dataset_ready = true;
-    }
-    /* Priority 2: Pre-provisioned TLV hex from config.h */
-    else if (load_dataset_from_tlvs(instance)) {
-        dataset_ready = true;
-    }
-#if THREAD_AUTO_START
-    /* Priority 3: Create a brand new Thread network */
-    if (!dataset_ready) {
-        create_default_dataset(instance);
-        dataset_ready = true;
+/**
+ * Resolve a configured queue depth; 0 selects a depth scaled to the
+ * heap that is free at boot (the glue fixes queue sizes at init).
+ */
+static uint8_t ot_queue_depth(int configured, const char *name)
+{
+    if (configured > 0) {
+        return configured > UINT8_MAX ? UINT8_MAX : (uint8_t)configured;
     }
-#endif
 
-    if (dataset_ready) {
-        otIp6SetEnabled(instance, true);
-        otThreadSetEnabled(instance, true);
-        ESP_LOGI(TAG, "Thread interface up — joining network...");
-    } else {
-        ESP_LOGI(TAG, "No Thread dataset configured");
-        ESP_LOGI(TAG, "Provision via Home Assistant or serial CLI:");
-        ESP_LOGI(TAG, "  > dataset set active <hex-TLV>");
-        ESP_LOGI(TAG, "  > ifconfig up");
-        ESP_LOGI(TAG, "  > thread start");
-    }
+    uint32_t depth = esp_get_free_heap_size() * OT_QUEUE_AUTO_HEAP_PERCENT / 100 / 1280;
+    if (depth < OT_QUEUE_AUTO_MIN) depth = OT_QUEUE_AUTO_MIN;
+    if (depth > OT_QUEUE_AUTO_MAX) depth = OT_QUEUE_AUTO_MAX;
 
-    esp_openthread_lock_release();
-    vTaskDelete(NULL);
+    ESP_LOGI(TAG, "%s queue depth: %lu (auto)", name, (unsigned long)depth);
+    return (uint8_t)depth;
 }
 
 /* ------------------------------------------------------------------ */
 /*  OpenThread main task                                               */
 /* ------------------------------------------------------------------ */
 
+static void ot_state_changed(otChangedFlags flags, void *context)
+{
+    ot_startup_state_changed(flags, context);
+    ot_status_handle_state_change((otInstance *)context, flags);
+}
+
 static void ot_task(void *arg)
 {
     esp_netif_t *wifi_netif = (esp_netif_t *)arg;
@@ -378,12 +327,17 @@ static void ot_task(void *arg)
             .radio_mode = RADIO_MODE_NATIVE,
         },
         .host_config = {
+#if OT_CLI_UART_ENABLE
+            .host_connection_mode = HOST_CONNECTION_MODE_CLI_USB,
+            .host_usb_config = USB_SERIAL_JTAG_DRIVER_CONFIG_DEFAULT(),
+#else
             .host_connection_mode = HOST_CONNECTION_MODE_NONE,
+#endif
         },
         .port_config = {
-            .storage_partition_name = "nvs",
-            .netif_queue_size = 10,
-            .task_queue_size = 10,
+            .storage_partition_name = OT_SETTINGS_PARTITION,
+            .netif_queue_size = ot_queue_depth(OT_NETIF_QUEUE_SIZE, "netif"),
+            .task_queue_size = ot_queue_depth(OT_TASK_QUEUE_SIZE, "task"),
         },
     };
 
@@ -397,16 +351,28 @@ static void ot_task(void *arg)
     esp_netif_t *ot_netif = esp_netif_new(&ot_netif_cfg);
     assert(ot_netif != NULL);
     ESP_ERROR_CHECK(esp_netif_attach(ot_netif, esp_openthread_netif_glue_init(&ot_platform_config)));
+    boot_time_mark(BOOT_PHASE_OT_INIT);
 
     /* Get the OpenThread instance */
     otInstance *instance = esp_openthread_get_instance();
 
-    /* Register state-change callback for logging */
-    otSetStateChangedCallback(instance, ot_state_change_callback, instance);
+    /* State changes are logged and published to ot_status readers */
+    otSetStateChangedCallback(instance, ot_state_changed, instance);
 
-    /* Border router init must happen after the mainloop is running,
-     * so launch it as a separate task. */
-    xTaskCreate(ot_br_init_task, "ot_br_init", 6144, wifi_netif, 5, NULL);
+#if OT_CLI_UART_ENABLE
+    /* Serial CLI with the firmware's "otbr" commands */
+    esp_openthread_cli_init();
+    otbr_cli_init(instance);
+    esp_openthread_cli_create_task();
+#endif
+
+    /* Thread start and border router init must happen after the
+     * mainloop is running, so launch them as a separate task. */
+    xTaskCreate(ot_br_init_task, "ot_br_init", BR_INIT_STACK, wifi_netif, 5, NULL);
+
+    /* Other tasks read Thread state from snapshots, not under the lock */
+    ot_status_start(instance);
+    ot_profiler_init();
 
     /* Start the mainloop — this never returns */
     esp_openthread_launch_mainloop();
@@ -423,12 +389,16 @@ static void ot_task(void *arg)
 
 void app_main(void)
 {
+    /* Before anything logs: from here on no task waits for the console */
+    log_ring_init();
+    mem_watch_init();
+
     ESP_LOGI(TAG, "========================================");
     ESP_LOGI(TAG, "  ESP32-C6 OpenThread Border Router");
     ESP_LOGI(TAG, "  Device: %s", DEVICE_NAME);
     ESP_LOGI(TAG, "========================================");
 
-    /* --- NVS (required for Wi-Fi and OT dataset storage) --- */
+    /* --- NVS (Wi-Fi and firmware state) --- */
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES ||
         ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -437,6 +407,9 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
 
+    /* --- OpenThread settings partition (datasets, frame counters) --- */
+    ESP_ERROR_CHECK(ot_settings_init());
+
     /* --- Event-fd (required by OpenThread platform layer) --- */
     esp_vfs_eventfd_config_t eventfd_config = {
         .max_fds = 4,
@@ -457,19 +430,24 @@ void app_main(void)
     gpio_set_level(GPIO_NUM_14, 1);
     ESP_LOGI(TAG, "Antenna: external");
 
-    /* --- Wi-Fi (backbone network) --- */
+    /* --- Wi-Fi (backbone network) — associates in the background --- */
     esp_netif_t *wifi_netif = init_wifi();
+    channel_plan_init(wifi_reconnect_cached_channel());
 
     /* --- mDNS (Home Assistant discovery) --- */
     init_mdns();
 
-    /* --- Launch the OpenThread task --- */
-    xTaskCreate(ot_task, "ot_main", 20480, wifi_netif, 5, NULL);
+    /* --- NAT64 engine mapping table (NAT64_ENGINE 1 only) --- */
+    nat64_init();
+
+    /* --- Launch the OpenThread task (does not wait for Wi-Fi) --- */
+    xTaskCreate(ot_task, "ot_main", OT_TASK_STACK, wifi_netif, 5, NULL);
 
     /* --- Enable Wi-Fi / 802.15.4 radio coexistence --- */
 #if CONFIG_ESP_COEX_SW_COEXIST_ENABLE && CONFIG_SOC_IEEE802154_SUPPORTED
     ESP_ERROR_CHECK(esp_coex_wifi_i154_enable());
 #endif
 
-    ESP_LOGI(TAG, "OTBR startup complete — %s is online", DEVICE_NAME);
+    ESP_LOGI(TAG, "OTBR startup launched — %s attaches to the backbone "
+             "when Wi-Fi is up", DEVICE_NAME);
 }
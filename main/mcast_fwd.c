@@ -0,0 +1,547 @@
+/*
+ * Multicast forwarding policy — see mcast_fwd.h
+ */
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_openthread_task_queue.h"
+#include "esp_timer.h"
+
+#if CONFIG_OPENTHREAD_BACKBONE_ROUTER
+#include "openthread/backbone_router_ftd.h"
+#endif
+
+#include "config.h"
+#include "mcast_fwd.h"
+#include "metrics.h"
+
+static const char *TAG = "mcast";
+
+#define ETH_HLEN                14
+#define IP6_HLEN                40
+#define ICMP6_MLD_QUERY         130
+#define ICMP6_MLD_REPORT        131
+#define ICMP6_MLD_DONE          132
+#define ICMP6_MLD2_REPORT       143
+
+/* MLDv2 record types (RFC 3810 5.2.12) */
+#define MLD2_IS_EXCLUDE         2
+#define MLD2_TO_EXCLUDE         4
+#define MLD2_BLOCK_OLD          6
+
+#define THREAD_RATE_KBPS        250
+#define BUCKETS                 64
+#define NIL                     0xff
+#define FNV_INIT                2166136261u
+
+_Static_assert(MCAST_THREAD_GROUPS < NIL && MCAST_LAN_GROUPS < NIL, "table index is a uint8_t");
+
+typedef struct {
+    uint8_t group[16];
+    uint8_t next;
+} thread_group_t;
+
+typedef struct {
+    uint8_t mac[6];
+    uint32_t expires_s;
+} lan_listener_t;
+
+typedef struct {
+    uint8_t group[16];
+    uint8_t next;
+    uint8_t num;
+    uint32_t crowded_until_s;   /* more listeners than fit: no unicast */
+    lan_listener_t listeners[MCAST_LAN_LISTENERS];
+} lan_group_t;
+
+/* Tables and stats (s_lock) */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static mcast_fwd_stats_t s_stats;
+static thread_group_t s_thread[MCAST_THREAD_GROUPS];
+static uint8_t s_thread_buckets[BUCKETS];
+static bool s_thread_known;
+static lan_group_t s_lan[MCAST_LAN_GROUPS];
+static uint8_t s_lan_buckets[BUCKETS];
+static uint8_t s_lan_free;
+static uint32_t s_querier_s;    /* 0: never */
+static uint32_t s_report_s;
+static uint32_t s_lan_full_s;
+
+static volatile mcast_policy_t s_policy = MCAST_POLICY;
+static otInstance *s_instance;
+static esp_timer_handle_t s_timer;
+static atomic_bool s_refresh_queued;
+
+/* Mainloop's copy of the MLR registrations */
+static uint8_t s_staging[MCAST_THREAD_GROUPS][16];
+
+/* ------------------------------------------------------------------ */
+/*  Helpers                                                            */
+/* ------------------------------------------------------------------ */
+
+/* Seconds since boot, never 0 */
+static uint32_t now_s(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000000) + 1;
+}
+
+static bool within(uint32_t then_s, uint32_t now, uint32_t window_s)
+{
+    return then_s != 0 && now - then_s < window_s;
+}
+
+static uint32_t airtime_us(size_t len, uint32_t kbps)
+{
+    return (uint32_t)(len * 8 * 1000 / kbps);
+}
+
+static uint8_t bucket(const uint8_t *group)
+{
+    uint32_t hash = FNV_INIT;
+    for (int i = 0; i < 16; i++) hash = (hash ^ group[i]) * 16777619u;
+    return (uint8_t)(hash & (BUCKETS - 1));
+}
+
+static bool crowded(const lan_group_t *g, uint32_t now)
+{
+    return (int32_t)(g->crowded_until_s - now) > 0;
+}
+
+/* Scope wider than realm-local, and not all-nodes/all-routers */
+static bool crosses_border(const uint8_t *group)
+{
+    static const uint8_t zeros[13];
+    if (group[0] != 0xff || (group[1] & 0x0f) < 4) return false;
+    return memcmp(&group[2], zeros, sizeof(zeros)) != 0 || group[15] > 2;
+}
+
+static uint16_t be16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Subscription tables (s_lock held)                                  */
+/* ------------------------------------------------------------------ */
+
+static bool thread_has(const uint8_t *group)
+{
+    for (uint8_t i = s_thread_buckets[bucket(group)]; i != NIL; i = s_thread[i].next) {
+        if (memcmp(s_thread[i].group, group, 16) == 0) return true;
+    }
+    return false;
+}
+
+static uint8_t lan_find(const uint8_t *group)
+{
+    for (uint8_t i = s_lan_buckets[bucket(group)]; i != NIL; i = s_lan[i].next) {
+        if (memcmp(s_lan[i].group, group, 16) == 0) return i;
+    }
+    return NIL;
+}
+
+static void lan_unlink(uint8_t *link)
+{
+    uint8_t i = *link;
+    *link = s_lan[i].next;
+    s_lan[i].next = s_lan_free;
+    s_lan_free = i;
+    s_stats.lan_groups--;
+}
+
+static void lan_remove(uint8_t index)
+{
+    uint8_t *link = &s_lan_buckets[bucket(s_lan[index].group)];
+    while (*link != index) link = &s_lan[*link].next;
+    lan_unlink(link);
+}
+
+static void lan_add(const uint8_t *group, const uint8_t *mac, uint32_t now)
+{
+    uint8_t i = lan_find(group);
+    if (i == NIL) {
+        if (s_lan_free == NIL) {
+            s_stats.table_full++;
+            s_lan_full_s = now;
+            return;
+        }
+        i = s_lan_free;
+        s_lan_free = s_lan[i].next;
+
+        lan_group_t *g = &s_lan[i];
+        memset(g, 0, sizeof(*g));
+        memcpy(g->group, group, 16);
+        uint8_t *head = &s_lan_buckets[bucket(group)];
+        g->next = *head;
+        *head = i;
+        s_stats.lan_groups++;
+    }
+
+    lan_group_t *g = &s_lan[i];
+    for (uint8_t k = 0; k < g->num; k++) {
+        if (memcmp(g->listeners[k].mac, mac, 6) == 0) {
+            g->listeners[k].expires_s = now + MCAST_LISTENER_TIMEOUT_S;
+            return;
+        }
+    }
+    if (g->num < MCAST_LAN_LISTENERS) {
+        memcpy(g->listeners[g->num].mac, mac, 6);
+        g->listeners[g->num++].expires_s = now + MCAST_LISTENER_TIMEOUT_S;
+    } else {
+        g->crowded_until_s = now + MCAST_LISTENER_TIMEOUT_S;
+    }
+}
+
+static void lan_leave(const uint8_t *group, const uint8_t *mac, uint32_t now)
+{
+    uint8_t i = lan_find(group);
+    if (i == NIL) return;
+
+    lan_group_t *g = &s_lan[i];
+    for (uint8_t k = 0; k < g->num; k++) {
+        if (memcmp(g->listeners[k].mac, mac, 6) == 0) {
+            g->listeners[k] = g->listeners[--g->num];
+            break;
+        }
+    }
+    if (g->num == 0 && !crowded(g, now)) lan_remove(i);
+}
+
+static void lan_expire(uint32_t now)
+{
+    for (size_t b = 0; b < BUCKETS; b++) {
+        uint8_t *link = &s_lan_buckets[b];
+        while (*link != NIL) {
+            lan_group_t *g = &s_lan[*link];
+            for (uint8_t k = 0; k < g->num;) {
+                if ((int32_t)(g->listeners[k].expires_s - now) <= 0) {
+                    g->listeners[k] = g->listeners[--g->num];
+                } else {
+                    k++;
+                }
+            }
+            if (g->num == 0 && !crowded(g, now)) {
+                lan_unlink(link);
+            } else {
+                link = &g->next;
+            }
+        }
+    }
+}
+
+/* Hosts only repeat their reports when a querier asks; until one is
+ * seen (and answered), a missing group may just not have reported.   */
+static bool snooping_trusted(uint32_t now)
+{
+    return within(s_querier_s, now, MCAST_LISTENER_TIMEOUT_S) &&
+           within(s_report_s, now, MCAST_LISTENER_TIMEOUT_S) &&
+           !within(s_lan_full_s, now, MCAST_LISTENER_TIMEOUT_S);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Data path                                                          */
+/* ------------------------------------------------------------------ */
+
+void mcast_fwd_snoop(const uint8_t *frame, size_t len)
+{
+    if (s_instance == NULL || s_policy == MCAST_POLICY_OFF || len < ETH_HLEN + IP6_HLEN ||
+        !(frame[0] & 1) ||
+        be16(&frame[12]) != 0x86dd) {
+        return;
+    }
+    const uint8_t *ip6 = frame + ETH_HLEN;
+    const uint8_t *mac = frame + 6;
+    uint8_t next = ip6[6];
+    size_t off = ETH_HLEN + IP6_HLEN;
+
+    /* MLD always carries a Router Alert in a hop-by-hop header */
+    if (next != 0 || off + 8 > len) return;
+    next = frame[off];
+    off += (frame[off + 1] + 1) * 8;
+    if (next != 58 || off + 24 > len) return;
+
+    const uint8_t *icmp = frame + off;
+    uint32_t now = now_s();
+
+    taskENTER_CRITICAL(&s_lock);
+    switch (icmp[0]) {
+    case ICMP6_MLD_QUERY:
+        s_querier_s = now;
+        break;
+    case ICMP6_MLD_REPORT:
+    case ICMP6_MLD_DONE:
+        s_stats.mld_reports++;
+        s_report_s = now;
+        if (crosses_border(&icmp[8])) {
+            if (icmp[0] == ICMP6_MLD_REPORT) {
+                lan_add(&icmp[8], mac, now);
+            } else {
+                lan_leave(&icmp[8], mac, now);
+            }
+        }
+        break;
+    case ICMP6_MLD2_REPORT: {
+        s_stats.mld_reports++;
+        s_report_s = now;
+        uint16_t records = be16(&icmp[6]);
+        size_t rec = off + 8;
+        for (uint16_t r = 0; r < records && rec + 20 <= len; r++) {
+            const uint8_t *p = frame + rec;
+            uint16_t sources = be16(&p[2]);
+            rec += 20 + (size_t)sources * 16 + (size_t)p[1] * 4;
+            if (rec > len || p[0] == MLD2_BLOCK_OLD || !crosses_border(&p[4])) continue;
+
+            /* Exclude mode, or include with sources: listening */
+            if (p[0] == MLD2_IS_EXCLUDE || p[0] == MLD2_TO_EXCLUDE || sources > 0) {
+                lan_add(&p[4], mac, now);
+            } else {
+                lan_leave(&p[4], mac, now);
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+mcast_fwd_action_t mcast_fwd_to_backbone(const uint8_t *frame, size_t len,
+                                         uint8_t macs[MCAST_LAN_LISTENERS][6],
+                                         size_t *num_macs)
+{
+    mcast_policy_t policy = s_policy;
+    if (s_instance == NULL || policy == MCAST_POLICY_OFF || len < ETH_HLEN + IP6_HLEN ||
+        frame[0] != 0x33 || frame[1] != 0x33 || be16(&frame[12]) != 0x86dd) {
+        return MCAST_FWD_PASS;
+    }
+    const uint8_t *group = frame + ETH_HLEN + 24;
+    if (!crosses_border(group)) return MCAST_FWD_PASS;
+
+    /* We are a station: a multicast frame goes up to the AP at the data
+     * rate and back down at the basic rate; each unicast copy goes up
+     * and back down at the data rate.                                 */
+    uint32_t now = now_s();
+    uint32_t unicast_us = airtime_us(len, MCAST_UNICAST_RATE_KBPS);
+    uint32_t mcast_us = unicast_us + airtime_us(len, MCAST_BASIC_RATE_KBPS);
+    mcast_fwd_action_t action = MCAST_FWD_PASS;
+    *num_macs = 0;
+
+    taskENTER_CRITICAL(&s_lock);
+    bool trusted = snooping_trusted(now);
+    uint8_t i = trusted ? lan_find(group) : NIL;
+    const lan_group_t *g = i != NIL ? &s_lan[i] : NULL;
+    if (!trusted) {
+        s_stats.out_unfiltered++;
+    } else if (g == NULL) {
+        action = MCAST_FWD_DROP;
+        s_stats.out_dropped++;
+        s_stats.out_dropped_bytes += len;
+        s_stats.wifi_airtime_saved_us += mcast_us;
+    } else if (policy == MCAST_POLICY_UNICAST && g->num > 0 && len <= MCAST_FRAME_MAX &&
+               !crowded(g, now) && 2 * g->num * unicast_us < mcast_us) {
+        action = MCAST_FWD_UNICAST;
+        for (uint8_t k = 0; k < g->num; k++) memcpy(macs[k], g->listeners[k].mac, 6);
+        *num_macs = g->num;
+        s_stats.out_unicast++;
+        s_stats.out_copies += g->num;
+        s_stats.wifi_airtime_saved_us += mcast_us - 2 * g->num * unicast_us;
+    } else {
+        s_stats.out_forwarded++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return action;
+}
+
+bool mcast_fwd_to_thread(const uint8_t *packet, size_t len)
+{
+    if (s_instance == NULL || s_policy == MCAST_POLICY_OFF || len < IP6_HLEN ||
+        (packet[0] >> 4) != 6 || !crosses_border(packet + 24)) {
+        return false;
+    }
+    bool drop = false;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (!s_thread_known) {
+        s_stats.in_unfiltered++;
+    } else if (thread_has(packet + 24)) {
+        s_stats.in_forwarded++;
+    } else {
+        drop = true;
+        s_stats.in_dropped++;
+        s_stats.in_dropped_bytes += len;
+        s_stats.thread_airtime_saved_us += airtime_us(len, THREAD_RATE_KBPS);
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return drop;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Refresh                                                            */
+/* ------------------------------------------------------------------ */
+
+/* Mainloop: copy the MLR registrations, then swap them in. The MLR
+ * registry lives in OpenThread's Backbone Router; without it the Thread
+ * side stays unknown and inbound multicast is never filtered.         */
+static void refresh_tasklet(void *arg)
+{
+    atomic_store(&s_refresh_queued, false);
+
+    bool primary = false;
+    bool overflow = false;
+    size_t n = 0;
+
+#if CONFIG_OPENTHREAD_BACKBONE_ROUTER
+    primary = otBackboneRouterGetState(s_instance) == OT_BACKBONE_ROUTER_STATE_PRIMARY;
+    if (primary) {
+        otBackboneRouterMulticastListenerIterator it =
+            OT_BACKBONE_ROUTER_MULTICAST_LISTENER_ITERATOR_INIT;
+        otBackboneRouterMulticastListenerInfo info;
+        while (otBackboneRouterMulticastListenerGetNext(s_instance, &it, &info) == OT_ERROR_NONE) {
+            if (n == MCAST_THREAD_GROUPS) {
+                overflow = true;
+                break;
+            }
+            memcpy(s_staging[n++], info.mAddress.mFields.m8, 16);
+        }
+    }
+#endif
+
+    taskENTER_CRITICAL(&s_lock);
+    memset(s_thread_buckets, NIL, sizeof(s_thread_buckets));
+    for (size_t i = 0; i < n; i++) {
+        uint8_t *head = &s_thread_buckets[bucket(s_staging[i])];
+        memcpy(s_thread[i].group, s_staging[i], 16);
+        s_thread[i].next = *head;
+        *head = (uint8_t)i;
+    }
+    /* An incomplete table would drop registered groups */
+    s_thread_known = primary && !overflow;
+    s_stats.bbr_primary = primary;
+    s_stats.thread_groups = n;
+    if (overflow) s_stats.table_full++;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/* esp_timer task: age backbone listeners, queue the Thread refresh */
+static void timer_cb(void *arg)
+{
+    uint32_t now = now_s();
+    taskENTER_CRITICAL(&s_lock);
+    lan_expire(now);
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (atomic_exchange(&s_refresh_queued, true)) return;
+    if (esp_openthread_task_queue_post(refresh_tasklet, NULL) != ESP_OK) {
+        atomic_store(&s_refresh_queued, false);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Control / metrics                                                  */
+/* ------------------------------------------------------------------ */
+
+static void write_metrics(metrics_writer_t *w)
+{
+    mcast_fwd_stats_t st;
+    mcast_fwd_get_stats(&st);
+
+    metrics_header(w, "otbr_mcast_packets_total", "counter",
+                   "Multicast packets crossing the border by policy decision");
+    metrics_sample(w, "otbr_mcast_packets_total", "dir=\"out\",result=\"forwarded\"",
+                   st.out_forwarded);
+    metrics_sample(w, "otbr_mcast_packets_total", "dir=\"out\",result=\"unicast\"",
+                   st.out_unicast);
+    metrics_sample(w, "otbr_mcast_packets_total", "dir=\"out\",result=\"dropped\"",
+                   st.out_dropped);
+    metrics_sample(w, "otbr_mcast_packets_total", "dir=\"out\",result=\"unfiltered\"",
+                   st.out_unfiltered);
+    metrics_sample(w, "otbr_mcast_packets_total", "dir=\"in\",result=\"forwarded\"",
+                   st.in_forwarded);
+    metrics_sample(w, "otbr_mcast_packets_total", "dir=\"in\",result=\"dropped\"",
+                   st.in_dropped);
+    metrics_sample(w, "otbr_mcast_packets_total", "dir=\"in\",result=\"unfiltered\"",
+                   st.in_unfiltered);
+    metrics_counter(w, "otbr_mcast_unicast_copies_total",
+                    "Unicast Wi-Fi frames sent in place of multicast", st.out_copies);
+
+    metrics_header(w, "otbr_mcast_dropped_bytes_total", "counter",
+                   "Multicast bytes not forwarded for lack of listeners");
+    metrics_sample(w, "otbr_mcast_dropped_bytes_total", "dir=\"out\"", st.out_dropped_bytes);
+    metrics_sample(w, "otbr_mcast_dropped_bytes_total", "dir=\"in\"", st.in_dropped_bytes);
+
+    metrics_header(w, "otbr_mcast_airtime_saved_us_total", "counter",
+                   "Estimated airtime saved by the multicast policy");
+    metrics_sample(w, "otbr_mcast_airtime_saved_us_total", "link=\"wifi\"",
+                   st.wifi_airtime_saved_us);
+    metrics_sample(w, "otbr_mcast_airtime_saved_us_total", "link=\"thread\"",
+                   st.thread_airtime_saved_us);
+
+    metrics_header(w, "otbr_mcast_groups", "gauge", "Multicast groups with listeners");
+    metrics_sample(w, "otbr_mcast_groups", "side=\"thread\"", st.thread_groups);
+    metrics_sample(w, "otbr_mcast_groups", "side=\"backbone\"", st.lan_groups);
+    metrics_counter(w, "otbr_mcast_mld_reports_total", "MLD reports seen on the backbone",
+                    st.mld_reports);
+    metrics_counter(w, "otbr_mcast_table_full_total", "Groups that didn't fit a table",
+                    st.table_full);
+}
+
+const char *mcast_policy_name(mcast_policy_t policy)
+{
+    switch (policy) {
+    case MCAST_POLICY_OFF:     return "off";
+    case MCAST_POLICY_FILTER:  return "filter";
+    case MCAST_POLICY_UNICAST: return "unicast";
+    default:                   return "?";
+    }
+}
+
+void mcast_fwd_set_policy(mcast_policy_t policy)
+{
+    s_policy = policy;
+    ESP_LOGI(TAG, "Multicast policy: %s", mcast_policy_name(policy));
+}
+
+void mcast_fwd_start(otInstance *instance)
+{
+    if (s_instance != NULL) return;
+
+    memset(s_thread_buckets, NIL, sizeof(s_thread_buckets));
+    memset(s_lan_buckets, NIL, sizeof(s_lan_buckets));
+    for (uint8_t i = 0; i < MCAST_LAN_GROUPS; i++) {
+        s_lan[i].next = i + 1 < MCAST_LAN_GROUPS ? i + 1 : NIL;
+    }
+    s_lan_free = 0;
+    s_instance = instance;     /* data path hooks start here */
+
+    const esp_timer_create_args_t args = {
+        .callback = timer_cb,
+        .name = "mcast",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &s_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(s_timer, MCAST_REFRESH_MS * 1000));
+
+    metrics_register_source(write_metrics);
+    if (s_policy == MCAST_POLICY_OFF) {
+        ESP_LOGW(TAG, "Multicast filtering inactive (MCAST_POLICY 0): all groups forwarded, "
+                      "set 'otbr mcast filter' to enable");
+    }
+#if !CONFIG_OPENTHREAD_BACKBONE_ROUTER
+    ESP_LOGW(TAG, "No Backbone Router in this OpenThread build: inbound multicast unfiltered");
+#endif
+}
+
+void mcast_fwd_get_stats(mcast_fwd_stats_t *stats)
+{
+    uint32_t now = now_s();
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    stats->snooping = snooping_trusted(now);
+    taskEXIT_CRITICAL(&s_lock);
+    stats->policy = s_policy;
+}
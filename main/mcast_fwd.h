@@ -0,0 +1,111 @@
+/*
+ * Multicast forwarding policy
+ *
+ * lwIP forwards IPv6 multicast between the Thread netif and the Wi-Fi
+ * backbone with no notion of who is listening.  On Wi-Fi every
+ * multicast frame is sent at the AP's lowest basic rate and held for
+ * the next DTIM beacon; on Thread it is flooded to every router.  This
+ * module keeps two indexed subscription tables and applies them in the
+ * esp_netif data path (netif_hooks.c) to groups wider than realm-local
+ * scope (ff04 and up), the ones that cross the border:
+ *
+ *   Thread side   groups Thread devices registered with MLR, read from
+ *                 OpenThread's Backbone Router every MCAST_REFRESH_MS
+ *                 while this router is the Primary BBR
+ *   backbone      groups backbone hosts reported with MLDv1/v2, with
+ *                 up to MCAST_LAN_LISTENERS listener MAC addresses each,
+ *                 snooped from received frames and aged out after the
+ *                 MLD listener interval
+ *
+ * With MCAST_POLICY 1 a group is only forwarded if the other side has a
+ * listener; with 2, a group with few backbone listeners is sent to each
+ * of them as a unicast Wi-Fi frame (same IPv6 packet, listener's MAC),
+ * which goes at the data rate, is acknowledged and isn't held for DTIM.
+ * Both are opt-in (the default is 0).  As a station, each unicast copy
+ * crosses the air twice (up to the AP and down to the listener); a
+ * multicast frame goes up at the data rate and down at the basic rate.
+ * A table that is unknown or incomplete never drops anything: inbound
+ * filtering needs the Primary BBR role and a table that fits, outbound
+ * filtering needs an MLD querier and listener reports on the backbone
+ * (without one, hosts report a group only once, when they join).
+ * Counters include an estimate of the airtime saved on each link.
+ */
+
+#ifndef MCAST_FWD_H
+#define MCAST_FWD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "openthread/instance.h"
+
+#define MCAST_THREAD_GROUPS     64
+#define MCAST_LAN_GROUPS        32
+#define MCAST_LAN_LISTENERS     4
+#define MCAST_REFRESH_MS        5000
+#define MCAST_LISTENER_TIMEOUT_S 260    /* MLD Multicast Address Listening Interval */
+#define MCAST_FRAME_MAX         1518
+
+typedef enum {
+    MCAST_POLICY_OFF = 0,       /* forward everything (lwIP's behaviour) */
+    MCAST_POLICY_FILTER,        /* forward only groups with listeners    */
+    MCAST_POLICY_UNICAST,       /* filter, and convert to unicast on Wi-Fi */
+} mcast_policy_t;
+
+typedef enum {
+    MCAST_FWD_PASS = 0,
+    MCAST_FWD_DROP,
+    MCAST_FWD_UNICAST,
+} mcast_fwd_action_t;
+
+typedef struct {
+    mcast_policy_t policy;
+    bool bbr_primary;           /* Thread-side table known            */
+    bool snooping;              /* backbone table trusted             */
+    uint32_t thread_groups;
+    uint32_t lan_groups;
+    uint32_t mld_reports;
+    uint32_t table_full;        /* groups that didn't fit a table     */
+    /* Thread → backbone */
+    uint32_t out_forwarded;
+    uint32_t out_unicast;       /* packets sent as unicast copies     */
+    uint32_t out_copies;
+    uint32_t out_dropped;       /* no backbone listener               */
+    uint32_t out_unfiltered;    /* table not trusted yet              */
+    uint64_t out_dropped_bytes;
+    /* backbone → Thread */
+    uint32_t in_forwarded;
+    uint32_t in_dropped;        /* no MLR registration                */
+    uint32_t in_unfiltered;
+    uint64_t in_dropped_bytes;
+    /* Estimates: dropped frames, and unicast copies vs one multicast */
+    uint64_t wifi_airtime_saved_us;
+    uint64_t thread_airtime_saved_us;
+} mcast_fwd_stats_t;
+
+/** Start refreshing the Thread-side table and register metrics. */
+void mcast_fwd_start(otInstance *instance);
+
+void mcast_fwd_set_policy(mcast_policy_t policy);
+
+const char *mcast_policy_name(mcast_policy_t policy);
+
+void mcast_fwd_get_stats(mcast_fwd_stats_t *stats);
+
+/** Called by netif_hooks.c for every Ethernet frame received on the backbone. */
+void mcast_fwd_snoop(const uint8_t *frame, size_t len);
+
+/**
+ * Called by netif_hooks.c for every Ethernet frame lwIP sends to the
+ * backbone.  MCAST_FWD_UNICAST: send a copy to each of the *num_macs
+ * listener addresses in macs instead.
+ */
+mcast_fwd_action_t mcast_fwd_to_backbone(const uint8_t *frame, size_t len,
+                                         uint8_t macs[MCAST_LAN_LISTENERS][6],
+                                         size_t *num_macs);
+
+/** Called for every IPv6 packet lwIP sends to Thread; true: drop it. */
+bool mcast_fwd_to_thread(const uint8_t *packet, size_t len);
+
+#endif /* MCAST_FWD_H */
@@ -0,0 +1,117 @@
+/*
+ * Fixed-size block pools — see mem_pool.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "mem_pool.h"
+
+static const char *TAG = "mem_pool";
+
+static portMUX_TYPE s_list_lock = portMUX_INITIALIZER_UNLOCKED;
+static mem_pool_t *s_pools;
+
+static bool owns(const mem_pool_t *pool, const void *block)
+{
+    const uint8_t *p = block;
+    return p >= pool->blocks && p < pool->blocks + (size_t)pool->count * pool->block_size;
+}
+
+void mem_pool_register(mem_pool_t *pool)
+{
+    taskENTER_CRITICAL(&s_list_lock);
+    if (!pool->registered) {
+        pool->registered = true;
+        pool->next = s_pools;
+        s_pools = pool;
+    }
+    taskEXIT_CRITICAL(&s_list_lock);
+}
+
+void *mem_pool_alloc(mem_pool_t *pool, size_t size)
+{
+    void *block = NULL;
+    bool first_miss = false;
+
+    taskENTER_CRITICAL(&pool->lock);
+    if (size > pool->block_size) {
+        first_miss = pool->oversize++ == 0;
+    } else if (pool->free_list != NULL) {
+        block = pool->free_list;
+        pool->free_list = *(void **)block;
+    } else if (pool->fresh < pool->count) {
+        block = pool->blocks + (size_t)pool->fresh++ * pool->block_size;
+    } else {
+        first_miss = pool->exhausted++ == 0;
+    }
+    if (block != NULL && ++pool->used > pool->peak) pool->peak = pool->used;
+    taskEXIT_CRITICAL(&pool->lock);
+
+    if (block != NULL) {
+        memset(block, 0, pool->block_size);
+        return block;
+    }
+    if (first_miss) {
+        ESP_LOGW(TAG, "%s: %s, using the heap", pool->name,
+                 size > pool->block_size ? "request larger than a block" : "pool empty");
+    }
+    return calloc(1, size);
+}
+
+void mem_pool_free(mem_pool_t *pool, void *block)
+{
+    if (block == NULL) return;
+    if (!owns(pool, block)) {
+        free(block);
+        return;
+    }
+
+    taskENTER_CRITICAL(&pool->lock);
+    *(void **)block = pool->free_list;
+    pool->free_list = block;
+    pool->used--;
+    taskEXIT_CRITICAL(&pool->lock);
+}
+
+size_t mem_pool_list(mem_pool_stats_t *out, size_t max)
+{
+    size_t n = 0;
+
+    taskENTER_CRITICAL(&s_list_lock);
+    mem_pool_t *pool = s_pools;
+    taskEXIT_CRITICAL(&s_list_lock);
+
+    /* Pools are never unregistered, so the list can be walked unlocked */
+    for (; pool != NULL && n < max; pool = pool->next, n++) {
+        taskENTER_CRITICAL(&pool->lock);
+        out[n] = (mem_pool_stats_t){
+            .name = pool->name,
+            .block_size = pool->block_size,
+            .count = pool->count,
+            .used = pool->used,
+            .peak = pool->peak,
+            .exhausted = pool->exhausted,
+            .oversize = pool->oversize,
+        };
+        taskEXIT_CRITICAL(&pool->lock);
+    }
+    return n;
+}
+
+size_t mem_pool_reserved_bytes(void)
+{
+    size_t bytes = 0;
+
+    taskENTER_CRITICAL(&s_list_lock);
+    for (const mem_pool_t *pool = s_pools; pool != NULL; pool = pool->next) {
+        bytes += (size_t)pool->count * pool->block_size;
+    }
+    taskEXIT_CRITICAL(&s_list_lock);
+    return bytes;
+}
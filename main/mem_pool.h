@@ -0,0 +1,85 @@
+/*
+ * Fixed-size block pools
+ *
+ * Entries that live for as long as a Thread device stays registered
+ * (published SRP hosts and services), queued SRP updates and small
+ * discovery-proxy answers are allocated and freed in an order nobody
+ * controls; over weeks of uptime that leaves the heap in pieces even
+ * when plenty is free.  Each pool is a static array of equal blocks
+ * reserved at build time (so it shows in the image's .bss size, not as
+ * heap) with a free list.  Allocation takes a block, or falls back to
+ * the heap when the pool is empty or the request is larger than a
+ * block — counted, so "otbr mem" shows which pool to resize.
+ *
+ *     MEM_POOL_DEFINE(s_host_pool, "srp_host", sizeof(pub_host_t), 32);
+ *     mem_pool_register(&s_host_pool);            // once, for reports
+ *     pub_host_t *h = mem_pool_alloc(&s_host_pool, sizeof(*h));
+ *     mem_pool_free(&s_host_pool, h);
+ */
+
+#ifndef MEM_POOL_H
+#define MEM_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+#define MEM_POOL_ALIGN(size)    (((size) + 7) & ~(size_t)7)
+
+typedef struct mem_pool {
+    const char *name;
+    size_t block_size;
+    uint16_t count;
+    uint8_t *blocks;
+    /* Everything below is guarded by lock */
+    portMUX_TYPE lock;
+    void *free_list;            /* blocks handed back                 */
+    uint16_t fresh;             /* blocks never handed out start here */
+    uint16_t used;
+    uint16_t peak;
+    uint32_t exhausted;         /* heap fallbacks: pool empty         */
+    uint32_t oversize;          /* heap fallbacks: request too large  */
+    struct mem_pool *next;      /* registered pools                   */
+    bool registered;
+} mem_pool_t;
+
+typedef struct {
+    const char *name;
+    size_t block_size;
+    uint16_t count;
+    uint16_t used;
+    uint16_t peak;
+    uint32_t exhausted;
+    uint32_t oversize;
+} mem_pool_stats_t;
+
+/** Define a static pool of count blocks of at least size bytes. */
+#define MEM_POOL_DEFINE(var, label, size, count_)                                  \
+    static uint8_t var##_blocks[(count_) * MEM_POOL_ALIGN(size)]                  \
+        __attribute__((aligned(8)));                                              \
+    static mem_pool_t var = {                                                     \
+        .name = (label),                                                          \
+        .block_size = MEM_POOL_ALIGN(size),                                       \
+        .count = (count_),                                                        \
+        .blocks = var##_blocks,                                                   \
+        .lock = portMUX_INITIALIZER_UNLOCKED,                                     \
+    }
+
+/** Add a pool to the memory report and metrics (idempotent). */
+void mem_pool_register(mem_pool_t *pool);
+
+/** Zeroed block of at least size bytes, from the pool or the heap; NULL if neither has one. */
+void *mem_pool_alloc(mem_pool_t *pool, size_t size);
+
+/** Free a block from mem_pool_alloc(); NULL is ignored. */
+void mem_pool_free(mem_pool_t *pool, void *block);
+
+/** Stats of up to max registered pools; returns how many were written. */
+size_t mem_pool_list(mem_pool_stats_t *out, size_t max);
+
+/** Bytes reserved by all registered pools. */
+size_t mem_pool_reserved_bytes(void);
+
+#endif /* MEM_POOL_H */
@@ -0,0 +1,480 @@
+/*
+ * Memory budget, heap/stack watch and soak test — see mem_watch.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "lwip/inet.h"
+#include "lwip/sockets.h"
+
+#include "burst_bench.h"
+#include "config.h"
+#include "mem_pool.h"
+#include "mem_watch.h"
+#include "metrics.h"
+#include "ot_status.h"
+#include "srp_mdns.h"
+
+static const char *TAG = "mem";
+
+#define MAX_TASKS               24
+#define MAX_POOLS               8
+#define STACK_WARNED_MAX        8
+
+/* Stack sizes set in config.h, shown next to their high-water marks */
+static const struct { const char *name; uint32_t size; } s_stack_sizes[] = {
+    { "ot_main", OT_TASK_STACK },
+};
+
+typedef enum {
+    WARN_HEAP,
+    WARN_BLOCK,
+    WARN_STACK,
+    WARN_OT_BUFFERS,
+    WARN_ALLOC,
+    WARN_KINDS,
+} warn_kind_t;
+
+static const char *const s_warn_names[WARN_KINDS] = {
+    "heap", "block", "stack", "ot_buffers", "alloc",
+};
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static mem_watch_stats_t s_stats;
+static uint32_t s_warn_counts[WARN_KINDS];
+static TaskHandle_t s_task;
+
+/* Watch task only */
+static bool s_raised[WARN_KINDS];
+static char s_stack_warned[STACK_WARNED_MAX][16];
+static mem_task_stack_t s_stacks[MAX_TASKS];
+static ot_status_t s_status;
+
+static struct {
+    mem_soak_stats_t st;        /* s_lock */
+    uint32_t base_largest;
+    int64_t base_us;
+    uint32_t minutes;
+    char addr[INET6_ADDRSTRLEN];
+    volatile bool stop;
+    TaskHandle_t task;
+} s_soak;
+
+/* ------------------------------------------------------------------ */
+/*  Sampling                                                           */
+/* ------------------------------------------------------------------ */
+
+static void on_alloc_failed(size_t size, uint32_t caps, const char *function_name)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.alloc_failures++;
+    s_stats.last_failed_size = size;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static void sample_heap(mem_watch_stats_t *st)
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+
+    st->heap_total = heap_caps_get_total_size(MALLOC_CAP_8BIT);
+    st->heap_free = info.total_free_bytes;
+    st->heap_min_free = info.minimum_free_bytes;
+    st->heap_largest = info.largest_free_block;
+    st->fragmentation = info.total_free_bytes > 0
+        ? 100 - (uint32_t)((uint64_t)info.largest_free_block * 100 / info.total_free_bytes)
+        : 0;
+}
+
+/* Copy heap and OpenThread buffer figures into s_stats */
+static void sample(void)
+{
+    mem_watch_stats_t st;
+    sample_heap(&st);
+    bool buffers = ot_status_read(&s_status);
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.heap_total = st.heap_total;
+    s_stats.heap_free = st.heap_free;
+    s_stats.heap_min_free = st.heap_min_free;
+    s_stats.heap_largest = st.heap_largest;
+    s_stats.fragmentation = st.fragmentation;
+    if (buffers) {
+        s_stats.ot_buffers = s_status.buffers.mTotalBuffers;
+        s_stats.ot_buffers_free = s_status.buffers.mFreeBuffers;
+        if (s_stats.ot_buffers_min_free == 0 ||
+            s_status.buffers.mFreeBuffers < s_stats.ot_buffers_min_free) {
+            s_stats.ot_buffers_min_free = s_status.buffers.mFreeBuffers;
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static uint32_t known_stack_size(const char *name)
+{
+    for (size_t i = 0; i < sizeof(s_stack_sizes) / sizeof(s_stack_sizes[0]); i++) {
+        if (strcmp(name, s_stack_sizes[i].name) == 0) return s_stack_sizes[i].size;
+    }
+    return 0;
+}
+
+size_t mem_watch_get_stacks(mem_task_stack_t *out, size_t max)
+{
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    UBaseType_t cap = uxTaskGetNumberOfTasks() + 2;
+    TaskStatus_t *tasks = malloc(cap * sizeof(*tasks));
+    if (tasks == NULL) return 0;
+
+    UBaseType_t n = uxTaskGetSystemState(tasks, cap, NULL);
+    size_t count = 0;
+    for (UBaseType_t i = 0; i < n && count < max; i++, count++) {
+        strlcpy(out[count].name, tasks[i].pcTaskName, sizeof(out[count].name));
+        out[count].free_min = tasks[i].usStackHighWaterMark;
+        out[count].stack_size = known_stack_size(out[count].name);
+    }
+    free(tasks);
+    return count;
+#else
+    return 0;
+#endif
+}
+
+/* ------------------------------------------------------------------ */
+/*  Warnings                                                           */
+/* ------------------------------------------------------------------ */
+
+static void count_warning(warn_kind_t kind)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_warn_counts[kind]++;
+    s_stats.warnings++;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/* Warn once when value drops below limit; clear once it is a quarter
+ * above it again                                                      */
+static void check(warn_kind_t kind, uint32_t value, uint32_t limit, const char *what)
+{
+    if (!s_raised[kind] && value < limit) {
+        s_raised[kind] = true;
+        count_warning(kind);
+        ESP_LOGW(TAG, "%s down to %lu (warning below %lu)", what,
+                 (unsigned long)value, (unsigned long)limit);
+    } else if (s_raised[kind] && value >= limit + limit / 4) {
+        s_raised[kind] = false;
+        ESP_LOGI(TAG, "%s back to %lu", what, (unsigned long)value);
+    }
+}
+
+/* A high-water mark never recovers: warn once per task */
+static void check_stacks(void)
+{
+    size_t n = mem_watch_get_stacks(s_stacks, MAX_TASKS);
+
+    for (size_t i = 0; i < n; i++) {
+        if (s_stacks[i].free_min >= MEM_WARN_STACK_BYTES) continue;
+
+        size_t slot = 0;
+        while (slot < STACK_WARNED_MAX && s_stack_warned[slot][0] != '\0' &&
+               strcmp(s_stack_warned[slot], s_stacks[i].name) != 0) {
+            slot++;
+        }
+        if (slot < STACK_WARNED_MAX && s_stack_warned[slot][0] != '\0') continue;
+        if (slot < STACK_WARNED_MAX) {
+            strlcpy(s_stack_warned[slot], s_stacks[i].name, sizeof(s_stack_warned[slot]));
+        }
+
+        count_warning(WARN_STACK);
+        ESP_LOGW(TAG, "Task %s has come within %lu B of its stack end (warning below %d)",
+                 s_stacks[i].name, (unsigned long)s_stacks[i].free_min, MEM_WARN_STACK_BYTES);
+    }
+}
+
+static void watch_task(void *arg)
+{
+    uint32_t reported_failures = 0;
+
+    for (;;) {
+        sample();
+
+        mem_watch_stats_t st;
+        mem_watch_get_stats(&st);
+        check(WARN_HEAP, st.heap_free, MEM_WARN_FREE_BYTES, "Free heap");
+        check(WARN_BLOCK, st.heap_largest, MEM_WARN_BLOCK_BYTES, "Largest free heap block");
+        if (st.ot_buffers > 0) {
+            check(WARN_OT_BUFFERS, st.ot_buffers_free, MEM_WARN_OT_BUFFERS,
+                  "Free OpenThread message buffers");
+        }
+        check_stacks();
+
+        if (st.alloc_failures != reported_failures) {
+            count_warning(WARN_ALLOC);
+            ESP_LOGW(TAG, "%lu allocations failed since the last check (last %lu B); "
+                     "%lu B free, largest block %lu B",
+                     (unsigned long)(st.alloc_failures - reported_failures),
+                     (unsigned long)st.last_failed_size, (unsigned long)st.heap_free,
+                     (unsigned long)st.heap_largest);
+            reported_failures = st.alloc_failures;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(MEM_WATCH_PERIOD_MS));
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Budget report                                                      */
+/* ------------------------------------------------------------------ */
+
+static void log_budget(void)
+{
+    mem_watch_stats_t st;
+    mem_watch_get_stats(&st);
+
+    ESP_LOGI(TAG, "Memory budget: heap %lu B, %lu B free (lowest %lu B), "
+             "largest block %lu B (%lu %% fragmented)",
+             (unsigned long)st.heap_total, (unsigned long)st.heap_free,
+             (unsigned long)st.heap_min_free, (unsigned long)st.heap_largest,
+             (unsigned long)st.fragmentation);
+
+    mem_pool_stats_t pools[MAX_POOLS];
+    size_t num_pools = mem_pool_list(pools, MAX_POOLS);
+    for (size_t i = 0; i < num_pools; i++) {
+        ESP_LOGI(TAG, "  pool %-12s %3u x %4u B = %6u B static",
+                 pools[i].name, (unsigned)pools[i].count, (unsigned)pools[i].block_size,
+                 (unsigned)(pools[i].count * pools[i].block_size));
+    }
+    ESP_LOGI(TAG, "  pools total        %6u B static", (unsigned)mem_pool_reserved_bytes());
+
+    if (st.ot_buffers > 0) {
+        ESP_LOGI(TAG, "  OpenThread message buffers: %u, %u free",
+                 (unsigned)st.ot_buffers, (unsigned)st.ot_buffers_free);
+    }
+    ESP_LOGI(TAG, "  stack ot_br_init   %5lu of %d B used",
+             (unsigned long)st.br_init_stack_used, BR_INIT_STACK);
+
+    size_t n = mem_watch_get_stacks(s_stacks, MAX_TASKS);
+    for (size_t i = 0; i < n; i++) {
+        if (s_stacks[i].stack_size > 0) {
+            ESP_LOGI(TAG, "  stack %-12s %5lu of %lu B used", s_stacks[i].name,
+                     (unsigned long)(s_stacks[i].stack_size - s_stacks[i].free_min),
+                     (unsigned long)s_stacks[i].stack_size);
+        } else {
+            ESP_LOGI(TAG, "  stack %-12s %5lu B never used", s_stacks[i].name,
+                     (unsigned long)s_stacks[i].free_min);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Soak test                                                          */
+/* ------------------------------------------------------------------ */
+
+static void log_soak(const char *what, const mem_soak_stats_t *st)
+{
+    int64_t hours_x100 = (esp_timer_get_time() - s_soak.base_us) / 36000000;
+    ESP_LOGI(TAG, "soak %s: %lu cycles in %lu s (%lu skipped); free heap %+ld B "
+             "(%+ld B/h), largest block %+ld B, lowest largest block %lu B",
+             what, (unsigned long)st->cycles, (unsigned long)st->elapsed_s,
+             (unsigned long)st->skipped, (long)st->drift,
+             (long)(hours_x100 > 0 ? st->drift * 100 / hours_x100 : 0),
+             (long)st->largest_drift, (unsigned long)st->min_largest);
+}
+
+static void soak_wait(uint32_t ms)
+{
+    if (!s_soak.stop) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+}
+
+/* Heap after a full publish/remove cycle; the first one is the base,
+ * since mDNS keeps some of what its first publish allocates           */
+static void soak_sample(bool churned, int64_t start_us)
+{
+    uint32_t free_now = esp_get_free_heap_size();
+    uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    mem_soak_stats_t copy;
+
+    taskENTER_CRITICAL(&s_lock);
+    mem_soak_stats_t *st = &s_soak.st;
+    if (!churned) st->skipped++;
+    if (st->cycles++ == 0) {
+        st->base_free = free_now;
+        st->min_largest = largest;
+        s_soak.base_largest = largest;
+        s_soak.base_us = esp_timer_get_time();
+    }
+    st->drift = (int32_t)(free_now - st->base_free);
+    st->largest_drift = (int32_t)(largest - s_soak.base_largest);
+    if (largest < st->min_largest) st->min_largest = largest;
+    st->elapsed_s = (uint32_t)((esp_timer_get_time() - start_us) / 1000000);
+    copy = *st;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (copy.cycles % MEM_SOAK_REPORT_CYCLES == 0) log_soak("progress", &copy);
+}
+
+static void soak_task(void *arg)
+{
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us = s_soak.minutes > 0 ? start_us + (int64_t)s_soak.minutes * 60000000 : INT64_MAX;
+    bool published = false;
+
+    while (!s_soak.stop && esp_timer_get_time() < end_us) {
+        /* A removal that couldn't run yet (publish still busy) goes first */
+        bool churned = false;
+        if (!published) published = churned = srp_mdns_bench(MEM_SOAK_HOSTS) == ESP_OK;
+        if (s_soak.addr[0] != '\0') {
+            burst_bench_start(s_soak.addr, MEM_SOAK_BURST_COUNT, MEM_SOAK_BURST_SIZE);
+        }
+        soak_wait(MEM_SOAK_CYCLE_MS / 2);
+
+        if (published && srp_mdns_bench(0) == ESP_OK) published = false;
+        soak_wait(MEM_SOAK_CYCLE_MS / 2);
+
+        if (!s_soak.stop) soak_sample(churned, start_us);
+    }
+
+    /* Don't leave the synthetic hosts on the LAN */
+    for (int i = 0; published && i < 10; i++) {
+        if (srp_mdns_bench(0) == ESP_OK) published = false;
+        else vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+
+    mem_soak_stats_t st;
+    taskENTER_CRITICAL(&s_lock);
+    s_soak.st.active = false;
+    st = s_soak.st;
+    s_soak.task = NULL;
+    taskEXIT_CRITICAL(&s_lock);
+    log_soak("done", &st);
+
+    vTaskDelete(NULL);
+}
+
+esp_err_t mem_soak_start(uint32_t minutes, const char *ipv6_addr)
+{
+    struct in6_addr addr;
+    if (s_soak.task != NULL) return ESP_ERR_INVALID_STATE;
+    if (ipv6_addr != NULL && inet_pton(AF_INET6, ipv6_addr, &addr) != 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    memset(&s_soak.st, 0, sizeof(s_soak.st));
+    s_soak.st.active = true;
+    taskEXIT_CRITICAL(&s_lock);
+    s_soak.minutes = minutes;
+    s_soak.stop = false;
+    strlcpy(s_soak.addr, ipv6_addr != NULL ? ipv6_addr : "", sizeof(s_soak.addr));
+
+    if (xTaskCreate(soak_task, "mem_soak", 3072, NULL, 2, &s_soak.task) != pdPASS) {
+        s_soak.st.active = false;
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "soak: %d synthetic mDNS hosts every %d s%s%s, %s", MEM_SOAK_HOSTS,
+             MEM_SOAK_CYCLE_MS / 1000, s_soak.addr[0] ? ", echo bursts to " : "", s_soak.addr,
+             minutes > 0 ? "timed" : "until stopped");
+    return ESP_OK;
+}
+
+void mem_soak_stop(void)
+{
+    s_soak.stop = true;
+    /* Lower priority than any caller: it can't exit between these lines */
+    if (s_soak.task != NULL) xTaskNotifyGive(s_soak.task);
+}
+
+void mem_soak_get_stats(mem_soak_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_soak.st;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Control / metrics                                                  */
+/* ------------------------------------------------------------------ */
+
+static void write_metrics(metrics_writer_t *w)
+{
+    mem_watch_stats_t st;
+    mem_watch_get_stats(&st);
+
+    metrics_gauge(w, "otbr_heap_fragmentation_percent",
+                  "Share of free heap outside the largest block", st.fragmentation);
+    metrics_counter(w, "otbr_heap_alloc_failures_total", "Heap allocations that failed",
+                    st.alloc_failures);
+    metrics_gauge(w, "otbr_ot_message_buffers_free_min",
+                  "Fewest free OpenThread message buffers seen", st.ot_buffers_min_free);
+
+    uint32_t counts[WARN_KINDS];
+    taskENTER_CRITICAL(&s_lock);
+    memcpy(counts, s_warn_counts, sizeof(counts));
+    taskEXIT_CRITICAL(&s_lock);
+    metrics_header(w, "otbr_mem_warnings_total", "counter", "Memory warnings by kind");
+    for (size_t i = 0; i < WARN_KINDS; i++) {
+        metrics_printf(w, "otbr_mem_warnings_total{kind=\"%s\"} %lu\n", s_warn_names[i],
+                       (unsigned long)counts[i]);
+    }
+
+    mem_pool_stats_t pools[MAX_POOLS];
+    size_t num_pools = mem_pool_list(pools, MAX_POOLS);
+    metrics_header(w, "otbr_mem_pool_blocks", "gauge", "Static pool blocks by state");
+    for (size_t i = 0; i < num_pools; i++) {
+        metrics_printf(w, "otbr_mem_pool_blocks{pool=\"%s\",state=\"total\"} %u\n",
+                       pools[i].name, (unsigned)pools[i].count);
+        metrics_printf(w, "otbr_mem_pool_blocks{pool=\"%s\",state=\"used\"} %u\n",
+                       pools[i].name, (unsigned)pools[i].used);
+        metrics_printf(w, "otbr_mem_pool_blocks{pool=\"%s\",state=\"peak\"} %u\n",
+                       pools[i].name, (unsigned)pools[i].peak);
+    }
+    metrics_header(w, "otbr_mem_pool_fallbacks_total", "counter",
+                   "Pool allocations served from the heap");
+    for (size_t i = 0; i < num_pools; i++) {
+        metrics_printf(w, "otbr_mem_pool_fallbacks_total{pool=\"%s\",reason=\"exhausted\"} %lu\n",
+                       pools[i].name, (unsigned long)pools[i].exhausted);
+        metrics_printf(w, "otbr_mem_pool_fallbacks_total{pool=\"%s\",reason=\"oversize\"} %lu\n",
+                       pools[i].name, (unsigned long)pools[i].oversize);
+    }
+
+    mem_soak_stats_t soak;
+    mem_soak_get_stats(&soak);
+    if (soak.cycles > 0) {
+        metrics_header(w, "otbr_soak_heap_drift_bytes", "gauge",
+                       "Free heap change since the soak test's first cycle");
+        metrics_printf(w, "otbr_soak_heap_drift_bytes %ld\n", (long)soak.drift);
+        metrics_counter(w, "otbr_soak_cycles_total", "Soak test cycles run", soak.cycles);
+    }
+}
+
+void mem_watch_init(void)
+{
+    heap_caps_register_failed_alloc_callback(on_alloc_failed);
+}
+
+void mem_watch_start(void)
+{
+    if (s_task != NULL) return;
+
+    /* Called at the end of ot_br_init, which then exits */
+    s_stats.br_init_stack_used = BR_INIT_STACK - uxTaskGetStackHighWaterMark(NULL);
+    sample();
+    log_budget();
+
+    metrics_register_source(write_metrics);
+    xTaskCreate(watch_task, "mem_watch", 3072, NULL, 2, &s_task);
+}
+
+void mem_watch_get_stats(mem_watch_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,99 @@
+/*
+ * Memory budget, heap/stack watch and soak test
+ *
+ * Once border routing is up, a budget report is logged: heap size, free
+ * and largest block, the static pools (mem_pool.h), OpenThread's message
+ * buffer pool (CONFIG_OPENTHREAD_NUM_MESSAGE_BUFFERS — already a fixed
+ * array inside OpenThread), how much of OT_TASK_STACK and BR_INIT_STACK
+ * was actually used, and every task's lowest free stack.
+ *
+ * Every MEM_WATCH_PERIOD_MS the heap's fragmentation (share of free heap
+ * outside the largest block), task stack high-water marks and free
+ * message buffers are checked against the MEM_WARN_* limits in config.h.
+ * Each limit logs one warning when crossed and one line when it has
+ * recovered by a quarter, so a slow leak shows up in the log well
+ * before an allocation fails.  Failed allocations themselves are
+ * counted with the size that failed.
+ *
+ * The soak test ("otbr mem soak") hands MEM_SOAK_HOSTS synthetic hosts
+ * straight to the SRP → mDNS publisher (the SRP server is not
+ * involved), which publishes and removes them every MEM_SOAK_CYCLE_MS,
+ * optionally with an echo burst to a Thread device each cycle, and
+ * reports how free heap and the largest block drift from where they
+ * were after the first cycle.  Steady values over
+ * hours mean nothing leaks or fragments on those paths.
+ */
+
+#ifndef MEM_WATCH_H
+#define MEM_WATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define MEM_WATCH_PERIOD_MS     30000
+
+#define MEM_SOAK_CYCLE_MS       20000
+#define MEM_SOAK_HOSTS          12
+#define MEM_SOAK_BURST_COUNT    50
+#define MEM_SOAK_BURST_SIZE     256
+#define MEM_SOAK_REPORT_CYCLES  15      /* progress in the log, every 5 min */
+
+typedef struct {
+    uint32_t heap_total;
+    uint32_t heap_free;
+    uint32_t heap_min_free;
+    uint32_t heap_largest;
+    uint32_t fragmentation;     /* % of free heap outside the largest block */
+    uint32_t alloc_failures;
+    uint32_t last_failed_size;
+    uint32_t warnings;
+    uint16_t ot_buffers;
+    uint16_t ot_buffers_free;
+    uint16_t ot_buffers_min_free;
+    uint32_t br_init_stack_used;
+} mem_watch_stats_t;
+
+typedef struct {
+    char name[16];
+    uint32_t stack_size;        /* 0 unless set in config.h           */
+    uint32_t free_min;          /* high-water mark (bytes never used) */
+} mem_task_stack_t;
+
+typedef struct {
+    bool active;
+    uint32_t cycles;
+    uint32_t skipped;           /* cycles the SRP churn couldn't run  */
+    uint32_t elapsed_s;
+    uint32_t base_free;         /* after the first cycle              */
+    int32_t drift;              /* free heap now minus base_free      */
+    int32_t largest_drift;      /* same for the largest free block    */
+    uint32_t min_largest;
+} mem_soak_stats_t;
+
+/** Count failed allocations from here on; call early in app_main. */
+void mem_watch_init(void);
+
+/** Log the budget report and start watching; call from ot_br_init. */
+void mem_watch_start(void);
+
+void mem_watch_get_stats(mem_watch_stats_t *stats);
+
+/** Stack high-water marks of up to max tasks; returns how many. */
+size_t mem_watch_get_stacks(mem_task_stack_t *out, size_t max);
+
+/**
+ * Run the soak test for minutes (0: until stopped), with an echo burst
+ * to ipv6_addr every cycle unless it is NULL.  ESP_ERR_INVALID_STATE if
+ * one is running, ESP_ERR_INVALID_ARG for a bad address.
+ */
+esp_err_t mem_soak_start(uint32_t minutes, const char *ipv6_addr);
+
+/** Stop after the current cycle; the final report is logged. */
+void mem_soak_stop(void);
+
+void mem_soak_get_stats(mem_soak_stats_t *stats);
+
+#endif /* MEM_WATCH_H */
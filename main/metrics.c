@@ -0,0 +1,440 @@
+/*
+ * Data-plane metrics (Prometheus text exposition) — see metrics.h
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_heap_caps.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#if CONFIG_LWIP_STATS
+#include "lwip/stats.h"
+#endif
+
+#include "config.h"
+#include "boot_time.h"
+#include "metrics.h"
+#include "netif_hooks.h"
+#include "ot_settings.h"
+#include "ot_status.h"
+#include "wifi_power.h"
+#include "wifi_reconnect.h"
+
+static const char *TAG = "metrics";
+
+#define METRICS_MAX_SOURCES     16
+#define METRICS_CHUNK_SIZE      512
+
+struct metrics_writer {
+    httpd_req_t *req;
+    size_t len;
+    char buf[METRICS_CHUNK_SIZE];
+};
+
+/* Sources register from their own init, on whichever task runs it */
+static portMUX_TYPE s_sources_lock = portMUX_INITIALIZER_UNLOCKED;
+static metrics_source_fn s_sources[METRICS_MAX_SOURCES];
+static size_t s_num_sources = 0;
+static httpd_handle_t s_server = NULL;
+
+/* Tasks whose stack high-water mark is exported (missing ones are skipped) */
+static const char *const s_task_names[] = {
+    "ot_main", "main", "sys_evt", "tiT", "wifi", "mdns", "esp_timer", "httpd",
+};
+
+/* ------------------------------------------------------------------ */
+/*  OpenThread task-queue drop counter                                 */
+/*                                                                     */
+/*  The netif glue hands packets to the OpenThread task through        */
+/*  esp_openthread_task_queue_post(); a full queue drops the packet    */
+/*  silently.  The linker wraps the call (see main/CMakeLists.txt) so  */
+/*  failed posts can be counted.                                       */
+/* ------------------------------------------------------------------ */
+
+typedef void (*ot_task_queue_fn_t)(void *);
+esp_err_t __real_esp_openthread_task_queue_post(ot_task_queue_fn_t task, void *arg);
+
+static volatile uint32_t s_task_queue_posts = 0;
+static volatile uint32_t s_task_queue_drops = 0;
+
+esp_err_t __wrap_esp_openthread_task_queue_post(ot_task_queue_fn_t task, void *arg)
+{
+    esp_err_t err = __real_esp_openthread_task_queue_post(task, arg);
+    if (err == ESP_OK) {
+        s_task_queue_posts++;
+    } else {
+        s_task_queue_drops++;
+    }
+    return err;
+}
+
+uint32_t metrics_task_queue_drops(void)
+{
+    return s_task_queue_drops;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Writer helpers                                                     */
+/* ------------------------------------------------------------------ */
+
+static void writer_flush(metrics_writer_t *w)
+{
+    if (w->len > 0) {
+        httpd_resp_send_chunk(w->req, w->buf, w->len);
+        w->len = 0;
+    }
+}
+
+void metrics_printf(metrics_writer_t *w, const char *fmt, ...)
+{
+    va_list ap;
+
+    for (int pass = 0; pass < 2; pass++) {
+        size_t room = sizeof(w->buf) - w->len;
+        va_start(ap, fmt);
+        int n = vsnprintf(w->buf + w->len, room, fmt, ap);
+        va_end(ap);
+
+        if (n < 0) return;
+        if ((size_t)n < room) {
+            w->len += n;
+            return;
+        }
+        /* Did not fit — flush what we have and retry once */
+        writer_flush(w);
+    }
+    /* A single line longer than the chunk buffer is truncated */
+    w->len = sizeof(w->buf) - 1;
+    writer_flush(w);
+}
+
+void metrics_header(metrics_writer_t *w, const char *name,
+                    const char *type, const char *help)
+{
+    metrics_printf(w, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void metrics_sample(metrics_writer_t *w, const char *name,
+                    const char *labels, uint64_t value)
+{
+    if (labels != NULL) {
+        metrics_printf(w, "%s{%s} %llu\n", name, labels, (unsigned long long)value);
+    } else {
+        metrics_printf(w, "%s %llu\n", name, (unsigned long long)value);
+    }
+}
+
+void metrics_counter(metrics_writer_t *w, const char *name,
+                     const char *help, uint64_t value)
+{
+    metrics_header(w, name, "counter", help);
+    metrics_sample(w, name, NULL, value);
+}
+
+void metrics_gauge(metrics_writer_t *w, const char *name,
+                   const char *help, uint64_t value)
+{
+    metrics_header(w, name, "gauge", help);
+    metrics_sample(w, name, NULL, value);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Built-in sources                                                   */
+/* ------------------------------------------------------------------ */
+
+static void write_forwarding(metrics_writer_t *w, const ot_status_t *s)
+{
+    /* in = backbone → Thread, out = Thread → backbone */
+    metrics_header(w, "otbr_forward_packets_total", "counter",
+                   "Packets forwarded between Thread and the backbone");
+    metrics_sample(w, "otbr_forward_packets_total", "dir=\"in\",cast=\"unicast\"",
+                   s->br.mInboundUnicast.mPackets);
+    metrics_sample(w, "otbr_forward_packets_total", "dir=\"in\",cast=\"multicast\"",
+                   s->br.mInboundMulticast.mPackets);
+    metrics_sample(w, "otbr_forward_packets_total", "dir=\"out\",cast=\"unicast\"",
+                   s->br.mOutboundUnicast.mPackets);
+    metrics_sample(w, "otbr_forward_packets_total", "dir=\"out\",cast=\"multicast\"",
+                   s->br.mOutboundMulticast.mPackets);
+
+    metrics_header(w, "otbr_forward_bytes_total", "counter",
+                   "Bytes forwarded between Thread and the backbone");
+    metrics_sample(w, "otbr_forward_bytes_total", "dir=\"in\",cast=\"unicast\"",
+                   s->br.mInboundUnicast.mBytes);
+    metrics_sample(w, "otbr_forward_bytes_total", "dir=\"in\",cast=\"multicast\"",
+                   s->br.mInboundMulticast.mBytes);
+    metrics_sample(w, "otbr_forward_bytes_total", "dir=\"out\",cast=\"unicast\"",
+                   s->br.mOutboundUnicast.mBytes);
+    metrics_sample(w, "otbr_forward_bytes_total", "dir=\"out\",cast=\"multicast\"",
+                   s->br.mOutboundMulticast.mBytes);
+
+    metrics_header(w, "otbr_ot_ip6_packets_total", "counter",
+                   "IPv6 packets handled by the Thread interface");
+    metrics_sample(w, "otbr_ot_ip6_packets_total", "dir=\"tx\",result=\"ok\"", s->ip6.mTxSuccess);
+    metrics_sample(w, "otbr_ot_ip6_packets_total", "dir=\"tx\",result=\"fail\"", s->ip6.mTxFailure);
+    metrics_sample(w, "otbr_ot_ip6_packets_total", "dir=\"rx\",result=\"ok\"", s->ip6.mRxSuccess);
+    metrics_sample(w, "otbr_ot_ip6_packets_total", "dir=\"rx\",result=\"fail\"", s->ip6.mRxFailure);
+
+    metrics_gauge(w, "otbr_ot_message_buffers_total",
+                  "OpenThread message buffers in the pool", s->buffers.mTotalBuffers);
+    metrics_gauge(w, "otbr_ot_message_buffers_free",
+                  "Free OpenThread message buffers", s->buffers.mFreeBuffers);
+    metrics_gauge(w, "otbr_ot_message_buffers_max_used",
+                  "High-water mark of used OpenThread message buffers",
+                  s->buffers.mMaxUsedBuffers);
+
+    metrics_counter(w, "otbr_ra_rx_total", "Router Advertisements received on the backbone",
+                    s->br.mRaRx);
+    metrics_counter(w, "otbr_ra_tx_failures_total", "Router Advertisements that failed to send",
+                    s->br.mRaTxFailure);
+
+#if CONFIG_OPENTHREAD_NAT64
+    metrics_header(w, "otbr_nat64_packets_total", "counter", "Packets translated by NAT64");
+    metrics_sample(w, "otbr_nat64_packets_total", "dir=\"4to6\"", s->nat64.mTotal.m4To6Packets);
+    metrics_sample(w, "otbr_nat64_packets_total", "dir=\"6to4\"", s->nat64.mTotal.m6To4Packets);
+    metrics_header(w, "otbr_nat64_bytes_total", "counter", "Bytes translated by NAT64");
+    metrics_sample(w, "otbr_nat64_bytes_total", "dir=\"4to6\"", s->nat64.mTotal.m4To6Bytes);
+    metrics_sample(w, "otbr_nat64_bytes_total", "dir=\"6to4\"", s->nat64.mTotal.m6To4Bytes);
+#endif
+
+    metrics_gauge(w, "otbr_srp_hosts", "Registered SRP hosts", s->srp_hosts);
+    metrics_gauge(w, "otbr_srp_services", "Registered SRP services", s->srp_services);
+    metrics_header(w, "otbr_srp_responses_total", "counter", "SRP server responses by result");
+    metrics_sample(w, "otbr_srp_responses_total", "result=\"success\"", s->srp_responses.mSuccess);
+    metrics_sample(w, "otbr_srp_responses_total", "result=\"server_failure\"",
+                   s->srp_responses.mServerFailure);
+    metrics_sample(w, "otbr_srp_responses_total", "result=\"format_error\"",
+                   s->srp_responses.mFormatError);
+    metrics_sample(w, "otbr_srp_responses_total", "result=\"name_exists\"",
+                   s->srp_responses.mNameExists);
+    metrics_sample(w, "otbr_srp_responses_total", "result=\"refused\"", s->srp_responses.mRefused);
+    metrics_sample(w, "otbr_srp_responses_total", "result=\"other\"", s->srp_responses.mOther);
+
+    metrics_gauge(w, "otbr_thread_role",
+                  "Thread role (0 disabled, 1 detached, 2 child, 3 router, 4 leader)", s->role);
+}
+
+static void write_queues(metrics_writer_t *w)
+{
+    metrics_header(w, "otbr_ot_task_queue_posts_total", "counter",
+                   "Work items posted to the OpenThread task queue");
+    metrics_sample(w, "otbr_ot_task_queue_posts_total", "result=\"ok\"", s_task_queue_posts);
+    metrics_sample(w, "otbr_ot_task_queue_posts_total", "result=\"dropped\"", s_task_queue_drops);
+
+    netif_hooks_counters_t wifi, thread;
+    netif_hooks_get_backbone(&wifi);
+    netif_hooks_get_thread(&thread);
+    metrics_header(w, "otbr_netif_drops_total", "counter",
+                   "Frames lwIP refused on receive or the driver refused on transmit");
+    metrics_sample(w, "otbr_netif_drops_total", "netif=\"backbone\",dir=\"rx\"", wifi.rx_dropped);
+    metrics_sample(w, "otbr_netif_drops_total", "netif=\"backbone\",dir=\"tx\"", wifi.tx_dropped);
+    metrics_sample(w, "otbr_netif_drops_total", "netif=\"thread\",dir=\"rx\"", thread.rx_dropped);
+    metrics_sample(w, "otbr_netif_drops_total", "netif=\"thread\",dir=\"tx\"", thread.tx_dropped);
+
+#if CONFIG_LWIP_STATS
+    /* Off in sdkconfig.defaults: it counts on every packet in lwIP */
+    metrics_header(w, "otbr_lwip_drops_total", "counter", "Packets dropped inside lwIP by layer");
+    metrics_sample(w, "otbr_lwip_drops_total", "layer=\"link\"", lwip_stats.link.drop);
+    metrics_sample(w, "otbr_lwip_drops_total", "layer=\"ip4\"", lwip_stats.ip.drop);
+    metrics_sample(w, "otbr_lwip_drops_total", "layer=\"ip6\"", lwip_stats.ip6.drop);
+#endif
+}
+
+static void write_system(metrics_writer_t *w)
+{
+    metrics_gauge(w, "otbr_uptime_seconds", "Seconds since boot",
+                  (uint64_t)(esp_timer_get_time() / 1000000));
+    metrics_gauge(w, "otbr_heap_free_bytes", "Current free heap", esp_get_free_heap_size());
+    metrics_gauge(w, "otbr_heap_min_free_bytes", "Lowest free heap since boot",
+                  esp_get_minimum_free_heap_size());
+    metrics_gauge(w, "otbr_heap_largest_free_block_bytes", "Largest allocatable heap block",
+                  heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+
+    metrics_header(w, "otbr_task_stack_free_min_bytes", "gauge",
+                   "Per-task stack high-water mark (lowest free stack seen)");
+    for (size_t i = 0; i < sizeof(s_task_names) / sizeof(s_task_names[0]); i++) {
+        TaskHandle_t task = xTaskGetHandle(s_task_names[i]);
+        if (task == NULL) continue;
+        metrics_printf(w, "otbr_task_stack_free_min_bytes{task=\"%s\"} %u\n",
+                       s_task_names[i], (unsigned)uxTaskGetStackHighWaterMark(task));
+    }
+
+    metrics_header(w, "otbr_boot_phase_ms", "gauge", "Time since power-on when a boot phase was reached");
+    static const struct { boot_phase_t phase; const char *name; } phases[] = {
+        { BOOT_PHASE_THREAD_START,   "thread_start" },
+        { BOOT_PHASE_THREAD_ROUTER,  "thread_router" },
+        { BOOT_PHASE_WIFI_CONNECTED, "wifi_connected" },
+        { BOOT_PHASE_BR_READY,       "br_ready" },
+    };
+    for (size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); i++) {
+        int64_t us = boot_time_get_us(phases[i].phase);
+        if (us < 0) continue;
+        metrics_printf(w, "otbr_boot_phase_ms{phase=\"%s\"} %lld\n", phases[i].name, us / 1000);
+    }
+}
+
+static void write_backbone(metrics_writer_t *w)
+{
+    wifi_reconnect_stats_t rc;
+    wifi_reconnect_get_stats(&rc);
+
+    metrics_gauge(w, "otbr_backbone_connected", "Wi-Fi backbone connected (1/0)", rc.connected);
+    metrics_counter(w, "otbr_backbone_outages_total", "Wi-Fi disconnects from a connected state",
+                    rc.outages);
+    metrics_counter(w, "otbr_backbone_connect_attempts_total", "Wi-Fi connect attempts",
+                    rc.attempts);
+    metrics_header(w, "otbr_backbone_reconnects_total", "counter",
+                   "Successful Wi-Fi reconnects by path");
+    metrics_sample(w, "otbr_backbone_reconnects_total", "path=\"cached\"", rc.fast_path_ok);
+    metrics_sample(w, "otbr_backbone_reconnects_total", "path=\"scan\"", rc.full_scan_ok);
+    metrics_header(w, "otbr_backbone_reconnect_ms", "gauge", "Wi-Fi outage duration (disconnect to IP)");
+    metrics_sample(w, "otbr_backbone_reconnect_ms", "stat=\"last\"", rc.last_ms);
+    metrics_sample(w, "otbr_backbone_reconnect_ms", "stat=\"min\"", rc.min_ms);
+    metrics_sample(w, "otbr_backbone_reconnect_ms", "stat=\"max\"", rc.max_ms);
+    metrics_sample(w, "otbr_backbone_reconnect_ms", "stat=\"avg\"", rc.avg_ms);
+
+    wifi_power_stats_t ps;
+    wifi_power_get_stats(&ps);
+
+    metrics_gauge(w, "otbr_backbone_power_save", "Wi-Fi modem sleep currently on (1/0)",
+                  ps.ps_enabled);
+    metrics_counter(w, "otbr_backbone_power_save_switches_total",
+                    "Wi-Fi power-save on/off transitions", ps.ps_switches);
+    metrics_counter(w, "otbr_backbone_power_save_off_ms_total",
+                    "Time with Wi-Fi power save off", ps.ps_off_ms);
+    metrics_header(w, "otbr_backbone_rtt_ms", "gauge",
+                   "Gateway ping round-trip time by Wi-Fi power-save state");
+    metrics_sample(w, "otbr_backbone_rtt_ms", "ps=\"off\",stat=\"min\"", ps.rtt_ps_off.min_ms);
+    metrics_sample(w, "otbr_backbone_rtt_ms", "ps=\"off\",stat=\"avg\"", ps.rtt_ps_off.avg_ms);
+    metrics_sample(w, "otbr_backbone_rtt_ms", "ps=\"off\",stat=\"max\"", ps.rtt_ps_off.max_ms);
+    metrics_sample(w, "otbr_backbone_rtt_ms", "ps=\"on\",stat=\"min\"", ps.rtt_ps_on.min_ms);
+    metrics_sample(w, "otbr_backbone_rtt_ms", "ps=\"on\",stat=\"avg\"", ps.rtt_ps_on.avg_ms);
+    metrics_sample(w, "otbr_backbone_rtt_ms", "ps=\"on\",stat=\"max\"", ps.rtt_ps_on.max_ms);
+    metrics_header(w, "otbr_backbone_rtt_probes_total", "counter",
+                   "Gateway pings by Wi-Fi power-save state and result");
+    metrics_sample(w, "otbr_backbone_rtt_probes_total", "ps=\"off\",result=\"ok\"",
+                   ps.rtt_ps_off.count);
+    metrics_sample(w, "otbr_backbone_rtt_probes_total", "ps=\"off\",result=\"lost\"",
+                   ps.rtt_ps_off.lost);
+    metrics_sample(w, "otbr_backbone_rtt_probes_total", "ps=\"on\",result=\"ok\"",
+                   ps.rtt_ps_on.count);
+    metrics_sample(w, "otbr_backbone_rtt_probes_total", "ps=\"on\",result=\"lost\"",
+                   ps.rtt_ps_on.lost);
+}
+
+static void write_storage(metrics_writer_t *w)
+{
+    ot_settings_stats_t st;
+    ot_settings_get_stats(&st);
+
+    metrics_header(w, "otbr_settings_ops_total", "counter",
+                   "OpenThread settings operations by outcome");
+    metrics_sample(w, "otbr_settings_ops_total", "op=\"write\"", st.writes);
+    metrics_sample(w, "otbr_settings_ops_total", "op=\"delete\"", st.deletes);
+    metrics_sample(w, "otbr_settings_ops_total", "op=\"skipped\"", st.skipped);
+    metrics_sample(w, "otbr_settings_ops_total", "op=\"deferred\"", st.deferred);
+    metrics_sample(w, "otbr_settings_ops_total", "op=\"coalesced\"", st.coalesced);
+    metrics_sample(w, "otbr_settings_ops_total", "op=\"flushed\"", st.flushed);
+    metrics_counter(w, "otbr_settings_stall_us_total",
+                    "Time spent in settings flash writes/erases, which stalls the mainloop (us)",
+                    st.stall_us);
+    metrics_counter(w, "otbr_settings_flush_us_total",
+                    "Part of the stall time spent by the background flusher (us)", st.flush_us);
+    metrics_gauge(w, "otbr_settings_stall_max_us",
+                  "Longest single settings flash operation (us)", st.stall_max_us);
+}
+
+/* ------------------------------------------------------------------ */
+/*  HTTP endpoint                                                      */
+/* ------------------------------------------------------------------ */
+
+static esp_err_t metrics_get_handler(httpd_req_t *req)
+{
+    metrics_writer_t *w = malloc(sizeof(*w));
+    if (w == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "out of memory");
+        return ESP_FAIL;
+    }
+    w->req = req;
+    w->len = 0;
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+    /* From the mainloop's last snapshot: scrapes never take the lock */
+    ot_status_t *status = malloc(sizeof(*status));
+    bool ot_ok = status != NULL && ot_status_read(status);
+    if (ot_ok) {
+        write_forwarding(w, status);
+        metrics_gauge(w, "otbr_ot_status_age_ms", "Age of the OpenThread snapshot scraped (ms)",
+                      (uint64_t)((esp_timer_get_time() - status->published_us) / 1000));
+    }
+    metrics_gauge(w, "otbr_scrape_ot_ok",
+                  "1 if OpenThread counters were sampled in this scrape", ot_ok);
+    free(status);
+
+    write_queues(w);
+    write_backbone(w);
+    write_storage(w);
+    write_system(w);
+
+    taskENTER_CRITICAL(&s_sources_lock);
+    size_t num_sources = s_num_sources;
+    taskEXIT_CRITICAL(&s_sources_lock);
+    for (size_t i = 0; i < num_sources; i++) {
+        s_sources[i](w);
+    }
+
+    writer_flush(w);
+    httpd_resp_send_chunk(req, NULL, 0);
+    free(w);
+    return ESP_OK;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                         */
+/* ------------------------------------------------------------------ */
+
+void metrics_register_source(metrics_source_fn fn)
+{
+    taskENTER_CRITICAL(&s_sources_lock);
+    bool full = s_num_sources >= METRICS_MAX_SOURCES;
+    if (!full) s_sources[s_num_sources++] = fn;
+    taskEXIT_CRITICAL(&s_sources_lock);
+
+    if (full) ESP_LOGW(TAG, "Too many metrics sources");
+}
+
+void metrics_start(void)
+{
+#if METRICS_HTTP_PORT
+    if (s_server != NULL) return;
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = METRICS_HTTP_PORT;
+    config.max_open_sockets = 2;
+    config.lru_purge_enable = true;
+
+    esp_err_t err = httpd_start(&s_server, &config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start metrics server: %s", esp_err_to_name(err));
+        s_server = NULL;
+        return;
+    }
+
+    const httpd_uri_t uri = {
+        .uri = "/metrics",
+        .method = HTTP_GET,
+        .handler = metrics_get_handler,
+    };
+    httpd_register_uri_handler(s_server, &uri);
+
+    ESP_LOGI(TAG, "Metrics at http://%s.local:%d/metrics", DEVICE_NAME, METRICS_HTTP_PORT);
+#endif
+}
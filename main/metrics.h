@@ -0,0 +1,56 @@
+/*
+ * Data-plane metrics (Prometheus text exposition)
+ *
+ * Serves http://<device>:METRICS_HTTP_PORT/metrics with forwarding
+ * counters (Thread ↔ backbone packets/bytes), OpenThread IPv6 and
+ * queue drops, message-buffer pressure, NAT64 and SRP counters, flash
+ * stall time from settings writes, heap and per-task stack high-water
+ * marks.
+ *
+ * Other subsystems add their own series by registering a source; the
+ * source is called on every scrape with a writer to print into.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+
+typedef struct metrics_writer metrics_writer_t;
+
+typedef void (*metrics_source_fn)(metrics_writer_t *w);
+
+/**
+ * Start the HTTP scrape endpoint.  Called once the backbone is up;
+ * does nothing if METRICS_HTTP_PORT is 0.
+ */
+void metrics_start(void);
+
+/**
+ * Register an extra metrics source (up to METRICS_MAX_SOURCES).
+ * May be called before metrics_start().
+ */
+void metrics_register_source(metrics_source_fn fn);
+
+/** Packets dropped so far because the OpenThread task queue was full. */
+uint32_t metrics_task_queue_drops(void);
+
+/** printf-style raw output into the scrape response. */
+void metrics_printf(metrics_writer_t *w, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/** Emit the "# HELP" / "# TYPE" lines for a metric family. */
+void metrics_header(metrics_writer_t *w, const char *name,
+                    const char *type, const char *help);
+
+/** Emit one sample; labels is e.g. "dir=\"in\"" or NULL. */
+void metrics_sample(metrics_writer_t *w, const char *name,
+                    const char *labels, uint64_t value);
+
+/** Shorthand: header + single unlabelled sample. */
+void metrics_counter(metrics_writer_t *w, const char *name,
+                     const char *help, uint64_t value);
+void metrics_gauge(metrics_writer_t *w, const char *name,
+                   const char *help, uint64_t value);
+
+#endif /* METRICS_H */
@@ -0,0 +1,848 @@
+/*
+ * NAT64 engine — see nat64.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_openthread.h"
+#include "esp_openthread_task_queue.h"
+#include "esp_timer.h"
+
+#include "openthread/ip6.h"
+#include "openthread/message.h"
+#include "openthread/nat64.h"
+
+#include "config.h"
+#include "metrics.h"
+#include "nat64.h"
+#include "ot_status.h"
+
+static const char *TAG = "nat64";
+
+/* Backbone ports NAT64_PORT_BASE .. +NAT64_MAX_MAPPINGS-1 belong to the
+ * engine: below lwIP's ephemeral range (49152+), above its servers.   */
+#define NAT64_PORT_BASE         16384
+_Static_assert(NAT64_MAX_MAPPINGS > 0 && NAT64_MAX_MAPPINGS <= 16384,
+               "NAT64_MAX_MAPPINGS must be 1..16384");
+
+/* RFC 6146 transitory timeout, for TCP after FIN or RST */
+#define TCP_CLOSING_TIMEOUT_S   240
+
+/* Table full: UDP/ICMP mappings idle at least this long may be evicted
+ * (RFC 4787 wants 2 min, but losing new flows is worse).              */
+#define PRESSURE_IDLE_S         30
+
+#define SWEEP_MS                1000
+#define FULL_WARN_INTERVAL_S    60
+
+#define THREAD_MTU              1280
+#define IP6_HLEN                40
+#define IP4_HLEN                20
+#define ETH_HLEN                14
+
+#define PROTO_ICMP              1
+#define PROTO_TCP               6
+#define PROTO_UDP               17
+#define PROTO_ICMP6             58
+
+#define TCP_FIN                 0x01
+#define TCP_RST                 0x04
+
+#define NIL                     0xffff
+
+#define MAPPING_TCP_CLOSING     0x01
+#define MAPPING_STRESS          0x02
+
+#define STRESS_SRC_PORT         5000
+#define STRESS_SETTLE_MS        2000
+
+#define FNV_INIT                2166136261u
+
+typedef struct {
+    otIp6Address src;           /* Thread host */
+    uint16_t src_port;          /* its port, or ICMP echo identifier */
+    uint16_t next;              /* hash chain, or free list */
+    uint32_t last_used_s;
+    uint8_t proto;              /* 0 = free */
+    uint8_t flags;
+} mapping_t;
+
+/* Table (s_table_lock).  Backbone port = NAT64_PORT_BASE + index.      */
+static SemaphoreHandle_t s_table_lock;
+static mapping_t *s_mappings;
+static uint16_t *s_buckets;
+static uint32_t s_num_buckets;
+static uint16_t s_free = NIL;
+static uint16_t s_ip_id;
+static uint32_t s_full_warned_s;
+
+/* Addresses (s_lock) */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t s_prefix[12];            /* favored NAT64 /96 */
+static bool s_have_prefix;
+static uint8_t s_backbone_ip4[4];
+static nat64_stats_t s_stats;
+
+static otInstance *s_instance;
+static esp_netif_t *s_backbone;
+static esp_netif_t *s_thread_netif;
+static TaskHandle_t s_task;
+
+/* Housekeeping task's copy of the OpenThread snapshot                */
+static ot_status_t s_status;
+
+static struct {
+    bool active;
+    uint32_t flows;
+    volatile uint32_t replies;
+    uint8_t dst[4];
+    uint16_t port;
+} s_stress;
+
+/* Synthetic Thread sources for the stress test: fd00:0:0:6464::<flow> */
+static const uint8_t s_stress_prefix[12] = { 0xfd, 0, 0, 0, 0, 0, 0x64, 0x64, 0, 0, 0, 0 };
+
+/* ------------------------------------------------------------------ */
+/*  Helpers                                                            */
+/* ------------------------------------------------------------------ */
+
+static inline uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static inline void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static inline uint32_t now_s(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+/* One's-complement sum of big-endian 16-bit words */
+static uint32_t sum16(uint32_t sum, const uint8_t *p, size_t len)
+{
+    for (; len > 1; p += 2, len -= 2) sum += (uint32_t)(p[0] << 8 | p[1]);
+    if (len > 0) sum += (uint32_t)p[0] << 8;
+    return sum;
+}
+
+static uint16_t fold(uint32_t sum)
+{
+    while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t)sum;
+}
+
+/* RFC 1624 incremental update: words summing to `removed` were replaced
+ * by words summing to `added`; the payload is never re-read.          */
+static void csum_replace(uint8_t *field, uint32_t removed, uint32_t added)
+{
+    uint32_t sum = (uint16_t)~get16(field) + (uint16_t)~fold(removed) + fold(added);
+    put16(field, (uint16_t)~fold(sum));
+}
+
+static uint32_t pseudo6(const uint8_t *src, const uint8_t *dst, uint8_t proto, size_t len)
+{
+    return sum16(sum16(0, src, 16), dst, 16) + proto + (uint32_t)len;
+}
+
+static uint32_t pseudo4(const uint8_t *src, const uint8_t *dst)
+{
+    /* Protocol and length words are equal on both sides for TCP/UDP */
+    return sum16(sum16(0, src, 4), dst, 4);
+}
+
+static uint32_t proto_timeout_s(const mapping_t *m)
+{
+    switch (m->proto) {
+    case PROTO_TCP:
+        return (m->flags & MAPPING_TCP_CLOSING) ? TCP_CLOSING_TIMEOUT_S : NAT64_TCP_TIMEOUT_S;
+    case PROTO_UDP:
+        return NAT64_UDP_TIMEOUT_S;
+    default:
+        return NAT64_ICMP_TIMEOUT_S;
+    }
+}
+
+static uint32_t *proto_count(uint8_t proto)
+{
+    switch (proto) {
+    case PROTO_TCP: return &s_stats.mappings_tcp;
+    case PROTO_UDP: return &s_stats.mappings_udp;
+    default:        return &s_stats.mappings_icmp;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Mapping table (s_table_lock held)                                  */
+/* ------------------------------------------------------------------ */
+
+static uint32_t key_hash(uint8_t proto, const uint8_t *src, uint16_t port)
+{
+    uint32_t hash = FNV_INIT;
+    uint8_t key[3] = { proto, (uint8_t)(port >> 8), (uint8_t)port };
+
+    for (int i = 0; i < 16; i++) hash = (hash ^ src[i]) * 16777619u;
+    for (int i = 0; i < 3; i++) hash = (hash ^ key[i]) * 16777619u;
+    return hash & (s_num_buckets - 1);
+}
+
+static uint16_t mapping_find(uint8_t proto, const uint8_t *src, uint16_t port)
+{
+    for (uint16_t i = s_buckets[key_hash(proto, src, port)]; i != NIL; i = s_mappings[i].next) {
+        const mapping_t *m = &s_mappings[i];
+        if (m->proto == proto && m->src_port == port && memcmp(m->src.mFields.m8, src, 16) == 0) {
+            return i;
+        }
+    }
+    return NIL;
+}
+
+static void mapping_remove(uint16_t index)
+{
+    mapping_t *m = &s_mappings[index];
+    uint16_t *link = &s_buckets[key_hash(m->proto, m->src.mFields.m8, m->src_port)];
+
+    while (*link != index) link = &s_mappings[*link].next;
+    *link = m->next;
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.mappings--;
+    (*proto_count(m->proto))--;
+    taskEXIT_CRITICAL(&s_lock);
+
+    m->proto = 0;
+    m->next = s_free;
+    s_free = index;
+}
+
+static void sweep(uint32_t now)
+{
+    uint32_t expired = 0;
+
+    for (uint16_t i = 0; i < NAT64_MAX_MAPPINGS; i++) {
+        const mapping_t *m = &s_mappings[i];
+        if (m->proto == 0 || now - m->last_used_s < proto_timeout_s(m)) continue;
+        mapping_remove(i);
+        expired++;
+    }
+
+    if (expired == 0) return;
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.expired += expired;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/* Least recently used UDP/ICMP mapping idle past PRESSURE_IDLE_S */
+static bool evict_idle(uint32_t now)
+{
+    uint16_t victim = NIL;
+
+    for (uint16_t i = 0; i < NAT64_MAX_MAPPINGS; i++) {
+        const mapping_t *m = &s_mappings[i];
+        if (m->proto == 0 || m->proto == PROTO_TCP || now - m->last_used_s < PRESSURE_IDLE_S) {
+            continue;
+        }
+        if (victim == NIL || m->last_used_s < s_mappings[victim].last_used_s) victim = i;
+    }
+    if (victim == NIL) return false;
+
+    mapping_remove(victim);
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.evicted++;
+    taskEXIT_CRITICAL(&s_lock);
+    return true;
+}
+
+static uint16_t mapping_create(uint8_t proto, const uint8_t *src, uint16_t port, uint32_t now)
+{
+    if (s_free == NIL) sweep(now);
+    if (s_free == NIL && !evict_idle(now)) {
+        if (now - s_full_warned_s >= FULL_WARN_INTERVAL_S || s_full_warned_s == 0) {
+            ESP_LOGW(TAG, "Mapping table full (%d), new flows refused", NAT64_MAX_MAPPINGS);
+            s_full_warned_s = now;
+        }
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.exhausted++;
+        taskEXIT_CRITICAL(&s_lock);
+        return NIL;
+    }
+
+    uint16_t index = s_free;
+    mapping_t *m = &s_mappings[index];
+    s_free = m->next;
+
+    memcpy(m->src.mFields.m8, src, 16);
+    m->src_port = port;
+    m->proto = proto;
+    m->flags = memcmp(src, s_stress_prefix, sizeof(s_stress_prefix)) == 0 ? MAPPING_STRESS : 0;
+    m->last_used_s = now;
+
+    uint16_t *bucket = &s_buckets[key_hash(proto, src, port)];
+    m->next = *bucket;
+    *bucket = index;
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.mappings++;
+    (*proto_count(proto))++;
+    if (s_stats.mappings > s_stats.mappings_max) s_stats.mappings_max = s_stats.mappings;
+    taskEXIT_CRITICAL(&s_lock);
+    return index;
+}
+
+static void account_lookup(uint32_t cycles, bool hit)
+{
+    taskENTER_CRITICAL(&s_lock);
+    if (hit) {
+        s_stats.hits++;
+    } else {
+        s_stats.misses++;
+    }
+    s_stats.lookup_cycles_sum += cycles;
+    s_stats.lookup_count++;
+    if (cycles > s_stats.lookup_cycles_max) s_stats.lookup_cycles_max = cycles;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Thread → IPv4                                                      */
+/* ------------------------------------------------------------------ */
+
+static void count_unsupported(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.unsupported++;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+bool nat64_from_thread(esp_netif_t *netif, uint8_t *packet, size_t *len)
+{
+    if (s_mappings == NULL || netif != s_thread_netif) return false;
+    if (*len < IP6_HLEN || (packet[0] >> 4) != 6) return false;
+
+    uint8_t prefix[12], src4[4];
+    taskENTER_CRITICAL(&s_lock);
+    bool ready = s_have_prefix;
+    memcpy(prefix, s_prefix, sizeof(prefix));
+    memcpy(src4, s_backbone_ip4, sizeof(src4));
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (!ready || memcmp(packet + 24, prefix, sizeof(prefix)) != 0) return false;
+
+    /* For the NAT64 prefix from here on; anything not translated is
+     * left to lwIP, which has no route for it and says so.            */
+    size_t payload_len = get16(packet + 4);
+    uint8_t next_header = packet[6];
+    uint8_t *l4 = packet + IP6_HLEN;
+    uint16_t port;
+    uint8_t *csum;
+
+    if (payload_len + IP6_HLEN > *len || packet[7] <= 1 || src4[0] == 0) {
+        count_unsupported();
+        return false;
+    }
+
+    switch (next_header) {
+    case PROTO_UDP:
+        if (payload_len < 8) goto unsupported;
+        port = get16(l4);
+        csum = l4 + 6;
+        break;
+    case PROTO_TCP:
+        if (payload_len < 20) goto unsupported;
+        port = get16(l4);
+        csum = l4 + 16;
+        break;
+    case PROTO_ICMP6:
+        if (payload_len < 8 || l4[0] != 128) goto unsupported;    /* echo request */
+        port = get16(l4 + 4);
+        csum = l4 + 2;
+        break;
+    default:
+        goto unsupported;
+    }
+
+    const uint8_t *src6 = packet + 8;
+    uint32_t now = now_s();
+
+    xSemaphoreTake(s_table_lock, portMAX_DELAY);
+    uint32_t start = esp_cpu_get_cycle_count();
+    uint16_t index = mapping_find(next_header, src6, port);
+    bool hit = index != NIL;
+    if (!hit) index = mapping_create(next_header, src6, port, now);
+    if (index != NIL) {
+        mapping_t *m = &s_mappings[index];
+        m->last_used_s = now;
+        if (next_header == PROTO_TCP && (l4[13] & (TCP_FIN | TCP_RST))) {
+            m->flags |= MAPPING_TCP_CLOSING;
+        }
+    }
+    uint16_t id = s_ip_id++;
+    account_lookup(esp_cpu_get_cycle_count() - start, hit);
+    xSemaphoreGive(s_table_lock);
+
+    if (index == NIL) return false;
+
+    uint16_t ext_port = (uint16_t)(NAT64_PORT_BASE + index);
+    const uint8_t *dst4 = packet + 24 + 12;
+
+    if (next_header == PROTO_ICMP6) {
+        /* ICMPv4 has no pseudo-header; echo request 128 → 8 */
+        csum_replace(csum, pseudo6(src6, packet + 24, PROTO_ICMP6, payload_len) +
+                               (uint32_t)(l4[0] << 8 | l4[1]) + port,
+                     (uint32_t)(8 << 8 | l4[1]) + ext_port);
+        l4[0] = 8;
+        put16(l4 + 4, ext_port);
+    } else {
+        csum_replace(csum, sum16(sum16(0, src6, 16), packet + 24, 16) + port,
+                     pseudo4(src4, dst4) + ext_port);
+        if (next_header == PROTO_UDP && get16(csum) == 0) put16(csum, 0xffff);
+        put16(l4, ext_port);
+    }
+
+    /* IPv4 header over the tail of the IPv6 one, then slide down.  DF
+     * stays clear: Thread packets fit 1280, and nothing turns ICMPv4
+     * "fragmentation needed" back into IPv6 Packet Too Big.           */
+    uint8_t tos = (uint8_t)((packet[0] << 4) | (packet[1] >> 4));
+    uint8_t ttl = packet[7];
+    uint8_t ip4[IP4_HLEN] = { 0x45, tos };
+    put16(ip4 + 2, (uint16_t)(IP4_HLEN + payload_len));
+    put16(ip4 + 4, id);
+    ip4[8] = ttl;
+    ip4[9] = next_header == PROTO_ICMP6 ? PROTO_ICMP : next_header;
+    memcpy(ip4 + 12, src4, 4);
+    memcpy(ip4 + 16, dst4, 4);
+    put16(ip4 + 10, (uint16_t)~fold(sum16(0, ip4, IP4_HLEN)));
+
+    memcpy(packet + IP6_HLEN - IP4_HLEN, ip4, IP4_HLEN);
+    memmove(packet, packet + IP6_HLEN - IP4_HLEN, IP4_HLEN + payload_len);
+    *len = IP4_HLEN + payload_len;
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.packets_6to4++;
+    s_stats.bytes_6to4 += *len;
+    taskEXIT_CRITICAL(&s_lock);
+    return true;
+
+unsupported:
+    count_unsupported();
+    return false;
+}
+
+/* ------------------------------------------------------------------ */
+/*  IPv4 → Thread                                                      */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    size_t len;
+    uint8_t data[];
+} thread_packet_t;
+
+/* OpenThread task: the Wi-Fi RX task must not wait for the OT lock */
+static void send_to_thread(void *arg)
+{
+    thread_packet_t *pkt = arg;
+    otMessageSettings settings = {
+        .mLinkSecurityEnabled = true,
+        .mPriority = OT_MESSAGE_PRIORITY_NORMAL,
+    };
+    otMessage *message = otIp6NewMessage(s_instance, &settings);
+
+    if (message != NULL) {
+        if (otMessageAppend(message, pkt->data, (uint16_t)pkt->len) == OT_ERROR_NONE) {
+            otIp6Send(s_instance, message);     /* takes ownership */
+        } else {
+            otMessageFree(message);
+        }
+    }
+    free(pkt);
+}
+
+bool nat64_from_backbone(const uint8_t *frame, size_t len)
+{
+    if (s_mappings == NULL || len < ETH_HLEN + IP4_HLEN) return false;
+    if (get16(frame + 12) != 0x0800) return false;
+
+    const uint8_t *ip = frame + ETH_HLEN;
+    size_t ihl = (size_t)(ip[0] & 0x0f) * 4;
+    size_t total = get16(ip + 2);
+    uint8_t proto = ip[9];
+
+    if ((ip[0] >> 4) != 4 || ihl < IP4_HLEN || total < ihl + 8 || total > len - ETH_HLEN) {
+        return false;
+    }
+    if (get16(ip + 6) & 0x3fff) return false;      /* fragments: lwIP's problem */
+
+    uint8_t prefix[12];
+    taskENTER_CRITICAL(&s_lock);
+    bool ours = s_have_prefix && memcmp(ip + 16, s_backbone_ip4, 4) == 0;
+    memcpy(prefix, s_prefix, sizeof(prefix));
+    taskEXIT_CRITICAL(&s_lock);
+    if (!ours) return false;
+
+    const uint8_t *l4 = ip + ihl;
+    size_t l4_len = total - ihl;
+    uint16_t ext_port;
+
+    switch (proto) {
+    case PROTO_UDP:
+        ext_port = get16(l4 + 2);
+        break;
+    case PROTO_TCP:
+        if (l4_len < 20) return false;
+        ext_port = get16(l4 + 2);
+        break;
+    case PROTO_ICMP:
+        if (l4[0] != 0) return false;                /* echo reply only */
+        ext_port = get16(l4 + 4);
+        break;
+    default:
+        return false;
+    }
+    if (ext_port < NAT64_PORT_BASE || ext_port >= NAT64_PORT_BASE + NAT64_MAX_MAPPINGS) {
+        return false;
+    }
+
+    uint8_t proto6 = proto == PROTO_ICMP ? PROTO_ICMP6 : proto;
+    uint16_t index = (uint16_t)(ext_port - NAT64_PORT_BASE);
+    otIp6Address dst6;
+    uint16_t port;
+    uint8_t flags;
+
+    xSemaphoreTake(s_table_lock, portMAX_DELAY);
+    uint32_t start = esp_cpu_get_cycle_count();
+    mapping_t *m = &s_mappings[index];
+    bool found = m->proto == proto6;
+    if (found) {
+        m->last_used_s = now_s();
+        if (proto == PROTO_TCP && (l4[13] & (TCP_FIN | TCP_RST))) m->flags |= MAPPING_TCP_CLOSING;
+        dst6 = m->src;
+        port = m->src_port;
+        flags = m->flags;
+    }
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+    xSemaphoreGive(s_table_lock);
+
+    if (!found) return false;   /* lwIP answers with RST / port unreachable */
+    account_lookup(cycles, true);
+
+    if (flags & MAPPING_STRESS) {
+        s_stress.replies++;
+        return true;
+    }
+
+    if (IP6_HLEN + l4_len > THREAD_MTU || ip[8] <= 1) {
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.too_big++;
+        taskEXIT_CRITICAL(&s_lock);
+        return true;
+    }
+
+    thread_packet_t *pkt = malloc(sizeof(*pkt) + IP6_HLEN + l4_len);
+    if (pkt == NULL) return true;
+
+    uint8_t *ip6 = pkt->data;
+    uint8_t *out = ip6 + IP6_HLEN;
+    pkt->len = IP6_HLEN + l4_len;
+
+    ip6[0] = (uint8_t)(0x60 | ip[1] >> 4);
+    ip6[1] = (uint8_t)(ip[1] << 4);
+    ip6[2] = ip6[3] = 0;
+    put16(ip6 + 4, (uint16_t)l4_len);
+    ip6[6] = proto6;
+    ip6[7] = (uint8_t)(ip[8] - 1);
+    memcpy(ip6 + 8, prefix, sizeof(prefix));
+    memcpy(ip6 + 8 + 12, ip + 12, 4);
+    memcpy(ip6 + 24, dst6.mFields.m8, 16);
+    memcpy(out, l4, l4_len);
+
+    if (proto == PROTO_ICMP) {
+        /* echo reply 0 → 129, and ICMPv6 covers the pseudo-header */
+        csum_replace(out + 2, (uint32_t)(out[0] << 8 | out[1]) + ext_port,
+                     pseudo6(ip6 + 8, ip6 + 24, PROTO_ICMP6, l4_len) +
+                         (uint32_t)(129 << 8 | out[1]) + port);
+        out[0] = 129;
+        put16(out + 4, port);
+    } else {
+        uint8_t *csum = out + (proto == PROTO_UDP ? 6 : 16);
+        put16(out + 2, port);
+        if (proto == PROTO_UDP && get16(csum) == 0) {
+            /* Optional in IPv4, mandatory in IPv6 */
+            put16(csum, (uint16_t)~fold(sum16(pseudo6(ip6 + 8, ip6 + 24, PROTO_UDP, l4_len),
+                                              out, l4_len)));
+        } else {
+            csum_replace(csum, pseudo4(ip + 12, ip + 16) + ext_port,
+                         sum16(sum16(0, ip6 + 8, 16), ip6 + 24, 16) + port);
+        }
+        if (proto == PROTO_UDP && get16(csum) == 0) put16(csum, 0xffff);
+    }
+
+    if (esp_openthread_task_queue_post(send_to_thread, pkt) != ESP_OK) {
+        free(pkt);
+        return true;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.packets_4to6++;
+    s_stats.bytes_4to6 += pkt->len;
+    taskEXIT_CRITICAL(&s_lock);
+    return true;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Stress test                                                        */
+/* ------------------------------------------------------------------ */
+
+static void stress_task(void *arg)
+{
+    uint8_t prefix[12];
+    taskENTER_CRITICAL(&s_lock);
+    memcpy(prefix, s_prefix, sizeof(prefix));
+    taskEXIT_CRITICAL(&s_lock);
+
+    nat64_stats_t before;
+    nat64_get_stats(&before);
+    int64_t start_us = esp_timer_get_time();
+    uint32_t sent = 0;
+
+    for (uint32_t i = 0; i < s_stress.flows; i++) {
+        char payload[24];
+        size_t payload_len = (size_t)snprintf(payload, sizeof(payload), "otbr-nat64 %lu",
+                                              (unsigned long)i);
+        size_t udp_len = 8 + payload_len;
+        size_t len = IP6_HLEN + udp_len;
+
+        uint8_t *pkt = calloc(1, len);
+        if (pkt == NULL) break;
+
+        pkt[0] = 0x60;
+        put16(pkt + 4, (uint16_t)udp_len);
+        pkt[6] = PROTO_UDP;
+        pkt[7] = 64;
+        memcpy(pkt + 8, s_stress_prefix, sizeof(s_stress_prefix));
+        pkt[20] = (uint8_t)(i >> 24);
+        pkt[21] = (uint8_t)(i >> 16);
+        pkt[22] = (uint8_t)(i >> 8);
+        pkt[23] = (uint8_t)i;
+        memcpy(pkt + 24, prefix, sizeof(prefix));
+        memcpy(pkt + 36, s_stress.dst, 4);
+
+        uint8_t *udp = pkt + IP6_HLEN;
+        put16(udp, STRESS_SRC_PORT);
+        put16(udp + 2, s_stress.port);
+        put16(udp + 4, (uint16_t)udp_len);
+        memcpy(udp + 8, payload, payload_len);
+        put16(udp + 6, (uint16_t)~fold(sum16(pseudo6(pkt + 8, pkt + 24, PROTO_UDP, udp_len),
+                                             udp, udp_len)));
+
+        /* lwIP copies it into a pbuf, as for packets from OpenThread */
+        if (nat64_from_thread(s_thread_netif, pkt, &len)) {
+            esp_netif_receive(s_thread_netif, pkt, len, NULL);
+            sent++;
+        }
+        free(pkt);
+
+        /* Leave room in the tcpip mailbox for everyone else */
+        if ((i & 15) == 15) vTaskDelay(1);
+    }
+
+    int64_t send_ms = (esp_timer_get_time() - start_us) / 1000;
+    vTaskDelay(pdMS_TO_TICKS(STRESS_SETTLE_MS));
+
+    nat64_stats_t after;
+    nat64_get_stats(&after);
+    uint32_t lookups = after.lookup_count - before.lookup_count;
+
+    ESP_LOGI(TAG, "stress: %lu flows, %lu translated in %lld ms, %lu exhausted, %lu evicted, "
+             "%lu replies; %lu mappings (max %lu), lookup avg %lu cycles",
+             (unsigned long)s_stress.flows, (unsigned long)sent, send_ms,
+             (unsigned long)(after.exhausted - before.exhausted),
+             (unsigned long)(after.evicted - before.evicted),
+             (unsigned long)s_stress.replies, (unsigned long)after.mappings,
+             (unsigned long)after.mappings_max,
+             (unsigned long)(lookups ? (after.lookup_cycles_sum - before.lookup_cycles_sum) / lookups
+                                     : 0));
+
+    s_stress.active = false;
+    vTaskDelete(NULL);
+}
+
+esp_err_t nat64_stress(uint32_t ipv4, uint16_t port, uint32_t flows)
+{
+    if (s_mappings == NULL || s_stress.active) return ESP_ERR_INVALID_STATE;
+    if (flows > NAT64_STRESS_MAX) return ESP_ERR_INVALID_ARG;
+
+    if (flows == 0) {
+        xSemaphoreTake(s_table_lock, portMAX_DELAY);
+        for (uint16_t i = 0; i < NAT64_MAX_MAPPINGS; i++) {
+            if (s_mappings[i].proto != 0 && (s_mappings[i].flags & MAPPING_STRESS)) {
+                mapping_remove(i);
+            }
+        }
+        xSemaphoreGive(s_table_lock);
+        return ESP_OK;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    bool ready = s_have_prefix && s_backbone_ip4[0] != 0;
+    taskEXIT_CRITICAL(&s_lock);
+    if (!ready) return ESP_ERR_INVALID_STATE;
+
+    s_stress.flows = flows;
+    s_stress.replies = 0;
+    memcpy(s_stress.dst, &ipv4, 4);
+    s_stress.port = port;
+    s_stress.active = true;
+    if (xTaskCreate(stress_task, "nat64_stress", 3072, NULL, 3, NULL) != pdPASS) {
+        s_stress.active = false;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Housekeeping task                                                  */
+/* ------------------------------------------------------------------ */
+
+static void refresh_addresses(void)
+{
+    esp_netif_ip_info_t ip_info = { 0 };
+    esp_netif_get_ip_info(s_backbone, &ip_info);
+
+    bool have_prefix = ot_status_read(&s_status) && s_status.have_nat64_prefix &&
+                       s_status.nat64_prefix.mLength == 96;
+
+    taskENTER_CRITICAL(&s_lock);
+    memcpy(s_backbone_ip4, &ip_info.ip.addr, 4);
+    if (have_prefix) memcpy(s_prefix, s_status.nat64_prefix.mPrefix.mFields.m8, sizeof(s_prefix));
+    s_have_prefix = have_prefix;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static void nat64_task(void *arg)
+{
+    for (;;) {
+        refresh_addresses();
+
+        xSemaphoreTake(s_table_lock, portMAX_DELAY);
+        sweep(now_s());
+        xSemaphoreGive(s_table_lock);
+
+        vTaskDelay(pdMS_TO_TICKS(SWEEP_MS));
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Control / metrics                                                  */
+/* ------------------------------------------------------------------ */
+
+static void write_metrics(metrics_writer_t *w)
+{
+    nat64_stats_t st;
+    nat64_get_stats(&st);
+
+    metrics_header(w, "otbr_nat64_mappings", "gauge", "NAT64 engine mappings in use");
+    metrics_sample(w, "otbr_nat64_mappings", "proto=\"udp\"", st.mappings_udp);
+    metrics_sample(w, "otbr_nat64_mappings", "proto=\"tcp\"", st.mappings_tcp);
+    metrics_sample(w, "otbr_nat64_mappings", "proto=\"icmp\"", st.mappings_icmp);
+    metrics_gauge(w, "otbr_nat64_mappings_capacity", "NAT64_MAX_MAPPINGS", st.capacity);
+    metrics_gauge(w, "otbr_nat64_mappings_max", "Most mappings in use at once", st.mappings_max);
+
+    metrics_header(w, "otbr_nat64_lookups_total", "counter", "Mapping lookups by result");
+    metrics_sample(w, "otbr_nat64_lookups_total", "result=\"hit\"", st.hits);
+    metrics_sample(w, "otbr_nat64_lookups_total", "result=\"miss\"", st.misses);
+    metrics_header(w, "otbr_nat64_mappings_removed_total", "counter", "Mappings removed");
+    metrics_sample(w, "otbr_nat64_mappings_removed_total", "reason=\"expired\"", st.expired);
+    metrics_sample(w, "otbr_nat64_mappings_removed_total", "reason=\"evicted\"", st.evicted);
+    metrics_counter(w, "otbr_nat64_exhausted_total", "New flows refused, table full",
+                    st.exhausted);
+
+    metrics_header(w, "otbr_nat64_engine_packets_total", "counter",
+                   "Packets translated by the NAT64 engine");
+    metrics_sample(w, "otbr_nat64_engine_packets_total", "dir=\"6to4\"", st.packets_6to4);
+    metrics_sample(w, "otbr_nat64_engine_packets_total", "dir=\"4to6\"", st.packets_4to6);
+    metrics_header(w, "otbr_nat64_engine_bytes_total", "counter",
+                   "Bytes translated by the NAT64 engine");
+    metrics_sample(w, "otbr_nat64_engine_bytes_total", "dir=\"6to4\"", st.bytes_6to4);
+    metrics_sample(w, "otbr_nat64_engine_bytes_total", "dir=\"4to6\"", st.bytes_4to6);
+    metrics_header(w, "otbr_nat64_dropped_total", "counter", "Packets not translated");
+    metrics_sample(w, "otbr_nat64_dropped_total", "reason=\"unsupported\"", st.unsupported);
+    metrics_sample(w, "otbr_nat64_dropped_total", "reason=\"too_big\"", st.too_big);
+
+    metrics_header(w, "otbr_nat64_lookup_cycles", "summary",
+                   "CPU cycles per mapping lookup/insert");
+    metrics_sample(w, "otbr_nat64_lookup_cycles_sum", NULL, st.lookup_cycles_sum);
+    metrics_sample(w, "otbr_nat64_lookup_cycles_count", NULL, st.lookup_count);
+    metrics_gauge(w, "otbr_nat64_lookup_cycles_max", "Slowest mapping lookup",
+                  st.lookup_cycles_max);
+}
+
+void nat64_init(void)
+{
+    if (!NAT64_ENGINE || s_mappings != NULL) return;
+
+    s_num_buckets = 1;
+    while (s_num_buckets < NAT64_MAX_MAPPINGS) s_num_buckets <<= 1;
+
+    s_mappings = calloc(NAT64_MAX_MAPPINGS, sizeof(*s_mappings));
+    s_buckets = malloc(s_num_buckets * sizeof(*s_buckets));
+    if (s_mappings == NULL || s_buckets == NULL) {
+        ESP_LOGE(TAG, "No memory for %d mappings, using OpenThread's translator",
+                 NAT64_MAX_MAPPINGS);
+        free(s_mappings);
+        free(s_buckets);
+        s_mappings = NULL;
+        s_buckets = NULL;
+        return;
+    }
+
+    memset(s_buckets, 0xff, s_num_buckets * sizeof(*s_buckets));
+    for (uint16_t i = NAT64_MAX_MAPPINGS; i-- > 0;) {
+        s_mappings[i].next = s_free;
+        s_free = i;
+    }
+    s_stats.capacity = NAT64_MAX_MAPPINGS;
+
+    s_table_lock = xSemaphoreCreateMutex();
+    metrics_register_source(write_metrics);
+}
+
+void nat64_start(otInstance *instance, esp_netif_t *backbone)
+{
+    if (s_mappings == NULL || s_task != NULL) return;
+
+    s_instance = instance;
+    s_backbone = backbone;
+    s_thread_netif = esp_openthread_get_netif();
+
+    /* Without an IPv4 CIDR OpenThread's translator stays idle but the
+     * NAT64 prefix is still published, so traffic for it reaches us. */
+    otNat64ClearIp4Cidr(instance);
+    xTaskCreate(nat64_task, "nat64", 3072, NULL, 3, &s_task);
+    ESP_LOGI(TAG, "Engine on: %d mappings (%u bytes), ports %d-%d", NAT64_MAX_MAPPINGS,
+             (unsigned)(NAT64_MAX_MAPPINGS * sizeof(mapping_t) + s_num_buckets * sizeof(uint16_t)),
+             NAT64_PORT_BASE, NAT64_PORT_BASE + NAT64_MAX_MAPPINGS - 1);
+}
+
+bool nat64_engine_enabled(void)
+{
+    return s_task != NULL;
+}
+
+void nat64_get_stats(nat64_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
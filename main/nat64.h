@@ -0,0 +1,96 @@
+/*
+ * NAT64 engine
+ *
+ * With NAT64_ENGINE 0 Thread → IPv4 traffic goes through OpenThread's
+ * translator and lwIP's NAPT, whose mapping limits and timeouts are
+ * fixed at build time.  NAT64_ENGINE 1 translates in the esp_netif data
+ * path instead (stateful NAT64 onto the backbone's IPv4 address):
+ *   - mappings live in a hash table of NAT64_MAX_MAPPINGS entries;
+ *     each entry owns one backbone port, so replies find their mapping
+ *     by index
+ *   - idle mappings expire per protocol (NAT64_*_TIMEOUT_S); when the
+ *     table is full, long-idle UDP/ICMP mappings are evicted first
+ *   - a packet that finds no free mapping is counted as exhausted and
+ *     left to lwIP, which answers the Thread device with ICMPv6
+ *     unreachable instead of dropping it silently
+ *
+ * UDP, TCP and ICMP echo are translated; other traffic passes through.
+ * Occupancy, hits/misses, evictions, exhaustion and lookup cost are on
+ * /metrics and "otbr nat64".
+ */
+
+#ifndef NAT64_H
+#define NAT64_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_netif.h"
+#include "openthread/instance.h"
+
+#define NAT64_STRESS_MAX        16384
+
+typedef struct {
+    uint32_t capacity;
+    uint32_t mappings;          /* in use now                          */
+    uint32_t mappings_udp;
+    uint32_t mappings_tcp;
+    uint32_t mappings_icmp;
+    uint32_t mappings_max;      /* high-water mark                     */
+    uint32_t hits;              /* packets that found their mapping    */
+    uint32_t misses;            /* packets that created one            */
+    uint32_t expired;           /* idle past their protocol's timeout  */
+    uint32_t evicted;           /* reclaimed early, table full         */
+    uint32_t exhausted;         /* no mapping available                */
+    uint32_t unsupported;       /* to the NAT64 prefix, not translated */
+    uint32_t too_big;           /* IPv4 replies over the Thread MTU    */
+    uint32_t packets_6to4;
+    uint32_t packets_4to6;
+    uint64_t bytes_6to4;
+    uint64_t bytes_4to6;
+    uint64_t lookup_cycles_sum; /* table lookup/insert, lock held      */
+    uint32_t lookup_count;
+    uint32_t lookup_cycles_max;
+} nat64_stats_t;
+
+/** Allocate the mapping table and register metrics (NAT64_ENGINE 1). */
+void nat64_init(void);
+
+/**
+ * Take NAT64 over from OpenThread's translator.  Call with the
+ * OpenThread lock held, after the border router is initialized.
+ */
+void nat64_start(otInstance *instance, esp_netif_t *backbone);
+
+bool nat64_engine_enabled(void);
+
+void nat64_get_stats(nat64_stats_t *stats);
+
+/**
+ * Stress test: open flows UDP flows from synthetic Thread addresses to
+ * ipv4:port (network order) through the engine; replies are counted
+ * and dropped before they reach the mesh, and the outcome is logged.
+ * flows 0 removes the mappings of earlier runs.  Returns
+ * ESP_ERR_INVALID_STATE while a run is in progress, the engine is off,
+ * or no NAT64 prefix is known yet.
+ */
+esp_err_t nat64_stress(uint32_t ipv4, uint16_t port, uint32_t flows);
+
+/* ---- Data path (netif_hooks.c) ---- */
+
+/**
+ * IPv6 packet from the Thread interface: if it is for the NAT64
+ * prefix, translate it in place to IPv4 (*len shrinks) and return true.
+ */
+bool nat64_from_thread(esp_netif_t *netif, uint8_t *packet, size_t *len);
+
+/**
+ * Ethernet frame from the backbone: if it is a reply on a NAT64
+ * mapping, hand the IPv6 translation to OpenThread and return true
+ * (the frame is consumed).
+ */
+bool nat64_from_backbone(const uint8_t *frame, size_t len);
+
+#endif /* NAT64_H */
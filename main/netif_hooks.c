@@ -0,0 +1,138 @@
+/*
+ * Hooks on the esp_netif data path — see netif_hooks.h
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "mcast_fwd.h"
+#include "nat64.h"
+#include "netif_hooks.h"
+#include "pkt_capture.h"
+
+static esp_netif_t *s_backbone;
+static netif_hooks_counters_t s_counters[2];   /* backbone, other (s_lock) */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Unicast copies of a multicast frame; lwIP output is serialized (tcpip
+ * thread or core lock), so one buffer is enough                       */
+static uint8_t s_unicast_frame[MCAST_FRAME_MAX];
+
+esp_err_t __real_esp_netif_receive(esp_netif_t *esp_netif, void *buffer, size_t len, void *eb);
+esp_err_t __real_esp_netif_transmit(esp_netif_t *esp_netif, void *data, size_t len);
+esp_err_t __real_esp_netif_transmit_wrap(esp_netif_t *esp_netif, void *data, size_t len,
+                                         void *netstack_buf);
+
+static inline netif_hooks_counters_t *counters_for(esp_netif_t *esp_netif)
+{
+    return &s_counters[esp_netif == s_backbone ? 0 : 1];
+}
+
+static inline void count_tx(esp_netif_t *esp_netif, void *data, size_t len)
+{
+    pkt_capture_tap(esp_netif == s_backbone, true, data, len);
+    taskENTER_CRITICAL(&s_lock);
+    counters_for(esp_netif)->tx_packets++;
+    counters_for(esp_netif)->tx_bytes += len;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static inline esp_err_t count_result(esp_netif_t *esp_netif, bool tx, esp_err_t err)
+{
+    if (err == ESP_OK) return err;
+    taskENTER_CRITICAL(&s_lock);
+    if (tx) {
+        counters_for(esp_netif)->tx_dropped++;
+    } else {
+        counters_for(esp_netif)->rx_dropped++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return err;
+}
+
+/* Multicast policy (mcast_fwd.c); true if the frame was dealt with here */
+static bool apply_mcast(esp_netif_t *esp_netif, void *data, size_t len, esp_err_t *err)
+{
+    *err = ESP_OK;
+    if (esp_netif != s_backbone) return mcast_fwd_to_thread(data, len);
+
+    uint8_t macs[MCAST_LAN_LISTENERS][6];
+    size_t num_macs = 0;
+    switch (mcast_fwd_to_backbone(data, len, macs, &num_macs)) {
+    case MCAST_FWD_DROP:
+        return true;
+    case MCAST_FWD_UNICAST:
+        /* Same IPv6 packet, listener's MAC; the driver copies the frame */
+        memcpy(s_unicast_frame, data, len);
+        for (size_t i = 0; i < num_macs; i++) {
+            memcpy(s_unicast_frame, macs[i], 6);
+            count_tx(esp_netif, s_unicast_frame, len);
+            esp_err_t e = count_result(esp_netif, true,
+                                       __real_esp_netif_transmit(esp_netif, s_unicast_frame, len));
+            if (e != ESP_OK) *err = e;
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+esp_err_t __wrap_esp_netif_receive(esp_netif_t *esp_netif, void *buffer, size_t len, void *eb)
+{
+    pkt_capture_tap(esp_netif == s_backbone, false, buffer, len);
+    taskENTER_CRITICAL(&s_lock);
+    counters_for(esp_netif)->rx_packets++;
+    counters_for(esp_netif)->rx_bytes += len;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (esp_netif == s_backbone) {
+        mcast_fwd_snoop(buffer, len);
+
+        if (nat64_from_backbone(buffer, len)) {
+            esp_netif_free_rx_buffer(esp_netif, eb);
+            return ESP_OK;
+        }
+    } else {
+        nat64_from_thread(esp_netif, buffer, &len);
+    }
+    return count_result(esp_netif, false, __real_esp_netif_receive(esp_netif, buffer, len, eb));
+}
+
+esp_err_t __wrap_esp_netif_transmit(esp_netif_t *esp_netif, void *data, size_t len)
+{
+    esp_err_t err;
+    if (apply_mcast(esp_netif, data, len, &err)) return err;
+    count_tx(esp_netif, data, len);
+    return count_result(esp_netif, true, __real_esp_netif_transmit(esp_netif, data, len));
+}
+
+esp_err_t __wrap_esp_netif_transmit_wrap(esp_netif_t *esp_netif, void *data, size_t len,
+                                         void *netstack_buf)
+{
+    esp_err_t err;
+    if (apply_mcast(esp_netif, data, len, &err)) return err;
+    count_tx(esp_netif, data, len);
+    return count_result(esp_netif, true,
+                        __real_esp_netif_transmit_wrap(esp_netif, data, len, netstack_buf));
+}
+
+void netif_hooks_set_backbone(esp_netif_t *wifi_netif)
+{
+    s_backbone = wifi_netif;
+}
+
+void netif_hooks_get_backbone(netif_hooks_counters_t *counters)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *counters = s_counters[0];
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void netif_hooks_get_thread(netif_hooks_counters_t *counters)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *counters = s_counters[1];
+    taskEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,42 @@
+/*
+ * Hooks on the esp_netif data path
+ *
+ * esp_netif_receive() (driver → lwIP) and esp_netif_transmit*() (lwIP →
+ * driver) are wrapped at link time so every frame on the backbone Wi-Fi
+ * interface can be counted without touching the Wi-Fi driver or lwIP.
+ * The NAT64 engine (nat64.c) translates in the same place, packet
+ * capture (pkt_capture.c) taps both interfaces there, and the multicast
+ * policy (mcast_fwd.c) filters or converts multicast crossing them.
+ *
+ * Drops are counted from the wrapped calls' results: a transmit the
+ * driver refuses (Wi-Fi TX queue full), and a receive lwIP refuses
+ * (tcpip mailbox full, no pbuf).  esp_netif_receive() only reports the
+ * latter with CONFIG_ESP_NETIF_RECEIVE_REPORT_ERRORS (sdkconfig.defaults).
+ */
+
+#ifndef NETIF_HOOKS_H
+#define NETIF_HOOKS_H
+
+#include <stdint.h>
+
+#include "esp_netif.h"
+
+typedef struct {
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    uint32_t rx_packets;
+    uint32_t tx_packets;
+    uint32_t rx_dropped;        /* refused by lwIP                    */
+    uint32_t tx_dropped;        /* refused by the driver              */
+} netif_hooks_counters_t;
+
+/** Tell the hooks which interface is the Wi-Fi backbone. */
+void netif_hooks_set_backbone(esp_netif_t *wifi_netif);
+
+/** Frames/bytes seen on the backbone interface since boot. */
+void netif_hooks_get_backbone(netif_hooks_counters_t *counters);
+
+/** The same for every other interface, i.e. the OpenThread netif. */
+void netif_hooks_get_thread(netif_hooks_counters_t *counters);
+
+#endif /* NETIF_HOOKS_H */
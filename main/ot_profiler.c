@@ -0,0 +1,350 @@
+/*
+ * OpenThread mainloop profiler — see ot_profiler.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_openthread_types.h"
+#include "esp_timer.h"
+
+#include "openthread/instance.h"
+#include "openthread/tasklet.h"
+#include "openthread/platform/alarm-micro.h"
+#include "openthread/platform/alarm-milli.h"
+#include "openthread/platform/radio.h"
+
+#include "config.h"
+#include "ot_profiler.h"
+
+static const char *TAG = "ot_profiler";
+
+/* Nesting of timed sections within one iteration (process → timer →
+ * tasklets → ...); deeper sections are charged to their parent.      */
+#define PART_STACK_DEPTH        6
+
+/* Tasks with their own CPU share row; the rest is "other"            */
+static const char *const s_cpu_tasks[] = {
+    "ot_main", "sys_evt", "mdns", "wifi", "tiT", "IDLE",
+};
+#define CPU_TASKS               (sizeof(s_cpu_tasks) / sizeof(s_cpu_tasks[0]))
+
+/* Everything below is touched only by the mainloop (and ot_profiler_init
+ * before it runs), so no locking.                                     */
+static bool s_running;
+static int64_t s_window_start_us;
+static int64_t s_window_end_us;
+static ot_profiler_report_t s_report;
+
+/* Current iteration */
+static bool s_iter_open;
+static uint32_t s_iter_part_us[OT_PROFILER_PART_COUNT];
+static uint8_t s_part_stack[PART_STACK_DEPTH];
+static uint32_t s_part_depth;
+static int64_t s_part_mark_us;
+
+/* Pending alarms and transmission */
+static uint32_t s_milli_deadline;
+static bool s_milli_armed;
+static uint32_t s_micro_deadline;
+static bool s_micro_armed;
+static int64_t s_tx_start_us;
+
+/* Run time per s_cpu_tasks row (+ other) and in total at window start */
+static uint64_t s_cpu_base[CPU_TASKS + 1];
+static uint64_t s_cpu_base_total;
+
+/* ------------------------------------------------------------------ */
+/*  Histograms and iteration accounting                                */
+/* ------------------------------------------------------------------ */
+
+static void hist_add(ot_profiler_hist_id_t id, uint32_t us)
+{
+    ot_profiler_hist_t *h = &s_report.hist[id];
+    uint32_t bucket = 0;
+
+    while (bucket < OT_PROFILER_BUCKETS - 1 && us >= (16u << bucket)) bucket++;
+    h->buckets[bucket]++;
+    h->count++;
+    h->sum_us += us;
+    if (us > h->max_us) h->max_us = us;
+}
+
+/* Charge the time since the last mark to the innermost open section */
+static void part_charge(int64_t now)
+{
+    if (s_part_depth > 0 && s_part_depth <= PART_STACK_DEPTH) {
+        s_iter_part_us[s_part_stack[s_part_depth - 1]] += (uint32_t)(now - s_part_mark_us);
+    }
+    s_part_mark_us = now;
+}
+
+static void part_enter(ot_profiler_part_t part)
+{
+    part_charge(esp_timer_get_time());
+    if (s_part_depth < PART_STACK_DEPTH) s_part_stack[s_part_depth] = (uint8_t)part;
+    s_part_depth++;
+    s_iter_open = true;
+}
+
+static void part_exit(void)
+{
+    part_charge(esp_timer_get_time());
+    if (s_part_depth > 0) s_part_depth--;
+}
+
+static void end_iteration(void)
+{
+    if (!s_iter_open) return;
+
+    uint32_t busy = 0;
+    for (int i = 0; i < OT_PROFILER_PART_COUNT; i++) busy += s_iter_part_us[i];
+
+    if (busy > s_report.hist[OT_PROFILER_ITERATION].max_us) {
+        memcpy(s_report.slowest_part_us, s_iter_part_us, sizeof(s_report.slowest_part_us));
+    }
+    hist_add(OT_PROFILER_ITERATION, busy);
+    for (int i = 0; i < OT_PROFILER_PART_COUNT; i++) s_report.part_us[i] += s_iter_part_us[i];
+
+    memset(s_iter_part_us, 0, sizeof(s_iter_part_us));
+    s_iter_open = false;
+}
+
+/* Also reached from tasks holding the OpenThread lock, but then the
+ * mainloop is in select() with no section open and this returns.     */
+void ot_profiler_note_flash(uint32_t us)
+{
+    if (!s_running || s_part_depth == 0 || s_part_depth > PART_STACK_DEPTH) return;
+
+    /* The flash op ran inside the current section: move its time over */
+    part_charge(esp_timer_get_time());
+    uint32_t *parent = &s_iter_part_us[s_part_stack[s_part_depth - 1]];
+    if (us > *parent) us = *parent;
+    *parent -= us;
+    s_iter_part_us[OT_PROFILER_PART_FLASH] += us;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Mainloop hooks                                                     */
+/*                                                                     */
+/*  Wrapped at link time (see main/CMakeLists.txt).  Each hook decides */
+/*  on entry whether it is profiling, so a start or stop from the CLI  */
+/*  in the middle of an iteration keeps the section stack balanced.    */
+/* ------------------------------------------------------------------ */
+
+/* esp_openthread_platform.h is private to the openthread component */
+esp_err_t __real_esp_openthread_platform_process(otInstance *instance,
+                                                 const esp_openthread_mainloop_context_t *mainloop);
+void __real_otTaskletsProcess(otInstance *aInstance);
+void __real_otPlatAlarmMilliStartAt(otInstance *aInstance, uint32_t aT0, uint32_t aDt);
+void __real_otPlatAlarmMilliFired(otInstance *aInstance);
+void __real_otPlatAlarmMicroStartAt(otInstance *aInstance, uint32_t aT0, uint32_t aDt);
+void __real_otPlatAlarmMicroFired(otInstance *aInstance);
+void __real_otPlatRadioReceiveDone(otInstance *aInstance, otRadioFrame *aFrame, otError aError);
+void __real_otPlatRadioTxStarted(otInstance *aInstance, otRadioFrame *aFrame);
+void __real_otPlatRadioTxDone(otInstance *aInstance, otRadioFrame *aFrame,
+                              otRadioFrame *aAckFrame, otError aError);
+
+/* One call per select() wakeup: starts the next iteration */
+esp_err_t __wrap_esp_openthread_platform_process(otInstance *instance,
+                                                 const esp_openthread_mainloop_context_t *mainloop)
+{
+    bool profiled = s_running;
+    if (!profiled) return __real_esp_openthread_platform_process(instance, mainloop);
+
+    if (s_part_depth == 0) end_iteration();
+    part_enter(OT_PROFILER_PART_OTHER);
+    esp_err_t err = __real_esp_openthread_platform_process(instance, mainloop);
+    part_exit();
+    return err;
+}
+
+void __wrap_otTaskletsProcess(otInstance *aInstance)
+{
+    bool profiled = s_running;
+    if (!profiled) {
+        __real_otTaskletsProcess(aInstance);
+        return;
+    }
+
+    int64_t start = esp_timer_get_time();
+    part_enter(OT_PROFILER_PART_TASKLETS);
+    __real_otTaskletsProcess(aInstance);
+    part_exit();
+    hist_add(OT_PROFILER_TASKLETS, (uint32_t)(esp_timer_get_time() - start));
+}
+
+void __wrap_otPlatAlarmMilliStartAt(otInstance *aInstance, uint32_t aT0, uint32_t aDt)
+{
+    s_milli_deadline = aT0 + aDt;
+    s_milli_armed = true;
+    __real_otPlatAlarmMilliStartAt(aInstance, aT0, aDt);
+}
+
+void __wrap_otPlatAlarmMilliFired(otInstance *aInstance)
+{
+    bool profiled = s_running;
+    if (profiled && s_milli_armed) {
+        int32_t late_ms = (int32_t)(otPlatAlarmMilliGetNow() - s_milli_deadline);
+        hist_add(OT_PROFILER_TIMER_LATE, late_ms > 0 ? (uint32_t)late_ms * 1000 : 0);
+    }
+    s_milli_armed = false;
+
+    if (profiled) part_enter(OT_PROFILER_PART_TIMERS);
+    __real_otPlatAlarmMilliFired(aInstance);
+    if (profiled) part_exit();
+}
+
+void __wrap_otPlatAlarmMicroStartAt(otInstance *aInstance, uint32_t aT0, uint32_t aDt)
+{
+    s_micro_deadline = aT0 + aDt;
+    s_micro_armed = true;
+    __real_otPlatAlarmMicroStartAt(aInstance, aT0, aDt);
+}
+
+void __wrap_otPlatAlarmMicroFired(otInstance *aInstance)
+{
+    bool profiled = s_running;
+    if (profiled && s_micro_armed) {
+        int32_t late_us = (int32_t)(otPlatAlarmMicroGetNow() - s_micro_deadline);
+        hist_add(OT_PROFILER_TIMER_LATE, late_us > 0 ? (uint32_t)late_us : 0);
+    }
+    s_micro_armed = false;
+
+    if (profiled) part_enter(OT_PROFILER_PART_TIMERS);
+    __real_otPlatAlarmMicroFired(aInstance);
+    if (profiled) part_exit();
+}
+
+void __wrap_otPlatRadioReceiveDone(otInstance *aInstance, otRadioFrame *aFrame, otError aError)
+{
+    bool profiled = s_running;
+    if (!profiled) {
+        __real_otPlatRadioReceiveDone(aInstance, aFrame, aError);
+        return;
+    }
+
+    /* The receive timestamp is taken by the driver in the radio ISR */
+    if (aError == OT_ERROR_NONE && aFrame != NULL) {
+        uint64_t now = otPlatRadioGetNow(aInstance);
+        uint64_t rx = aFrame->mInfo.mRxInfo.mTimestamp;
+        hist_add(OT_PROFILER_RADIO_RX, now > rx ? (uint32_t)(now - rx) : 0);
+    }
+    part_enter(OT_PROFILER_PART_RADIO);
+    __real_otPlatRadioReceiveDone(aInstance, aFrame, aError);
+    part_exit();
+}
+
+void __wrap_otPlatRadioTxStarted(otInstance *aInstance, otRadioFrame *aFrame)
+{
+    s_tx_start_us = esp_timer_get_time();
+    __real_otPlatRadioTxStarted(aInstance, aFrame);
+}
+
+void __wrap_otPlatRadioTxDone(otInstance *aInstance, otRadioFrame *aFrame,
+                              otRadioFrame *aAckFrame, otError aError)
+{
+    bool profiled = s_running;
+    if (profiled && s_tx_start_us != 0) {
+        hist_add(OT_PROFILER_RADIO_TX, (uint32_t)(esp_timer_get_time() - s_tx_start_us));
+    }
+    s_tx_start_us = 0;
+
+    if (profiled) part_enter(OT_PROFILER_PART_RADIO);
+    __real_otPlatRadioTxDone(aInstance, aFrame, aAckFrame, aError);
+    if (profiled) part_exit();
+}
+
+/* ------------------------------------------------------------------ */
+/*  CPU share                                                          */
+/* ------------------------------------------------------------------ */
+
+/* Run time per s_cpu_tasks row (+ other); false without run time stats */
+static bool sample_cpu(uint64_t rows[CPU_TASKS + 1], uint64_t *total)
+{
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    UBaseType_t max = uxTaskGetNumberOfTasks() + 2;
+    TaskStatus_t *tasks = malloc(max * sizeof(*tasks));
+    if (tasks == NULL) return false;
+
+    configRUN_TIME_COUNTER_TYPE run_total = 0;
+    UBaseType_t n = uxTaskGetSystemState(tasks, max, &run_total);
+
+    memset(rows, 0, (CPU_TASKS + 1) * sizeof(rows[0]));
+    for (UBaseType_t i = 0; i < n; i++) {
+        size_t row = 0;
+        while (row < CPU_TASKS && strcmp(tasks[i].pcTaskName, s_cpu_tasks[row]) != 0) row++;
+        rows[row] += tasks[i].ulRunTimeCounter;
+    }
+    *total = run_total;
+    free(tasks);
+    return true;
+#else
+    return false;
+#endif
+}
+
+static void report_cpu(ot_profiler_report_t *report)
+{
+    uint64_t rows[CPU_TASKS + 1];
+    uint64_t total;
+
+    report->num_cpu = 0;
+    if (!sample_cpu(rows, &total) || total <= s_cpu_base_total) return;
+
+    uint64_t window = total - s_cpu_base_total;
+    for (size_t i = 0; i <= CPU_TASKS && i < OT_PROFILER_CPU_ROWS; i++) {
+        ot_profiler_cpu_t *row = &report->cpu[report->num_cpu++];
+        strlcpy(row->task, i < CPU_TASKS ? s_cpu_tasks[i] : "other", sizeof(row->task));
+        uint64_t used = rows[i] > s_cpu_base[i] ? rows[i] - s_cpu_base[i] : 0;
+        row->permille = (uint32_t)(used * 1000 / window);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Control                                                            */
+/* ------------------------------------------------------------------ */
+
+void ot_profiler_start(void)
+{
+    memset(&s_report, 0, sizeof(s_report));
+    memset(s_iter_part_us, 0, sizeof(s_iter_part_us));
+    s_iter_open = false;
+    s_part_mark_us = esp_timer_get_time();
+
+    if (!sample_cpu(s_cpu_base, &s_cpu_base_total)) s_cpu_base_total = 0;
+    s_window_start_us = esp_timer_get_time();
+    s_running = true;
+    ESP_LOGI(TAG, "Profiling the OpenThread mainloop");
+}
+
+void ot_profiler_stop(void)
+{
+    if (!s_running) return;
+    end_iteration();
+    s_running = false;
+    s_window_end_us = esp_timer_get_time();
+    report_cpu(&s_report);
+}
+
+void ot_profiler_get_report(ot_profiler_report_t *report)
+{
+    if (s_running) {
+        s_report.window_ms = (uint32_t)((esp_timer_get_time() - s_window_start_us) / 1000);
+        report_cpu(&s_report);
+    } else if (s_window_start_us != 0) {
+        s_report.window_ms = (uint32_t)((s_window_end_us - s_window_start_us) / 1000);
+    }
+    s_report.running = s_running;
+    *report = s_report;
+}
+
+void ot_profiler_init(void)
+{
+    if (OT_PROFILER_AT_BOOT) ot_profiler_start();
+}
@@ -0,0 +1,93 @@
+/*
+ * OpenThread mainloop profiler
+ *
+ * esp_openthread_launch_mainloop() doesn't show where the Thread task's
+ * time goes, so a latency spike could be flash, coexistence, lwIP or
+ * OpenThread itself.  While started ("otbr profile start", or from boot
+ * with OT_PROFILER_AT_BOOT) the profiler records on the mainloop:
+ *   - each iteration: platform processing after a select() wakeup and
+ *     the tasklets that follow, split into radio callbacks, OpenThread
+ *     timers, tasklets, flash (settings writes) and other (the task
+ *     queue with packets from lwIP, the CLI, netif)
+ *   - each otTaskletsProcess() run
+ *   - timer lateness: how long after its deadline an OpenThread alarm
+ *     fired (millisecond alarms at 1 ms resolution)
+ *   - radio: frame receive timestamp to otPlatRadioReceiveDone(), and
+ *     transmit start to otPlatRadioTxDone(), which includes CCA,
+ *     retries and waiting for the coexistence arbiter
+ * as log2 histograms, plus the CPU share of ot_main, the event task,
+ * mDNS, Wi-Fi, lwIP and idle over the window from FreeRTOS run time
+ * statistics (only in builds with sdkconfig.profiler).
+ *
+ * The hooks are link-time wraps (see main/CMakeLists.txt) that cost a
+ * flag test while stopped.  Results are dumped on demand from the CLI
+ * ("otbr profile"); this is a latency tool, not a metrics source.
+ */
+
+#ifndef OT_PROFILER_H
+#define OT_PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Bucket i counts samples below (16 << i) us; the last one the rest   */
+#define OT_PROFILER_BUCKETS     14
+#define OT_PROFILER_CPU_ROWS    8
+
+typedef enum {
+    OT_PROFILER_ITERATION = 0,  /* mainloop work per wakeup           */
+    OT_PROFILER_TASKLETS,       /* one otTaskletsProcess() run        */
+    OT_PROFILER_TIMER_LATE,     /* alarm deadline → fired             */
+    OT_PROFILER_RADIO_RX,       /* frame received → handed to OT      */
+    OT_PROFILER_RADIO_TX,       /* transmit started → done            */
+    OT_PROFILER_HIST_COUNT,
+} ot_profiler_hist_id_t;
+
+typedef enum {
+    OT_PROFILER_PART_RADIO = 0,
+    OT_PROFILER_PART_TIMERS,
+    OT_PROFILER_PART_TASKLETS,
+    OT_PROFILER_PART_FLASH,
+    OT_PROFILER_PART_OTHER,
+    OT_PROFILER_PART_COUNT,
+} ot_profiler_part_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t buckets[OT_PROFILER_BUCKETS];
+} ot_profiler_hist_t;
+
+typedef struct {
+    char task[16];              /* "other" for the rest               */
+    uint32_t permille;          /* of CPU time in the window          */
+} ot_profiler_cpu_t;
+
+typedef struct {
+    bool running;
+    uint32_t window_ms;         /* since start (or until stop)        */
+    ot_profiler_hist_t hist[OT_PROFILER_HIST_COUNT];
+    uint64_t part_us[OT_PROFILER_PART_COUNT];           /* all iterations */
+    uint32_t slowest_part_us[OT_PROFILER_PART_COUNT];   /* slowest one    */
+    uint32_t num_cpu;           /* 0 without FreeRTOS run time stats  */
+    ot_profiler_cpu_t cpu[OT_PROFILER_CPU_ROWS];
+} ot_profiler_report_t;
+
+/** Start profiling if OT_PROFILER_AT_BOOT.  Call before the mainloop runs. */
+void ot_profiler_init(void);
+
+/**
+ * Clear the results and start a new window, or stop and keep them.
+ * Call on the mainloop (the CLI runs there).
+ */
+void ot_profiler_start(void);
+void ot_profiler_stop(void);
+
+/** Results so far.  Call on the mainloop. */
+void ot_profiler_get_report(ot_profiler_report_t *report);
+
+/** Mainloop time spent in a flash operation, from ot_settings. */
+void ot_profiler_note_flash(uint32_t us);
+
+#endif /* OT_PROFILER_H */
@@ -0,0 +1,478 @@
+/*
+ * OpenThread settings storage — see ot_settings.h
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#include "openthread/error.h"
+#include "openthread/instance.h"
+#include "openthread/platform/settings.h"
+
+#include "config.h"
+#include "ot_profiler.h"
+#include "ot_settings.h"
+
+static const char *TAG = "ot_settings";
+
+/* Namespace the ESP-IDF OpenThread port stores its settings under */
+#define OT_NVS_NAMESPACE        "openthread"
+
+/* Keys whose last written value is remembered for dedupe, and the
+ * largest value remembered.  Datasets are larger but rarely rewritten. */
+#define STORED_SLOTS            12
+#define VALUE_MAX_LEN           64
+
+#define PENDING_SLOTS           4
+
+/* Mainloop flash operations slower than this are logged              */
+#define SLOW_OP_LOG_US          20000
+
+typedef struct {
+    bool used;
+    uint16_t key;
+    uint16_t len;
+    uint8_t data[VALUE_MAX_LEN];
+} value_slot_t;
+
+typedef struct {
+    value_slot_t value;
+    uint32_t generation;        /* bumped on every update while pending */
+} pending_slot_t;
+
+/* Keys that may be held in RAM for OT_SETTINGS_COALESCE_MS.  Losing the
+ * latest value in a crash only costs a slower reattach or a new SRP
+ * lease; keys carrying security state (datasets, network info with the
+ * frame counters, keys) are always written through.                   */
+static const uint16_t s_deferrable_keys[] = {
+    OT_SETTINGS_KEY_PARENT_INFO,
+    OT_SETTINGS_KEY_DAD_INFO,
+    OT_SETTINGS_KEY_SRP_CLIENT_INFO,
+    OT_SETTINGS_KEY_SRP_SERVER_INFO,
+};
+
+static value_slot_t s_stored[STORED_SLOTS];
+static pending_slot_t s_pending[PENDING_SLOTS];
+static SemaphoreHandle_t s_lock;        /* all of the below, s_stored, s_pending */
+static ot_settings_stats_t s_stats;
+/* Key the flusher is writing; deleted (or wiped) meanwhile, it is
+ * deleted again once the write is done, instead of the mainloop
+ * waiting for the flusher.                                            */
+static bool s_flushing;
+static uint16_t s_flushing_key;
+static bool s_flushing_deleted;
+static TaskHandle_t s_flush_task;
+static otInstance *s_instance;
+
+otError __real_otPlatSettingsGet(otInstance *aInstance, uint16_t aKey, int aIndex,
+                                 uint8_t *aValue, uint16_t *aValueLength);
+otError __real_otPlatSettingsSet(otInstance *aInstance, uint16_t aKey,
+                                 const uint8_t *aValue, uint16_t aValueLength);
+otError __real_otPlatSettingsAdd(otInstance *aInstance, uint16_t aKey,
+                                 const uint8_t *aValue, uint16_t aValueLength);
+otError __real_otPlatSettingsDelete(otInstance *aInstance, uint16_t aKey, int aIndex);
+void __real_otPlatSettingsWipe(otInstance *aInstance);
+
+/* ------------------------------------------------------------------ */
+/*  Slot tables (call with s_lock held)                                */
+/* ------------------------------------------------------------------ */
+
+static bool is_deferrable(uint16_t key)
+{
+    for (size_t i = 0; i < sizeof(s_deferrable_keys) / sizeof(s_deferrable_keys[0]); i++) {
+        if (s_deferrable_keys[i] == key) return true;
+    }
+    return false;
+}
+
+static value_slot_t *stored_find(uint16_t key)
+{
+    for (int i = 0; i < STORED_SLOTS; i++) {
+        if (s_stored[i].used && s_stored[i].key == key) return &s_stored[i];
+    }
+    return NULL;
+}
+
+static void stored_forget(uint16_t key)
+{
+    value_slot_t *slot = stored_find(key);
+    if (slot) slot->used = false;
+}
+
+static void stored_remember(uint16_t key, const uint8_t *value, uint16_t len)
+{
+    value_slot_t *slot = stored_find(key);
+    if (len > VALUE_MAX_LEN) {
+        if (slot) slot->used = false;
+        return;
+    }
+    for (int i = 0; slot == NULL && i < STORED_SLOTS; i++) {
+        if (!s_stored[i].used) slot = &s_stored[i];
+    }
+    if (slot == NULL) return;   /* table full: that key just isn't deduped */
+
+    slot->used = true;
+    slot->key = key;
+    slot->len = len;
+    memcpy(slot->data, value, len);
+}
+
+static bool stored_matches(uint16_t key, const uint8_t *value, uint16_t len)
+{
+    const value_slot_t *slot = stored_find(key);
+    return slot && slot->len == len && memcmp(slot->data, value, len) == 0;
+}
+
+static pending_slot_t *pending_find(uint16_t key)
+{
+    for (int i = 0; i < PENDING_SLOTS; i++) {
+        if (s_pending[i].value.used && s_pending[i].value.key == key) return &s_pending[i];
+    }
+    return NULL;
+}
+
+static pending_slot_t *pending_alloc(void)
+{
+    for (int i = 0; i < PENDING_SLOTS; i++) {
+        if (!s_pending[i].value.used) return &s_pending[i];
+    }
+    return NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Timed flash operations                                             */
+/* ------------------------------------------------------------------ */
+
+/* The C6 has one core and the flash cache is off while NVS writes or
+ * erases, so every flash operation stalls the mainloop, whichever task
+ * issues it: the flusher's writes are counted as stall time too.      */
+static void account_stall(uint16_t key, int64_t start_us, bool is_delete, bool flusher)
+{
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start_us);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (flusher) {
+        s_stats.flush_us += elapsed;
+    } else if (is_delete) {
+        s_stats.deletes++;
+    } else {
+        s_stats.writes++;
+    }
+    s_stats.stall_us += elapsed;
+    if (elapsed > s_stats.stall_max_us) {
+        s_stats.stall_max_us = elapsed;
+        s_stats.stall_max_key = key;
+    }
+    xSemaphoreGive(s_lock);
+    if (!flusher) ot_profiler_note_flash(elapsed);
+
+    if (elapsed >= SLOW_OP_LOG_US) {
+        ESP_LOGW(TAG, "Flash %s of key 0x%04x%s took %lu ms", is_delete ? "erase" : "write",
+                 key, flusher ? " (deferred)" : "", (unsigned long)(elapsed / 1000));
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Background flusher                                                 */
+/* ------------------------------------------------------------------ */
+
+static void flush_task(void *arg)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(OT_SETTINGS_COALESCE_MS));
+
+        for (int i = 0; i < PENDING_SLOTS; i++) {
+            value_slot_t copy;
+            uint32_t generation;
+
+            xSemaphoreTake(s_lock, portMAX_DELAY);
+            copy = s_pending[i].value;
+            generation = s_pending[i].generation;
+            s_flushing = copy.used;
+            s_flushing_key = copy.key;
+            s_flushing_deleted = false;
+            xSemaphoreGive(s_lock);
+
+            if (!copy.used) continue;
+
+            int64_t start = esp_timer_get_time();
+            otError err = __real_otPlatSettingsSet(s_instance, copy.key, copy.data, copy.len);
+            account_stall(copy.key, start, false, true);
+
+            xSemaphoreTake(s_lock, portMAX_DELAY);
+            bool deleted = s_flushing_deleted;
+            s_flushing = false;
+            if (deleted) {
+                /* Handled below; the slot was already cleared */
+            } else if (err == OT_ERROR_NONE) {
+                stored_remember(copy.key, copy.data, copy.len);
+                s_stats.flushed++;
+            } else {
+                stored_forget(copy.key);
+                ESP_LOGW(TAG, "Deferred write of key 0x%04x failed: %d", copy.key, err);
+            }
+            /* Updated again while we were writing: leave it for next round */
+            if (s_pending[i].value.used && s_pending[i].generation == generation) {
+                s_pending[i].value.used = false;
+            }
+            bool again = s_pending[i].value.used;
+            xSemaphoreGive(s_lock);
+
+            /* Deleted or wiped while we were writing: don't resurrect it */
+            if (deleted) {
+                start = esp_timer_get_time();
+                __real_otPlatSettingsDelete(s_instance, copy.key, -1);
+                account_stall(copy.key, start, true, true);
+            }
+
+            if (again) xTaskNotifyGive(s_flush_task);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  otPlatSettings wrappers (linker --wrap, OpenThread mainloop)       */
+/* ------------------------------------------------------------------ */
+
+otError __wrap_otPlatSettingsGet(otInstance *aInstance, uint16_t aKey, int aIndex,
+                                 uint8_t *aValue, uint16_t *aValueLength)
+{
+    if (aIndex == 0 && s_lock != NULL) {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        pending_slot_t *p = pending_find(aKey);
+        if (p) {
+            if (aValue && aValueLength) {
+                memcpy(aValue, p->value.data, MIN(*aValueLength, p->value.len));
+            }
+            if (aValueLength) *aValueLength = p->value.len;
+            xSemaphoreGive(s_lock);
+            return OT_ERROR_NONE;
+        }
+        xSemaphoreGive(s_lock);
+    }
+    return __real_otPlatSettingsGet(aInstance, aKey, aIndex, aValue, aValueLength);
+}
+
+otError __wrap_otPlatSettingsSet(otInstance *aInstance, uint16_t aKey,
+                                 const uint8_t *aValue, uint16_t aValueLength)
+{
+    if (s_lock == NULL) return __real_otPlatSettingsSet(aInstance, aKey, aValue, aValueLength);
+
+    s_instance = aInstance;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    pending_slot_t *p = pending_find(aKey);
+    if (p) {
+        /* Newer value for a key that hasn't reached flash yet */
+        if (stored_matches(aKey, aValue, aValueLength)) {
+            p->value.used = false;      /* back to what flash holds */
+        } else {
+            p->value.len = aValueLength;
+            memcpy(p->value.data, aValue, aValueLength);
+            p->generation++;
+        }
+        s_stats.coalesced++;
+        xSemaphoreGive(s_lock);
+        return OT_ERROR_NONE;
+    }
+    if (stored_matches(aKey, aValue, aValueLength)) {
+        s_stats.skipped++;
+        xSemaphoreGive(s_lock);
+        return OT_ERROR_NONE;
+    }
+    if (is_deferrable(aKey) && aValueLength <= VALUE_MAX_LEN && (p = pending_alloc()) != NULL) {
+        p->value.used = true;
+        p->value.key = aKey;
+        p->value.len = aValueLength;
+        memcpy(p->value.data, aValue, aValueLength);
+        p->generation++;
+        s_stats.deferred++;
+        xSemaphoreGive(s_lock);
+        xTaskNotifyGive(s_flush_task);
+        return OT_ERROR_NONE;
+    }
+    xSemaphoreGive(s_lock);
+
+    int64_t start = esp_timer_get_time();
+    otError err = __real_otPlatSettingsSet(aInstance, aKey, aValue, aValueLength);
+    account_stall(aKey, start, false, false);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (err == OT_ERROR_NONE) {
+        stored_remember(aKey, aValue, aValueLength);
+    } else {
+        stored_forget(aKey);
+    }
+    xSemaphoreGive(s_lock);
+    return err;
+}
+
+otError __wrap_otPlatSettingsAdd(otInstance *aInstance, uint16_t aKey,
+                                 const uint8_t *aValue, uint16_t aValueLength)
+{
+    if (s_lock == NULL) return __real_otPlatSettingsAdd(aInstance, aKey, aValue, aValueLength);
+
+    /* Multi-value key (e.g. child info): no longer a single known value */
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    stored_forget(aKey);
+    xSemaphoreGive(s_lock);
+
+    int64_t start = esp_timer_get_time();
+    otError err = __real_otPlatSettingsAdd(aInstance, aKey, aValue, aValueLength);
+    account_stall(aKey, start, false, false);
+    return err;
+}
+
+otError __wrap_otPlatSettingsDelete(otInstance *aInstance, uint16_t aKey, int aIndex)
+{
+    if (s_lock == NULL) return __real_otPlatSettingsDelete(aInstance, aKey, aIndex);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    pending_slot_t *p = pending_find(aKey);
+    bool was_pending = p != NULL;
+    if (p) p->value.used = false;
+    stored_forget(aKey);
+    /* An in-flight flush of the key deletes it again when done */
+    if (s_flushing && s_flushing_key == aKey && aIndex <= 0) s_flushing_deleted = true;
+    xSemaphoreGive(s_lock);
+
+    int64_t start = esp_timer_get_time();
+    otError err = __real_otPlatSettingsDelete(aInstance, aKey, aIndex);
+    account_stall(aKey, start, true, false);
+
+    /* A key that only ever existed in RAM was still deleted */
+    if (err == OT_ERROR_NOT_FOUND && was_pending && aIndex <= 0) err = OT_ERROR_NONE;
+    return err;
+}
+
+void __wrap_otPlatSettingsWipe(otInstance *aInstance)
+{
+    if (s_lock == NULL) {
+        __real_otPlatSettingsWipe(aInstance);
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    /* Slots keep their generation, so a flush in progress can't take
+     * a write made after the wipe for the value it copied.            */
+    for (int i = 0; i < PENDING_SLOTS; i++) s_pending[i].value.used = false;
+    memset(s_stored, 0, sizeof(s_stored));
+    if (s_flushing) s_flushing_deleted = true;
+    xSemaphoreGive(s_lock);
+
+    int64_t start = esp_timer_get_time();
+    __real_otPlatSettingsWipe(aInstance);
+    account_stall(0, start, true, false);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Partition setup and migration                                      */
+/* ------------------------------------------------------------------ */
+
+/* Copy the "openthread" namespace out of the default partition (where
+ * firmware before the partition move kept it), then erase the source. */
+static void migrate_from_default_nvs(void)
+{
+    nvs_iterator_t it = NULL;
+    if (nvs_entry_find(NVS_DEFAULT_PART_NAME, OT_NVS_NAMESPACE, NVS_TYPE_BLOB, &it) != ESP_OK) {
+        return;     /* nothing to move */
+    }
+
+    nvs_handle_t src, dst;
+    if (nvs_open_from_partition(NVS_DEFAULT_PART_NAME, OT_NVS_NAMESPACE,
+                                NVS_READWRITE, &src) != ESP_OK) {
+        nvs_release_iterator(it);
+        return;
+    }
+    if (nvs_open_from_partition(OT_SETTINGS_PARTITION, OT_NVS_NAMESPACE,
+                                NVS_READWRITE, &dst) != ESP_OK) {
+        nvs_release_iterator(it);
+        nvs_close(src);
+        return;
+    }
+
+    int moved = 0;
+    bool ok = true;
+    esp_err_t err = ESP_OK;
+    while (err == ESP_OK) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+
+        size_t len = 0;
+        if (nvs_get_blob(dst, info.key, NULL, &len) == ESP_OK) {
+            /* Already present in the new partition — that copy wins */
+        } else if (nvs_get_blob(src, info.key, NULL, &len) == ESP_OK) {
+            void *buf = malloc(len ? len : 1);
+            if (buf == NULL ||
+                nvs_get_blob(src, info.key, buf, &len) != ESP_OK ||
+                nvs_set_blob(dst, info.key, buf, len) != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to move setting %s", info.key);
+                ok = false;
+            } else {
+                moved++;
+            }
+            free(buf);
+        }
+        err = nvs_entry_next(&it);
+    }
+    nvs_release_iterator(it);
+
+    if (ok && nvs_commit(dst) == ESP_OK) {
+        nvs_erase_all(src);
+        nvs_commit(src);
+        ESP_LOGI(TAG, "Moved %d OpenThread setting(s) from \"%s\" to \"%s\"",
+                 moved, NVS_DEFAULT_PART_NAME, OT_SETTINGS_PARTITION);
+    } else {
+        ESP_LOGE(TAG, "Settings migration incomplete; will retry next boot");
+    }
+    nvs_close(dst);
+    nvs_close(src);
+}
+
+esp_err_t ot_settings_init(void)
+{
+    esp_err_t ret = nvs_flash_init_partition(OT_SETTINGS_PARTITION);
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES ||
+        ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        /* Only the Thread settings are lost; Wi-Fi keeps its credentials */
+        ESP_LOGW(TAG, "Erasing \"%s\" partition (%s)", OT_SETTINGS_PARTITION, esp_err_to_name(ret));
+        ESP_ERROR_CHECK(nvs_flash_erase_partition(OT_SETTINGS_PARTITION));
+        ret = nvs_flash_init_partition(OT_SETTINGS_PARTITION);
+    }
+    if (ret != ESP_OK) return ret;
+
+    migrate_from_default_nvs();
+
+    s_lock = xSemaphoreCreateMutex();
+    if (s_lock == NULL ||
+        xTaskCreate(flush_task, "ot_settings", 3072, NULL, 2, &s_flush_task) != pdPASS) {
+        /* Wrappers stay pass-through while s_lock is NULL */
+        if (s_lock) vSemaphoreDelete(s_lock);
+        s_lock = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void ot_settings_get_stats(ot_settings_stats_t *stats)
+{
+    if (s_lock == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_lock);
+}
@@ -0,0 +1,60 @@
+/*
+ * OpenThread settings storage
+ *
+ * OpenThread keeps its settings (datasets, network info with the MAC/MLE
+ * frame counters, parent/child info, SRP state) in the dedicated
+ * OT_SETTINGS_PARTITION instead of the small shared "nvs" partition, so
+ * Thread churn no longer competes with Wi-Fi credentials for space and
+ * a full "nvs" can no longer wipe the Thread network.
+ *
+ * The OpenThread settings platform calls are wrapped (linker --wrap) to:
+ *   - skip writes whose value is identical to what is already stored,
+ *   - hold writes of low-value, high-churn keys in RAM for
+ *     OT_SETTINGS_COALESCE_MS and flush them from a background task,
+ *     so a burst of updates becomes one write per key,
+ *   - time every flash write and erase.
+ *
+ * Coalescing reduces how many flash writes there are, not what each
+ * costs: the C6 has a single core and runs nothing from flash while it
+ * is written, so the flusher's writes stall the mainloop just like the
+ * mainloop's own and count towards the same stall time.
+ *
+ * Frame-counter writes are rate-limited at the source instead (see
+ * OPENTHREAD_CONFIG_STORE_FRAME_COUNTER_AHEAD in the top-level
+ * CMakeLists.txt); they are never delayed.
+ */
+
+#ifndef OT_SETTINGS_H
+#define OT_SETTINGS_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define OT_SETTINGS_PARTITION   "ot_storage"
+
+typedef struct {
+    uint32_t writes;            /* flash writes done on the mainloop     */
+    uint32_t deletes;           /* flash deletes/wipes on the mainloop   */
+    uint32_t skipped;           /* identical rewrites that were dropped  */
+    uint32_t deferred;          /* writes held back for coalescing       */
+    uint32_t coalesced;         /* deferred writes superseded in RAM     */
+    uint32_t flushed;           /* deferred writes flushed in background */
+    uint64_t stall_us;          /* total time in flash ops, all tasks    */
+    uint64_t flush_us;          /* the flusher's share of stall_us       */
+    uint32_t stall_max_us;      /* longest single flash op               */
+    uint16_t stall_max_key;     /* settings key of that op               */
+} ot_settings_stats_t;
+
+/**
+ * Initialise OT_SETTINGS_PARTITION (erasing only that partition if it is
+ * full or from an older NVS version) and move any OpenThread settings
+ * left in the default "nvs" partition by older firmware across.
+ * Call after nvs_flash_init() and before esp_openthread_init().
+ */
+esp_err_t ot_settings_init(void);
+
+/** Copy out the write/stall counters. */
+void ot_settings_get_stats(ot_settings_stats_t *stats);
+
+#endif /* OT_SETTINGS_H */
@@ -0,0 +1,216 @@
+/*
+ * Thread startup: dataset selection and mesh bring-up — see ot_startup.h
+ */
+
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "openthread/dataset.h"
+#include "openthread/dataset_ftd.h"
+#include "openthread/instance.h"
+#include "openthread/ip6.h"
+#include "openthread/thread.h"
+
+#include "config.h"
+#include "boot_time.h"
+#include "channel_plan.h"
+#include "fast_reattach.h"
+#include "ot_startup.h"
+
+static const char *TAG = "thread";
+
+/* ------------------------------------------------------------------ */
+/*  Hex string → byte array helper                                     */
+/* ------------------------------------------------------------------ */
+
+static int hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int hex_to_bytes(const char *hex, uint8_t *out, size_t max_len)
+{
+    size_t hex_len = strlen(hex);
+    if (hex_len == 0 || hex_len % 2 != 0) return -1;
+
+    size_t byte_len = hex_len / 2;
+    if (byte_len > max_len) return -1;
+
+    for (size_t i = 0; i < byte_len; i++) {
+        int hi = hex_nibble(hex[i * 2]);
+        int lo = hex_nibble(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0) return -1;
+        out[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return (int)byte_len;
+}
+
+/* ------------------------------------------------------------------ */
+/*  OpenThread dataset helpers                                         */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Load a Thread active dataset from the hex TLV string in config.h.
+ * Returns true if the dataset was successfully applied.
+ */
+static bool load_dataset_from_tlvs(otInstance *instance)
+{
+    const char *hex = THREAD_DATASET_TLVS;
+    if (strlen(hex) == 0) return false;
+
+    otOperationalDatasetTlvs tlvs;
+    int len = hex_to_bytes(hex, tlvs.mTlvs, sizeof(tlvs.mTlvs));
+    if (len < 0) {
+        ESP_LOGE(TAG, "THREAD_DATASET_TLVS: invalid hex string");
+        return false;
+    }
+    tlvs.mLength = (uint8_t)len;
+
+    otError error = otDatasetSetActiveTlvs(instance, &tlvs);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to set active dataset from TLVs: %d", error);
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Thread dataset loaded from config (%d bytes)", len);
+    return true;
+}
+
+/**
+ * Create a brand new Thread network (only used when no existing
+ * dataset is available and auto-create is enabled).
+ */
+static void create_default_dataset(otInstance *instance, uint8_t channel)
+{
+    otOperationalDataset dataset;
+
+    ESP_LOGI(TAG, "Creating new Thread network");
+
+    memset(&dataset, 0, sizeof(dataset));
+
+    otError error = otDatasetCreateNewNetwork(instance, &dataset);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to create new network dataset: %d", error);
+        return;
+    }
+
+    /* Override channel and network name with our config */
+    dataset.mChannel = channel;
+    dataset.mComponents.mIsChannelPresent = true;
+
+    size_t name_len = strlen(THREAD_NETWORK_NAME);
+    if (name_len > OT_NETWORK_NAME_MAX_SIZE) {
+        name_len = OT_NETWORK_NAME_MAX_SIZE;
+    }
+    memcpy(dataset.mNetworkName.m8, THREAD_NETWORK_NAME, name_len);
+    dataset.mNetworkName.m8[name_len] = '\0';
+    dataset.mComponents.mIsNetworkNamePresent = true;
+
+    error = otDatasetSetActive(instance, &dataset);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to set active dataset: %d", error);
+    } else {
+        ESP_LOGI(TAG, "New network created: ch=%d, name=%s",
+                 channel, THREAD_NETWORK_NAME);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  OpenThread state-change callback                                   */
+/* ------------------------------------------------------------------ */
+
+void ot_startup_state_changed(otChangedFlags flags, void *context)
+{
+    otInstance *instance = (otInstance *)context;
+
+    if (flags & OT_CHANGED_THREAD_ROLE) {
+        otDeviceRole role = otThreadGetDeviceRole(instance);
+        const char *role_str;
+
+        switch (role) {
+        case OT_DEVICE_ROLE_DISABLED: role_str = "disabled"; break;
+        case OT_DEVICE_ROLE_DETACHED: role_str = "detached"; break;
+        case OT_DEVICE_ROLE_CHILD:    role_str = "child";    break;
+        case OT_DEVICE_ROLE_ROUTER:   role_str = "router";   break;
+        case OT_DEVICE_ROLE_LEADER:   role_str = "leader";   break;
+        default:                      role_str = "unknown";  break;
+        }
+
+        ESP_LOGI(TAG, "Thread role changed: %s", role_str);
+
+        if (role >= OT_DEVICE_ROLE_CHILD) {
+            boot_time_mark(BOOT_PHASE_THREAD_ATTACHED);
+        }
+        if (role >= OT_DEVICE_ROLE_ROUTER) {
+            boot_time_mark(BOOT_PHASE_THREAD_ROUTER);
+        }
+    }
+
+    if (flags & OT_CHANGED_THREAD_NETDATA) {
+        ESP_LOGI(TAG, "Thread network data updated");
+    }
+
+    fast_reattach_handle_state_change(instance, flags);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Thread start                                                       */
+/* ------------------------------------------------------------------ */
+
+static void thread_up(otInstance *instance)
+{
+    fast_reattach_init(instance);
+    otIp6SetEnabled(instance, true);
+    otThreadSetEnabled(instance, true);
+    boot_time_mark(BOOT_PHASE_THREAD_START);
+    ESP_LOGI(TAG, "Thread interface up — joining network...");
+}
+
+/* Energy scan finished (OpenThread mainloop): create the network on
+ * the planned channel and start Thread.                               */
+static void on_channel_planned(otInstance *instance, uint8_t channel, void *context)
+{
+    create_default_dataset(instance, channel);
+    thread_up(instance);
+}
+
+void ot_startup_start_thread(otInstance *instance, bool auto_create)
+{
+    bool dataset_ready = false;
+    otOperationalDataset dataset;
+
+    /* Priority 1: Saved dataset in NVS (from a previous boot or CLI) */
+    if (otDatasetGetActive(instance, &dataset) == OT_ERROR_NONE) {
+        ESP_LOGI(TAG, "Using saved Thread dataset from NVS");
+        dataset_ready = true;
+    }
+    /* Priority 2: Pre-provisioned TLV hex from config.h */
+    else if (load_dataset_from_tlvs(instance)) {
+        dataset_ready = true;
+    }
+    /* Priority 3: Create a brand new Thread network, on a planned
+     * channel unless THREAD_CHANNEL pins one (Thread starts once the
+     * AP channel is known and the energy scan completes). */
+    else if (auto_create) {
+        if (THREAD_CHANNEL == 0) {
+            channel_plan_scan_after_ap(instance, on_channel_planned, NULL);
+            return;
+        }
+        create_default_dataset(instance, THREAD_CHANNEL);
+        dataset_ready = true;
+    }
+
+    if (dataset_ready) {
+        thread_up(instance);
+    } else {
+        ESP_LOGI(TAG, "No Thread dataset configured");
+        ESP_LOGI(TAG, "Provision via Home Assistant or serial CLI:");
+        ESP_LOGI(TAG, "  > dataset set active <hex-TLV>");
+        ESP_LOGI(TAG, "  > ifconfig up");
+        ESP_LOGI(TAG, "  > thread start");
+    }
+}
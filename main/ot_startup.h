@@ -0,0 +1,34 @@
+/*
+ * Thread startup: dataset selection and mesh bring-up
+ *
+ * Platform-independent part of the boot sequence (OpenThread API only),
+ * shared by the firmware and the Linux host build in host/:
+ *
+ *   1. saved active dataset (from a previous boot or the CLI)
+ *   2. THREAD_DATASET_TLVS from config.h
+ *   3. a new network, when auto_create is set — on a planned channel
+ *      unless THREAD_CHANNEL pins one
+ */
+
+#ifndef OT_STARTUP_H
+#define OT_STARTUP_H
+
+#include <stdbool.h>
+
+#include "openthread/instance.h"
+
+/**
+ * Load the Thread dataset and bring the mesh interface up.  Does not
+ * depend on the backbone, so the 802.15.4 attach starts right away.
+ * Call with the OpenThread lock held, after the mainloop is running.
+ */
+void ot_startup_start_thread(otInstance *instance, bool auto_create);
+
+/**
+ * State-change callback: role logging, boot phase marks and the fast
+ * reattach cache.  Register with otSetStateChangedCallback(), passing
+ * the instance as the context.
+ */
+void ot_startup_state_changed(otChangedFlags flags, void *context);
+
+#endif /* OT_STARTUP_H */
@@ -0,0 +1,396 @@
+/*
+ * Lock-free OpenThread status snapshots — see ot_status.h
+ */
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_openthread.h"
+#include "esp_openthread_lock.h"
+#include "esp_openthread_task_queue.h"
+#include "esp_timer.h"
+
+#include "openthread/netdata.h"
+
+#include "metrics.h"
+#include "ot_status.h"
+
+static const char *TAG = "ot_status";
+
+/* State changes worth a fresh snapshot, table walks included, straight
+ * away; anything else shows up in the next periodic one.             */
+static const otChangedFlags PUBLISH_FLAGS =
+    OT_CHANGED_THREAD_ROLE | OT_CHANGED_THREAD_PARTITION_ID | OT_CHANGED_THREAD_NETDATA |
+    OT_CHANGED_THREAD_CHILD_ADDED | OT_CHANGED_THREAD_CHILD_REMOVED |
+    OT_CHANGED_THREAD_RLOC_ADDED | OT_CHANGED_THREAD_CHANNEL;
+
+/* Snapshots: written only by the mainloop, into the slot readers are
+ * not pointed at.  A slot's sequence number is odd while it is being
+ * written; a reader that sees it change while copying tries again.    */
+typedef struct {
+    atomic_uint seq;
+    ot_status_t status;
+} slot_t;
+
+static slot_t s_slots[2];
+static atomic_uint s_current;
+static uint32_t s_version;
+
+static otInstance *s_instance;
+static TaskHandle_t s_mainloop;
+static esp_timer_handle_t s_timer;
+static atomic_bool s_publish_queued;
+static int64_t s_tables_us;
+
+/* Statistics (s_lock) */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static ot_status_stats_t s_stats;
+
+/* Lock holder (changed only by the task holding the lock) */
+static uint32_t s_hold_depth;
+static int64_t s_hold_start_us;
+
+/* ------------------------------------------------------------------ */
+/*  Publishing (mainloop)                                              */
+/* ------------------------------------------------------------------ */
+
+/* Getters and counter copies: cheap enough for every publish */
+static void fill_counters(otInstance *instance, ot_status_t *st)
+{
+    st->role = otThreadGetDeviceRole(instance);
+    st->partition_id = otThreadGetPartitionId(instance);
+    st->rloc16 = otThreadGetRloc16(instance);
+    st->leader_router_id = otThreadGetLeaderRouterId(instance);
+    st->channel = otLinkGetChannel(instance);
+    st->netdata_version = otNetDataGetVersion(instance);
+    st->netdata_stable_version = otNetDataGetStableVersion(instance);
+
+    st->mac = *otLinkGetCounters(instance);
+    st->ip6 = *otThreadGetIp6Counters(instance);
+    st->br = *otIp6GetBorderRoutingCounters(instance);
+    otMessageGetBufferInfo(instance, &st->buffers);
+    st->srp_responses = *otSrpServerGetResponseCounters(instance);
+#if CONFIG_OPENTHREAD_NAT64
+    otNat64GetCounters(instance, &st->nat64);
+#endif
+}
+
+/* Walks over network data, neighbors and every SRP host and service */
+static void fill_tables(otInstance *instance, ot_status_t *st)
+{
+    st->on_mesh_prefixes = 0;
+    st->external_routes = 0;
+
+    otNetworkDataIterator it = OT_NETWORK_DATA_ITERATOR_INIT;
+    otBorderRouterConfig prefix;
+    while (otNetDataGetNextOnMeshPrefix(instance, &it, &prefix) == OT_ERROR_NONE) {
+        st->on_mesh_prefixes++;
+    }
+    it = OT_NETWORK_DATA_ITERATOR_INIT;
+    otExternalRouteConfig route;
+    while (otNetDataGetNextRoute(instance, &it, &route) == OT_ERROR_NONE) {
+        st->external_routes++;
+    }
+
+    otRoutePreference preference;
+    st->have_nat64_prefix =
+        otBorderRoutingGetFavoredNat64Prefix(instance, &st->nat64_prefix, &preference) ==
+        OT_ERROR_NONE;
+
+    otNeighborInfoIterator nit = OT_NEIGHBOR_INFO_ITERATOR_INIT;
+    otNeighborInfo info;
+    st->num_neighbors = 0;
+    while (st->num_neighbors < OT_STATUS_MAX_NEIGHBORS &&
+           otThreadGetNextNeighborInfo(instance, &nit, &info) == OT_ERROR_NONE) {
+        ot_status_neighbor_t *n = &st->neighbors[st->num_neighbors++];
+        n->rloc16 = info.mRloc16;
+        n->average_rssi = info.mAverageRssi;
+        n->last_rssi = info.mLastRssi;
+        n->link_quality_in = info.mLinkQualityIn;
+        n->is_child = info.mIsChild;
+        n->age_s = info.mAge;
+    }
+
+    st->srp_hosts = 0;
+    st->srp_services = 0;
+    const otSrpServerHost *host = NULL;
+    while ((host = otSrpServerGetNextHost(instance, host)) != NULL) {
+        if (otSrpServerHostIsDeleted(host)) continue;
+        st->srp_hosts++;
+
+        const otSrpServerService *service = NULL;
+        while ((service = otSrpServerHostGetNextService(host, service)) != NULL) {
+            if (!otSrpServerServiceIsDeleted(service)) st->srp_services++;
+        }
+    }
+}
+
+/* prev: the published snapshot, for the tables when they are not redone */
+static bool fill(otInstance *instance, ot_status_t *st, const ot_status_t *prev,
+                 otChangedFlags changed, int64_t now)
+{
+    bool tables = changed != 0 || prev->version == 0 ||
+                  now - s_tables_us >= OT_STATUS_TABLES_PERIOD_MS * 1000LL;
+
+    if (tables) {
+        fill_tables(instance, st);
+        s_tables_us = now;
+    } else {
+        *st = *prev;
+    }
+    st->version = ++s_version;
+    st->published_us = now;
+    st->changed = changed;
+    st->tables_us = s_tables_us;
+    fill_counters(instance, st);
+    return tables;
+}
+
+static void publish(otInstance *instance, otChangedFlags changed)
+{
+    int64_t start = esp_timer_get_time();
+
+    unsigned current = atomic_load_explicit(&s_current, memory_order_relaxed);
+    unsigned next = current ^ 1;
+    slot_t *slot = &s_slots[next];
+    unsigned seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    bool tables = fill(instance, &slot->status, &s_slots[current].status, changed, start);
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+    atomic_store_explicit(&s_current, next, memory_order_release);
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.publishes++;
+    if (tables) s_stats.table_walks++;
+    s_stats.publish_us += us;
+    if (us > s_stats.publish_max_us) s_stats.publish_max_us = us;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static void publish_tasklet(void *arg)
+{
+    atomic_store(&s_publish_queued, false);
+    publish(s_instance, 0);
+}
+
+/* esp_timer task: hand the work to the mainloop, at most once queued */
+static void timer_cb(void *arg)
+{
+    if (atomic_exchange(&s_publish_queued, true)) return;
+    if (esp_openthread_task_queue_post(publish_tasklet, NULL) != ESP_OK) {
+        atomic_store(&s_publish_queued, false);
+    }
+}
+
+void ot_status_handle_state_change(otInstance *instance, otChangedFlags flags)
+{
+    if (s_instance == NULL || !(flags & PUBLISH_FLAGS)) return;
+    publish(instance, flags);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Readers                                                            */
+/* ------------------------------------------------------------------ */
+
+bool ot_status_read(ot_status_t *status)
+{
+    uint32_t retries = 0;
+
+    for (;;) {
+        unsigned index = atomic_load_explicit(&s_current, memory_order_acquire);
+        const slot_t *slot = &s_slots[index];
+        unsigned seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+
+        /* Odd: the mainloop has lapped us and is rewriting this slot;
+         * s_current already points at the finished one.               */
+        if (seq & 1) {
+            retries++;
+            continue;
+        }
+        if (seq == 0) return false;
+
+        memcpy(status, &slot->status, sizeof(*status));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) == seq) break;
+        retries++;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.reads++;
+    s_stats.read_retries += retries;
+    taskEXIT_CRITICAL(&s_lock);
+    return true;
+}
+
+/* ------------------------------------------------------------------ */
+/*  OpenThread lock accounting                                         */
+/*                                                                     */
+/*  esp_openthread_lock_acquire/release are wrapped at link time (see  */
+/*  main/CMakeLists.txt).  The mainloop's own holds are its normal     */
+/*  running state and are not counted; every other task's hold is time */
+/*  the mainloop can't run.                                            */
+/* ------------------------------------------------------------------ */
+
+bool __real_esp_openthread_lock_acquire(TickType_t block_ticks);
+void __real_esp_openthread_lock_release(void);
+
+/* Row for the calling task, or NULL once the table is full (s_lock held) */
+static ot_status_lock_task_t *task_row(TaskHandle_t task)
+{
+    const char *name = pcTaskGetName(task);
+
+    for (uint32_t i = 0; i < s_stats.num_tasks; i++) {
+        if (strncmp(s_stats.tasks[i].task, name, sizeof(s_stats.tasks[i].task) - 1) == 0) {
+            return &s_stats.tasks[i];
+        }
+    }
+    if (s_stats.num_tasks == OT_STATUS_MAX_TASKS) return NULL;
+
+    ot_status_lock_task_t *row = &s_stats.tasks[s_stats.num_tasks++];
+    strlcpy(row->task, name, sizeof(row->task));
+    return row;
+}
+
+bool __wrap_esp_openthread_lock_acquire(TickType_t block_ticks)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (s_mainloop == NULL || self == s_mainloop) {
+        return __real_esp_openthread_lock_acquire(block_ticks);
+    }
+
+    int64_t start = esp_timer_get_time();
+    bool acquired = __real_esp_openthread_lock_acquire(block_ticks);
+    int64_t now = esp_timer_get_time();
+
+    /* Recursive: only the outermost acquire starts a hold */
+    if (acquired && s_hold_depth++ > 0) return true;
+    if (acquired) s_hold_start_us = now;
+
+    taskENTER_CRITICAL(&s_lock);
+    ot_status_lock_task_t *row = task_row(self);
+    if (row != NULL) {
+        row->wait_us += (uint64_t)(now - start);
+        if (!acquired) row->timeouts++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return acquired;
+}
+
+void __wrap_esp_openthread_lock_release(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (s_mainloop == NULL || self == s_mainloop || s_hold_depth == 0 || --s_hold_depth > 0) {
+        __real_esp_openthread_lock_release();
+        return;
+    }
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - s_hold_start_us);
+    __real_esp_openthread_lock_release();
+
+    taskENTER_CRITICAL(&s_lock);
+    ot_status_lock_task_t *row = task_row(self);
+    if (row != NULL) {
+        row->holds++;
+        row->hold_us += us;
+        if (us > row->hold_max_us) row->hold_max_us = us;
+    } else {
+        s_stats.other_tasks++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Control / metrics                                                  */
+/* ------------------------------------------------------------------ */
+
+static void write_metrics(metrics_writer_t *w)
+{
+    ot_status_stats_t stats;
+    const ot_status_stats_t *st = &stats;
+    ot_status_get_stats(&stats);
+
+    metrics_counter(w, "otbr_ot_status_publishes_total", "Status snapshots published",
+                    st->publishes);
+    metrics_counter(w, "otbr_ot_status_table_walks_total",
+                    "Status snapshots that re-walked network data, neighbors and SRP",
+                    st->table_walks);
+    metrics_counter(w, "otbr_ot_status_publish_us_total",
+                    "Mainloop time spent publishing status snapshots (us)", st->publish_us);
+    metrics_gauge(w, "otbr_ot_status_publish_max_us", "Slowest status snapshot (us)",
+                  st->publish_max_us);
+    metrics_counter(w, "otbr_ot_status_reads_total", "Status snapshot reads", st->reads);
+    metrics_counter(w, "otbr_ot_status_read_retries_total",
+                    "Snapshot reads repeated because a publish overlapped", st->read_retries);
+
+    metrics_header(w, "otbr_ot_lock_holds_total", "counter",
+                   "OpenThread lock holds by tasks other than the mainloop");
+    for (uint32_t i = 0; i < st->num_tasks; i++) {
+        metrics_printf(w, "otbr_ot_lock_holds_total{task=\"%s\"} %lu\n", st->tasks[i].task,
+                       (unsigned long)st->tasks[i].holds);
+    }
+    metrics_header(w, "otbr_ot_lock_hold_us_total", "counter",
+                   "Time other tasks held the OpenThread lock, stalling the mainloop (us)");
+    for (uint32_t i = 0; i < st->num_tasks; i++) {
+        metrics_printf(w, "otbr_ot_lock_hold_us_total{task=\"%s\"} %llu\n", st->tasks[i].task,
+                       (unsigned long long)st->tasks[i].hold_us);
+    }
+    metrics_header(w, "otbr_ot_lock_hold_max_us", "gauge",
+                   "Longest single OpenThread lock hold (us)");
+    for (uint32_t i = 0; i < st->num_tasks; i++) {
+        metrics_printf(w, "otbr_ot_lock_hold_max_us{task=\"%s\"} %lu\n", st->tasks[i].task,
+                       (unsigned long)st->tasks[i].hold_max_us);
+    }
+    metrics_header(w, "otbr_ot_lock_wait_us_total", "counter",
+                   "Time tasks spent waiting for the OpenThread lock (us)");
+    for (uint32_t i = 0; i < st->num_tasks; i++) {
+        metrics_printf(w, "otbr_ot_lock_wait_us_total{task=\"%s\"} %llu\n", st->tasks[i].task,
+                       (unsigned long long)st->tasks[i].wait_us);
+    }
+    metrics_header(w, "otbr_ot_lock_timeouts_total", "counter",
+                   "OpenThread lock acquires that timed out");
+    for (uint32_t i = 0; i < st->num_tasks; i++) {
+        metrics_printf(w, "otbr_ot_lock_timeouts_total{task=\"%s\"} %lu\n", st->tasks[i].task,
+                       (unsigned long)st->tasks[i].timeouts);
+    }
+}
+
+void ot_status_start(otInstance *instance)
+{
+    if (s_instance != NULL) return;
+
+    s_instance = instance;
+    s_mainloop = xTaskGetCurrentTaskHandle();
+    publish(instance, 0);
+
+    const esp_timer_create_args_t args = {
+        .callback = timer_cb,
+        .name = "ot_status",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &s_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(s_timer, OT_STATUS_PERIOD_MS * 1000));
+
+    metrics_register_source(write_metrics);
+    ESP_LOGI(TAG, "Publishing status every %d ms, tables every %d ms (%u bytes per snapshot)",
+             OT_STATUS_PERIOD_MS, OT_STATUS_TABLES_PERIOD_MS, (unsigned)sizeof(ot_status_t));
+}
+
+void ot_status_get_stats(ot_status_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void ot_status_reset_stats(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    memset(&s_stats, 0, sizeof(s_stats));
+    taskEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,129 @@
+/*
+ * Lock-free OpenThread status snapshots
+ *
+ * OpenThread may only be called with the OpenThread lock held, and a
+ * task holding it stalls the mainloop (radio, forwarding, CLI) for as
+ * long as it does.  Instead of every reader taking the lock for a few
+ * counters, the mainloop publishes a snapshot of the state they want:
+ *   - on state changes that affect it (role, partition, neighbors,
+ *     network data, channel) and every OT_STATUS_PERIOD_MS
+ *   - in two parts: counters, role and buffers are cheap getters and
+ *     are taken every time; the table walks (network data, neighbors,
+ *     every SRP host and service) are redone on those state changes and
+ *     every OT_STATUS_TABLES_PERIOD_MS, and carried over in between
+ *   - into two buffers with a sequence counter each, so the next
+ *     snapshot is written while readers copy the current one, and a
+ *     reader that raced a write retries instead of waiting
+ *
+ * ot_status_read() never blocks and never touches the lock.  To see
+ * what the lock costs, acquire/release are wrapped at link time: every
+ * hold by a task other than the mainloop is timed per task, as is the
+ * mainloop's own time spent publishing ("otbr status", /metrics).
+ */
+
+#ifndef OT_STATUS_H
+#define OT_STATUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "openthread/border_router.h"
+#include "openthread/instance.h"
+#include "openthread/ip6.h"
+#include "openthread/link.h"
+#include "openthread/message.h"
+#include "openthread/nat64.h"
+#include "openthread/srp_server.h"
+#include "openthread/thread.h"
+
+#define OT_STATUS_PERIOD_MS     200
+#define OT_STATUS_TABLES_PERIOD_MS 1000
+#define OT_STATUS_MAX_NEIGHBORS 32
+#define OT_STATUS_MAX_TASKS     8
+
+typedef struct {
+    uint16_t rloc16;
+    int8_t average_rssi;
+    int8_t last_rssi;
+    uint8_t link_quality_in;
+    bool is_child;
+    uint32_t age_s;             /* since last heard */
+} ot_status_neighbor_t;
+
+typedef struct {
+    uint32_t version;           /* 1 for the first snapshot, +1 each publish */
+    int64_t published_us;       /* esp_timer time it was taken        */
+    otChangedFlags changed;     /* what triggered it; 0 = periodic    */
+    int64_t tables_us;          /* when the table walks were redone   */
+
+    otDeviceRole role;
+    uint32_t partition_id;
+    uint16_t rloc16;
+    uint8_t leader_router_id;
+    uint8_t channel;
+
+    uint8_t netdata_version;
+    uint8_t netdata_stable_version;
+    uint8_t on_mesh_prefixes;
+    uint8_t external_routes;
+    bool have_nat64_prefix;
+    otIp6Prefix nat64_prefix;   /* favored NAT64 prefix               */
+
+    uint8_t num_neighbors;      /* entries used in neighbors[]        */
+    ot_status_neighbor_t neighbors[OT_STATUS_MAX_NEIGHBORS];
+
+    otMacCounters mac;
+    otIpCounters ip6;
+    otBorderRoutingCounters br;
+    otBufferInfo buffers;
+    otSrpServerResponseCounters srp_responses;
+    uint32_t srp_hosts;
+    uint32_t srp_services;
+#if CONFIG_OPENTHREAD_NAT64
+    otNat64ProtocolCounters nat64;
+#endif
+} ot_status_t;
+
+typedef struct {
+    char task[16];
+    uint32_t holds;
+    uint64_t hold_us;           /* total time holding the lock        */
+    uint32_t hold_max_us;
+    uint64_t wait_us;           /* total time blocked acquiring it    */
+    uint32_t timeouts;          /* acquires that gave up              */
+} ot_status_lock_task_t;
+
+typedef struct {
+    uint32_t publishes;
+    uint32_t table_walks;       /* publishes that redid the walks     */
+    uint64_t publish_us;        /* mainloop time spent publishing     */
+    uint32_t publish_max_us;
+    uint32_t reads;
+    uint32_t read_retries;      /* reads that raced a publish         */
+    uint32_t num_tasks;
+    uint32_t other_tasks;       /* holds by tasks past the table      */
+    ot_status_lock_task_t tasks[OT_STATUS_MAX_TASKS];
+} ot_status_stats_t;
+
+/**
+ * Publish the first snapshot and start the periodic one.  Call from the
+ * OpenThread task before esp_openthread_launch_mainloop(): that task is
+ * the mainloop whose lock holds are not counted.
+ */
+void ot_status_start(otInstance *instance);
+
+/** State-changed callback hook; publishes when flags affect the snapshot. */
+void ot_status_handle_state_change(otInstance *instance, otChangedFlags flags);
+
+/**
+ * Copy the latest snapshot.  Returns false (and leaves *status alone)
+ * until the first one is published.  Safe from any task.
+ */
+bool ot_status_read(ot_status_t *status);
+
+void ot_status_get_stats(ot_status_stats_t *stats);
+
+/** Zero the lock and publish statistics, e.g. to compare two runs. */
+void ot_status_reset_stats(void);
+
+#endif /* OT_STATUS_H */
@@ -0,0 +1,793 @@
+/*
+ * "otbr" OpenThread CLI command family — see otbr_cli.h
+ *
+ * Commands run on the OpenThread mainloop (the CLI is processed there),
+ * so they may call OpenThread APIs without taking the lock.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+
+#include "openthread/cli.h"
+#include "openthread/nat64.h"
+
+#include "config.h"
+#include "burst_bench.h"
+#include "channel_plan.h"
+#include "coex_ctrl.h"
+#include "commission.h"
+#include "dns_proxy.h"
+#include "log_ring.h"
+#include "mcast_fwd.h"
+#include "mem_pool.h"
+#include "mem_watch.h"
+#include "nat64.h"
+#include "ot_profiler.h"
+#include "ot_settings.h"
+#include "ot_status.h"
+#include "pkt_capture.h"
+#include "route_health.h"
+#include "srp_mdns.h"
+#include "wifi_power.h"
+#include "otbr_cli.h"
+
+typedef otError (*otbr_cmd_fn_t)(otInstance *instance, uint8_t argc, char *argv[]);
+
+typedef struct {
+    const char *name;
+    const char *usage;
+    otbr_cmd_fn_t handler;
+} otbr_cmd_t;
+
+static otError cmd_help(otInstance *instance, uint8_t argc, char *argv[]);
+
+/* ------------------------------------------------------------------ */
+/*  Commands                                                           */
+/* ------------------------------------------------------------------ */
+
+static otError cmd_burst(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc < 1) return OT_ERROR_INVALID_ARGS;
+
+    uint32_t count = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : BURST_BENCH_DEFAULT_COUNT;
+    uint32_t size  = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : BURST_BENCH_DEFAULT_SIZE;
+
+    esp_err_t err = burst_bench_start(argv[0], count, size);
+    if (err == ESP_ERR_INVALID_STATE) return OT_ERROR_BUSY;
+    if (err != ESP_OK) return OT_ERROR_INVALID_ARGS;
+
+    otCliOutputFormat("burst: %lu x %lu B to %s, results in the log\r\n",
+                      (unsigned long)count, (unsigned long)size, argv[0]);
+    return OT_ERROR_NONE;
+}
+
+static otError cmd_route(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc > 0) {
+        static const otRoutePreference prefs[] = {
+            OT_ROUTE_PREFERENCE_HIGH, OT_ROUTE_PREFERENCE_MED, OT_ROUTE_PREFERENCE_LOW,
+        };
+        const size_t count = sizeof(prefs) / sizeof(prefs[0]);
+        size_t i = 0;
+        if (strcmp(argv[0], "auto") == 0) {
+            route_health_set_mode(true, OT_ROUTE_PREFERENCE_MED);
+        } else if (strcmp(argv[0], "off") == 0) {
+            route_health_release();
+        } else {
+            while (i < count && strcmp(argv[0], route_health_preference_name(prefs[i])) != 0) i++;
+            if (i == count) return OT_ERROR_INVALID_ARGS;
+            route_health_set_mode(false, prefs[i]);
+        }
+    }
+
+    route_health_stats_t st;
+    route_health_get_stats(&st);
+
+    otCliOutputFormat("preference %s (%s), %lu changes\r\n",
+                      route_health_preference_name(st.preference),
+                      st.adaptive ? "adaptive" : st.pinned ? "pinned" : "OpenThread's",
+                      (unsigned long)st.changes);
+    otCliOutputFormat("health %lu/100; last sample: backbone %lu (rssi %d dBm), retries %lu, "
+                      "queues %lu, heap %lu\r\n",
+                      (unsigned long)st.score, (unsigned long)st.backbone, st.rssi,
+                      (unsigned long)st.retries, (unsigned long)st.queues,
+                      (unsigned long)st.heap);
+    return OT_ERROR_NONE;
+}
+
+static otError cmd_settings(otInstance *instance, uint8_t argc, char *argv[])
+{
+    ot_settings_stats_t st;
+    ot_settings_get_stats(&st);
+
+    otCliOutputFormat("writes %lu, deletes %lu, skipped %lu\r\n",
+                      (unsigned long)st.writes, (unsigned long)st.deletes,
+                      (unsigned long)st.skipped);
+    otCliOutputFormat("deferred %lu, coalesced %lu, flushed %lu\r\n",
+                      (unsigned long)st.deferred, (unsigned long)st.coalesced,
+                      (unsigned long)st.flushed);
+    otCliOutputFormat("flash stall: total %llu ms (flusher %llu ms), max %lu us (key 0x%04x)\r\n",
+                      (unsigned long long)(st.stall_us / 1000),
+                      (unsigned long long)(st.flush_us / 1000),
+                      (unsigned long)st.stall_max_us, st.stall_max_key);
+    return OT_ERROR_NONE;
+}
+
+static void print_channel_plan(void)
+{
+    channel_plan_report_t r;
+    channel_plan_get_report(&r);
+
+    otCliOutputFormat("wifi channel %u, thread channel %u, recommended %u\r\n",
+                      r.ap_channel, r.thread_channel, r.best_channel);
+    if (r.scanned) {
+        otCliOutputFormat("last energy scan %lld s ago\r\n", r.scan_age_s);
+    } else {
+        otCliOutputFormat("no energy scan yet (\"otbr channel scan\"), scoring Wi-Fi overlap only\r\n");
+    }
+    otCliOutputFormat("ch | energy dBm | score\r\n");
+    for (int i = 0; i < CHANNEL_PLAN_COUNT; i++) {
+        otCliOutputFormat("%2d | %10d | %5d%s\r\n", CHANNEL_PLAN_FIRST + i,
+                          r.energy_dbm[i], r.score[i],
+                          CHANNEL_PLAN_FIRST + i == r.best_channel ? " *" : "");
+    }
+}
+
+static void channel_scan_done(otInstance *instance, uint8_t channel, void *context)
+{
+    print_channel_plan();
+}
+
+static otError cmd_capture(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc > 0 && strcmp(argv[0], "stop") == 0) {
+        pkt_capture_stop();
+    } else if (argc > 0) {
+        if (strcmp(argv[0], "start") != 0 || argc < 4) return OT_ERROR_INVALID_ARGS;
+
+        pkt_capture_transport_t transport;
+        if (strcmp(argv[1], "udp") == 0) {
+            transport = PKT_CAPTURE_UDP;
+        } else if (strcmp(argv[1], "tcp") == 0) {
+            transport = PKT_CAPTURE_TCP;
+        } else {
+            return OT_ERROR_INVALID_ARGS;
+        }
+
+        /* The rest of the line is the filter */
+        char filter[128] = "";
+        for (uint8_t i = 4; i < argc; i++) {
+            if (i > 4) strlcat(filter, " ", sizeof(filter));
+            if (strlcat(filter, argv[i], sizeof(filter)) >= sizeof(filter)) {
+                return OT_ERROR_INVALID_ARGS;
+            }
+        }
+
+        esp_err_t err = pkt_capture_start(transport, argv[2],
+                                          (uint16_t)strtoul(argv[3], NULL, 0), filter);
+        if (err == ESP_ERR_INVALID_STATE) return OT_ERROR_BUSY;
+        if (err == ESP_ERR_NO_MEM) return OT_ERROR_NO_BUFS;
+        if (err != ESP_OK) return OT_ERROR_INVALID_ARGS;
+    }
+
+    pkt_capture_stats_t st;
+    pkt_capture_get_stats(&st);
+
+    otCliOutputFormat("capture: %s%s, %d slots of %d bytes, max used %lu\r\n",
+                      st.active ? "running over " : "stopped",
+                      st.active ? (st.transport == PKT_CAPTURE_TCP ? "tcp" : "udp") : "",
+                      CAPTURE_SLOTS, CAPTURE_SNAPLEN, (unsigned long)st.max_used);
+    otCliOutputFormat("packets: captured %lu, filtered out %lu, dropped %lu (ring full)\r\n",
+                      (unsigned long)st.captured, (unsigned long)st.filtered,
+                      (unsigned long)st.dropped);
+    otCliOutputFormat("stream: %lu records, %llu bytes, %lu send errors\r\n",
+                      (unsigned long)st.sent, (unsigned long long)st.bytes,
+                      (unsigned long)st.send_errors);
+    return OT_ERROR_NONE;
+}
+
+static otError cmd_channel(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc == 0) {
+        print_channel_plan();
+        return OT_ERROR_NONE;
+    }
+    if (strcmp(argv[0], "scan") == 0) {
+        /* Results are printed asynchronously when the scan completes */
+        return channel_plan_scan(instance, channel_scan_done, NULL);
+    }
+    if (strcmp(argv[0], "migrate") == 0) {
+        uint8_t channel = argc > 1 ? (uint8_t)strtoul(argv[1], NULL, 0) : channel_plan_best();
+        otError error = channel_plan_migrate(instance, channel);
+        if (error == OT_ERROR_NONE) {
+            otCliOutputFormat("moving to channel %u in %d s\r\n", channel,
+                              CHANNEL_MIGRATE_DELAY_MS / 1000);
+        }
+        return error;
+    }
+    return OT_ERROR_INVALID_ARGS;
+}
+
+static otError cmd_coex(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc > 0) {
+        if (strcmp(argv[0], "auto") == 0) {
+            coex_ctrl_set_mode(true, COEX_LEVEL_COUNT);
+        } else {
+            coex_level_t level;
+            for (level = 0; level < COEX_LEVEL_COUNT; level++) {
+                if (strcmp(argv[0], coex_level_name(level)) == 0) break;
+            }
+            if (level == COEX_LEVEL_COUNT) return OT_ERROR_INVALID_ARGS;
+            coex_ctrl_set_mode(false, level);
+        }
+    }
+
+    coex_ctrl_stats_t st;
+    coex_ctrl_get_stats(&st);
+
+    otCliOutputFormat("level %s (%s), %lu changes\r\n", coex_level_name(st.level),
+                      st.adaptive ? "adaptive" : "pinned", (unsigned long)st.level_changes);
+    otCliOutputFormat("last sample: %lu tx attempts, retry %lu.%lu %%, cca fail %lu.%lu %%, "
+                      "rx error %lu.%lu %%, wifi %lu kbps\r\n",
+                      (unsigned long)st.tx_attempts,
+                      (unsigned long)(st.retry_pm / 10), (unsigned long)(st.retry_pm % 10),
+                      (unsigned long)(st.cca_fail_pm / 10), (unsigned long)(st.cca_fail_pm % 10),
+                      (unsigned long)(st.rx_error_pm / 10), (unsigned long)(st.rx_error_pm % 10),
+                      (unsigned long)st.wifi_kbps);
+    otCliOutputFormat("mac totals: tx %lu, retry %lu, cca %lu, busy %lu, rx %lu, rx err %lu\r\n",
+                      (unsigned long)st.mac_tx_total, (unsigned long)st.mac_tx_retry,
+                      (unsigned long)st.mac_tx_err_cca, (unsigned long)st.mac_tx_err_busy,
+                      (unsigned long)st.mac_rx_total, (unsigned long)st.mac_rx_errors);
+    return OT_ERROR_NONE;
+}
+
+static otError cmd_commission(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc > 0) {
+        esp_err_t err;
+        if (strcmp(argv[0], "start") == 0) {
+            const char *pskd = argc > 1 ? argv[1] : NULL;
+            uint32_t minutes = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 0;
+            err = commission_start(pskd, minutes);
+        } else if (strcmp(argv[0], "stop") == 0) {
+            commission_stop();
+            err = ESP_OK;
+        } else if (strcmp(argv[0], "bench") == 0 && argc > 1) {
+            err = commission_bench_start((uint32_t)strtoul(argv[1], NULL, 0));
+            if (err == ESP_OK) {
+                otCliOutputFormat("commission bench: %s handshakes queued, results in the log\r\n",
+                                  argv[1]);
+            }
+        } else {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        if (err == ESP_ERR_INVALID_STATE) return OT_ERROR_BUSY;
+        if (err == ESP_ERR_NO_MEM) return OT_ERROR_NO_BUFS;
+        if (err != ESP_OK) return OT_ERROR_INVALID_ARGS;
+    }
+
+    commission_stats_t st;
+    commission_get_stats(&st);
+    otCliOutputFormat("commissioner: %s%s; %lu sessions, %lu joined, %lu failed\r\n",
+                      st.active ? "active" : "off", st.in_session ? ", joiner in session" : "",
+                      (unsigned long)st.sessions, (unsigned long)st.joined,
+                      (unsigned long)st.failed);
+    otCliOutputFormat("handshake avg %lu ms, max %lu ms; join avg %lu ms, max %lu ms\r\n",
+                      (unsigned long)st.handshake_ms_avg, (unsigned long)st.handshake_ms_max,
+                      (unsigned long)st.join_ms_avg, (unsigned long)st.join_ms_max);
+    otCliOutputFormat("%lu.%lu joins/min over %lu s, idle between sessions %lu ms\r\n",
+                      (unsigned long)(st.joins_per_min_x10 / 10),
+                      (unsigned long)(st.joins_per_min_x10 % 10), (unsigned long)st.elapsed_s,
+                      (unsigned long)st.idle_ms);
+
+    commission_bench_stats_t bench;
+    commission_bench_get_stats(&bench);
+    if (bench.active || bench.done > 0) {
+        otCliOutputFormat("bench: %s, %lu handshakes (%lu failed), avg %lu ms (commissioner "
+                          "%lu ms), max %lu ms, %lu per minute\r\n",
+                          bench.active ? "running" : "done", (unsigned long)bench.done,
+                          (unsigned long)bench.failed, (unsigned long)bench.avg_ms,
+                          (unsigned long)bench.commissioner_ms, (unsigned long)bench.max_ms,
+                          (unsigned long)bench.per_min);
+    }
+    return OT_ERROR_NONE;
+}
+
+static otError cmd_dns(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc > 0) {
+        if (strcmp(argv[0], "flush") != 0) return OT_ERROR_INVALID_ARGS;
+        dns_proxy_flush();
+    }
+
+    dns_proxy_stats_t st;
+    dns_proxy_get_stats(&st);
+
+    otCliOutputFormat("cache: %lu entries, %lu of %d bytes\r\n",
+                      (unsigned long)st.entries, (unsigned long)st.bytes, DNS_PROXY_CACHE_BYTES);
+    otCliOutputFormat("queries %lu: hits %lu (%lu%%), misses %lu (coalesced %lu), "
+                      "unsupported %lu\r\n",
+                      (unsigned long)st.queries, (unsigned long)st.hits,
+                      (unsigned long)(st.hits + st.misses ? st.hits * 100 / (st.hits + st.misses) : 0),
+                      (unsigned long)st.misses, (unsigned long)st.coalesced,
+                      (unsigned long)st.unsupported);
+    otCliOutputFormat("lookups %lu (refresh-ahead %lu), failed %lu, expired %lu, evicted %lu\r\n",
+                      (unsigned long)st.lookups, (unsigned long)st.refreshes,
+                      (unsigned long)st.failures, (unsigned long)st.expired,
+                      (unsigned long)st.evicted);
+    otCliOutputFormat("miss -> answer latency: avg %lu ms, max %lu ms\r\n",
+                      (unsigned long)(st.lookup_count ? st.lookup_ms_sum / st.lookup_count : 0),
+                      (unsigned long)st.lookup_max_ms);
+    return OT_ERROR_NONE;
+}
+
+static otError cmd_log(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc > 0) {
+        if (strcmp(argv[0], "udp") != 0 || argc < 2) return OT_ERROR_INVALID_ARGS;
+
+        esp_err_t err;
+        if (strcmp(argv[1], "off") == 0) {
+            err = log_ring_set_collector(NULL, 0);
+        } else {
+            if (argc < 3) return OT_ERROR_INVALID_ARGS;
+            err = log_ring_set_collector(argv[1], (uint16_t)strtoul(argv[2], NULL, 0));
+        }
+        if (err == ESP_ERR_INVALID_STATE) return OT_ERROR_INVALID_STATE;
+        if (err != ESP_OK) return OT_ERROR_INVALID_ARGS;
+    }
+
+    log_ring_stats_t st;
+    log_ring_get_stats(&st);
+
+    if (st.slots == 0) {
+        otCliOutputFormat("log: synchronous (LOG_RING_SLOTS 0)\r\n");
+        return OT_ERROR_NONE;
+    }
+    otCliOutputFormat("ring: %lu slots, max used %lu\r\n",
+                      (unsigned long)st.slots, (unsigned long)st.max_used);
+    otCliOutputFormat("records: queued %lu, dropped %lu, truncated %lu; lines %lu\r\n",
+                      (unsigned long)st.queued, (unsigned long)st.dropped,
+                      (unsigned long)st.truncated, (unsigned long)st.emitted);
+    otCliOutputFormat("udp: %s, sent %lu, failed %lu\r\n", st.udp_enabled ? "on" : "off",
+                      (unsigned long)st.udp_sent, (unsigned long)st.udp_failed);
+    return OT_ERROR_NONE;
+}
+
+static otError cmd_mcast(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc > 0) {
+        mcast_policy_t policy = MCAST_POLICY_OFF;
+        while (policy <= MCAST_POLICY_UNICAST && strcmp(argv[0], mcast_policy_name(policy)) != 0) {
+            policy++;
+        }
+        if (policy > MCAST_POLICY_UNICAST) return OT_ERROR_INVALID_ARGS;
+        mcast_fwd_set_policy(policy);
+    }
+
+    mcast_fwd_stats_t st;
+    mcast_fwd_get_stats(&st);
+
+    otCliOutputFormat("policy %s; thread groups %lu (%s), backbone groups %lu (%s)\r\n",
+                      mcast_policy_name(st.policy), (unsigned long)st.thread_groups,
+                      st.bbr_primary ? "MLR" : "unknown, not Primary BBR",
+                      (unsigned long)st.lan_groups,
+                      st.snooping ? "MLD" : "untrusted, no querier or reports");
+    otCliOutputFormat("to backbone: forwarded %lu, unicast %lu (%lu copies), dropped %lu "
+                      "(%llu B), unfiltered %lu\r\n",
+                      (unsigned long)st.out_forwarded, (unsigned long)st.out_unicast,
+                      (unsigned long)st.out_copies, (unsigned long)st.out_dropped,
+                      (unsigned long long)st.out_dropped_bytes, (unsigned long)st.out_unfiltered);
+    otCliOutputFormat("to thread: forwarded %lu, dropped %lu (%llu B), unfiltered %lu\r\n",
+                      (unsigned long)st.in_forwarded, (unsigned long)st.in_dropped,
+                      (unsigned long long)st.in_dropped_bytes, (unsigned long)st.in_unfiltered);
+    otCliOutputFormat("airtime saved (est.): wifi %llu ms, thread %llu ms; MLD reports %lu, "
+                      "table full %lu\r\n",
+                      (unsigned long long)(st.wifi_airtime_saved_us / 1000),
+                      (unsigned long long)(st.thread_airtime_saved_us / 1000),
+                      (unsigned long)st.mld_reports, (unsigned long)st.table_full);
+    return OT_ERROR_NONE;
+}
+
+static otError cmd_mem(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc > 0) {
+        if (strcmp(argv[0], "soak") != 0 || argc < 2) return OT_ERROR_INVALID_ARGS;
+
+        if (strcmp(argv[1], "stop") == 0) {
+            mem_soak_stop();
+            otCliOutputFormat("soak: stopping, report in the log\r\n");
+            return OT_ERROR_NONE;
+        }
+        char *end;
+        uint32_t minutes = (uint32_t)strtoul(argv[1], &end, 0);
+        if (*end != '\0') return OT_ERROR_INVALID_ARGS;
+
+        esp_err_t err = mem_soak_start(minutes, argc > 2 ? argv[2] : NULL);
+        if (err == ESP_ERR_INVALID_STATE) return OT_ERROR_BUSY;
+        if (err == ESP_ERR_NO_MEM) return OT_ERROR_NO_BUFS;
+        if (err != ESP_OK) return OT_ERROR_INVALID_ARGS;
+    }
+
+    mem_watch_stats_t st;
+    mem_watch_get_stats(&st);
+    otCliOutputFormat("heap: %lu B free of %lu, lowest %lu, largest block %lu "
+                      "(%lu %% fragmented)\r\n",
+                      (unsigned long)st.heap_free, (unsigned long)st.heap_total,
+                      (unsigned long)st.heap_min_free, (unsigned long)st.heap_largest,
+                      (unsigned long)st.fragmentation);
+    otCliOutputFormat("failed allocations: %lu (last %lu B), warnings: %lu\r\n",
+                      (unsigned long)st.alloc_failures, (unsigned long)st.last_failed_size,
+                      (unsigned long)st.warnings);
+    otCliOutputFormat("OpenThread message buffers: %u of %u free, lowest %u\r\n",
+                      st.ot_buffers_free, st.ot_buffers, st.ot_buffers_min_free);
+
+    mem_pool_stats_t pools[8];
+    size_t num_pools = mem_pool_list(pools, sizeof(pools) / sizeof(pools[0]));
+    for (size_t i = 0; i < num_pools; i++) {
+        otCliOutputFormat("pool %-12s %3u/%-3u x %3u B, peak %u, "
+                          "heap fallbacks %lu + %lu oversize\r\n",
+                          pools[i].name, pools[i].used, pools[i].count,
+                          (unsigned)pools[i].block_size, pools[i].peak,
+                          (unsigned long)pools[i].exhausted, (unsigned long)pools[i].oversize);
+    }
+
+    static mem_task_stack_t stacks[24];
+    size_t num_stacks = mem_watch_get_stacks(stacks, sizeof(stacks) / sizeof(stacks[0]));
+    for (size_t i = 0; i < num_stacks; i++) {
+        if (stacks[i].stack_size > 0) {
+            otCliOutputFormat("stack %-12s %5lu of %lu B used\r\n", stacks[i].name,
+                              (unsigned long)(stacks[i].stack_size - stacks[i].free_min),
+                              (unsigned long)stacks[i].stack_size);
+        } else {
+            otCliOutputFormat("stack %-12s %5lu B never used\r\n", stacks[i].name,
+                              (unsigned long)stacks[i].free_min);
+        }
+    }
+
+    mem_soak_stats_t soak;
+    mem_soak_get_stats(&soak);
+    if (soak.active || soak.cycles > 0) {
+        otCliOutputFormat("soak: %s, %lu cycles in %lu s (%lu skipped), free heap %+ld B, "
+                          "largest block %+ld B\r\n",
+                          soak.active ? "running" : "done", (unsigned long)soak.cycles,
+                          (unsigned long)soak.elapsed_s, (unsigned long)soak.skipped,
+                          (long)soak.drift, (long)soak.largest_drift);
+    }
+    return OT_ERROR_NONE;
+}
+
+static otError cmd_nat64(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc > 0) {
+        if (strcmp(argv[0], "stress") != 0 || argc < 2) return OT_ERROR_INVALID_ARGS;
+
+        otIp4Address ip4 = { 0 };
+        uint16_t port = 0;
+        uint32_t flows = 0;     /* "clear" */
+        if (strcmp(argv[1], "clear") != 0) {
+            if (argc < 4 || otIp4AddressFromString(argv[1], &ip4) != OT_ERROR_NONE) {
+                return OT_ERROR_INVALID_ARGS;
+            }
+            port = (uint16_t)strtoul(argv[2], NULL, 0);
+            flows = (uint32_t)strtoul(argv[3], NULL, 0);
+            if (port == 0 || flows == 0) return OT_ERROR_INVALID_ARGS;
+        }
+
+        esp_err_t err = nat64_stress(ip4.mFields.m32, port, flows);
+        if (err == ESP_ERR_INVALID_STATE) return OT_ERROR_BUSY;
+        if (err == ESP_ERR_NO_MEM) return OT_ERROR_NO_BUFS;
+        if (err != ESP_OK) return OT_ERROR_INVALID_ARGS;
+
+        if (flows > 0) {
+            otCliOutputFormat("nat64 stress: %lu flows to %s:%u, results in the log\r\n",
+                              (unsigned long)flows, argv[1], port);
+        }
+        return OT_ERROR_NONE;
+    }
+
+    if (!nat64_engine_enabled()) {
+#if CONFIG_OPENTHREAD_NAT64
+        otNat64AddressMappingIterator it;
+        otNat64AddressMapping mapping;
+        uint32_t count = 0;
+
+        otCliOutputFormat("OpenThread translator (NAT64_ENGINE 0):\r\n");
+        otNat64InitAddressMappingIterator(instance, &it);
+        while (otNat64GetNextAddressMapping(instance, &it, &mapping) == OT_ERROR_NONE) {
+            char ip6[OT_IP6_ADDRESS_STRING_SIZE];
+            char ip4[OT_IP4_ADDRESS_STRING_SIZE];
+            otIp6AddressToString(&mapping.mIp6, ip6, sizeof(ip6));
+            otIp4AddressToString(&mapping.mIp4, ip4, sizeof(ip4));
+            otCliOutputFormat("  %s -> %s, expires in %lu s\r\n", ip6, ip4,
+                              (unsigned long)(mapping.mRemainingTimeMs / 1000));
+            count++;
+        }
+        otCliOutputFormat("%lu mappings\r\n", (unsigned long)count);
+#else
+        otCliOutputFormat("NAT64 disabled\r\n");
+#endif
+        return OT_ERROR_NONE;
+    }
+
+    nat64_stats_t st;
+    nat64_get_stats(&st);
+
+    otCliOutputFormat("mappings: %lu of %lu (udp %lu, tcp %lu, icmp %lu), max %lu\r\n",
+                      (unsigned long)st.mappings, (unsigned long)st.capacity,
+                      (unsigned long)st.mappings_udp, (unsigned long)st.mappings_tcp,
+                      (unsigned long)st.mappings_icmp, (unsigned long)st.mappings_max);
+    otCliOutputFormat("lookups: hits %lu, misses %lu; expired %lu, evicted %lu, exhausted %lu\r\n",
+                      (unsigned long)st.hits, (unsigned long)st.misses,
+                      (unsigned long)st.expired, (unsigned long)st.evicted,
+                      (unsigned long)st.exhausted);
+    otCliOutputFormat("packets: 6to4 %lu, 4to6 %lu; not translated: unsupported %lu, "
+                      "too big %lu\r\n",
+                      (unsigned long)st.packets_6to4, (unsigned long)st.packets_4to6,
+                      (unsigned long)st.unsupported, (unsigned long)st.too_big);
+    otCliOutputFormat("lookup cost: avg %lu cycles, max %lu cycles\r\n",
+                      (unsigned long)(st.lookup_count ? st.lookup_cycles_sum / st.lookup_count : 0),
+                      (unsigned long)st.lookup_cycles_max);
+    return OT_ERROR_NONE;
+}
+
+static otError cmd_power(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc > 0) {
+        static const wifi_power_policy_t policies[] = {
+            WIFI_POWER_LOW_LATENCY, WIFI_POWER_ADAPTIVE, WIFI_POWER_SAVE,
+        };
+        size_t i;
+        for (i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+            if (strcmp(argv[0], wifi_power_policy_name(policies[i])) == 0) break;
+        }
+        if (i == sizeof(policies) / sizeof(policies[0])) return OT_ERROR_INVALID_ARGS;
+        wifi_power_set_policy(policies[i]);
+    }
+
+    wifi_power_stats_t st;
+    wifi_power_get_stats(&st);
+
+    otCliOutputFormat("policy %s, power save %s (%lu switches, off for %llu s)\r\n",
+                      wifi_power_policy_name(st.policy), st.ps_enabled ? "on" : "off",
+                      (unsigned long)st.ps_switches, (unsigned long long)(st.ps_off_ms / 1000));
+    if (!st.policy_applies) {
+        otCliOutputFormat("policy inactive: software coexistence needs modem sleep\r\n");
+    }
+
+    const struct { const char *name; const wifi_power_rtt_t *rtt; } rows[] = {
+        { "ps off", &st.rtt_ps_off },
+        { "ps on",  &st.rtt_ps_on },
+    };
+    for (size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); i++) {
+        otCliOutputFormat("gateway rtt %-6s: %lu ok, %lu lost, min/avg/max %lu/%lu/%lu ms\r\n",
+                          rows[i].name, (unsigned long)rows[i].rtt->count,
+                          (unsigned long)rows[i].rtt->lost, (unsigned long)rows[i].rtt->min_ms,
+                          (unsigned long)rows[i].rtt->avg_ms, (unsigned long)rows[i].rtt->max_ms);
+    }
+    return OT_ERROR_NONE;
+}
+
+static otError cmd_srp(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc > 0) {
+        if (strcmp(argv[0], "bench") != 0 || argc < 2) return OT_ERROR_INVALID_ARGS;
+
+        uint32_t count = 0;     /* "clear" */
+        if (strcmp(argv[1], "clear") != 0) {
+            count = (uint32_t)strtoul(argv[1], NULL, 0);
+            if (count == 0) return OT_ERROR_INVALID_ARGS;
+        }
+
+        esp_err_t err = srp_mdns_bench(count);
+        if (err == ESP_ERR_INVALID_STATE) return OT_ERROR_BUSY;
+        if (err == ESP_ERR_NO_MEM) return OT_ERROR_NO_BUFS;
+        if (err != ESP_OK) return OT_ERROR_INVALID_ARGS;
+
+        if (count > 0) {
+            otCliOutputFormat("srp bench: %lu %s.%s services queued, results in the log\r\n",
+                              (unsigned long)count, SRP_MDNS_BENCH_SERVICE, SRP_MDNS_BENCH_PROTO);
+        }
+        return OT_ERROR_NONE;
+    }
+
+    srp_mdns_stats_t st;
+    srp_mdns_get_stats(&st);
+
+    otCliOutputFormat("on mDNS: %lu hosts, %lu services\r\n",
+                      (unsigned long)st.hosts, (unsigned long)st.services);
+    otCliOutputFormat("updates %lu (coalesced %lu, pending %lu), batches %lu (max %lu)\r\n",
+                      (unsigned long)st.updates, (unsigned long)st.coalesced,
+                      (unsigned long)st.pending, (unsigned long)st.batches,
+                      (unsigned long)st.max_batch);
+    otCliOutputFormat("services: added %lu, updated %lu, unchanged %lu, removed %lu, errors %lu\r\n",
+                      (unsigned long)st.published, (unsigned long)st.republished,
+                      (unsigned long)st.unchanged, (unsigned long)st.removed,
+                      (unsigned long)st.errors);
+    otCliOutputFormat("update -> mDNS latency: avg %lu ms, max %lu ms\r\n",
+                      (unsigned long)(st.latency_count ? st.latency_sum_ms / st.latency_count : 0),
+                      (unsigned long)st.latency_max_ms);
+    return OT_ERROR_NONE;
+}
+
+static void print_hist(const char *name, const ot_profiler_hist_t *h)
+{
+    otCliOutputFormat("%-11s %7lu, avg %lu us, max %lu us\r\n", name, (unsigned long)h->count,
+                      (unsigned long)(h->count ? h->sum_us / h->count : 0),
+                      (unsigned long)h->max_us);
+    if (h->count == 0) return;
+
+    /* Non-empty log2 buckets, labelled by their upper bound */
+    char line[200];
+    int len = 0;
+    for (int i = 0; i < OT_PROFILER_BUCKETS && len < (int)sizeof(line); i++) {
+        if (h->buckets[i] == 0) continue;
+        uint32_t bound = 16u << i;
+        const char *op = i < OT_PROFILER_BUCKETS - 1 ? "<" : ">=";
+        if (i == OT_PROFILER_BUCKETS - 1) bound = 16u << (i - 1);
+        len += snprintf(line + len, sizeof(line) - len, " %s%lu%s:%lu", op,
+                        (unsigned long)(bound >= 1000 ? bound / 1000 : bound),
+                        bound >= 1000 ? "ms" : "us", (unsigned long)h->buckets[i]);
+    }
+    otCliOutputFormat("           %s\r\n", line);
+}
+
+static otError cmd_profile(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc > 0) {
+        if (strcmp(argv[0], "start") == 0) {
+            ot_profiler_start();
+        } else if (strcmp(argv[0], "stop") == 0) {
+            ot_profiler_stop();
+        } else {
+            return OT_ERROR_INVALID_ARGS;
+        }
+    }
+
+    static ot_profiler_report_t rep;
+    ot_profiler_get_report(&rep);
+
+    otCliOutputFormat("profiler %s, window %lu ms\r\n", rep.running ? "running" : "stopped",
+                      (unsigned long)rep.window_ms);
+
+    static const char *const hist_names[OT_PROFILER_HIST_COUNT] = {
+        "iteration", "tasklets", "timer late", "radio rx", "radio tx",
+    };
+    for (int i = 0; i < OT_PROFILER_HIST_COUNT; i++) print_hist(hist_names[i], &rep.hist[i]);
+
+    static const char *const part_names[OT_PROFILER_PART_COUNT] = {
+        "radio", "timers", "tasklets", "flash", "other",
+    };
+    uint64_t busy = 0;
+    for (int i = 0; i < OT_PROFILER_PART_COUNT; i++) busy += rep.part_us[i];
+    otCliOutputFormat("iteration time by part (slowest iteration):\r\n");
+    for (int i = 0; i < OT_PROFILER_PART_COUNT; i++) {
+        otCliOutputFormat("  %-9s %3lu%%  (%lu us)\r\n", part_names[i],
+                          (unsigned long)(busy ? rep.part_us[i] * 100 / busy : 0),
+                          (unsigned long)rep.slowest_part_us[i]);
+    }
+
+    if (rep.num_cpu > 0) {
+        otCliOutputFormat("cpu:");
+        for (uint32_t i = 0; i < rep.num_cpu; i++) {
+            otCliOutputFormat(" %s %lu.%lu%%", rep.cpu[i].task,
+                              (unsigned long)(rep.cpu[i].permille / 10),
+                              (unsigned long)(rep.cpu[i].permille % 10));
+        }
+        otCliOutputFormat("\r\n");
+    } else {
+        otCliOutputFormat("cpu: no run time stats (build with sdkconfig.profiler)\r\n");
+    }
+    return OT_ERROR_NONE;
+}
+
+static otError cmd_status(otInstance *instance, uint8_t argc, char *argv[])
+{
+    if (argc > 0) {
+        if (strcmp(argv[0], "reset") != 0) return OT_ERROR_INVALID_ARGS;
+        ot_status_reset_stats();
+    }
+
+    /* Read the way other tasks do, to show what they see */
+    static ot_status_t status;
+    if (ot_status_read(&status)) {
+        otCliOutputFormat("snapshot %lu, %lu ms old: %s, partition 0x%08lx, rloc16 0x%04x, "
+                          "leader %u, channel %u\r\n",
+                          (unsigned long)status.version,
+                          (unsigned long)((esp_timer_get_time() - status.published_us) / 1000),
+                          otThreadDeviceRoleToString(status.role),
+                          (unsigned long)status.partition_id, status.rloc16,
+                          status.leader_router_id, status.channel);
+        otCliOutputFormat("netdata v%u/%u: %u on-mesh prefixes, %u routes; %u neighbors\r\n",
+                          status.netdata_version, status.netdata_stable_version,
+                          status.on_mesh_prefixes, status.external_routes,
+                          status.num_neighbors);
+        for (uint8_t i = 0; i < status.num_neighbors; i++) {
+            const ot_status_neighbor_t *n = &status.neighbors[i];
+            otCliOutputFormat("  0x%04x %-6s rssi avg %d last %d, lqi %u, age %lu s\r\n",
+                              n->rloc16, n->is_child ? "child" : "router", n->average_rssi,
+                              n->last_rssi, n->link_quality_in, (unsigned long)n->age_s);
+        }
+    }
+
+    ot_status_stats_t st;
+    ot_status_get_stats(&st);
+
+    otCliOutputFormat("publishes %lu (%lu with table walks): avg %lu us, max %lu us; "
+                      "reads %lu (retried %lu)\r\n",
+                      (unsigned long)st.publishes, (unsigned long)st.table_walks,
+                      (unsigned long)(st.publishes ? st.publish_us / st.publishes : 0),
+                      (unsigned long)st.publish_max_us, (unsigned long)st.reads,
+                      (unsigned long)st.read_retries);
+    otCliOutputFormat("lock holds by other tasks:\r\n");
+    for (uint32_t i = 0; i < st.num_tasks; i++) {
+        const ot_status_lock_task_t *t = &st.tasks[i];
+        otCliOutputFormat("  %-12s %6lu holds, total %llu us, max %lu us, waited %llu us, "
+                          "timeouts %lu\r\n",
+                          t->task, (unsigned long)t->holds, (unsigned long long)t->hold_us,
+                          (unsigned long)t->hold_max_us, (unsigned long long)t->wait_us,
+                          (unsigned long)t->timeouts);
+    }
+    return OT_ERROR_NONE;
+}
+
+static const otbr_cmd_t s_commands[] = {
+    { "burst",      "<ipv6-addr> [count] [size]",                  cmd_burst },
+    { "capture",    "[start udp|tcp <addr> <port> [filter]|stop]", cmd_capture },
+    { "channel",    "[scan|migrate [channel]]",                    cmd_channel },
+    { "coex",       "[auto|balanced|thread|thread-max]",           cmd_coex },
+    { "commission", "[start [pskd [minutes]]|stop|bench <count>]", cmd_commission },
+    { "dns",        "[flush]",                                     cmd_dns },
+    { "log",        "[udp <addr> <port>|udp off]",                 cmd_log },
+    { "mcast",      "[off|filter|unicast]",                        cmd_mcast },
+    { "mem",        "[soak <minutes> [ipv6-addr]|soak stop]",      cmd_mem },
+    { "nat64",      "[stress <ipv4> <port> <flows>|stress clear]", cmd_nat64 },
+    { "power",      "[low-latency|adaptive|power-save]",           cmd_power },
+    { "profile",    "[start|stop]",                                cmd_profile },
+    { "route",      "[auto|off|high|medium|low]",                  cmd_route },
+    { "settings",   "",                                            cmd_settings },
+    { "srp",        "[bench <count>|bench clear]",                 cmd_srp },
+    { "status",     "[reset]",                                     cmd_status },
+    { "help",       "",                                            cmd_help },
+};
+
+static otError cmd_help(otInstance *instance, uint8_t argc, char *argv[])
+{
+    for (size_t i = 0; i < sizeof(s_commands) / sizeof(s_commands[0]); i++) {
+        otCliOutputFormat("otbr %s %s\r\n", s_commands[i].name, s_commands[i].usage);
+    }
+    return OT_ERROR_NONE;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Dispatch                                                           */
+/* ------------------------------------------------------------------ */
+
+static otError otbr_command(void *context, uint8_t argc, char *argv[])
+{
+    otInstance *instance = (otInstance *)context;
+
+    if (argc == 0) return cmd_help(instance, 0, NULL);
+
+    for (size_t i = 0; i < sizeof(s_commands) / sizeof(s_commands[0]); i++) {
+        if (strcmp(argv[0], s_commands[i].name) == 0) {
+            return s_commands[i].handler(instance, argc - 1, &argv[1]);
+        }
+    }
+    return OT_ERROR_INVALID_COMMAND;
+}
+
+static const otCliCommand s_user_commands[] = {
+    { "otbr", otbr_command },
+};
+
+void otbr_cli_init(otInstance *instance)
+{
+    otCliSetUserCommands(s_user_commands,
+                         sizeof(s_user_commands) / sizeof(s_user_commands[0]),
+                         instance);
+}
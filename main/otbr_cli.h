@@ -0,0 +1,18 @@
+/*
+ * "otbr" OpenThread CLI command family
+ *
+ * Firmware-specific diagnostics and tools, reachable from the serial
+ * console when OT_CLI_UART_ENABLE is set:
+ *
+ *   > otbr help
+ */
+
+#ifndef OTBR_CLI_H
+#define OTBR_CLI_H
+
+#include "openthread/instance.h"
+
+/** Register the "otbr" user command (after esp_openthread_cli_init()). */
+void otbr_cli_init(otInstance *instance);
+
+#endif /* OTBR_CLI_H */
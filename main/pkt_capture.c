@@ -0,0 +1,649 @@
+/*
+ * On-device packet capture — see pkt_capture.h
+ */
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/inet.h"
+#include "lwip/sockets.h"
+
+#include "config.h"
+#include "pkt_capture.h"
+
+static const char *TAG = "pkt_capture";
+
+_Static_assert((CAPTURE_SLOTS & (CAPTURE_SLOTS - 1)) == 0,
+               "CAPTURE_SLOTS must be a power of two");
+
+#define WRITER_POLL_MS          10
+#define STREAM_BUF_MAX          1400    /* one UDP datagram */
+#define HEADER_REPEAT_US        (5 * 1000000LL)
+#define SEND_TIMEOUT_MS         1000
+
+/* pcapng (draft-ietf-opsawg-pcapng) */
+#define BLOCK_SHB               0x0A0D0D0Au
+#define BLOCK_IDB               0x00000001u
+#define BLOCK_EPB               0x00000006u
+#define BYTE_ORDER_MAGIC        0x1A2B3C4Du
+#define LINKTYPE_ETHERNET       1
+#define LINKTYPE_RAW            101     /* bare IPv4/IPv6 */
+#define OPT_END                 0
+#define OPT_IF_NAME             2
+#define OPT_EPB_FLAGS           2
+#define EPB_FLAG_INBOUND        1
+#define EPB_FLAG_OUTBOUND       2
+
+#define IFACE_WIFI              0       /* pcapng interface ids */
+#define IFACE_THREAD            1
+
+#define EPB_MAX_LEN             (32 + ((CAPTURE_SNAPLEN + 3) & ~3) + 12)
+_Static_assert(EPB_MAX_LEN <= STREAM_BUF_MAX, "CAPTURE_SNAPLEN too large for a datagram");
+
+#define ETHERTYPE_IP            0x0800
+#define ETHERTYPE_ARP           0x0806
+#define ETHERTYPE_IPV6          0x86DD
+#define PROTO_ICMP              1
+#define PROTO_TCP               6
+#define PROTO_UDP               17
+#define PROTO_ICMP6             58
+
+/* Bounded multi-producer queue (Vyukov), as in log_ring.c: a slot's seq
+ * is its position while free and position + 1 once written.           */
+typedef struct {
+    atomic_uint seq;
+    int64_t time_us;            /* esp_timer */
+    uint16_t len;               /* on the wire */
+    uint16_t caplen;
+    uint8_t iface;
+    uint8_t outbound;
+    uint8_t data[CAPTURE_SNAPLEN];
+} slot_t;
+
+typedef enum {
+    TERM_WIFI,
+    TERM_THREAD,
+    TERM_IN,
+    TERM_OUT,
+    TERM_ETHERTYPE,
+    TERM_PROTO,
+    TERM_PORT,
+    TERM_HOST,
+} term_kind_t;
+
+typedef struct {
+    term_kind_t kind;
+    bool negate;
+    uint16_t value;             /* ethertype, IP protocol or port     */
+    uint8_t family;             /* TERM_HOST: 4 or 6                  */
+    uint8_t addr[16];
+} term_t;
+
+/* What the filter looks at, parsed from the headers */
+typedef struct {
+    uint16_t ethertype;
+    uint8_t proto;              /* 0: unknown / not IP                */
+    uint8_t family;             /* 4 or 6; 0 when not IP              */
+    const uint8_t *src;
+    const uint8_t *dst;
+    bool has_ports;
+    uint16_t sport;
+    uint16_t dport;
+} pkt_info_t;
+
+static slot_t *s_slots;
+static atomic_uint s_head;
+static uint32_t s_tail;                 /* writer task only */
+static TaskHandle_t s_task;
+
+/* Filter and stream target: written by pkt_capture_start() only while no
+ * capture is running, read by producers and the writer while one is.  */
+static atomic_bool s_active;
+static term_t s_terms[PKT_CAPTURE_MAX_TERMS];
+static uint32_t s_num_terms;
+static uint16_t s_stream_port;
+static struct sockaddr_storage s_dest;
+static pkt_capture_transport_t s_transport;
+
+/* Producer counters: any task, no lock */
+static atomic_uint s_captured;
+static atomic_uint s_filtered;
+static atomic_uint s_dropped;
+
+/* Writer statistics (s_lock) */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static pkt_capture_stats_t s_stats;
+
+/* ------------------------------------------------------------------ */
+/*  Filter                                                             */
+/* ------------------------------------------------------------------ */
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static void parse(bool backbone, const uint8_t *p, size_t len, pkt_info_t *pi)
+{
+    memset(pi, 0, sizeof(*pi));
+
+    if (backbone) {
+        if (len < 14) return;
+        pi->ethertype = get16(p + 12);
+        p += 14;
+        len -= 14;
+    } else if (len > 0) {
+        pi->ethertype = (p[0] >> 4) == 6 ? ETHERTYPE_IPV6 : (p[0] >> 4) == 4 ? ETHERTYPE_IP : 0;
+    }
+
+    size_t off;
+    uint8_t proto;
+    if (pi->ethertype == ETHERTYPE_IPV6 && len >= 40) {
+        pi->family = 6;
+        pi->src = p + 8;
+        pi->dst = p + 24;
+        proto = p[6];
+        off = 40;
+        /* Hop-by-hop, routing and destination options; a non-first
+         * fragment has no transport header.                           */
+        for (int i = 0; i < 4 && len >= off + 8; i++) {
+            if (proto == 0 || proto == 43 || proto == 60) {
+                proto = p[off];
+                off += (size_t)(p[off + 1] + 1) * 8;
+            } else if (proto == 44) {
+                if ((get16(p + off + 2) & 0xFFF8) != 0) return;
+                proto = p[off];
+                off += 8;
+            } else {
+                break;
+            }
+        }
+    } else if (pi->ethertype == ETHERTYPE_IP && len >= 20) {
+        pi->family = 4;
+        pi->src = p + 12;
+        pi->dst = p + 16;
+        proto = p[9];
+        off = (size_t)(p[0] & 0x0F) * 4;
+        if ((get16(p + 6) & 0x1FFF) != 0) {
+            pi->proto = proto;
+            return;
+        }
+    } else {
+        return;
+    }
+
+    pi->proto = proto;
+    if ((proto == PROTO_UDP || proto == PROTO_TCP) && len >= off + 4) {
+        pi->has_ports = true;
+        pi->sport = get16(p + off);
+        pi->dport = get16(p + off + 2);
+    }
+}
+
+static bool term_match(const term_t *t, bool backbone, bool outbound, const pkt_info_t *pi)
+{
+    size_t alen = pi->family == 6 ? 16 : 4;
+
+    switch (t->kind) {
+    case TERM_WIFI:      return backbone;
+    case TERM_THREAD:    return !backbone;
+    case TERM_IN:        return !outbound;
+    case TERM_OUT:       return outbound;
+    case TERM_ETHERTYPE: return pi->ethertype == t->value;
+    case TERM_PROTO:     return pi->proto == t->value;
+    case TERM_PORT:      return pi->has_ports && (pi->sport == t->value || pi->dport == t->value);
+    case TERM_HOST:
+        return pi->family == t->family &&
+               (memcmp(pi->src, t->addr, alen) == 0 || memcmp(pi->dst, t->addr, alen) == 0);
+    }
+    return false;
+}
+
+static bool filter_match(bool backbone, bool outbound, const uint8_t *data, size_t len)
+{
+    pkt_info_t pi;
+    parse(backbone, data, len, &pi);
+
+    /* Never capture the capture stream itself */
+    if (pi.has_ports && (pi.sport == s_stream_port || pi.dport == s_stream_port)) return false;
+
+    for (uint32_t i = 0; i < s_num_terms; i++) {
+        if (term_match(&s_terms[i], backbone, outbound, &pi) == s_terms[i].negate) return false;
+    }
+    return true;
+}
+
+static esp_err_t compile(const char *filter, term_t *terms, uint32_t *num_terms)
+{
+    static const struct { const char *word; term_kind_t kind; uint16_t value; } words[] = {
+        { "wifi",   TERM_WIFI,      0 },
+        { "thread", TERM_THREAD,    0 },
+        { "in",     TERM_IN,        0 },
+        { "out",    TERM_OUT,       0 },
+        { "ip6",    TERM_ETHERTYPE, ETHERTYPE_IPV6 },
+        { "ip",     TERM_ETHERTYPE, ETHERTYPE_IP },
+        { "arp",    TERM_ETHERTYPE, ETHERTYPE_ARP },
+        { "udp",    TERM_PROTO,     PROTO_UDP },
+        { "tcp",    TERM_PROTO,     PROTO_TCP },
+        { "icmp6",  TERM_PROTO,     PROTO_ICMP6 },
+        { "icmp",   TERM_PROTO,     PROTO_ICMP },
+    };
+    char buf[128];
+    char *save = NULL;
+    bool negate = false;
+
+    *num_terms = 0;
+    if (filter == NULL) return ESP_OK;
+    if (strlcpy(buf, filter, sizeof(buf)) >= sizeof(buf)) return ESP_ERR_INVALID_ARG;
+
+    for (char *w = strtok_r(buf, " ", &save); w != NULL; w = strtok_r(NULL, " ", &save)) {
+        if (strcmp(w, "not") == 0) {
+            negate = !negate;
+            continue;
+        }
+        if (*num_terms == PKT_CAPTURE_MAX_TERMS) return ESP_ERR_INVALID_ARG;
+
+        term_t *t = &terms[*num_terms];
+        memset(t, 0, sizeof(*t));
+        t->negate = negate;
+
+        size_t i = 0;
+        while (i < sizeof(words) / sizeof(words[0]) && strcmp(w, words[i].word) != 0) i++;
+        if (i < sizeof(words) / sizeof(words[0])) {
+            t->kind = words[i].kind;
+            t->value = words[i].value;
+        } else if (strcmp(w, "port") == 0 || strcmp(w, "host") == 0) {
+            char *arg = strtok_r(NULL, " ", &save);
+            if (arg == NULL) return ESP_ERR_INVALID_ARG;
+            if (w[0] == 'p') {
+                char *end;
+                unsigned long port = strtoul(arg, &end, 10);
+                if (*end != '\0' || port == 0 || port > 65535) return ESP_ERR_INVALID_ARG;
+                t->kind = TERM_PORT;
+                t->value = (uint16_t)port;
+            } else {
+                t->kind = TERM_HOST;
+                if (inet_pton(AF_INET, arg, t->addr) == 1) {
+                    t->family = 4;
+                } else if (inet_pton(AF_INET6, arg, t->addr) == 1) {
+                    t->family = 6;
+                } else {
+                    return ESP_ERR_INVALID_ARG;
+                }
+            }
+        } else {
+            return ESP_ERR_INVALID_ARG;
+        }
+        (*num_terms)++;
+        negate = false;
+    }
+    return negate ? ESP_ERR_INVALID_ARG : ESP_OK;     /* trailing "not" */
+}
+
+/* ------------------------------------------------------------------ */
+/*  Tap (any task)                                                     */
+/* ------------------------------------------------------------------ */
+
+void pkt_capture_tap(bool backbone, bool outbound, const void *data, size_t len)
+{
+    if (!atomic_load_explicit(&s_active, memory_order_acquire)) return;
+
+    if (!filter_match(backbone, outbound, data, len)) {
+        atomic_fetch_add_explicit(&s_filtered, 1, memory_order_relaxed);
+        return;
+    }
+
+    unsigned pos = atomic_load_explicit(&s_head, memory_order_relaxed);
+    slot_t *slot;
+    for (;;) {
+        slot = &s_slots[pos & (CAPTURE_SLOTS - 1)];
+        unsigned seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int diff = (int)(seq - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&s_head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&s_head, memory_order_relaxed);
+        }
+    }
+
+    slot->time_us = esp_timer_get_time();
+    slot->iface = backbone ? IFACE_WIFI : IFACE_THREAD;
+    slot->outbound = outbound;
+    slot->len = len > UINT16_MAX ? UINT16_MAX : (uint16_t)len;
+    slot->caplen = len > CAPTURE_SNAPLEN ? CAPTURE_SNAPLEN : (uint16_t)len;
+    memcpy(slot->data, data, slot->caplen);
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    atomic_fetch_add_explicit(&s_captured, 1, memory_order_relaxed);
+}
+
+/* ------------------------------------------------------------------ */
+/*  pcapng stream (writer task)                                        */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    int sock;
+    socklen_t dest_len;
+    int64_t epoch_offset_us;    /* wall clock - esp_timer at start    */
+    size_t len;
+    uint8_t buf[STREAM_BUF_MAX];
+} stream_t;
+
+static void put32(stream_t *s, uint32_t v)
+{
+    memcpy(s->buf + s->len, &v, 4);
+    s->len += 4;
+}
+
+static void put16(stream_t *s, uint16_t v)
+{
+    memcpy(s->buf + s->len, &v, 2);
+    s->len += 2;
+}
+
+static void put_padded(stream_t *s, const void *data, size_t len)
+{
+    memcpy(s->buf + s->len, data, len);
+    s->len += len;
+    while (s->len & 3) s->buf[s->len++] = 0;
+}
+
+/* Send what is buffered; false once the collector is gone (TCP) */
+static bool stream_flush(stream_t *s)
+{
+    if (s->len == 0) return true;
+
+    bool ok;
+    if (s_transport == PKT_CAPTURE_TCP) {
+        size_t done = 0;
+        while (done < s->len) {
+            ssize_t n = send(s->sock, s->buf + done, s->len - done, 0);
+            if (n <= 0) break;
+            done += (size_t)n;
+        }
+        ok = done == s->len;
+    } else {
+        ok = sendto(s->sock, s->buf, s->len, MSG_DONTWAIT, (struct sockaddr *)&s_dest,
+                    s->dest_len) == (ssize_t)s->len;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    if (ok) {
+        s_stats.bytes += s->len;
+    } else {
+        s_stats.send_errors++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    s->len = 0;
+    return ok || s_transport == PKT_CAPTURE_UDP;
+}
+
+static bool stream_reserve(stream_t *s, size_t len)
+{
+    return s->len + len <= sizeof(s->buf) || stream_flush(s);
+}
+
+static void put_idb(stream_t *s, uint16_t linktype, const char *name)
+{
+    size_t name_len = strlen(name);
+    uint32_t total = 20 + 4 + ((name_len + 3) & ~3u) + 4;
+
+    put32(s, BLOCK_IDB);
+    put32(s, total);
+    put16(s, linktype);
+    put16(s, 0);
+    put32(s, CAPTURE_SNAPLEN);
+    put16(s, OPT_IF_NAME);
+    put16(s, (uint16_t)name_len);
+    put_padded(s, name, name_len);
+    put16(s, OPT_END);
+    put16(s, 0);
+    put32(s, total);
+}
+
+/* Section header and both interfaces: a collector can start reading here */
+static bool put_headers(stream_t *s)
+{
+    if (!stream_reserve(s, 28 + 2 * 36)) return false;
+
+    put32(s, BLOCK_SHB);
+    put32(s, 28);
+    put32(s, BYTE_ORDER_MAGIC);
+    put16(s, 1);                        /* version 1.0 */
+    put16(s, 0);
+    put32(s, 0xFFFFFFFFu);              /* section length unknown */
+    put32(s, 0xFFFFFFFFu);
+    put32(s, 28);
+
+    put_idb(s, LINKTYPE_ETHERNET, "wifi");
+    put_idb(s, LINKTYPE_RAW, "thread");
+    return true;
+}
+
+static bool put_epb(stream_t *s, const slot_t *slot)
+{
+    uint32_t padded = (slot->caplen + 3) & ~3u;
+    uint32_t total = 28 + padded + 12 + 4;
+    uint64_t ts = (uint64_t)(slot->time_us + s->epoch_offset_us);
+
+    if (!stream_reserve(s, total)) return false;
+
+    put32(s, BLOCK_EPB);
+    put32(s, total);
+    put32(s, slot->iface);
+    put32(s, (uint32_t)(ts >> 32));
+    put32(s, (uint32_t)ts);
+    put32(s, slot->caplen);
+    put32(s, slot->len);
+    put_padded(s, slot->data, slot->caplen);
+    put16(s, OPT_EPB_FLAGS);
+    put16(s, 4);
+    put32(s, slot->outbound ? EPB_FLAG_OUTBOUND : EPB_FLAG_INBOUND);
+    put16(s, OPT_END);
+    put16(s, 0);
+    put32(s, total);
+    return true;
+}
+
+static bool stream_open(stream_t *s)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    s->epoch_offset_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - esp_timer_get_time();
+    s->len = 0;
+    s->dest_len = s_dest.ss_family == AF_INET6 ? sizeof(struct sockaddr_in6)
+                                               : sizeof(struct sockaddr_in);
+
+    s->sock = socket(s_dest.ss_family,
+                     s_transport == PKT_CAPTURE_TCP ? SOCK_STREAM : SOCK_DGRAM, 0);
+    if (s->sock < 0) return false;
+    if (s_transport == PKT_CAPTURE_UDP) return true;
+
+    struct timeval timeout = { .tv_sec = SEND_TIMEOUT_MS / 1000,
+                               .tv_usec = (SEND_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(s->sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (connect(s->sock, (struct sockaddr *)&s_dest, s->dest_len) != 0) {
+        close(s->sock);
+        s->sock = -1;
+        return false;
+    }
+    return true;
+}
+
+/* Stream queued records; false if the collector went away */
+static bool drain(stream_t *s)
+{
+    uint32_t used = atomic_load_explicit(&s_head, memory_order_relaxed) - s_tail;
+    taskENTER_CRITICAL(&s_lock);
+    if (used > s_stats.max_used) s_stats.max_used = used;
+    taskEXIT_CRITICAL(&s_lock);
+
+    for (;;) {
+        slot_t *slot = &s_slots[s_tail & (CAPTURE_SLOTS - 1)];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != s_tail + 1) break;
+
+        bool ok = put_epb(s, slot);
+        atomic_store_explicit(&slot->seq, s_tail + CAPTURE_SLOTS, memory_order_release);
+        s_tail++;
+        if (!ok) return false;
+
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.sent++;
+        taskEXIT_CRITICAL(&s_lock);
+    }
+    return stream_flush(s);
+}
+
+static void set_streaming(bool streaming)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.streaming = streaming;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static void writer_task(void *arg)
+{
+    static stream_t stream = { .sock = -1 };
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);    /* pkt_capture_start() */
+
+        if (!stream_open(&stream)) {
+            ESP_LOGW(TAG, "Cannot reach the capture collector");
+            atomic_store(&s_active, false);
+            set_streaming(false);
+            continue;
+        }
+
+        bool ok = true;
+        int64_t headers_us = 0;
+        while (ok && atomic_load(&s_active)) {
+            /* UDP may lose datagrams: repeat the headers so the stream
+             * can be parsed again from the next one                   */
+            int64_t now = esp_timer_get_time();
+            if (headers_us == 0 ||
+                (s_transport == PKT_CAPTURE_UDP && now - headers_us >= HEADER_REPEAT_US)) {
+                ok = put_headers(&stream);
+                headers_us = now;
+            }
+            ok = ok && drain(&stream);
+            if (ok) vTaskDelay(pdMS_TO_TICKS(WRITER_POLL_MS));
+        }
+
+        if (ok) {
+            drain(&stream);
+        } else {
+            ESP_LOGW(TAG, "Capture collector closed the connection, stopping");
+            atomic_store(&s_active, false);
+            /* Throw away what producers queued meanwhile */
+            while (atomic_load_explicit(&s_slots[s_tail & (CAPTURE_SLOTS - 1)].seq,
+                                        memory_order_acquire) == s_tail + 1) {
+                atomic_store_explicit(&s_slots[s_tail & (CAPTURE_SLOTS - 1)].seq,
+                                      s_tail + CAPTURE_SLOTS, memory_order_release);
+                s_tail++;
+            }
+        }
+        close(stream.sock);
+        stream.sock = -1;
+        set_streaming(false);
+        ESP_LOGI(TAG, "Capture stopped");
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Control                                                            */
+/* ------------------------------------------------------------------ */
+
+esp_err_t pkt_capture_start(pkt_capture_transport_t transport, const char *addr, uint16_t port,
+                            const char *filter)
+{
+    struct sockaddr_storage dest = { 0 };
+    struct sockaddr_in *in = (struct sockaddr_in *)&dest;
+    struct sockaddr_in6 *in6 = (struct sockaddr_in6 *)&dest;
+
+    if (port == 0) return ESP_ERR_INVALID_ARG;
+    if (inet_pton(AF_INET, addr, &in->sin_addr) == 1) {
+        in->sin_family = AF_INET;
+        in->sin_port = htons(port);
+    } else if (inet_pton(AF_INET6, addr, &in6->sin6_addr) == 1) {
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons(port);
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    term_t terms[PKT_CAPTURE_MAX_TERMS];
+    uint32_t num_terms;
+    esp_err_t err = compile(filter, terms, &num_terms);
+    if (err != ESP_OK) return err;
+
+    taskENTER_CRITICAL(&s_lock);
+    bool busy = atomic_load(&s_active) || s_stats.streaming;
+    if (!busy) s_stats.streaming = true;
+    taskEXIT_CRITICAL(&s_lock);
+    if (busy) return ESP_ERR_INVALID_STATE;
+
+    if (s_slots == NULL) {
+        s_slots = calloc(CAPTURE_SLOTS, sizeof(*s_slots));
+        if (s_slots != NULL) {
+            for (unsigned i = 0; i < CAPTURE_SLOTS; i++) atomic_init(&s_slots[i].seq, i);
+        }
+    }
+    if (s_slots != NULL && s_task == NULL &&
+        xTaskCreate(writer_task, "pkt_capture", 3072, NULL, 1, &s_task) != pdPASS) {
+        s_task = NULL;
+    }
+    if (s_slots == NULL || s_task == NULL) {
+        set_streaming(false);
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* Producers only read these while s_active is set */
+    memcpy(s_terms, terms, sizeof(terms));
+    s_num_terms = num_terms;
+    s_stream_port = port;
+    s_dest = dest;
+    s_transport = transport;
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.transport = transport;
+    taskEXIT_CRITICAL(&s_lock);
+
+    atomic_store_explicit(&s_active, true, memory_order_release);
+    xTaskNotifyGive(s_task);
+    ESP_LOGI(TAG, "Capturing%s%s to %s port %u over %s", num_terms ? " " : "",
+             num_terms ? filter : "", addr, port, transport == PKT_CAPTURE_TCP ? "TCP" : "UDP");
+    return ESP_OK;
+}
+
+void pkt_capture_stop(void)
+{
+    atomic_store(&s_active, false);
+}
+
+void pkt_capture_get_stats(pkt_capture_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+
+    stats->active = atomic_load(&s_active);
+    stats->captured = atomic_load_explicit(&s_captured, memory_order_relaxed);
+    stats->filtered = atomic_load_explicit(&s_filtered, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&s_dropped, memory_order_relaxed);
+}
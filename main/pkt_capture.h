@@ -0,0 +1,80 @@
+/*
+ * On-device packet capture
+ *
+ * Taps both interfaces where netif_hooks.c sees them — the Wi-Fi
+ * backbone (Ethernet frames) and the OpenThread netif (IPv6 packets),
+ * each direction — so forwarding between them can be debugged without
+ * a separate sniffer.  Packets that pass the filter are stamped with
+ * esp_timer microseconds and copied (first CAPTURE_SNAPLEN bytes) into
+ * a lock-free ring of CAPTURE_SLOTS records in the calling task; a
+ * low-priority task streams them as pcapng to a collector on the
+ * backbone over UDP (blocks batched into datagrams, headers repeated
+ * every few seconds so a collector can join late) or TCP.  A full ring
+ * drops packets and counts them.
+ *
+ * Filters are BPF-like primitives, all of which must match:
+ *
+ *   wifi | thread        interface
+ *   in | out             direction (to lwIP / to the driver)
+ *   ip6 | ip | arp       network protocol
+ *   udp | tcp | icmp6 | icmp
+ *   port <n>             source or destination port
+ *   host <addr>          IPv4 or IPv6 source or destination
+ *
+ * each optionally preceded by "not", e.g. "thread udp not port 5353".
+ * The stream's own port is never captured.  Forwarding delay per packet
+ * is the time between a packet's "in" record on one interface and its
+ * "out" record on the other; tools/capture_collector.py matches them.
+ */
+
+#ifndef PKT_CAPTURE_H
+#define PKT_CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define PKT_CAPTURE_MAX_TERMS   8
+
+typedef enum {
+    PKT_CAPTURE_UDP = 0,
+    PKT_CAPTURE_TCP,
+} pkt_capture_transport_t;
+
+typedef struct {
+    bool active;
+    bool streaming;             /* writer connected / sending         */
+    pkt_capture_transport_t transport;
+    uint32_t captured;          /* records queued                     */
+    uint32_t filtered;          /* packets the filter rejected        */
+    uint32_t dropped;           /* ring full                          */
+    uint32_t max_used;          /* high-water mark of occupied slots  */
+    uint32_t sent;              /* records streamed                   */
+    uint64_t bytes;             /* pcapng bytes streamed              */
+    uint32_t send_errors;
+} pkt_capture_stats_t;
+
+/**
+ * Start capturing packets matching filter ("" or NULL: everything) and
+ * streaming them to addr (IPv4 or IPv6 literal) port.
+ * ESP_ERR_INVALID_ARG for a bad address or filter, ESP_ERR_INVALID_STATE
+ * while a capture is running or still being flushed, ESP_ERR_NO_MEM.
+ */
+esp_err_t pkt_capture_start(pkt_capture_transport_t transport, const char *addr, uint16_t port,
+                            const char *filter);
+
+/** Stop capturing; records already queued are still sent. */
+void pkt_capture_stop(void);
+
+void pkt_capture_get_stats(pkt_capture_stats_t *stats);
+
+/**
+ * Called by netif_hooks.c for every frame: backbone (Ethernet) or
+ * Thread (IPv6), outbound (lwIP → driver) or inbound.  Returns at once
+ * while no capture is running.
+ */
+void pkt_capture_tap(bool backbone, bool outbound, const void *data, size_t len);
+
+#endif /* PKT_CAPTURE_H */
@@ -0,0 +1,264 @@
+/*
+ * Health-based route preference — see route_health.h
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_openthread_task_queue.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+#include "openthread/border_router.h"
+
+#include "config.h"
+#include "coex_ctrl.h"
+#include "metrics.h"
+#include "ot_status.h"
+#include "route_health.h"
+
+static const char *TAG = "route_health";
+
+/* Component ranges: full marks at the first value, none at the second */
+#define RSSI_GOOD_DBM           (-50)
+#define RSSI_BAD_DBM            (-85)
+#define RETRY_BAD_PM            300
+#define BUFFERS_BUSY_PCT        50      /* in use before the score drops */
+#define HEAP_GOOD_BYTES         (64 * 1024)
+#define HEAP_BAD_BYTES          (16 * 1024)
+
+/* Weights of backbone, retries, queues, heap (sum 100) */
+#define WEIGHT_BACKBONE         40
+#define WEIGHT_RETRIES          20
+#define WEIGHT_QUEUES           25
+#define WEIGHT_HEAP             15
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static route_health_stats_t s_stats = {
+    .adaptive = ROUTE_HEALTH_ADAPT,
+    .preference = OT_ROUTE_PREFERENCE_MED,
+};
+static otInstance *s_instance;
+static TaskHandle_t s_task;
+static int64_t s_changed_us;
+static bool s_published;        /* a preference of ours is set in OpenThread */
+
+/* Sampler's copy of the OpenThread snapshot (too big for its stack)  */
+static ot_status_t s_status;
+
+const char *route_health_preference_name(otRoutePreference preference)
+{
+    switch (preference) {
+    case OT_ROUTE_PREFERENCE_HIGH: return "high";
+    case OT_ROUTE_PREFERENCE_LOW:  return "low";
+    default:                       return "medium";
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Publishing (mainloop)                                              */
+/* ------------------------------------------------------------------ */
+
+static void apply_tasklet(void *arg)
+{
+    otRoutePreference preference = (otRoutePreference)(intptr_t)arg;
+    otBorderRoutingSetRoutePreference(s_instance, preference);
+}
+
+static void clear_tasklet(void *arg)
+{
+    otBorderRoutingClearRoutePreference(s_instance);
+}
+
+static void apply_preference(otRoutePreference preference, const char *reason)
+{
+    taskENTER_CRITICAL(&s_lock);
+    bool same = s_published && preference == s_stats.preference;
+    taskEXIT_CRITICAL(&s_lock);
+    if (same) return;
+
+    if (esp_openthread_task_queue_post(apply_tasklet, (void *)(intptr_t)preference) != ESP_OK) {
+        return;                 /* queue full: next sample tries again */
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.preference = preference;
+    s_stats.changes++;
+    s_published = true;
+    taskEXIT_CRITICAL(&s_lock);
+    s_changed_us = esp_timer_get_time();
+
+    ESP_LOGI(TAG, "Route preference %s (%s)", route_health_preference_name(preference), reason);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Scoring                                                            */
+/* ------------------------------------------------------------------ */
+
+/* 100 at good, 0 at bad, linear between (either direction) */
+static uint32_t scale(int32_t value, int32_t good, int32_t bad)
+{
+    if (good > bad ? value >= good : value <= good) return 100;
+    if (good > bad ? value <= bad : value >= bad) return 0;
+    return (uint32_t)((value - bad) * 100 / (good - bad));
+}
+
+/* Preference for score, given the current one: a boundary is only
+ * crossed ROUTE_HEALTH_BAND past it                                   */
+static otRoutePreference choose(uint32_t score, otRoutePreference current)
+{
+    uint32_t high = ROUTE_HEALTH_HIGH;
+    uint32_t low = ROUTE_HEALTH_LOW;
+
+    if (current == OT_ROUTE_PREFERENCE_HIGH) {
+        high -= ROUTE_HEALTH_BAND;
+    } else {
+        high += ROUTE_HEALTH_BAND;
+    }
+    if (current == OT_ROUTE_PREFERENCE_LOW) {
+        low += ROUTE_HEALTH_BAND;
+    } else {
+        low -= ROUTE_HEALTH_BAND;
+    }
+
+    if (score >= high) return OT_ROUTE_PREFERENCE_HIGH;
+    if (score < low) return OT_ROUTE_PREFERENCE_LOW;
+    return OT_ROUTE_PREFERENCE_MED;
+}
+
+static void route_health_task(void *arg)
+{
+    uint32_t prev_drops = metrics_task_queue_drops();
+    uint32_t smoothed = 0;              /* score x4: a quarter of each new sample */
+    bool first = true;
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(ROUTE_HEALTH_SAMPLE_MS));
+
+        route_health_stats_t sample = { 0 };
+
+        wifi_ap_record_t ap;
+        bool connected = esp_wifi_sta_get_ap_info(&ap) == ESP_OK;
+        sample.rssi = connected ? ap.rssi : 0;
+        sample.backbone = connected ? scale(ap.rssi, RSSI_GOOD_DBM, RSSI_BAD_DBM) : 0;
+
+        coex_ctrl_stats_t coex;
+        coex_ctrl_get_stats(&coex);
+        sample.retries = scale((int32_t)coex.retry_pm, 0, RETRY_BAD_PM);
+
+        uint32_t drops = metrics_task_queue_drops();
+        sample.queues = 100;
+        if (drops != prev_drops) {
+            sample.queues = 0;
+        } else if (ot_status_read(&s_status) && s_status.buffers.mTotalBuffers > 0) {
+            const otBufferInfo *b = &s_status.buffers;
+            int32_t used_pct = (b->mTotalBuffers - b->mFreeBuffers) * 100 / b->mTotalBuffers;
+            sample.queues = scale(used_pct, BUFFERS_BUSY_PCT, 100);
+        }
+        prev_drops = drops;
+
+        sample.heap = scale((int32_t)esp_get_free_heap_size(), HEAP_GOOD_BYTES, HEAP_BAD_BYTES);
+
+        uint32_t score = (sample.backbone * WEIGHT_BACKBONE + sample.retries * WEIGHT_RETRIES +
+                          sample.queues * WEIGHT_QUEUES + sample.heap * WEIGHT_HEAP) / 100;
+        smoothed = smoothed - smoothed / 4 + score;
+        /* Losing the backbone counts at once, not over a few samples */
+        if (first || !connected) smoothed = score * 4;
+        first = false;
+
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.score = smoothed / 4;
+        s_stats.backbone = sample.backbone;
+        s_stats.retries = sample.retries;
+        s_stats.queues = sample.queues;
+        s_stats.heap = sample.heap;
+        s_stats.rssi = sample.rssi;
+        sample.adaptive = s_stats.adaptive;
+        sample.preference = s_stats.preference;
+        taskEXIT_CRITICAL(&s_lock);
+
+        if (!sample.adaptive) continue;
+
+        /* Without a backbone the route leads nowhere, whatever the rest
+         * of the score says                                           */
+        otRoutePreference want = connected ? choose(smoothed / 4, sample.preference)
+                                           : OT_ROUTE_PREFERENCE_LOW;
+        bool held = esp_timer_get_time() - s_changed_us < (int64_t)ROUTE_HEALTH_HOLD_S * 1000000;
+        if (want != sample.preference && (!held || !connected)) {
+            apply_preference(want, connected ? "health score" : "backbone down");
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Control / metrics                                                  */
+/* ------------------------------------------------------------------ */
+
+static void write_metrics(metrics_writer_t *w)
+{
+    route_health_stats_t st;
+    route_health_get_stats(&st);
+
+    metrics_gauge(w, "otbr_route_health_score", "Border router health score (0-100, smoothed)",
+                  st.score);
+    metrics_header(w, "otbr_route_health_component", "gauge",
+                   "Last health sample by component (0-100)");
+    metrics_sample(w, "otbr_route_health_component", "component=\"backbone\"", st.backbone);
+    metrics_sample(w, "otbr_route_health_component", "component=\"retries\"", st.retries);
+    metrics_sample(w, "otbr_route_health_component", "component=\"queues\"", st.queues);
+    metrics_sample(w, "otbr_route_health_component", "component=\"heap\"", st.heap);
+    metrics_gauge(w, "otbr_route_preference",
+                  "Published route preference (0 low, 1 medium, 2 high)",
+                  (uint64_t)(st.preference + 1));
+    metrics_counter(w, "otbr_route_preference_changes_total", "Route preference changes",
+                    st.changes);
+}
+
+void route_health_set_mode(bool adaptive, otRoutePreference preference)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.adaptive = adaptive;
+    s_stats.pinned = !adaptive;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (!adaptive) apply_preference(preference, "pinned");
+}
+
+void route_health_release(void)
+{
+    if (esp_openthread_task_queue_post(clear_tasklet, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "Task queue full, route preference not handed back");
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.adaptive = false;
+    s_stats.pinned = false;
+    s_stats.preference = OT_ROUTE_PREFERENCE_MED;
+    s_published = false;
+    taskEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Route preference left to OpenThread");
+}
+
+void route_health_start(otInstance *instance)
+{
+    if (s_task != NULL) return;
+
+    s_instance = instance;
+    metrics_register_source(write_metrics);
+    xTaskCreate(route_health_task, "route_health", 3072, NULL, 3, &s_task);
+
+    if (!ROUTE_HEALTH_ADAPT) route_health_release();
+}
+
+void route_health_get_stats(route_health_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,71 @@
+/*
+ * Health-based route preference
+ *
+ * With several of these boards on one Thread network every border
+ * router publishes its routes (OMR prefix, external routes) with the
+ * same preference, so Thread devices pick one regardless of how well it
+ * is connected.  Every ROUTE_HEALTH_SAMPLE_MS this module scores the
+ * router from 0 to 100:
+ *
+ *   backbone     Wi-Fi RSSI of the AP; -50 dBm or better is full marks,
+ *                -85 dBm or a lost connection none              40 %
+ *   retries      802.15.4 MAC retry rate (coex_ctrl's sample)   20 %
+ *   queues       OpenThread message buffers in use, and any
+ *                task-queue drops since the last sample         25 %
+ *   heap         free heap; 64 KB or more is full marks         15 %
+ *
+ * smooths the score, and publishes it as the route preference in the
+ * network data: high above ROUTE_HEALTH_HIGH, low below ROUTE_HEALTH_LOW,
+ * medium between.  Each boundary has a hysteresis band and a change is
+ * held for at least ROUTE_HEALTH_HOLD_S, so network data doesn't churn.
+ * Losing the backbone publishes low at once, whatever the score.  Traffic then prefers the
+ * best-connected router.
+ */
+
+#ifndef ROUTE_HEALTH_H
+#define ROUTE_HEALTH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "openthread/instance.h"
+#include "openthread/netdata.h"
+
+#define ROUTE_HEALTH_SAMPLE_MS  10000
+#define ROUTE_HEALTH_HIGH       70
+#define ROUTE_HEALTH_LOW        40
+#define ROUTE_HEALTH_BAND       5       /* hysteresis either side */
+
+typedef struct {
+    bool adaptive;              /* preference follows the score        */
+    bool pinned;                /* from the CLI; neither: OpenThread's */
+    otRoutePreference preference;
+    uint32_t changes;
+    uint32_t score;             /* smoothed, 0..100                    */
+    /* Last sample, each 0..100 */
+    uint32_t backbone;
+    uint32_t retries;
+    uint32_t queues;
+    uint32_t heap;
+    int8_t rssi;                /* 0 when not connected                */
+} route_health_stats_t;
+
+/**
+ * Start scoring and publishing.  Call once border routing is
+ * initialized.  With ROUTE_HEALTH_ADAPT 0 the score is still kept but
+ * the preference is left to OpenThread (cleared) until set from the CLI.
+ */
+void route_health_start(otInstance *instance);
+
+/** Pin a preference (adaptive = false) or follow the score again. */
+void route_health_set_mode(bool adaptive, otRoutePreference preference);
+
+/** Stop adapting and clear the preference, so OpenThread picks its own. */
+void route_health_release(void);
+
+void route_health_get_stats(route_health_stats_t *stats);
+
+/** "high", "medium" or "low". */
+const char *route_health_preference_name(otRoutePreference preference);
+
+#endif /* ROUTE_HEALTH_H */
@@ -0,0 +1,897 @@
+/*
+ * SRP → mDNS advertising proxy — see srp_mdns.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "mdns.h"
+
+#include "openthread/dns.h"
+#include "openthread/srp_server.h"
+#include "openthread/thread.h"
+
+#include "config.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "srp_mdns.h"
+
+static const char *TAG = "srp_mdns";
+
+/* The mDNS responder's own limit (at most 64); our tables are twice
+ * that, so probe sequences stay short even when full.                 */
+#define MAX_SERVICES            CONFIG_MDNS_MAX_SERVICES
+#define TABLE_SIZE              (2 * MAX_SERVICES)
+
+#define LABEL_MAX               64      /* DNS label + NUL */
+#define SERVICE_MAX             24      /* "_matterc", "_tcp", subtypes */
+#define PROTO_MAX               5
+#define HOST_ADDRS_MAX          4
+#define SUBTYPES_MAX            4
+#define UPDATE_IDS_MAX          4       /* SRP updates answered by one snapshot */
+#define TXT_ITEMS_MAX           32
+#define TXT_BUF_SIZE            768     /* keys and values, NUL-terminated */
+
+#define BENCH_HOST_PREFIX       "otbrbench-"
+
+#define FNV_INIT                2166136261u
+
+/* Removed entry in an open-addressed table */
+#define TOMBSTONE               ((void *)1)
+
+typedef struct {
+    char instance[LABEL_MAX];
+    char service[SERVICE_MAX];
+    char proto[PROTO_MAX];
+    char subtypes[SUBTYPES_MAX][SERVICE_MAX];
+    uint8_t num_subtypes;
+    bool deleted;
+    uint16_t port;
+    uint16_t txt_len;
+    uint8_t *txt;
+} svc_snap_t;
+
+/* Copy of an SRP host update, taken on the mainloop */
+typedef struct host_snap {
+    struct host_snap *next;
+    char name[LABEL_MAX];
+    bool deleted;
+    uint8_t num_addrs;
+    otIp6Address addrs[HOST_ADDRS_MAX];
+    int64_t received_us;
+    uint16_t num_services;
+    svc_snap_t *services;
+    /* SRP updates to answer once published; none for benchmark hosts */
+    uint8_t num_ids;
+    otSrpServerServiceUpdateId ids[UPDATE_IDS_MAX];
+} host_snap_t;
+
+typedef struct {
+    char name[LABEL_MAX];
+    uint32_t addr_hash;
+    uint16_t num_services;
+} pub_host_t;
+
+typedef struct {
+    char instance[LABEL_MAX];
+    char service[SERVICE_MAX];
+    char proto[PROTO_MAX];
+    uint32_t content_hash;      /* port, TXT and subtypes */
+    pub_host_t *host;
+} pub_service_t;
+
+/* Entries and queued updates come from fixed pools (mem_pool.h) */
+MEM_POOL_DEFINE(s_host_pool, "srp_host", sizeof(pub_host_t), MEM_POOL_SRP_HOSTS);
+MEM_POOL_DEFINE(s_service_pool, "srp_service", sizeof(pub_service_t), MEM_POOL_SRP_SERVICES);
+MEM_POOL_DEFINE(s_update_pool, "srp_update", sizeof(host_snap_t), MEM_POOL_SRP_UPDATES);
+/* Every published host has a service, and the responder caps services
+ * (leaving room for the border router's own)                          */
+_Static_assert(MEM_POOL_SRP_HOSTS <= MEM_POOL_SRP_SERVICES &&
+               MEM_POOL_SRP_SERVICES + 4 <= MAX_SERVICES,
+               "MEM_POOL_SRP_* don't fit CONFIG_MDNS_MAX_SERVICES");
+_Static_assert(MEM_POOL_SRP_UPDATES <= MEM_POOL_SRP_HOSTS, "more queued updates than hosts");
+_Static_assert(SRP_MDNS_BENCH_MAX <= MEM_POOL_SRP_SERVICES, "bench hosts don't fit the pools");
+
+/* Published state — only touched by the publisher task */
+static pub_host_t *s_hosts[TABLE_SIZE];
+static pub_service_t *s_services[TABLE_SIZE];
+
+/* Queued updates, newest per host (s_pending_lock) */
+static SemaphoreHandle_t s_pending_lock;
+static host_snap_t *s_pending;
+static host_snap_t *s_pending_index[TABLE_SIZE];
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static srp_mdns_stats_t s_stats;
+static TaskHandle_t s_task;
+static otInstance *s_instance;
+
+/* TXT records handed to the mDNS responder — publisher task only */
+static mdns_txt_item_t s_txt_items[TXT_ITEMS_MAX];
+static uint8_t s_txt_lens[TXT_ITEMS_MAX];
+static char s_txt_buf[TXT_BUF_SIZE];
+
+static struct {
+    bool active;
+    uint32_t count;             /* hosts in the last run */
+    uint32_t remaining;
+    int64_t start_us;
+} s_bench;
+
+/* ------------------------------------------------------------------ */
+/*  Hash tables                                                        */
+/* ------------------------------------------------------------------ */
+
+static uint32_t fnv1a(uint32_t hash, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t fnv1a_str(uint32_t hash, const char *s)
+{
+    /* Include the NUL so "ab"+"c" and "a"+"bc" differ */
+    return fnv1a(hash, s, strlen(s) + 1);
+}
+
+static uint32_t service_key_hash(const char *instance, const char *service, const char *proto)
+{
+    return fnv1a_str(fnv1a_str(fnv1a_str(FNV_INIT, instance), service), proto);
+}
+
+static pub_host_t **host_slot(const char *name, bool for_insert)
+{
+    uint32_t i = fnv1a_str(FNV_INIT, name) % TABLE_SIZE;
+    pub_host_t **free_slot = NULL;
+
+    for (uint32_t n = 0; n < TABLE_SIZE; n++, i = (i + 1) % TABLE_SIZE) {
+        pub_host_t *h = s_hosts[i];
+        if (h == NULL) return for_insert ? (free_slot ? free_slot : &s_hosts[i]) : NULL;
+        if (h == TOMBSTONE) {
+            if (free_slot == NULL) free_slot = &s_hosts[i];
+        } else if (strcmp(h->name, name) == 0) {
+            return &s_hosts[i];
+        }
+    }
+    return for_insert ? free_slot : NULL;
+}
+
+static pub_service_t **service_slot(const svc_snap_t *svc, bool for_insert)
+{
+    uint32_t i = service_key_hash(svc->instance, svc->service, svc->proto) % TABLE_SIZE;
+    pub_service_t **free_slot = NULL;
+
+    for (uint32_t n = 0; n < TABLE_SIZE; n++, i = (i + 1) % TABLE_SIZE) {
+        pub_service_t *s = s_services[i];
+        if (s == NULL) return for_insert ? (free_slot ? free_slot : &s_services[i]) : NULL;
+        if (s == TOMBSTONE) {
+            if (free_slot == NULL) free_slot = &s_services[i];
+        } else if (strcmp(s->instance, svc->instance) == 0 &&
+                   strcmp(s->service, svc->service) == 0 &&
+                   strcmp(s->proto, svc->proto) == 0) {
+            return &s_services[i];
+        }
+    }
+    return for_insert ? free_slot : NULL;
+}
+
+static void count_error(const char *what, const char *name, esp_err_t err)
+{
+    ESP_LOGW(TAG, "%s %s: %s", what, name, esp_err_to_name(err));
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.errors++;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Snapshots                                                          */
+/* ------------------------------------------------------------------ */
+
+static void snap_free(host_snap_t *snap)
+{
+    for (uint16_t i = 0; i < snap->num_services; i++) {
+        free(snap->services[i].txt);
+    }
+    free(snap->services);
+    mem_pool_free(&s_update_pool, snap);
+}
+
+/* Copy label number index of a dotted DNS name; false if it is missing
+ * or does not fit.                                                    */
+static bool copy_label(const char *name, int index, char *out, size_t size)
+{
+    for (; index > 0 && name != NULL; index--) {
+        name = strchr(name, '.');
+        if (name != NULL) name++;
+    }
+    if (name == NULL || *name == '\0') return false;
+
+    const char *end = strchr(name, '.');
+    size_t len = end ? (size_t)(end - name) : strlen(name);
+    if (len == 0 || len >= size) return false;
+
+    memcpy(out, name, len);
+    out[len] = '\0';
+    return true;
+}
+
+static bool is_backbone_reachable(otInstance *instance, const otIp6Address *addr)
+{
+    const otMeshLocalPrefix *ml = otThreadGetMeshLocalPrefix(instance);
+
+    if (addr->mFields.m8[0] == 0xfe && (addr->mFields.m8[1] & 0xc0) == 0x80) return false;
+    return memcmp(addr->mFields.m8, ml->m8, sizeof(ml->m8)) != 0;
+}
+
+static bool snapshot_service(const otSrpServerService *service, svc_snap_t *svc)
+{
+    const char *service_name = otSrpServerServiceGetServiceName(service);
+
+    if (!copy_label(otSrpServerServiceGetInstanceLabel(service), 0,
+                    svc->instance, sizeof(svc->instance)) ||
+        !copy_label(service_name, 0, svc->service, sizeof(svc->service)) ||
+        !copy_label(service_name, 1, svc->proto, sizeof(svc->proto))) {
+        ESP_LOGW(TAG, "Skipping service with unusable name: %s", service_name);
+        return false;
+    }
+
+    svc->deleted = otSrpServerServiceIsDeleted(service);
+    svc->port = otSrpServerServiceGetPort(service);
+
+    uint16_t num_subtypes = otSrpServerServiceGetNumberOfSubTypes(service);
+    for (uint16_t i = 0; i < num_subtypes && svc->num_subtypes < SUBTYPES_MAX; i++) {
+        if (otSrpServerParseSubTypeServiceName(otSrpServerServiceGetSubTypeServiceNameAt(service, i),
+                                               svc->subtypes[svc->num_subtypes],
+                                               SERVICE_MAX) == OT_ERROR_NONE) {
+            svc->num_subtypes++;
+        }
+    }
+
+    uint16_t txt_len = 0;
+    const uint8_t *txt = otSrpServerServiceGetTxtData(service, &txt_len);
+    if (txt_len > 0) {
+        svc->txt = malloc(txt_len);
+        if (svc->txt == NULL) return false;
+        memcpy(svc->txt, txt, txt_len);
+        svc->txt_len = txt_len;
+    }
+    return true;
+}
+
+static host_snap_t *snapshot_host(otInstance *instance, const otSrpServerHost *host)
+{
+    host_snap_t *snap = mem_pool_alloc(&s_update_pool, sizeof(*snap));
+    if (snap == NULL) return NULL;
+
+    if (!copy_label(otSrpServerHostGetFullName(host), 0, snap->name, sizeof(snap->name))) {
+        mem_pool_free(&s_update_pool, snap);
+        return NULL;
+    }
+    snap->received_us = esp_timer_get_time();
+    snap->deleted = otSrpServerHostIsDeleted(host);
+
+    /* A deleted host takes all its services with it */
+    if (snap->deleted) return snap;
+
+    uint8_t num_addrs = 0;
+    const otIp6Address *addrs = otSrpServerHostGetAddresses(host, &num_addrs);
+    for (uint8_t i = 0; i < num_addrs && snap->num_addrs < HOST_ADDRS_MAX; i++) {
+        if (is_backbone_reachable(instance, &addrs[i])) snap->addrs[snap->num_addrs++] = addrs[i];
+    }
+
+    uint16_t count = 0;
+    for (const otSrpServerService *s = otSrpServerHostGetNextService(host, NULL); s != NULL;
+         s = otSrpServerHostGetNextService(host, s)) {
+        count++;
+    }
+    if (count == 0) return snap;
+
+    snap->services = calloc(count, sizeof(svc_snap_t));
+    if (snap->services == NULL) {
+        mem_pool_free(&s_update_pool, snap);
+        return NULL;
+    }
+    for (const otSrpServerService *s = otSrpServerHostGetNextService(host, NULL); s != NULL;
+         s = otSrpServerHostGetNextService(host, s)) {
+        if (snapshot_service(s, &snap->services[snap->num_services])) {
+            snap->num_services++;
+        } else {
+            free(snap->services[snap->num_services].txt);
+            memset(&snap->services[snap->num_services], 0, sizeof(svc_snap_t));
+        }
+    }
+    return snap;
+}
+
+static bool same_service(const svc_snap_t *a, const svc_snap_t *b)
+{
+    return strcmp(a->instance, b->instance) == 0 && strcmp(a->service, b->service) == 0 &&
+           strcmp(a->proto, b->proto) == 0;
+}
+
+/* Fold an older queued update into a newer one for the same host: the
+ * newer one wins, services only the older one mentions are kept, and
+ * the older SRP updates are answered with the newer one.  SRP updates
+ * that don't fit are moved to superseded (*num_superseded of them).
+ * Frees old.                                                          */
+static void snap_merge(host_snap_t *newer, host_snap_t *old,
+                       otSrpServerServiceUpdateId *superseded, uint8_t *num_superseded)
+{
+    newer->received_us = old->received_us;
+    for (uint8_t i = 0; i < old->num_ids; i++) {
+        if (newer->num_ids < UPDATE_IDS_MAX) {
+            newer->ids[newer->num_ids++] = old->ids[i];
+        } else {
+            superseded[(*num_superseded)++] = old->ids[i];
+        }
+    }
+    if (newer->deleted || old->deleted) {
+        snap_free(old);
+        return;
+    }
+
+    uint16_t extra = 0;
+    for (uint16_t i = 0; i < old->num_services; i++) {
+        bool found = false;
+        for (uint16_t j = 0; j < newer->num_services && !found; j++) {
+            found = same_service(&old->services[i], &newer->services[j]);
+        }
+        if (!found) {
+            old->services[extra++] = old->services[i];   /* move, keeps txt */
+        } else {
+            free(old->services[i].txt);
+        }
+    }
+    old->num_services = extra;
+
+    if (extra > 0) {
+        svc_snap_t *merged = realloc(newer->services,
+                                     (newer->num_services + extra) * sizeof(svc_snap_t));
+        if (merged != NULL) {
+            memcpy(&merged[newer->num_services], old->services, extra * sizeof(svc_snap_t));
+            newer->services = merged;
+            newer->num_services += extra;
+            old->num_services = 0;
+        }
+    }
+    snap_free(old);
+}
+
+/* Queue a snapshot; false (snap not taken) if the pending index is
+ * full, which the heap fallback for snapshots makes possible.         */
+static bool enqueue(host_snap_t *snap)
+{
+    bool coalesced = false;
+    otSrpServerServiceUpdateId superseded[UPDATE_IDS_MAX];
+    uint8_t num_superseded = 0;
+
+    xSemaphoreTake(s_pending_lock, portMAX_DELAY);
+
+    uint32_t i = fnv1a_str(FNV_INIT, snap->name) % TABLE_SIZE;
+    uint32_t n = 0;
+    while (n < TABLE_SIZE && s_pending_index[i] != NULL &&
+           strcmp(s_pending_index[i]->name, snap->name) != 0) {
+        i = (i + 1) % TABLE_SIZE;
+        n++;
+    }
+    if (n == TABLE_SIZE) {
+        xSemaphoreGive(s_pending_lock);
+        return false;
+    }
+
+    host_snap_t *old = s_pending_index[i];
+    if (old != NULL) {
+        /* Take the old entry's place in the queue */
+        host_snap_t **pp = &s_pending;
+        while (*pp != old) pp = &(*pp)->next;
+        snap->next = old->next;
+        *pp = snap;
+        snap_merge(snap, old, superseded, &num_superseded);
+        coalesced = true;
+    } else {
+        snap->next = s_pending;
+        s_pending = snap;
+    }
+    s_pending_index[i] = snap;
+
+    xSemaphoreGive(s_pending_lock);
+
+    /* Only SRP updates carry ids, and those arrive on the mainloop: the
+     * host's newer update, still queued, will be answered with the result */
+    for (uint8_t k = 0; k < num_superseded; k++) {
+        otSrpServerHandleServiceUpdateResult(s_instance, superseded[k], OT_ERROR_NONE);
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.updates++;
+    if (coalesced) {
+        s_stats.coalesced++;
+    } else {
+        s_stats.pending++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    xTaskNotifyGive(s_task);
+    return true;
+}
+
+/* ------------------------------------------------------------------ */
+/*  SRP server handler (OpenThread mainloop)                           */
+/* ------------------------------------------------------------------ */
+
+static void on_service_update(otSrpServerServiceUpdateId id, const otSrpServerHost *host,
+                              uint32_t timeout, void *context)
+{
+    otInstance *instance = (otInstance *)context;
+    host_snap_t *snap = snapshot_host(instance, host);
+
+    if (snap == NULL) {
+        otSrpServerHandleServiceUpdateResult(instance, id, OT_ERROR_NO_BUFS);
+        return;
+    }
+
+    /* Answered by the publisher task once mDNS has taken it (or not) */
+    snap->ids[0] = id;
+    snap->num_ids = 1;
+    if (!enqueue(snap)) {
+        count_error("No room to queue", snap->name, ESP_ERR_NO_MEM);
+        snap_free(snap);
+        otSrpServerHandleServiceUpdateResult(instance, id, OT_ERROR_NO_BUFS);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Publishing (publisher task)                                        */
+/* ------------------------------------------------------------------ */
+
+static otError ot_error(esp_err_t err)
+{
+    switch (err) {
+    case ESP_OK:         return OT_ERROR_NONE;
+    case ESP_ERR_NO_MEM: return OT_ERROR_NO_BUFS;
+    default:             return OT_ERROR_FAILED;
+    }
+}
+
+static void unpublish_service(pub_service_t **slot)
+{
+    pub_service_t *s = *slot;
+
+    esp_err_t err = mdns_service_remove_for_host(s->instance, s->service, s->proto, s->host->name);
+    if (err != ESP_OK) count_error("Removing service", s->instance, err);
+
+    s->host->num_services--;
+    mem_pool_free(&s_service_pool, s);
+    *slot = TOMBSTONE;
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.removed++;
+    s_stats.services--;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static uint32_t content_hash(const svc_snap_t *svc)
+{
+    uint32_t hash = fnv1a(FNV_INIT, &svc->port, sizeof(svc->port));
+    hash = fnv1a(hash, svc->txt, svc->txt_len);
+    for (uint8_t i = 0; i < svc->num_subtypes; i++) {
+        hash = fnv1a_str(hash, svc->subtypes[i]);
+    }
+    return hash;
+}
+
+/* Fill s_txt_items and s_txt_lens from a TXT record; returns the item
+ * count.  Items are NUL-terminated copies, as the add call wants.      */
+static size_t build_txt(const svc_snap_t *svc)
+{
+    otDnsTxtEntryIterator it;
+    otDnsTxtEntry entry;
+    size_t count = 0;
+    size_t used = 0;
+
+    otDnsInitTxtEntryIterator(&it, svc->txt, svc->txt_len);
+    while (count < TXT_ITEMS_MAX && otDnsGetNextTxtEntry(&it, &entry) == OT_ERROR_NONE) {
+        if (entry.mKey == NULL) continue;   /* key too long for the iterator */
+
+        /* The iterator reuses its key buffer: copy both halves */
+        size_t key_len = strlen(entry.mKey);
+        if (used + key_len + entry.mValueLength + 2 > sizeof(s_txt_buf)) break;
+
+        char *key = &s_txt_buf[used];
+        memcpy(key, entry.mKey, key_len + 1);
+        used += key_len + 1;
+        char *value = &s_txt_buf[used];
+        if (entry.mValueLength > 0) memcpy(value, entry.mValue, entry.mValueLength);
+        value[entry.mValueLength] = '\0';
+        used += entry.mValueLength + 1;
+
+        s_txt_items[count].key = key;
+        s_txt_items[count].value = value;
+        s_txt_lens[count] = (uint8_t)entry.mValueLength;
+        count++;
+    }
+    return count;
+}
+
+static otError publish_service(pub_host_t *host, const svc_snap_t *svc)
+{
+    pub_service_t **slot = service_slot(svc, !svc->deleted);
+
+    if (svc->deleted) {
+        if (slot != NULL) unpublish_service(slot);
+        return OT_ERROR_NONE;
+    }
+
+    uint32_t hash = content_hash(svc);
+    pub_service_t *s = (slot != NULL && *slot != TOMBSTONE) ? *slot : NULL;
+
+    if (s != NULL && s->host != host) {
+        /* Same instance name, different SRP host */
+        count_error("Service owned by another host", svc->instance, ESP_ERR_INVALID_STATE);
+        return OT_ERROR_DUPLICATED;
+    }
+    if (s != NULL && s->content_hash == hash) {
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.unchanged++;
+        taskEXIT_CRITICAL(&s_lock);
+        return OT_ERROR_NONE;
+    }
+
+    bool republish = s != NULL;
+    if (republish) {
+        /* TXT or subtypes changed: replace the whole service record set */
+        mdns_service_remove_for_host(s->instance, s->service, s->proto, s->host->name);
+        s->host->num_services--;
+    } else {
+        if (slot == NULL || s_stats.services >= MAX_SERVICES) {
+            count_error("No room for service", svc->instance, ESP_ERR_NO_MEM);
+            return OT_ERROR_NO_BUFS;
+        }
+        if (mdns_service_exists_with_instance(svc->instance, svc->service, svc->proto, NULL)) {
+            /* The responder advertises this one for the router itself */
+            count_error("Service already on the LAN", svc->instance, ESP_ERR_INVALID_STATE);
+            return OT_ERROR_DUPLICATED;
+        }
+        s = mem_pool_alloc(&s_service_pool, sizeof(*s));
+        if (s == NULL) {
+            count_error("No memory for service", svc->instance, ESP_ERR_NO_MEM);
+            return OT_ERROR_NO_BUFS;
+        }
+        strcpy(s->instance, svc->instance);
+        strcpy(s->service, svc->service);
+        strcpy(s->proto, svc->proto);
+        *slot = s;
+    }
+    s->host = host;
+    s->content_hash = hash;
+    host->num_services++;
+
+    /* One call for the service and its TXT record, and the subtypes
+     * queued straight after it, so all go out in the first announcement */
+    size_t num_txt = build_txt(svc);
+    esp_err_t err = mdns_service_add_for_host(svc->instance, svc->service, svc->proto,
+                                              host->name, svc->port,
+                                              num_txt ? s_txt_items : NULL, num_txt);
+    for (size_t i = 0; err == ESP_OK && i < num_txt; i++) {
+        /* Binary values were cut at their first NUL: set the real length */
+        if (strlen(s_txt_items[i].value) == s_txt_lens[i]) continue;
+        err = mdns_service_txt_item_set_for_host_with_explicit_value_len(
+            svc->instance, svc->service, svc->proto, host->name, s_txt_items[i].key,
+            s_txt_items[i].value, s_txt_lens[i]);
+    }
+    if (err == ESP_OK && svc->num_subtypes > 0) {
+        mdns_subtype_item_t subtypes[SUBTYPES_MAX];
+        for (uint8_t i = 0; i < svc->num_subtypes; i++) {
+            subtypes[i].subtype = svc->subtypes[i];
+        }
+        err = mdns_service_subtype_update_multiple_items_for_host(
+            svc->instance, svc->service, svc->proto, host->name, subtypes, svc->num_subtypes);
+    }
+    if (err != ESP_OK) {
+        count_error("Publishing service", svc->instance, err);
+        /* Leave the hash stale so the next registration retries */
+        s->content_hash = ~hash;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    if (republish) {
+        s_stats.republished++;
+    } else {
+        s_stats.published++;
+        s_stats.services++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return ot_error(err);
+}
+
+static void unpublish_host(pub_host_t **slot)
+{
+    pub_host_t *h = *slot;
+
+    for (uint32_t i = 0; i < TABLE_SIZE && h->num_services > 0; i++) {
+        if (s_services[i] != NULL && s_services[i] != TOMBSTONE && s_services[i]->host == h) {
+            unpublish_service(&s_services[i]);
+        }
+    }
+    mdns_delegate_hostname_remove(h->name);
+    mem_pool_free(&s_host_pool, h);
+    *slot = TOMBSTONE;
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.hosts--;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static otError publish_host(const host_snap_t *snap)
+{
+    pub_host_t **slot = host_slot(snap->name, !snap->deleted);
+
+    if (snap->deleted) {
+        if (slot != NULL) unpublish_host(slot);
+        return OT_ERROR_NONE;
+    }
+    if (slot == NULL) {
+        count_error("No room for host", snap->name, ESP_ERR_NO_MEM);
+        return OT_ERROR_NO_BUFS;
+    }
+
+    mdns_ip_addr_t addrs[HOST_ADDRS_MAX];
+    memset(addrs, 0, sizeof(addrs));
+    for (uint8_t i = 0; i < snap->num_addrs; i++) {
+        addrs[i].addr.type = ESP_IPADDR_TYPE_V6;
+        memcpy(addrs[i].addr.u_addr.ip6.addr, snap->addrs[i].mFields.m8, 16);
+        addrs[i].next = i + 1 < snap->num_addrs ? &addrs[i + 1] : NULL;
+    }
+    uint32_t addr_hash = fnv1a(FNV_INIT, snap->addrs, snap->num_addrs * sizeof(otIp6Address));
+
+    esp_err_t err = ESP_OK;
+    pub_host_t *h = *slot != TOMBSTONE ? *slot : NULL;
+    if (h == NULL) {
+        if (mdns_hostname_exists(snap->name)) {
+            /* Delegated by someone else, or the router's own name */
+            count_error("Host already on the LAN", snap->name, ESP_ERR_INVALID_STATE);
+            return OT_ERROR_DUPLICATED;
+        }
+        h = mem_pool_alloc(&s_host_pool, sizeof(*h));
+        if (h == NULL) {
+            count_error("No memory for host", snap->name, ESP_ERR_NO_MEM);
+            return OT_ERROR_NO_BUFS;
+        }
+        strcpy(h->name, snap->name);
+        h->addr_hash = addr_hash;
+        *slot = h;
+
+        err = mdns_delegate_hostname_add(h->name, snap->num_addrs ? addrs : NULL);
+        if (err != ESP_OK) count_error("Adding host", h->name, err);
+
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.hosts++;
+        taskEXIT_CRITICAL(&s_lock);
+    } else if (h->addr_hash != addr_hash) {
+        h->addr_hash = addr_hash;
+        err = mdns_delegate_hostname_set_address(h->name, snap->num_addrs ? addrs : NULL);
+        if (err != ESP_OK) count_error("Updating host", h->name, err);
+    }
+
+    /* The first failure is the update's result */
+    otError error = ot_error(err);
+    for (uint16_t i = 0; i < snap->num_services; i++) {
+        otError svc_error = publish_service(h, &snap->services[i]);
+        if (error == OT_ERROR_NONE) error = svc_error;
+    }
+    return error;
+}
+
+static void bench_account(const host_snap_t *snap, int64_t now)
+{
+    if (!s_bench.active || snap->deleted ||
+        strncmp(snap->name, BENCH_HOST_PREFIX, strlen(BENCH_HOST_PREFIX)) != 0) {
+        return;
+    }
+    if (--s_bench.remaining > 0) return;
+
+    int64_t elapsed_ms = (now - s_bench.start_us) / 1000;
+    ESP_LOGI(TAG, "bench: %lu services published in %lld ms (%lu/s)",
+             (unsigned long)s_bench.count, elapsed_ms,
+             (unsigned long)(elapsed_ms > 0 ? s_bench.count * 1000 / elapsed_ms : s_bench.count));
+    s_bench.active = false;
+}
+
+static void publish_task(void *arg)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        /* Let the rest of a registration burst arrive */
+        vTaskDelay(pdMS_TO_TICKS(SRP_MDNS_BATCH_MS));
+
+        xSemaphoreTake(s_pending_lock, portMAX_DELAY);
+        host_snap_t *batch = s_pending;
+        s_pending = NULL;
+        memset(s_pending_index, 0, sizeof(s_pending_index));
+        xSemaphoreGive(s_pending_lock);
+
+        uint32_t count = 0;
+        while (batch != NULL) {
+            host_snap_t *snap = batch;
+            batch = snap->next;
+
+            otError error = publish_host(snap);
+
+            /* Answer the SRP updates behind this snapshot */
+            if (snap->num_ids > 0) {
+                esp_openthread_lock_acquire(portMAX_DELAY);
+                for (uint8_t i = 0; i < snap->num_ids; i++) {
+                    otSrpServerHandleServiceUpdateResult(s_instance, snap->ids[i], error);
+                }
+                esp_openthread_lock_release();
+            }
+
+            int64_t now = esp_timer_get_time();
+            uint32_t latency_ms = (uint32_t)((now - snap->received_us) / 1000);
+            bench_account(snap, now);
+            snap_free(snap);
+            count++;
+
+            taskENTER_CRITICAL(&s_lock);
+            s_stats.pending--;
+            s_stats.latency_sum_ms += latency_ms;
+            s_stats.latency_count++;
+            if (latency_ms > s_stats.latency_max_ms) s_stats.latency_max_ms = latency_ms;
+            taskEXIT_CRITICAL(&s_lock);
+        }
+
+        if (count == 0) continue;
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.batches++;
+        if (count > s_stats.max_batch) s_stats.max_batch = count;
+        taskEXIT_CRITICAL(&s_lock);
+        ESP_LOGD(TAG, "Published a batch of %lu host updates", (unsigned long)count);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Benchmark                                                          */
+/* ------------------------------------------------------------------ */
+
+static host_snap_t *bench_host(uint32_t n, bool deleted)
+{
+    host_snap_t *snap = mem_pool_alloc(&s_update_pool, sizeof(*snap));
+    svc_snap_t *svc = calloc(1, sizeof(*svc));
+    uint8_t *txt = malloc(16);
+    if (snap == NULL || svc == NULL || txt == NULL) {
+        mem_pool_free(&s_update_pool, snap);
+        free(svc);
+        free(txt);
+        return NULL;
+    }
+
+    snprintf(snap->name, sizeof(snap->name), BENCH_HOST_PREFIX "%lu", (unsigned long)n);
+    snap->deleted = deleted;
+    snap->received_us = esp_timer_get_time();
+
+    /* 2001:db8::/32 (documentation): resolvable, not reachable */
+    snap->num_addrs = 1;
+    snap->addrs[0].mFields.m8[0] = 0x20;
+    snap->addrs[0].mFields.m8[1] = 0x01;
+    snap->addrs[0].mFields.m8[2] = 0x0d;
+    snap->addrs[0].mFields.m8[3] = 0xb8;
+    snap->addrs[0].mFields.m8[14] = (uint8_t)(n >> 8);
+    snap->addrs[0].mFields.m8[15] = (uint8_t)n;
+
+    strcpy(svc->instance, snap->name);
+    strcpy(svc->service, SRP_MDNS_BENCH_SERVICE);
+    strcpy(svc->proto, SRP_MDNS_BENCH_PROTO);
+    svc->port = 9;
+    svc->txt_len = (uint16_t)snprintf((char *)txt + 1, 15, "n=%lu", (unsigned long)n);
+    txt[0] = (uint8_t)svc->txt_len;
+    svc->txt_len++;
+    svc->txt = txt;
+
+    snap->services = svc;
+    snap->num_services = 1;
+    return snap;
+}
+
+esp_err_t srp_mdns_bench(uint32_t count)
+{
+    if (s_task == NULL) return ESP_ERR_INVALID_STATE;
+    if (s_bench.active) return ESP_ERR_INVALID_STATE;
+    if (count > SRP_MDNS_BENCH_MAX) return ESP_ERR_INVALID_ARG;
+
+    bool clear = count == 0;
+    uint32_t n = clear ? s_bench.count : count;
+
+    if (!clear) {
+        s_bench.count = count;
+        s_bench.remaining = count;
+        s_bench.start_us = esp_timer_get_time();
+        s_bench.active = true;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        host_snap_t *snap = bench_host(i, clear);
+        if (snap == NULL) {
+            s_bench.active = false;
+            return ESP_ERR_NO_MEM;
+        }
+        if (!enqueue(snap)) {
+            snap_free(snap);
+            s_bench.active = false;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Control / metrics                                                  */
+/* ------------------------------------------------------------------ */
+
+static void write_metrics(metrics_writer_t *w)
+{
+    srp_mdns_stats_t st;
+    srp_mdns_get_stats(&st);
+
+    metrics_counter(w, "otbr_srp_mdns_updates_total", "SRP host updates received", st.updates);
+    metrics_counter(w, "otbr_srp_mdns_coalesced_total",
+                    "SRP host updates merged into one still queued", st.coalesced);
+    metrics_gauge(w, "otbr_srp_mdns_pending", "SRP host updates waiting for mDNS", st.pending);
+    metrics_counter(w, "otbr_srp_mdns_batches_total", "mDNS publish batches", st.batches);
+    metrics_gauge(w, "otbr_srp_mdns_batch_max", "Host updates in the largest batch",
+                  st.max_batch);
+    metrics_gauge(w, "otbr_srp_mdns_hosts", "SRP hosts advertised on mDNS", st.hosts);
+    metrics_gauge(w, "otbr_srp_mdns_services", "SRP services advertised on mDNS", st.services);
+
+    metrics_header(w, "otbr_srp_mdns_service_ops_total", "counter",
+                   "mDNS service operations by kind");
+    metrics_sample(w, "otbr_srp_mdns_service_ops_total", "op=\"add\"", st.published);
+    metrics_sample(w, "otbr_srp_mdns_service_ops_total", "op=\"update\"", st.republished);
+    metrics_sample(w, "otbr_srp_mdns_service_ops_total", "op=\"unchanged\"", st.unchanged);
+    metrics_sample(w, "otbr_srp_mdns_service_ops_total", "op=\"remove\"", st.removed);
+    metrics_counter(w, "otbr_srp_mdns_errors_total", "mDNS publish failures", st.errors);
+
+    metrics_header(w, "otbr_srp_mdns_latency_ms", "summary",
+                   "SRP update received to published on mDNS");
+    metrics_sample(w, "otbr_srp_mdns_latency_ms_sum", NULL, st.latency_sum_ms);
+    metrics_sample(w, "otbr_srp_mdns_latency_ms_count", NULL, st.latency_count);
+    metrics_gauge(w, "otbr_srp_mdns_latency_max_ms", "Slowest SRP update to mDNS",
+                  st.latency_max_ms);
+}
+
+void srp_mdns_init(void)
+{
+    if (s_task != NULL) return;
+
+    s_pending_lock = xSemaphoreCreateMutex();
+    mem_pool_register(&s_host_pool);
+    mem_pool_register(&s_service_pool);
+    mem_pool_register(&s_update_pool);
+    metrics_register_source(write_metrics);
+    xTaskCreate(publish_task, "srp_mdns", 4096, NULL, 4, &s_task);
+}
+
+void srp_mdns_start(otInstance *instance)
+{
+    s_instance = instance;
+    otSrpServerSetServiceUpdateHandler(instance, on_service_update, instance);
+    ESP_LOGI(TAG, "Advertising SRP services on mDNS (up to %d)", MAX_SERVICES);
+}
+
+void srp_mdns_get_stats(srp_mdns_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
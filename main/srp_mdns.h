@@ -0,0 +1,79 @@
+/*
+ * SRP → mDNS advertising proxy
+ *
+ * Thread devices register their services with the border router's SRP
+ * server; this module re-publishes them on the Wi-Fi LAN through the
+ * mDNS responder (delegated host names + services), which is how Home
+ * Assistant and Matter controllers find them.
+ *
+ * Built for as many services as the mDNS responder holds
+ * (CONFIG_MDNS_MAX_SERVICES, at most 64) and the re-registration storm
+ * after a border-router restart:
+ *   - updates are copied on the OpenThread mainloop and published by a
+ *     separate task, so mDNS calls never run on the mainloop; the SRP
+ *     server is answered once the update is on mDNS, with the result
+ *     (OT_ERROR_DUPLICATED for a name already on the LAN, NO_BUFS when
+ *     full).  Conflicts found later by mDNS probing are not reported.
+ *   - updates for the same host within SRP_MDNS_BATCH_MS are merged and
+ *     published as one batch
+ *   - published hosts and services live in hash tables; an update that
+ *     matches what is already on mDNS is skipped, a changed service is
+ *     re-published on its own, TXT record and subtypes included
+ *
+ * Counters (throughput, batch sizes, update → mDNS latency) are on
+ * /metrics and "otbr srp".
+ */
+
+#ifndef SRP_MDNS_H
+#define SRP_MDNS_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "openthread/instance.h"
+
+#define SRP_MDNS_BENCH_SERVICE  "_otbrbench"
+#define SRP_MDNS_BENCH_PROTO    "_udp"
+#define SRP_MDNS_BENCH_MAX      60      /* fits the SRP pools (config.h) */
+
+typedef struct {
+    uint32_t updates;           /* SRP host updates received           */
+    uint32_t coalesced;         /* merged into an update still queued  */
+    uint32_t pending;           /* host updates waiting to be published */
+    uint32_t batches;
+    uint32_t max_batch;         /* host updates in the largest batch   */
+    uint32_t hosts;             /* currently on mDNS                   */
+    uint32_t services;
+    uint32_t published;         /* services added                      */
+    uint32_t republished;       /* services changed and re-added       */
+    uint32_t unchanged;         /* identical re-registrations skipped  */
+    uint32_t removed;           /* services removed                    */
+    uint32_t errors;            /* mDNS calls failed or table full     */
+    uint64_t latency_sum_ms;    /* SRP update → published, per update */
+    uint32_t latency_count;
+    uint32_t latency_max_ms;
+} srp_mdns_stats_t;
+
+/** Create the publisher task and register metrics.  Call after mdns_init(). */
+void srp_mdns_init(void);
+
+/**
+ * Take over SRP service updates from the SRP server.  Call with the
+ * OpenThread lock held, after the border router is initialized.
+ */
+void srp_mdns_start(otInstance *instance);
+
+void srp_mdns_get_stats(srp_mdns_stats_t *stats);
+
+/**
+ * Benchmark: queue count synthetic hosts ("otbrbench-<n>", one
+ * SRP_MDNS_BENCH_SERVICE service each) for the publisher task; the time
+ * until all are published is logged.  The snapshots are made up here,
+ * so the SRP server (DNS update parsing, signature checks, the update
+ * answer) is not part of the measurement.  count 0 removes the hosts of
+ * the previous run.  Returns ESP_ERR_INVALID_STATE while a run is in
+ * progress.
+ */
+esp_err_t srp_mdns_bench(uint32_t count);
+
+#endif /* SRP_MDNS_H */
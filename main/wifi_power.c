@@ -0,0 +1,242 @@
+/*
+ * Backbone Wi-Fi power-save policy and latency probe — see wifi_power.h
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "lwip/ip_addr.h"
+#include "ping/ping_sock.h"
+
+#include "config.h"
+#include "ot_status.h"
+#include "wifi_power.h"
+
+static const char *TAG = "wifi_ps";
+
+#define RTT_PROBE_TIMEOUT_MS    1000
+
+/* How often the adaptive policy looks at the border-routing counters */
+#define WIFI_POWER_SAMPLE_MS    200
+
+/* Software Wi-Fi/802.15.4 coexistence needs modem sleep: the driver
+ * rejects WIFI_PS_NONE, so power save stays on whatever the policy.   */
+#if CONFIG_ESP_COEX_SW_COEXIST_ENABLE
+#define PS_OFF_ALLOWED          0
+#else
+#define PS_OFF_ALLOWED          1
+#endif
+
+typedef struct {
+    uint32_t count;
+    uint32_t lost;
+    uint32_t min_ms;
+    uint32_t max_ms;
+    uint64_t sum_ms;
+} rtt_acc_t;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static wifi_power_policy_t s_policy = WIFI_POWER_POLICY;
+static bool s_ps_enabled = true;        /* ESP-IDF starts in modem sleep */
+static int64_t s_ps_changed_us = 0;
+static uint32_t s_ps_switches = 0;
+static uint64_t s_ps_off_us = 0;
+static uint32_t s_last_rtt_ms = 0;
+static rtt_acc_t s_rtt[2];              /* indexed by s_ps_enabled */
+
+static esp_ping_handle_t s_ping;
+static TaskHandle_t s_monitor_task;
+
+const char *wifi_power_policy_name(wifi_power_policy_t policy)
+{
+    switch (policy) {
+    case WIFI_POWER_LOW_LATENCY: return "low-latency";
+    case WIFI_POWER_ADAPTIVE:    return "adaptive";
+    case WIFI_POWER_SAVE:        return "power-save";
+    default:                     return "?";
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Power-save state                                                   */
+/* ------------------------------------------------------------------ */
+
+static void set_power_save(bool enable)
+{
+    if (enable == s_ps_enabled || (!enable && !PS_OFF_ALLOWED)) return;
+
+    esp_err_t err = esp_wifi_set_ps(enable ? WIFI_PS_MIN_MODEM : WIFI_PS_NONE);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "esp_wifi_set_ps(%s) failed: %s",
+                 enable ? "min-modem" : "none", esp_err_to_name(err));
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    taskENTER_CRITICAL(&s_lock);
+    if (!s_ps_enabled) s_ps_off_us += now - s_ps_changed_us;
+    s_ps_enabled = enable;
+    s_ps_changed_us = now;
+    s_ps_switches++;
+    taskEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGD(TAG, "Power save %s", enable ? "on" : "off");
+}
+
+/* Monitor task's copy of the OpenThread snapshot (too big for its stack) */
+static ot_status_t s_status;
+
+/* Total border-routing packets in both directions, or -1 before the
+ * first OpenThread snapshot (treated as "no new information").       */
+static int64_t forwarded_packets(void)
+{
+    if (!ot_status_read(&s_status)) return -1;
+
+    const otBorderRoutingCounters *c = &s_status.br;
+    return (int64_t)c->mInboundUnicast.mPackets + c->mInboundMulticast.mPackets +
+           c->mOutboundUnicast.mPackets + c->mOutboundMulticast.mPackets;
+}
+
+static void monitor_task(void *arg)
+{
+    int64_t last_total = forwarded_packets();
+    int64_t last_active_us = esp_timer_get_time();
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(WIFI_POWER_SAMPLE_MS));
+        if (s_policy != WIFI_POWER_ADAPTIVE) continue;
+
+        int64_t now = esp_timer_get_time();
+        int64_t total = forwarded_packets();
+        if (total >= 0 && total != last_total) {
+            last_total = total;
+            last_active_us = now;
+            set_power_save(false);
+        } else if (now - last_active_us >= (int64_t)WIFI_POWER_IDLE_MS * 1000) {
+            set_power_save(true);
+        }
+    }
+}
+
+void wifi_power_set_policy(wifi_power_policy_t policy)
+{
+    s_policy = policy;
+
+    /* Adaptive starts awake; the monitor turns power save back on once
+     * forwarding has been idle for WIFI_POWER_IDLE_MS.                */
+    set_power_save(policy == WIFI_POWER_SAVE);
+    ESP_LOGI(TAG, "Backbone power policy: %s", wifi_power_policy_name(policy));
+    if (!PS_OFF_ALLOWED && policy != WIFI_POWER_SAVE) {
+        ESP_LOGW(TAG, "Wi-Fi/802.15.4 coexistence needs modem sleep: power save stays on");
+    }
+}
+
+void wifi_power_init(void)
+{
+    s_ps_changed_us = esp_timer_get_time();
+    wifi_power_set_policy(s_policy);
+}
+
+void wifi_power_start_monitor(void)
+{
+    if (s_monitor_task != NULL) return;
+    if (!PS_OFF_ALLOWED) {
+        ESP_LOGI(TAG, "Software coexistence keeps modem sleep on: no adaptive power monitor");
+        return;
+    }
+    xTaskCreate(monitor_task, "wifi_ps", 2560, NULL, 3, &s_monitor_task);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Gateway RTT probe                                                  */
+/* ------------------------------------------------------------------ */
+
+static void on_ping_success(esp_ping_handle_t hdl, void *args)
+{
+    uint32_t rtt_ms;
+    esp_ping_get_profile(hdl, ESP_PING_PROF_TIMEGAP, &rtt_ms, sizeof(rtt_ms));
+
+    taskENTER_CRITICAL(&s_lock);
+    rtt_acc_t *acc = &s_rtt[s_ps_enabled];
+    if (acc->count == 0 || rtt_ms < acc->min_ms) acc->min_ms = rtt_ms;
+    if (rtt_ms > acc->max_ms) acc->max_ms = rtt_ms;
+    acc->sum_ms += rtt_ms;
+    acc->count++;
+    s_last_rtt_ms = rtt_ms;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+static void on_ping_timeout(esp_ping_handle_t hdl, void *args)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_rtt[s_ps_enabled].lost++;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void wifi_power_handle_disconnected(void)
+{
+    if (s_ping == NULL) return;
+    esp_ping_stop(s_ping);
+    esp_ping_delete_session(s_ping);
+    s_ping = NULL;
+}
+
+void wifi_power_handle_got_ip(const esp_ip4_addr_t *gateway)
+{
+    if (WIFI_RTT_PROBE_MS == 0 || gateway->addr == 0) return;
+
+    wifi_power_handle_disconnected();
+
+    esp_ping_config_t config = ESP_PING_DEFAULT_CONFIG();
+    config.target_addr = (ip_addr_t)IPADDR4_INIT(gateway->addr);
+    config.count = ESP_PING_COUNT_INFINITE;
+    config.interval_ms = WIFI_RTT_PROBE_MS;
+    config.timeout_ms = RTT_PROBE_TIMEOUT_MS;
+    config.data_size = 32;
+
+    esp_ping_callbacks_t cbs = {
+        .on_ping_success = on_ping_success,
+        .on_ping_timeout = on_ping_timeout,
+    };
+
+    if (esp_ping_new_session(&config, &cbs, &s_ping) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to create the gateway RTT probe");
+        s_ping = NULL;
+        return;
+    }
+    esp_ping_start(s_ping);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Statistics                                                         */
+/* ------------------------------------------------------------------ */
+
+static void rtt_export(const rtt_acc_t *acc, wifi_power_rtt_t *out)
+{
+    out->count = acc->count;
+    out->lost = acc->lost;
+    out->min_ms = acc->min_ms;
+    out->max_ms = acc->max_ms;
+    out->avg_ms = acc->count ? (uint32_t)(acc->sum_ms / acc->count) : 0;
+}
+
+void wifi_power_get_stats(wifi_power_stats_t *stats)
+{
+    int64_t now = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&s_lock);
+    stats->policy = s_policy;
+    stats->policy_applies = PS_OFF_ALLOWED;
+    stats->ps_enabled = s_ps_enabled;
+    stats->ps_switches = s_ps_switches;
+    stats->ps_off_ms = (s_ps_off_us + (s_ps_enabled ? 0 : now - s_ps_changed_us)) / 1000;
+    stats->last_rtt_ms = s_last_rtt_ms;
+    rtt_export(&s_rtt[0], &stats->rtt_ps_off);
+    rtt_export(&s_rtt[1], &stats->rtt_ps_on);
+    taskEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,84 @@
+/*
+ * Backbone Wi-Fi power-save policy and latency probe
+ *
+ * ESP-IDF leaves the STA in modem sleep (WIFI_PS_MIN_MODEM): the radio
+ * only wakes for DTIM beacons, so every packet the AP sends us — e.g. a
+ * Matter command from Home Assistant on its way to a Thread device —
+ * can sit in the AP's buffer for up to a DTIM period.  These boards are
+ * always on USB power, so that saving buys nothing.
+ *
+ *   WIFI_POWER_LOW_LATENCY  power save off (WIFI_PS_NONE)
+ *   WIFI_POWER_ADAPTIVE     power save off while border routing is
+ *                           forwarding traffic, back on after
+ *                           WIFI_POWER_IDLE_MS without any
+ *   WIFI_POWER_SAVE         ESP-IDF default modem sleep
+ *
+ * With CONFIG_ESP_COEX_SW_COEXIST_ENABLE (Wi-Fi and 802.15.4 sharing the
+ * C6's radio, as in sdkconfig.defaults) the driver requires modem sleep,
+ * so power save stays on under every policy; the other policies only
+ * take effect in builds without software coexistence.
+ *
+ * While Wi-Fi is up the IPv4 gateway is pinged every WIFI_RTT_PROBE_MS
+ * and the round-trip times are kept per power-save state, so the effect
+ * of the policy is visible on /metrics and with "otbr power".  Only
+ * IPv4 is probed; modem sleep delays both families alike.
+ */
+
+#ifndef WIFI_POWER_H
+#define WIFI_POWER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_netif.h"
+
+typedef enum {
+    WIFI_POWER_LOW_LATENCY = 0,
+    WIFI_POWER_ADAPTIVE    = 1,
+    WIFI_POWER_SAVE        = 2,
+} wifi_power_policy_t;
+
+typedef struct {
+    uint32_t count;             /* replies received */
+    uint32_t lost;              /* probes that timed out */
+    uint32_t min_ms;
+    uint32_t max_ms;
+    uint32_t avg_ms;
+} wifi_power_rtt_t;
+
+typedef struct {
+    wifi_power_policy_t policy;
+    bool policy_applies;        /* false: coexistence keeps modem sleep on */
+    bool ps_enabled;            /* modem sleep currently on */
+    uint32_t ps_switches;       /* power-save on/off transitions */
+    uint64_t ps_off_ms;         /* total time with power save off */
+    uint32_t last_rtt_ms;
+    wifi_power_rtt_t rtt_ps_off;
+    wifi_power_rtt_t rtt_ps_on;
+} wifi_power_stats_t;
+
+/** Apply WIFI_POWER_POLICY.  Call after esp_wifi_init(). */
+void wifi_power_init(void);
+
+/**
+ * Start watching border-routing traffic for the adaptive policy.
+ * Call once border routing is up (the OpenThread lock must exist).
+ * Does nothing with software coexistence, where modem sleep stays on.
+ */
+void wifi_power_start_monitor(void);
+
+/** Switch policy at runtime (e.g. to compare latency). */
+void wifi_power_set_policy(wifi_power_policy_t policy);
+
+/** Start/restart the gateway RTT probe (IP_EVENT_STA_GOT_IP). */
+void wifi_power_handle_got_ip(const esp_ip4_addr_t *gateway);
+
+/** Stop the RTT probe while the backbone is down. */
+void wifi_power_handle_disconnected(void);
+
+void wifi_power_get_stats(wifi_power_stats_t *stats);
+
+const char *wifi_power_policy_name(wifi_power_policy_t policy);
+
+#endif /* WIFI_POWER_H */
@@ -0,0 +1,251 @@
+/*
+ * Backbone (Wi-Fi STA) reconnect engine — see wifi_reconnect.h
+ */
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#include "config.h"
+#include "wifi_reconnect.h"
+
+static const char *TAG = "wifi_rc";
+
+#define AP_CACHE_NVS_NAMESPACE  "otbr"
+#define AP_CACHE_NVS_KEY        "wifi_ap"
+
+/* Fast-path attempts per outage before falling back to a full scan
+ * (the AP may have changed channel, or we may need to roam).         */
+#define FAST_PATH_MAX_ATTEMPTS  2
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t valid;
+} ap_cache_t;
+
+static wifi_config_t s_base_config;
+static ap_cache_t s_ap_cache;
+static esp_timer_handle_t s_retry_timer;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Per-outage state.  Attempts start on the esp_timer task as well as
+ * the event loop, so the fast-path fields are kept under s_lock.      */
+static uint32_t s_backoff_step = 0;
+static uint32_t s_fast_attempts = 0;
+static bool s_attempt_fast = false;     /* last attempt used the fast path */
+static int64_t s_outage_start_us = -1;
+
+static wifi_reconnect_stats_t s_stats;
+static uint64_t s_total_ms = 0;
+static uint32_t s_restored = 0;
+
+/* ------------------------------------------------------------------ */
+/*  Cached AP (NVS)                                                    */
+/* ------------------------------------------------------------------ */
+
+static void ap_cache_load(void)
+{
+    nvs_handle_t handle;
+    if (nvs_open(AP_CACHE_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) return;
+
+    size_t len = sizeof(s_ap_cache);
+    if (nvs_get_blob(handle, AP_CACHE_NVS_KEY, &s_ap_cache, &len) != ESP_OK ||
+        len != sizeof(s_ap_cache)) {
+        memset(&s_ap_cache, 0, sizeof(s_ap_cache));
+    }
+    nvs_close(handle);
+}
+
+static void ap_cache_save(void)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(AP_CACHE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, AP_CACHE_NVS_KEY, &s_ap_cache, sizeof(s_ap_cache));
+        if (err == ESP_OK) err = nvs_commit(handle);
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to cache AP: %s", esp_err_to_name(err));
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Connection attempts                                                */
+/* ------------------------------------------------------------------ */
+
+static void start_attempt(void)
+{
+    wifi_config_t cfg = s_base_config;
+
+    taskENTER_CRITICAL(&s_lock);
+    bool fast = s_ap_cache.valid && s_fast_attempts < FAST_PATH_MAX_ATTEMPTS;
+    if (fast) s_fast_attempts++;
+    s_attempt_fast = fast;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (fast) {
+        /* Fast path: lock to the cached AP and probe only its channel */
+        cfg.sta.bssid_set = true;
+        memcpy(cfg.sta.bssid, s_ap_cache.bssid, sizeof(cfg.sta.bssid));
+        cfg.sta.channel = s_ap_cache.channel;
+        cfg.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        cfg.sta.bssid_set = false;
+        cfg.sta.channel = 0;
+        cfg.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    }
+
+    esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, &cfg);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "esp_wifi_set_config failed: %s", esp_err_to_name(err));
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.attempts++;
+    taskEXIT_CRITICAL(&s_lock);
+
+    err = esp_wifi_connect();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "esp_wifi_connect failed: %s", esp_err_to_name(err));
+    }
+}
+
+static void retry_timer_cb(void *arg)
+{
+    start_attempt();
+}
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                         */
+/* ------------------------------------------------------------------ */
+
+void wifi_reconnect_init(const wifi_config_t *base_config)
+{
+    s_base_config = *base_config;
+    ap_cache_load();
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = retry_timer_cb,
+        .name = "wifi_retry",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_retry_timer));
+
+    if (s_ap_cache.valid) {
+        ESP_LOGI(TAG, "Cached AP %02x:%02x:%02x:%02x:%02x:%02x on channel %u",
+                 s_ap_cache.bssid[0], s_ap_cache.bssid[1], s_ap_cache.bssid[2],
+                 s_ap_cache.bssid[3], s_ap_cache.bssid[4], s_ap_cache.bssid[5],
+                 s_ap_cache.channel);
+    }
+}
+
+void wifi_reconnect_connect_now(void)
+{
+    esp_timer_stop(s_retry_timer);
+    start_attempt();
+}
+
+uint32_t wifi_reconnect_schedule(void)
+{
+    /* Exponential backoff, capped, with "equal jitter": half the delay
+     * is fixed and the other half random, so several border routers
+     * losing the same AP do not retry in lock-step. */
+    uint32_t delay = WIFI_RECONNECT_MIN_MS;
+    for (uint32_t i = 0; i < s_backoff_step && delay < WIFI_RECONNECT_MAX_MS; i++) {
+        delay *= 2;
+    }
+    if (delay > WIFI_RECONNECT_MAX_MS) delay = WIFI_RECONNECT_MAX_MS;
+    delay = delay / 2 + esp_random() % (delay / 2 + 1);
+    s_backoff_step++;
+
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.backoff_ms = delay;
+    taskEXIT_CRITICAL(&s_lock);
+
+    esp_timer_stop(s_retry_timer);
+    esp_timer_start_once(s_retry_timer, (uint64_t)delay * 1000);
+    return delay;
+}
+
+void wifi_reconnect_handle_connected(const wifi_event_sta_connected_t *event)
+{
+    if (!s_ap_cache.valid || s_ap_cache.channel != event->channel ||
+        memcmp(s_ap_cache.bssid, event->bssid, sizeof(s_ap_cache.bssid)) != 0) {
+        memcpy(s_ap_cache.bssid, event->bssid, sizeof(s_ap_cache.bssid));
+        s_ap_cache.channel = event->channel;
+        s_ap_cache.valid = 1;
+        ap_cache_save();
+        ESP_LOGI(TAG, "Cached new AP on channel %u", event->channel);
+    }
+}
+
+void wifi_reconnect_handle_disconnected(const wifi_event_sta_disconnected_t *event)
+{
+    taskENTER_CRITICAL(&s_lock);
+    if (s_stats.connected) {
+        s_stats.outages++;
+        s_outage_start_us = esp_timer_get_time();
+    } else if (s_outage_start_us < 0) {
+        /* Never connected yet (boot) — measure from the first failure */
+        s_outage_start_us = esp_timer_get_time();
+    }
+    s_stats.connected = false;
+    s_stats.last_reason = event->reason;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void wifi_reconnect_handle_got_ip(void)
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t ms = 0;
+    bool measured = false;
+
+    taskENTER_CRITICAL(&s_lock);
+    bool fast = s_attempt_fast;
+    s_fast_attempts = 0;
+    if (s_outage_start_us >= 0) {
+        ms = (uint32_t)((now - s_outage_start_us) / 1000);
+        measured = true;
+        s_restored++;
+        s_total_ms += ms;
+        s_stats.last_ms = ms;
+        if (s_stats.min_ms == 0 || ms < s_stats.min_ms) s_stats.min_ms = ms;
+        if (ms > s_stats.max_ms) s_stats.max_ms = ms;
+        s_stats.avg_ms = (uint32_t)(s_total_ms / s_restored);
+    }
+    if (fast) {
+        s_stats.fast_path_ok++;
+    } else {
+        s_stats.full_scan_ok++;
+    }
+    s_stats.connected = true;
+    s_stats.backoff_ms = 0;
+    s_outage_start_us = -1;
+    taskEXIT_CRITICAL(&s_lock);
+
+    s_backoff_step = 0;
+
+    if (measured) {
+        ESP_LOGI(TAG, "Backbone restored after %lu ms (%s)",
+                 (unsigned long)ms, fast ? "cached BSSID/channel" : "full scan");
+    }
+}
+
+void wifi_reconnect_get_stats(wifi_reconnect_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+uint8_t wifi_reconnect_cached_channel(void)
+{
+    return s_ap_cache.valid ? s_ap_cache.channel : 0;
+}
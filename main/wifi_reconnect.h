@@ -0,0 +1,61 @@
+/*
+ * Backbone (Wi-Fi STA) reconnect engine
+ *
+ * Replaces the immediate esp_wifi_connect() loop with:
+ *   - a fast path that reuses the cached BSSID + channel of the last
+ *     AP and skips the full-channel scan,
+ *   - exponential backoff with jitter between attempts, so a missing
+ *     AP does not steal airtime from 802.15.4 through coexistence,
+ *   - reconnect-time statistics.
+ *
+ * The engine only drives the Wi-Fi STA; the Thread side is untouched
+ * and keeps routing inside the mesh while the backbone is down.
+ */
+
+#ifndef WIFI_RECONNECT_H
+#define WIFI_RECONNECT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_wifi.h"
+
+typedef struct {
+    uint32_t outages;           /* Disconnects from a connected state     */
+    uint32_t attempts;          /* esp_wifi_connect() calls, all outages  */
+    uint32_t fast_path_ok;      /* Reconnects via cached BSSID/channel    */
+    uint32_t full_scan_ok;      /* Reconnects via full-channel scan       */
+    uint32_t last_ms;           /* Last outage: disconnect → got IP       */
+    uint32_t min_ms;
+    uint32_t max_ms;
+    uint32_t avg_ms;
+    uint32_t backoff_ms;        /* Delay before the pending attempt       */
+    uint8_t  last_reason;       /* wifi_err_reason_t of last disconnect   */
+    bool     connected;
+} wifi_reconnect_stats_t;
+
+/**
+ * Initialise the engine with the STA configuration from config.h and
+ * load the cached AP (BSSID/channel) from NVS.
+ */
+void wifi_reconnect_init(const wifi_config_t *base_config);
+
+/** Connect immediately (used on WIFI_EVENT_STA_START). */
+void wifi_reconnect_connect_now(void);
+
+/**
+ * Schedule the next attempt with exponential backoff and jitter.
+ * Returns the chosen delay in milliseconds.
+ */
+uint32_t wifi_reconnect_schedule(void);
+
+void wifi_reconnect_handle_connected(const wifi_event_sta_connected_t *event);
+void wifi_reconnect_handle_disconnected(const wifi_event_sta_disconnected_t *event);
+void wifi_reconnect_handle_got_ip(void);
+
+void wifi_reconnect_get_stats(wifi_reconnect_stats_t *stats);
+
+/** Channel of the cached (last associated) AP, or 0 if none is cached. */
+uint8_t wifi_reconnect_cached_channel(void);
+
+#endif /* WIFI_RECONNECT_H */
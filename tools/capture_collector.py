@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""Receive a border router's packet capture and measure forwarding delay.
+
+Listens for the pcapng stream of "otbr capture" and writes it to a file
+that Wireshark opens directly:
+
+  tools/capture_collector.py --out otbr.pcapng            # UDP 5141
+  tools/capture_collector.py --tcp --out otbr.pcapng      # TCP 5141
+
+then on the border router's console, e.g.
+
+  otbr capture start udp 192.168.1.10 5141 ip6 not port 5353
+
+Interface "wifi" carries the backbone's Ethernet frames, "thread" the
+IPv6 packets of the OpenThread netif; every record has a microsecond
+timestamp and an inbound/outbound flag.  With --delays, each IPv6 packet
+that comes in on one interface and goes out of the other is matched
+(by its headers and first payload bytes, ignoring the hop limit) and the
+forwarding delay is printed per direction on Ctrl-C.  Standard library
+only.
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+BLOCK_SHB = 0x0A0D0D0A
+BLOCK_EPB = 0x00000006
+IFACE_NAMES = {0: "wifi", 1: "thread"}
+MATCH_WINDOW_US = 2_000_000
+
+
+# ---- pcapng stream ----
+
+class Blocks:
+    """Split a byte stream into pcapng blocks (little-endian, as sent)."""
+
+    def __init__(self):
+        self.buf = b""
+
+    def feed(self, data):
+        self.buf += data
+        while len(self.buf) >= 12:
+            btype, blen = struct.unpack_from("<II", self.buf, 0)
+            if blen < 12 or blen % 4:
+                raise ValueError(f"bad pcapng block length {blen}")
+            if len(self.buf) < blen:
+                break
+            block, self.buf = self.buf[:blen], self.buf[blen:]
+            yield btype, block
+
+
+def parse_epb(block):
+    iface, ts_hi, ts_lo, caplen, origlen = struct.unpack_from("<IIIII", block, 8)
+    data = block[28:28 + caplen]
+    opts = block[28 + ((caplen + 3) & ~3):-4]
+    flags = 0
+    while len(opts) >= 4:
+        code, olen = struct.unpack_from("<HH", opts, 0)
+        if code == 0:
+            break
+        if code == 2 and olen == 4:
+            flags = struct.unpack_from("<I", opts, 4)[0]
+        opts = opts[4 + ((olen + 3) & ~3):]
+    outbound = (flags & 3) == 2
+    return iface, (ts_hi << 32) | ts_lo, outbound, data
+
+
+# ---- Forwarding delay ----
+
+def ipv6_packet(iface, data):
+    if iface == 0:
+        if len(data) < 14 or data[12:14] != b"\x86\xdd":
+            return None
+        data = data[14:]
+    if len(data) < 40 or data[0] >> 4 != 6:
+        return None
+    return data
+
+
+class Delays:
+    def __init__(self, verbose):
+        self.verbose = verbose
+        self.pending = {}       # key -> (ts, iface)
+        self.samples = {"thread->wifi": [], "wifi->thread": []}
+
+    def add(self, iface, ts, outbound, data):
+        ip = ipv6_packet(iface, data)
+        if ip is None:
+            return
+        key = ip[:7] + ip[8:64]         # all but the hop limit
+        if not outbound:
+            self.pending[key] = (ts, iface)
+        else:
+            seen = self.pending.pop(key, None)
+            if seen is not None and seen[1] != iface:
+                direction = f"{IFACE_NAMES[seen[1]]}->{IFACE_NAMES[iface]}"
+                delay = ts - seen[0]
+                self.samples[direction].append(delay)
+                if self.verbose:
+                    src = socket.inet_ntop(socket.AF_INET6, ip[8:24])
+                    dst = socket.inet_ntop(socket.AF_INET6, ip[24:40])
+                    print(f"  {direction:13} {delay:7} us  {src} -> {dst}")
+        if len(self.pending) > 4096:
+            self.pending = {k: v for k, v in self.pending.items()
+                            if ts - v[0] < MATCH_WINDOW_US}
+
+    def report(self):
+        for direction, samples in self.samples.items():
+            if not samples:
+                print(f"{direction}: no matched packets")
+                continue
+            s = sorted(samples)
+            pct = lambda p: s[min(len(s) - 1, int(len(s) * p / 100))]
+            print(f"{direction}: {len(s)} packets, min {s[0]} us, p50 {pct(50)} us, "
+                  f"p90 {pct(90)} us, p99 {pct(99)} us, max {s[-1]} us")
+
+
+# ---- Receive ----
+
+def chunks(args):
+    if args.tcp:
+        server = socket.create_server(("", args.listen), family=socket.AF_INET6, dualstack_ipv6=True)
+        print(f"waiting for the border router on TCP port {args.listen}")
+        conn, peer = server.accept()
+        print(f"streaming from {peer[0]}")
+        while True:
+            data = conn.recv(65536)
+            if not data:
+                return
+            yield data
+    else:
+        sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+        sock.setsockopt(socket.IPPROTO_IPV6, socket.IPV6_V6ONLY, 0)
+        sock.bind(("", args.listen))
+        print(f"listening on UDP port {args.listen}")
+        while True:
+            yield sock.recv(65536)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--listen", type=int, default=5141, help="port to listen on (5141)")
+    ap.add_argument("--tcp", action="store_true", help="accept a TCP stream instead of UDP")
+    ap.add_argument("--out", help="write the pcapng stream to this file")
+    ap.add_argument("--delays", action="store_true", help="match forwarded packets, report delay")
+    ap.add_argument("--verbose", action="store_true", help="print every matched packet")
+    args = ap.parse_args()
+
+    out = open(args.out, "wb") if args.out else None
+    delays = Delays(args.verbose) if args.delays else None
+    blocks = Blocks()
+    records = 0
+    started = False         # a late UDP listener waits for the next header
+    start = time.time()
+
+    try:
+        for data in chunks(args):
+            for btype, block in blocks.feed(data):
+                started = started or btype == BLOCK_SHB
+                if not started:
+                    continue
+                if out:
+                    out.write(block)
+                if btype == BLOCK_EPB:
+                    records += 1
+                    if delays:
+                        delays.add(*parse_epb(block))
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if out:
+            out.close()
+
+    print(f"\n{records} packets in {time.time() - start:.0f} s")
+    if delays:
+        delays.report()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
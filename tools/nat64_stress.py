@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""Open thousands of NAT64 flows through a border router's NAT64 engine.
+
+Runs a UDP echo server on this machine as the IPv4 "internet" stand-in,
+then starts "otbr nat64 stress <this-ip> <port> <flows>" on a border
+router (NAT64_ENGINE 1) over its USB serial console:
+
+  tools/nat64_stress.py --port /dev/ttyACM0 --flows 4000
+
+Each flow is a UDP packet from its own synthetic Thread address, so the
+engine needs one mapping (and one backbone port) per flow.  This side
+counts the distinct source ports that arrive and echoes every packet;
+the device counts the echoes that find their mapping again and logs the
+outcome.  With more flows than NAT64_MAX_MAPPINGS the excess shows up as
+"exhausted" (or as evictions once earlier mappings have idled 30 s).
+Run it on the same Wi-Fi/LAN segment.  Standard library only.
+"""
+
+import argparse
+import os
+import socket
+import sys
+import termios
+import threading
+import time
+import tty
+
+
+# ---- Serial console ----
+
+class Console:
+    def __init__(self, port):
+        self.fd = os.open(port, os.O_RDWR | os.O_NOCTTY)
+        tty.setraw(self.fd)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+        self.result = threading.Event()
+        threading.Thread(target=self._reader, daemon=True).start()
+
+    def _reader(self):
+        buf = b""
+        while True:
+            try:
+                data = os.read(self.fd, 512)
+            except OSError:
+                return
+            buf += data
+            while b"\n" in buf:
+                line, buf = buf.split(b"\n", 1)
+                text = line.decode(errors="replace").strip()
+                if "nat64" in text or text.startswith(("mappings:", "lookups:", "packets:",
+                                                       "lookup cost:", "Error")):
+                    print(f"  device: {text}")
+                if "stress:" in text:
+                    self.result.set()
+
+    def command(self, line):
+        os.write(self.fd, line.encode() + b"\r\n")
+
+
+# ---- IPv4 stand-in ----
+
+class EchoServer:
+    def __init__(self, port):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+        self.sock.bind(("", port))
+        self.sock.settimeout(0.1)
+        self.sources = set()
+        self.packets = 0
+        self.first = None
+        self.last = None
+        self.running = True
+        threading.Thread(target=self._serve, daemon=True).start()
+
+    def _serve(self):
+        while self.running:
+            try:
+                msg, addr = self.sock.recvfrom(2048)
+            except socket.timeout:
+                continue
+            now = time.monotonic()
+            self.first = self.first or now
+            self.last = now
+            self.packets += 1
+            self.sources.add(addr)
+            self.sock.sendto(msg, addr)
+
+
+def local_ip():
+    # The address this machine would use to reach the internet (no packet is sent)
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as s:
+        s.connect(("192.0.2.1", 9))
+        return s.getsockname()[0]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", required=True, help="border router serial console")
+    parser.add_argument("--flows", type=int, default=4000, help="flows to open (max 16384)")
+    parser.add_argument("--ip", default=None, help="this machine's LAN IPv4 address")
+    parser.add_argument("--udp-port", type=int, default=46464, help="echo server port")
+    parser.add_argument("--timeout", type=float, default=60, help="give up after this many s")
+    parser.add_argument("--keep", action="store_true", help="leave the mappings to expire")
+    args = parser.parse_args()
+
+    ip = args.ip or local_ip()
+    console = Console(args.port)
+    server = EchoServer(args.udp_port)
+
+    console.command("otbr nat64 stress clear")
+    time.sleep(1)
+
+    print(f"opening {args.flows} flows to {ip}:{args.udp_port} ...")
+    console.command(f"otbr nat64 stress {ip} {args.udp_port} {args.flows}")
+    done = console.result.wait(args.timeout)
+    server.running = False
+
+    ports = {port for _, port in server.sources}
+    print(f"stand-in received {server.packets} packets from {len(ports)} backbone ports")
+    if server.first is not None and server.last > server.first:
+        print(f"  rate   {server.packets / (server.last - server.first):8.0f} flows/s")
+    if ports:
+        print(f"  ports  {min(ports)}-{max(ports)}")
+    if not done:
+        print(f"  no result from the device after {args.timeout:.0f} s")
+
+    console.command("otbr nat64")
+    time.sleep(0.5)
+    if not args.keep:
+        console.command("otbr nat64 stress clear")
+        time.sleep(0.5)
+
+    sys.exit(0 if done and len(ports) == server.packets else 1)
+
+
+if __name__ == "__main__":
+    main()
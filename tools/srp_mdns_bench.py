@@ -0,0 +1,235 @@
+#!/usr/bin/env python3
+"""Measure how fast SRP services show up on the LAN via mDNS.
+
+Starts "otbr srp bench <count>" on a border router over its USB serial
+console (OT_CLI_UART_ENABLE 1), then watches mDNS on this machine's LAN
+until every _otbrbench._udp instance is resolvable (PTR -> SRV -> AAAA):
+
+  tools/srp_mdns_bench.py --port /dev/ttyACM0 --count 60
+
+The synthetic services go through the same queue, batching and publish
+path as real SRP registrations, but are made up on the border router:
+the SRP server itself (update parsing, signatures, the answer to the
+device) is bypassed.  This is the mDNS half of the "border router
+restarted and every device re-registered" case, seen from Home Assistant.
+Run it on
+a machine on the same Wi-Fi/LAN segment; nothing else may hold port 5353
+without SO_REUSEPORT.  Standard library only.
+"""
+
+import argparse
+import ipaddress
+import os
+import socket
+import struct
+import sys
+import termios
+import threading
+import time
+import tty
+
+MDNS_ADDR = "224.0.0.251"
+MDNS_PORT = 5353
+SERVICE = "_otbrbench._udp.local"
+HOST_PREFIX = "otbrbench-"
+
+TYPE_A, TYPE_PTR, TYPE_AAAA, TYPE_SRV = 1, 12, 28, 33
+MAX_QUESTIONS = 20
+
+
+# ---- DNS wire format ----
+
+def encode_name(name):
+    out = b""
+    for label in name.rstrip(".").split("."):
+        out += bytes([len(label)]) + label.encode()
+    return out + b"\0"
+
+
+def build_query(questions):
+    msg = struct.pack("!HHHHHH", 0, 0, len(questions), 0, 0, 0)
+    for name, qtype in questions:
+        msg += encode_name(name) + struct.pack("!HH", qtype, 1)
+    return msg
+
+
+def decode_name(msg, offset):
+    labels = []
+    end = None
+    for _ in range(128):
+        length = msg[offset]
+        if length & 0xC0 == 0xC0:
+            if end is None:
+                end = offset + 2
+            offset = ((length & 0x3F) << 8) | msg[offset + 1]
+        elif length == 0:
+            return ".".join(labels).lower(), end if end is not None else offset + 1
+        else:
+            labels.append(msg[offset + 1:offset + 1 + length].decode(errors="replace"))
+            offset += 1 + length
+    raise ValueError("name compression loop")
+
+
+def parse_records(msg):
+    _, flags, qd, an, ns, ar = struct.unpack_from("!HHHHHH", msg)
+    if not flags & 0x8000:
+        return []  # a query, not a response
+    offset = 12
+    for _ in range(qd):
+        _, offset = decode_name(msg, offset)
+        offset += 4
+
+    records = []
+    for _ in range(an + ns + ar):
+        name, offset = decode_name(msg, offset)
+        rtype, _, _, rdlen = struct.unpack_from("!HHIH", msg, offset)
+        offset += 10
+        rdata = msg[offset:offset + rdlen]
+        if rtype == TYPE_PTR:
+            records.append((name, rtype, decode_name(msg, offset)[0]))
+        elif rtype == TYPE_SRV:
+            records.append((name, rtype, decode_name(msg, offset + 6)[0]))
+        elif rtype == TYPE_AAAA and rdlen == 16:
+            records.append((name, rtype, str(ipaddress.IPv6Address(rdata))))
+        elif rtype == TYPE_A and rdlen == 4:
+            records.append((name, rtype, str(ipaddress.IPv4Address(rdata))))
+        offset += rdlen
+    return records
+
+
+# ---- Serial console ----
+
+class Console:
+    def __init__(self, port):
+        self.fd = os.open(port, os.O_RDWR | os.O_NOCTTY)
+        tty.setraw(self.fd)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+        threading.Thread(target=self._reader, daemon=True).start()
+
+    def _reader(self):
+        buf = b""
+        while True:
+            try:
+                data = os.read(self.fd, 512)
+            except OSError:
+                return
+            buf += data
+            while b"\n" in buf:
+                line, buf = buf.split(b"\n", 1)
+                text = line.decode(errors="replace").strip()
+                if "srp bench" in text or "srp_mdns" in text:
+                    print(f"  device: {text}")
+
+    def command(self, line):
+        os.write(self.fd, line.encode() + b"\r\n")
+
+
+# ---- Benchmark ----
+
+class Resolver:
+    def __init__(self):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        if hasattr(socket, "SO_REUSEPORT"):
+            self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEPORT, 1)
+        self.sock.bind(("", MDNS_PORT))
+        mreq = struct.pack("4s4s", socket.inet_aton(MDNS_ADDR), socket.inet_aton("0.0.0.0"))
+        self.sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+        self.sock.settimeout(0.05)
+
+        self.instances = set()
+        self.srv = {}
+        self.hosts = set()
+        self.resolved = {}  # instance -> seconds since start
+
+    def query(self):
+        questions = [(SERVICE, TYPE_PTR)]
+        questions += [(i, TYPE_SRV) for i in self.instances if i not in self.srv]
+        questions += [(h, TYPE_AAAA) for h in set(self.srv.values()) if h not in self.hosts]
+        for i in range(0, len(questions), MAX_QUESTIONS):
+            self.sock.sendto(build_query(questions[i:i + MAX_QUESTIONS]), (MDNS_ADDR, MDNS_PORT))
+
+    def receive(self, start):
+        try:
+            msg, _ = self.sock.recvfrom(9000)
+        except socket.timeout:
+            return
+        try:
+            records = parse_records(msg)
+        except (ValueError, IndexError, struct.error):
+            return
+
+        for name, rtype, value in records:
+            if rtype == TYPE_PTR and name == SERVICE.lower() and value.startswith(HOST_PREFIX):
+                self.instances.add(value)
+            elif rtype == TYPE_SRV and name.startswith(HOST_PREFIX):
+                self.instances.add(name)
+                self.srv[name] = value
+            elif rtype in (TYPE_AAAA, TYPE_A) and name.startswith(HOST_PREFIX):
+                self.hosts.add(name)
+
+        now = time.monotonic() - start
+        for instance, host in self.srv.items():
+            if instance not in self.resolved and host in self.hosts:
+                self.resolved[instance] = now
+
+
+def percentile(values, p):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", required=True, help="border router serial console")
+    parser.add_argument("--count", type=int, default=60,
+                        help="services to register (max SRP_HOSTS_EXPECTED, 60)")
+    parser.add_argument("--timeout", type=float, default=120, help="give up after this many s")
+    parser.add_argument("--query-interval", type=float, default=1.0,
+                        help="seconds between mDNS queries")
+    parser.add_argument("--keep", action="store_true", help="leave the services published")
+    args = parser.parse_args()
+
+    console = Console(args.port)
+    resolver = Resolver()
+
+    # Start from a clean slate in case an earlier run was interrupted
+    console.command("otbr srp bench clear")
+    time.sleep(2)
+
+    print(f"registering {args.count} services ...")
+    start = time.monotonic()
+    console.command(f"otbr srp bench {args.count}")
+
+    next_query = start
+    while len(resolver.resolved) < args.count:
+        now = time.monotonic()
+        if now - start > args.timeout:
+            break
+        if now >= next_query:
+            resolver.query()
+            next_query = now + args.query_interval
+        resolver.receive(start)
+
+    times = list(resolver.resolved.values())
+    print(f"resolvable on the LAN: {len(times)}/{args.count}")
+    if times:
+        print(f"  first  {min(times) * 1000:8.0f} ms")
+        print(f"  median {percentile(times, 0.5) * 1000:8.0f} ms")
+        print(f"  p90    {percentile(times, 0.9) * 1000:8.0f} ms")
+        print(f"  all    {max(times) * 1000:8.0f} ms" if len(times) == args.count else
+              f"  timed out after {args.timeout:.0f} s")
+        print(f"  rate   {len(times) / max(max(times), 0.001):8.1f} services/s")
+
+    console.command("otbr srp")
+    time.sleep(0.5)
+    if not args.keep:
+        console.command("otbr srp bench clear")
+        time.sleep(0.5)
+
+    sys.exit(0 if len(times) == args.count else 1)
+
+
+if __name__ == "__main__":
+    main()